@@ -94,6 +94,26 @@ macro(setup_module_variables_for_maths base_directory json_directory)
   )
   list(REMOVE_DUPLICATES SM_MAT_MODULES)
 
+  set(SM_QUATERNION_ARRAY_MODULES
+    ${SM_MAT_MODULES}
+    ${SM_VVEC_MODULES}
+    ${base_directory}/sm/quaternion_array.cppm
+  )
+  list(REMOVE_DUPLICATES SM_QUATERNION_ARRAY_MODULES)
+
+  set(SM_AFFINE_MODULES
+    ${SM_MAT_MODULES}
+    ${base_directory}/sm/affine.cppm
+  )
+  list(REMOVE_DUPLICATES SM_AFFINE_MODULES)
+
+  set(SM_MAT_BATCH_MODULES
+    ${SM_MAT_MODULES}
+    ${SM_VVEC_MODULES}
+    ${base_directory}/sm/mat_batch.cppm
+  )
+  list(REMOVE_DUPLICATES SM_MAT_BATCH_MODULES)
+
   set(SM_SPLINE_MODULES
     ${SM_VVEC_MODULES}
     ${SM_MAT_MODULES}
@@ -152,6 +172,12 @@ macro(setup_module_variables_for_maths base_directory json_directory)
   )
   list(REMOVE_DUPLICATES SM_GRID_MODULES)
 
+  set(SM_GRID_PYRAMID_MODULES
+    ${SM_GRID_MODULES}
+    ${base_directory}/sm/grid_pyramid.cppm
+  )
+  list(REMOVE_DUPLICATES SM_GRID_PYRAMID_MODULES)
+
   set(SM_ALGO_MODULES
     ${SM_VEC_MODULES}
     ${SM_VVEC_MODULES}
@@ -179,6 +205,12 @@ macro(setup_module_variables_for_maths base_directory json_directory)
   )
   list(REMOVE_DUPLICATES SM_BOXFILTER_MODULES)
 
+  set(SM_FFT_MODULES
+    ${SM_MATHCONST_MODULES}
+    ${base_directory}/sm/fft.cppm
+  )
+  list(REMOVE_DUPLICATES SM_FFT_MODULES)
+
   set(SM_EDGECONV_MODULES
     ${SM_VEC_MODULES}
     ${SM_VVEC_MODULES}
@@ -242,9 +274,28 @@ macro(setup_module_variables_for_maths base_directory json_directory)
   )
   list(REMOVE_DUPLICATES SM_BEZCURVEPATH_MODULES)
 
+  set(SM_BOUNDARYFILL_MODULES
+    ${SM_BEZCOORD_MODULES}
+    ${base_directory}/sm/boundaryfill.cppm
+  )
+  list(REMOVE_DUPLICATES SM_BOUNDARYFILL_MODULES)
+
+  set(SM_POLYGON_INDEX_MODULES
+    ${base_directory}/sm/polygon_index.cppm
+  )
+  list(REMOVE_DUPLICATES SM_POLYGON_INDEX_MODULES)
+
+  set(SM_CSR_MODULES
+    ${base_directory}/sm/csr.cppm
+  )
+  list(REMOVE_DUPLICATES SM_CSR_MODULES)
+
   set(SM_HEXGRID_MODULES
     ${SM_BEZCURVEPATH_MODULES}
     ${SM_HEX_MODULES}
+    ${SM_BOUNDARYFILL_MODULES}
+    ${SM_POLYGON_INDEX_MODULES}
+    ${SM_CSR_MODULES}
     ${base_directory}/sm/hexgrid.cppm
   )
   list(REMOVE_DUPLICATES SM_HEXGRID_MODULES)
@@ -256,6 +307,12 @@ macro(setup_module_variables_for_maths base_directory json_directory)
   )
   list(REMOVE_DUPLICATES SM_HEXGRID_HDF_MODULES)
 
+  set(SM_HEXGRID_TILES_MODULES
+    ${SM_HEXGRID_MODULES}
+    ${base_directory}/sm/hexgrid_tiles.cppm
+  )
+  list(REMOVE_DUPLICATES SM_HEXGRID_TILES_MODULES)
+
   set(SM_HEXYHISTO_MODULES
     ${SM_VEC_MODULES}
     ${SM_VVEC_MODULES}
@@ -268,9 +325,22 @@ macro(setup_module_variables_for_maths base_directory json_directory)
     ${SM_BEZCURVEPATH_MODULES}
     ${SM_RECT_MODULES}
     ${SM_GRID_MODULES}
+    ${SM_SCALE_MODULES}
+    ${SM_BOXFILTER_MODULES}
+    ${SM_FFT_MODULES}
+    ${SM_BOUNDARYFILL_MODULES}
+    ${SM_POLYGON_INDEX_MODULES}
+    ${SM_CSR_MODULES}
     ${base_directory}/sm/cartgrid.cppm
   )
-  list(REMOVE_DUPLICATES SM_CARGRID_MODULES)
+  list(REMOVE_DUPLICATES SM_CARTGRID_MODULES)
+
+  set(SM_CARTGRID_HDF_MODULES
+    ${SM_CARTGRID_MODULES}
+    ${SM_HDFDATA_MODULES}
+    ${base_directory}/sm/cartgrid_hdf.cppm
+  )
+  list(REMOVE_DUPLICATES SM_CARTGRID_HDF_MODULES)
 
   set(SM_CONFIG_MODULES
     ${SM_VEC_MODULES}
@@ -311,6 +381,9 @@ macro(setup_module_variables_for_maths base_directory json_directory)
     ${SM_UTIL_MODULES}
     ${SM_QUATERNION_MODULES}
     ${SM_MAT_MODULES}
+    ${SM_QUATERNION_ARRAY_MODULES}
+    ${SM_AFFINE_MODULES}
+    ${SM_MAT_BATCH_MODULES}
     ${SM_SPLINE_MODULES}
     ${SM_RANDOM_WALK_MODULES}
     ${SM_RUNGEKUTTA4_MODULES}
@@ -320,14 +393,20 @@ macro(setup_module_variables_for_maths base_directory json_directory)
     ${SM_WINDER_MODULES}
     ${SM_BOOTSTRAP_MODULES}
     ${SM_GRID_MODULES}
+    ${SM_GRID_PYRAMID_MODULES}
     ${SM_ALGO_MODULES}
     ${SM_NM_SIMPLEX_MODULES}
     ${SM_HISTO_MODULES}
     ${SM_BOXFILTER_MODULES}
+    ${SM_FFT_MODULES}
     ${SM_GEOMETRY_MODULES}
     ${SM_BEZCURVE_MODULES}
     ${SM_BEZCURVEPATH_MODULES}
+    ${SM_BOUNDARYFILL_MODULES}
+    ${SM_POLYGON_INDEX_MODULES}
+    ${SM_CSR_MODULES}
     ${SM_HEXGRID_MODULES}
+    ${SM_HEXGRID_TILES_MODULES}
     ${SM_HEXYHISTO_MODULES}
     ${SM_CARTGRID_MODULES}
     ${SM_BASE64_MODULES}
@@ -0,0 +1,319 @@
+// -*- C++ -*-
+/*!
+ * This file is part of sebsjames/maths, a library of maths code for modern C++
+ *
+ * See https://github.com/sebsjames/maths
+ *
+ * \file
+ *
+ * An affine transform class, sm::affine. Most 4x4 transform matrices (those built from translate,
+ * rotate, scale and frombasis) have a bottom row of (0, 0, 0, 1). sm::affine stores only the
+ * linear 3x3 part and the translation, so that composition of two transforms costs 36
+ * multiplications instead of the 64 required by mat<F, 4>::operator*, and inversion needs only a
+ * 3x3 inverse (or, for rigid transforms, a transpose).
+ *
+ * Like sm::mat, sm::affine is constexpr capable.
+ */
+module;
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <type_traits>
+
+export module sm.affine;
+
+export import sm.vec;
+export import sm.quaternion;
+export import sm.mat;
+
+export namespace sm
+{
+    // Forward declare class and stream operator
+    template <typename F> requires std::is_floating_point_v<F> struct affine;
+    template <typename F> std::ostream& operator<< (std::ostream&, const affine<F>&);
+
+    /*!
+     * An affine transformation, x' = L x + t, where L is the 3x3 linear part (rotation, scaling
+     * and shear) and t is the translation. Equivalent to the 4x4 matrix
+     *
+     *  L0 L3 L6 t0
+     *  L1 L4 L7 t1
+     *  L2 L5 L8 t2
+     *   0  0  0  1
+     *
+     * Transformations are applied by post-multiplication, exactly as for sm::mat<F, 4>, so a
+     * chain of translate/rotate/scale calls on an affine gives the same transform as the same
+     * chain on a mat<F, 4>.
+     *
+     * \tparam F The floating point type of the elements
+     */
+    template <typename F> requires std::is_floating_point_v<F>
+    struct affine
+    {
+        //! The linear part of the transform. Default is identity.
+        sm::mat<F, 3> linear = sm::mat<F, 3>::identity();
+        //! The translation part of the transform. Default is zero.
+        sm::vec<F, 3> translation = { F{0}, F{0}, F{0} };
+
+        //! Default constructor gives the identity transform
+        constexpr affine() noexcept = default;
+
+        //! Construct from a linear part and a translation
+        constexpr affine (const sm::mat<F, 3>& _linear, const sm::vec<F, 3>& _translation) noexcept
+            : linear(_linear), translation(_translation) {}
+
+        /*!
+         * Construct from a 4x4 transform matrix. The bottom row of m is ignored; use
+         * affine<F>::is_affine(m) if you need to check that m really is affine.
+         */
+        constexpr explicit affine (const sm::mat<F, 4>& m) noexcept
+            : linear(m.linear()), translation(m.translation()) {}
+
+        //! Construct a pure rotation from a quaternion
+        constexpr explicit affine (const sm::quaternion<F>& q) noexcept
+            : linear(affine<F>::rotation_linear (q)) {}
+
+        //! Return true if the bottom row of m is (0, 0, 0, 1), so that m can be exactly represented as an affine
+        static constexpr bool is_affine (const sm::mat<F, 4>& m) noexcept
+        {
+            return m[3] == F{0} && m[7] == F{0} && m[11] == F{0} && m[15] == F{1};
+        }
+
+        //! Return the equivalent 4x4 transform matrix
+        constexpr sm::mat<F, 4> mat44() const noexcept
+        {
+            sm::mat<F, 4> m;
+            m[0] = this->linear[0];
+            m[1] = this->linear[1];
+            m[2] = this->linear[2];
+            m[3] = F{0};
+            m[4] = this->linear[3];
+            m[5] = this->linear[4];
+            m[6] = this->linear[5];
+            m[7] = F{0};
+            m[8] = this->linear[6];
+            m[9] = this->linear[7];
+            m[10] = this->linear[8];
+            m[11] = F{0};
+            m[12] = this->translation[0];
+            m[13] = this->translation[1];
+            m[14] = this->translation[2];
+            m[15] = F{1};
+            return m;
+        }
+
+        //! Convert to a 4x4 transform matrix
+        constexpr explicit operator sm::mat<F, 4>() const noexcept { return this->mat44(); }
+
+        //! Set to the identity transform
+        constexpr void set_identity() noexcept
+        {
+            this->linear.set_identity();
+            this->translation.zero();
+        }
+
+        //! Return the identity transform
+        static constexpr affine<F> identity() noexcept { return affine<F>{}; }
+
+        //! Create a transform into the given coordinate basis set (as mat<F, 4>::frombasis)
+        static constexpr affine<F> frombasis (const sm::vec<F, 3>& bx, const sm::vec<F, 3>& by, const sm::vec<F, 3>& bz) noexcept
+        {
+            affine<F> a;
+            a.linear.set_col (0, bx);
+            a.linear.set_col (1, by);
+            a.linear.set_col (2, bz);
+            return a;
+        }
+
+        //! Return the 3x3 rotation matrix for the (assumed unit) quaternion q
+        static constexpr sm::mat<F, 3> rotation_linear (const sm::quaternion<F>& q) noexcept
+        {
+            const F f2x = q.x * F{2};
+            const F f2y = q.y * F{2};
+            const F f2z = q.z * F{2};
+            sm::mat<F, 3> m;
+            m[0] = F{1} - (f2y * q.y + f2z * q.z);
+            m[1] = f2x * q.y + f2z * q.w;
+            m[2] = f2x * q.z - f2y * q.w;
+            m[3] = f2x * q.y - f2z * q.w;
+            m[4] = F{1} - (f2x * q.x + f2z * q.z);
+            m[5] = f2y * q.z + f2x * q.w;
+            m[6] = f2x * q.z + f2y * q.w;
+            m[7] = f2y * q.z - f2x * q.w;
+            m[8] = F{1} - (f2x * q.x + f2y * q.y);
+            return m;
+        }
+
+        //! Apply translation dv as a post-multiplication: this = this * T
+        template<typename T, std::size_t N = 3> requires std::is_arithmetic_v<T> && (N == 3 || N == 4)
+        constexpr void translate (const sm::vec<T, N>& dv) noexcept
+        {
+            this->translate (dv[0], dv[1], dv[2]);
+        }
+
+        //! Apply translation (dx, dy, dz) as a post-multiplication: this = this * T
+        template<typename T> requires std::is_arithmetic_v<T>
+        constexpr void translate (const T& dx, const T& dy, const T& dz) noexcept
+        {
+            this->translation[0] += this->linear[0] * dx + this->linear[3] * dy + this->linear[6] * dz;
+            this->translation[1] += this->linear[1] * dx + this->linear[4] * dy + this->linear[7] * dz;
+            this->translation[2] += this->linear[2] * dx + this->linear[5] * dy + this->linear[8] * dz;
+        }
+
+        //! Apply translation dv as a pre-multiplication: this = T * this
+        template<typename T, std::size_t N = 3> requires std::is_arithmetic_v<T> && (N == 3 || N == 4)
+        constexpr void pretranslate (const sm::vec<T, N>& dv) noexcept
+        {
+            this->translation[0] += dv[0];
+            this->translation[1] += dv[1];
+            this->translation[2] += dv[2];
+        }
+
+        //! Apply the rotation q as a post-multiplication: this = this * R
+        constexpr void rotate (const sm::quaternion<F>& q) noexcept
+        {
+            this->linear = this->linear * affine<F>::rotation_linear (q);
+        }
+
+        //! Apply a rotation of theta radians about axis as a post-multiplication: this = this * R
+        template <std::size_t N = 3> requires (N == 3 || N == 4)
+        constexpr void rotate (const sm::vec<F, N>& axis, const F theta) noexcept
+        {
+            sm::quaternion<F> q;
+            q.rotate (axis, theta);
+            this->rotate (q);
+        }
+
+        //! Apply the rotation q as a pre-multiplication: this = R * this
+        constexpr void prerotate (const sm::quaternion<F>& q) noexcept
+        {
+            const sm::mat<F, 3> r = affine<F>::rotation_linear (q);
+            this->linear = r * this->linear;
+            this->translation = r * this->translation;
+        }
+
+        //! Apply scaling by individual dims as a post-multiplication: this = this * S
+        template<typename T> requires std::is_arithmetic_v<T>
+        constexpr void scale (const T& scl_x, const T& scl_y, const T& scl_z) noexcept
+        {
+            this->linear[0] *= scl_x;
+            this->linear[1] *= scl_x;
+            this->linear[2] *= scl_x;
+            this->linear[3] *= scl_y;
+            this->linear[4] *= scl_y;
+            this->linear[5] *= scl_y;
+            this->linear[6] *= scl_z;
+            this->linear[7] *= scl_z;
+            this->linear[8] *= scl_z;
+        }
+
+        //! Apply scaling by vector as a post-multiplication: this = this * S
+        template<typename T, std::size_t N = 3> requires std::is_arithmetic_v<T> && (N == 3 || N == 4)
+        constexpr void scale (const sm::vec<T, N>& scl) noexcept { this->scale (scl[0], scl[1], scl[2]); }
+
+        //! Apply uniform scaling as a post-multiplication: this = this * S
+        template<typename T> requires std::is_arithmetic_v<T>
+        constexpr void scale (const T& scl) noexcept { this->scale (scl, scl, scl); }
+
+        //! The determinant of the transform (that of its linear part)
+        constexpr F determinant() const noexcept { return this->linear.determinant(); }
+
+        /*!
+         * Return the inverse transform, computed with a 3x3 inverse of the linear part. If the
+         * linear part is singular, a transform with all zero elements is returned, as for
+         * mat::inverse.
+         */
+        constexpr affine<F> inverse() const noexcept
+        {
+            affine<F> ai;
+            ai.linear = this->linear.inverse();
+            ai.translation = -(ai.linear * this->translation);
+            return ai;
+        }
+
+        /*!
+         * Return the inverse of a rigid transform (rotation and translation only). The linear
+         * part must be orthonormal, in which case its inverse is its transpose. Cheaper than
+         * inverse(), but gives the wrong answer if the transform includes any scaling or shear.
+         */
+        constexpr affine<F> rigid_inverse() const noexcept
+        {
+            affine<F> ai;
+            ai.linear = this->linear.transpose();
+            ai.translation = -(ai.linear * this->translation);
+            return ai;
+        }
+
+        //! Invert this transform in place
+        constexpr void inverse_inplace() noexcept { *this = this->inverse(); }
+
+        /*!
+         * Compose two transforms: return this * a2, which applies a2 first, then *this.
+         *
+         * L = L1 L2 (27 multiplications); t = L1 t2 + t1 (9 multiplications).
+         */
+        constexpr affine<F> operator* (const affine<F>& a2) const noexcept
+        {
+            affine<F> a;
+            a.linear = this->linear * a2.linear;
+            a.translation = this->linear * a2.translation;
+            a.translation += this->translation;
+            return a;
+        }
+
+        //! Compose with post-multiplication: *this = *this * a2
+        constexpr void operator*= (const affine<F>& a2) noexcept { *this = *this * a2; }
+
+        //! Compose with pre-multiplication: *this = a1 * *this
+        constexpr void premultiply (const affine<F>& a1) noexcept { *this = a1 * *this; }
+
+        //! Compose with a general 4x4 matrix, returning a 4x4 matrix
+        constexpr sm::mat<F, 4> operator* (const sm::mat<F, 4>& m2) const noexcept { return this->mat44() * m2; }
+
+        //! Transform the point v (v' = L v + t)
+        constexpr sm::vec<F, 3> operator* (const sm::vec<F, 3>& v) const noexcept
+        {
+            sm::vec<F, 3> vt = this->linear * v;
+            vt += this->translation;
+            return vt;
+        }
+
+        //! Transform the homogeneous coordinate v. The translation is scaled by v[3], which is unchanged.
+        constexpr sm::vec<F, 4> operator* (const sm::vec<F, 4>& v) const noexcept
+        {
+            sm::vec<F, 4> vt;
+            vt[0] = this->linear[0] * v[0] + this->linear[3] * v[1] + this->linear[6] * v[2] + this->translation[0] * v[3];
+            vt[1] = this->linear[1] * v[0] + this->linear[4] * v[1] + this->linear[7] * v[2] + this->translation[1] * v[3];
+            vt[2] = this->linear[2] * v[0] + this->linear[5] * v[1] + this->linear[8] * v[2] + this->translation[2] * v[3];
+            vt[3] = v[3];
+            return vt;
+        }
+
+        //! Transform a direction vector, v (no translation is applied, v' = L v)
+        constexpr sm::vec<F, 3> transform_direction (const sm::vec<F, 3>& v) const noexcept { return this->linear * v; }
+
+        //! Equality operator. True if the linear parts and translations are equal
+        constexpr bool operator== (const affine<F>& rhs) const noexcept
+        {
+            return this->linear == rhs.linear && this->translation == rhs.translation;
+        }
+
+        //! Not equals
+        constexpr bool operator!= (const affine<F>& rhs) const noexcept { return !(*this == rhs); }
+
+        //! Return a string representation of the equivalent 4x4 matrix
+        std::string str() const noexcept { return this->mat44().str(); }
+
+        //! Overload the stream output operator
+        friend std::ostream& operator<< <F> (std::ostream& os, const affine<F>& a);
+    };
+
+    template <typename F>
+    std::ostream& operator<< (std::ostream& os, const affine<F>& a)
+    {
+        os << a.str();
+        return os;
+    }
+
+} // namespace sm
@@ -0,0 +1,84 @@
+// -*- C++ -*-
+/*!
+ * This file is part of sebsjames/maths, a library of maths code for modern C++
+ *
+ * See https://github.com/sebsjames/maths
+ *
+ * \file
+ *
+ * Shared pieces of the boundary application code in sm::hexgrid and sm::cartgrid: the choice of
+ * interior fill and the scanline crossing computation used by the scanline fill.
+ *
+ * \author Seb James
+ * \date 2026
+ */
+module;
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+
+export module sm.boundaryfill;
+
+export import sm.bezcoord;
+
+export namespace sm
+{
+    /*!
+     * How hexgrid::set_boundary and cartgrid::set_boundary find the elements that lie inside a
+     * boundary once the boundary elements have been marked.
+     */
+    enum class boundaryfill
+    {
+        //! Iterative flood fill from the element nearest to the boundary centroid. Requires the
+        //! centroid to lie inside the boundary, as it does for convex shapes.
+        flood,
+        //! Keep each element whose centre lies inside the boundary polygon (even-odd rule), plus
+        //! the boundary elements. Rows of elements are processed in parallel. Works for any closed
+        //! boundary, including those whose centroid lies outside the enclosed region.
+        scanline
+    };
+
+    namespace algo
+    {
+        /*!
+         * For the closed polygon path (the last point joins back to the first), find the x
+         * coordinates at which the polygon crosses each of the horizontal lines y = ys[k]. ys
+         * must be sorted in ascending order. On return, xs[k] holds the sorted crossings for
+         * line k.
+         *
+         * An edge from p to q is counted as crossing line y if (p.y > y) != (q.y > y). This
+         * half-open rule counts a vertex lying exactly on a line once, so that a point at x on
+         * line k is inside the polygon when an odd number of xs[k] are less than x.
+         *
+         * Edges are bucketed by the lines they span, so the cost is O(P log L) for P points and
+         * L lines plus the number of crossings, rather than O(P L).
+         */
+        void scanline_crossings (const std::vector<sm::bezcoord<float>>& path,
+                                 const std::vector<float>& ys, std::vector<std::vector<float>>& xs)
+        {
+            xs.assign (ys.size(), std::vector<float>{});
+            const std::size_t np = path.size();
+            if (np < 3u || ys.empty()) { return; }
+
+            for (std::size_t i = 0; i < np; ++i) {
+                const sm::bezcoord<float>& p = path[i];
+                const sm::bezcoord<float>& q = path[(i + 1) % np];
+                if (p.y() == q.y()) { continue; } // A horizontal edge crosses no line
+                const float ylo = std::min (p.y(), q.y());
+                const float yhi = std::max (p.y(), q.y());
+                // The lines with ylo <= y < yhi are those crossed by this edge
+                auto k = std::lower_bound (ys.begin(), ys.end(), ylo);
+                for (; k != ys.end() && *k < yhi; ++k) {
+                    const float t = (*k - p.y()) / (q.y() - p.y());
+                    xs[k - ys.begin()].push_back (p.x() + t * (q.x() - p.x()));
+                }
+            }
+
+            const std::int64_t nl = static_cast<std::int64_t>(ys.size());
+#pragma omp parallel for
+            for (std::int64_t k = 0; k < nl; ++k) { std::sort (xs[k].begin(), xs[k].end()); }
+        }
+    }
+}
@@ -11,7 +11,6 @@
 module;
 
 #include <cstdint>
-#include <set>
 #include <list>
 #include <string>
 #include <array>
@@ -23,6 +22,11 @@ module;
 #include <vector>
 #include <stdexcept>
 #include <limits>
+#include <algorithm>
+#include <complex>
+#include <type_traits>
+#include <bit>
+#include <utility>
 
 export module sm.cartgrid;
 
@@ -33,23 +37,30 @@ export import sm.rect;
 // CARTGRID_COMPILE_WITH_BEZCURVES
 export import sm.bezcurvepath;
 export import sm.bezcoord;
+export import sm.boundaryfill;
+export import sm.csr;
 
 import sm.mathconst;
 export import sm.grid; // for gridfeatures
 import sm.vec;
 import sm.vvec;
+import sm.polygon_index;
 import sm.scale;
 import sm.interval;
 import sm.boxfilter;
+import sm.fft;
 
-// If the cartgrid::save and cartgrid::load methods are required, define
-// CARTGRID_COMPILE_LOAD_AND_SAVE. A link to libhdf5 will be required in your program.
-//#ifdef CARTGRID_COMPILE_LOAD_AND_SAVE
-//import sm.hdfdata; // see hexgrid_hdf for what to do
-//#endif
+// To save and load a cartgrid, see sm.cartgrid.hdf (cartgrid_hdf.cppm), which needs libhdf5.
 
 export namespace sm
 {
+    //! How a cartgrid stores its elements
+    enum class cartgridstorage
+    {
+        list,       // A std::list<rect> (cartgrid::rects) alongside the d_ vectors. Needed for arbitrary boundaries.
+        contiguous  // The d_ vectors only, with int32 neighbour indices. For rectangular domains.
+    };
+
     /*!
      * This class is used to build a Cartesian grid of rectangular elements.
      *
@@ -340,6 +351,81 @@ export namespace sm
             }
         }
 
+        /*!
+         * Fill the d_ vectors directly for a rectangular grid of elements with integer indices
+         * xi0 to xi1 and yi0 to yi1, in raster order from the bottom left. The neighbour
+         * relations (including a horizontal wrap, if wrap_h is true) and the neighbour flags
+         * match those that init() and init2() create for the rects in list storage.
+         */
+        void init_d_vectors (const std::int32_t xi0, const std::int32_t xi1,
+                             const std::int32_t yi0, const std::int32_t yi1, const bool wrap_h)
+        {
+            if (this->storage == cartgridstorage::contiguous && this->domain_shape != griddomainshape::rectangle) {
+                throw std::runtime_error ("cartgrid: contiguous storage is only available with griddomainshape::rectangle");
+            }
+            const std::int32_t w = xi1 - xi0 + 1;
+            const std::int32_t h = yi1 - yi0 + 1;
+            const std::int64_t n64 = static_cast<std::int64_t>(w) * static_cast<std::int64_t>(h);
+            if (n64 > std::numeric_limits<std::int32_t>::max()) {
+                throw std::runtime_error ("cartgrid: too many elements for int32 neighbour indices");
+            }
+            const std::size_t n = static_cast<std::size_t>(n64);
+
+            this->d_x.resize (n);
+            this->d_y.resize (n);
+            this->d_xi.resize (n);
+            this->d_yi.resize (n);
+            this->d_flags.resize (n);
+            this->d_dist_to_boundary.assign (n, -1.0f);
+            this->d_ne.resize (n);
+            this->d_nne.resize (n);
+            this->d_nn.resize (n);
+            this->d_nnw.resize (n);
+            this->d_nw.resize (n);
+            this->d_nsw.resize (n);
+            this->d_ns.resize (n);
+            this->d_nse.resize (n);
+
+            for (std::int32_t r = 0; r < h; ++r) {
+                const bool has_n = r < h - 1;
+                const bool has_s = r > 0;
+                for (std::int32_t c = 0; c < w; ++c) {
+                    const std::int32_t i = r * w + c;
+                    const bool has_e = c < w - 1;
+                    const bool has_w = c > 0;
+                    this->d_xi[i] = xi0 + c;
+                    this->d_yi[i] = yi0 + r;
+                    this->d_x[i] = this->d * this->d_xi[i];
+                    this->d_y[i] = this->v * this->d_yi[i];
+
+                    this->d_ne[i] = has_e ? i + 1 : (wrap_h ? i - (w - 1) : -1);
+                    this->d_nw[i] = has_w ? i - 1 : (wrap_h ? i + (w - 1) : -1);
+                    this->d_nn[i] = has_n ? i + w : -1;
+                    this->d_ns[i] = has_s ? i - w : -1;
+                    this->d_nne[i] = (has_n && has_e) ? i + w + 1 : -1;
+                    this->d_nnw[i] = (has_n && has_w) ? i + w - 1 : -1;
+                    this->d_nsw[i] = (has_s && has_w) ? i - w - 1 : -1;
+                    this->d_nse[i] = (has_s && has_e) ? i - w + 1 : -1;
+
+                    std::uint32_t flags = 0u;
+                    if (this->d_ne[i] >= 0) { flags |= RECT_HAS_NE; }
+                    if (this->d_nne[i] >= 0) { flags |= RECT_HAS_NNE; }
+                    if (this->d_nn[i] >= 0) { flags |= RECT_HAS_NN; }
+                    if (this->d_nnw[i] >= 0) { flags |= RECT_HAS_NNW; }
+                    if (this->d_nw[i] >= 0) { flags |= RECT_HAS_NW; }
+                    if (this->d_nsw[i] >= 0) { flags |= RECT_HAS_NSW; }
+                    if (this->d_ns[i] >= 0) { flags |= RECT_HAS_NS; }
+                    if (this->d_nse[i] >= 0) { flags |= RECT_HAS_NSE; }
+                    if (wrap_h && !has_e) { flags |= RECT_WRAPS_E; }
+                    if (wrap_h && !has_w) { flags |= RECT_WRAPS_W; }
+                    this->d_flags[i] = flags;
+                }
+            }
+
+            this->xi_minmax = sm::interval<std::int32_t>(xi0, xi1);
+            this->yi_minmax = sm::interval<std::int32_t>(yi0, yi1);
+        }
+
         //! Clear out all the d_ vectors
         void d_clear()
         {
@@ -348,265 +434,82 @@ export namespace sm
             this->d_xi.clear();
             this->d_yi.clear();
             this->d_flags.clear();
-        }
-
-#ifdef CARTGRID_COMPILE_LOAD_AND_SAVE
-        /*!
-         * Save this cartgrid (and all the rects in it) into the HDF5 file at the
-         * location \a path.
-         */
-        void save (const std::string& path)
-        {
-            sm::hdfdata cgdata (path, std::ios::out | std::ios::trunc);
-            cgdata.add_val ("/d", d);
-            cgdata.add_val ("/v", v);
-            cgdata.add_val ("/x_span", x_span);
-            cgdata.add_val ("/y_span", y_span);
-            cgdata.add_val ("/z", z);
-            cgdata.add_val ("/d_growthbuffer_horz", d_growthbuffer_horz);
-            cgdata.add_val ("/d_growthbuffer_vert", d_growthbuffer_vert);
-
-            // sm::vec<float, 2>
-            cgdata.add_contained_vals ("/boundary_entroid", boundary_centroid);
-
-            // Don't save bezcurvepath boundary - limit this to the ability to
-            // save which elements are boundary elements and which aren't
-
-            // vector<float>
-            cgdata.add_contained_vals ("/d_x", d_x);
-            cgdata.add_contained_vals ("/d_y", d_y);
-            cgdata.add_contained_vals ("/d_dist_to_boundary", d_dist_to_boundary);
-            // vector<std::int32_t>
-            cgdata.add_contained_vals ("/d_xi", d_xi);
-            cgdata.add_contained_vals ("/d_yi", d_yi);
-
-            cgdata.add_contained_vals ("/d_ne", d_ne);
-            cgdata.add_contained_vals ("/d_nne", d_nne);
-            cgdata.add_contained_vals ("/d_nn", d_nn);
-            cgdata.add_contained_vals ("/d_nnw", d_nnw);
-            cgdata.add_contained_vals ("/d_nw", d_nw);
-            cgdata.add_contained_vals ("/d_nsw", d_nsw);
-            cgdata.add_contained_vals ("/d_ns", d_ns);
-            cgdata.add_contained_vals ("/d_nse", d_nse);
-
-            // vector<std::uint32_t>
-            cgdata.add_contained_vals ("/d_flags", d_flags);
-
-            // list<rect> rects
-            // for i in list, save rect
-            std::list<sm::rect>::const_iterator r = this->rects.begin();
-            std::uint32_t rcount = 0;
-            while (r != this->rects.end()) {
-                // Make up a path
-                std::string h5path = "/rects/" + std::to_string(rcount);
-                r->save (cgdata, h5path);
-                ++r;
-                ++rcount;
-            }
-            cgdata.add_val ("/rcount", rcount);
-
-            // What about vrects? Probably don't save and re-call method to populate.
-            this->renumber_vector_indices();
-
-            // What about brects? Probably re-run/test this->boundary_contiguous() on load.
-            this->boundary_contiguous();
+            this->d_dist_to_boundary.clear();
         }
 
         /*!
-         * Populate this cartgrid from the HDF5 file at the location \a path.
+         * Set the grid parameters, then rebuild this cartgrid from its d_ vectors, which must
+         * already hold a complete, consistent domain (as written by sm::cartgrid_save and read
+         * back by sm::cartgrid_load). In list storage, the rects are recreated in d_ vector
+         * order, with their neighbour relations taken directly from d_ne and friends, so the
+         * rebuild is O(N). brects is then repopulated by boundary_contiguous().
          */
-        void load (const std::string& path)
+        void rebuild_from_d_vectors (const float _d, const float _v, const float _x_span, const float _y_span,
+                                     const float _z, const bool _grid_reduced)
         {
-            sm::hdfdata cgdata (path, std::ios::in);
-            cgdata.read_val ("/d", this->d);
-            cgdata.read_val ("/v", this->v);
-            cgdata.read_val ("/x_span", this->x_span);
-            cgdata.read_val ("/y_span", this->y_span);
-            cgdata.read_val ("/z", this->z);
-            cgdata.read_val ("/d_growthbuffer_horz", this->d_growthbuffer_horz);
-            cgdata.read_val ("/d_growthbuffer_vert", this->d_growthbuffer_vert);
-
-            cgdata.read_contained_vals ("/boundary_centroid", this->boundary_centroid);
-            cgdata.read_contained_vals ("/d_x", this->d_x);
-            cgdata.read_contained_vals ("/d_y", this->d_y);
-            cgdata.read_contained_vals ("/d_dist_to_boundary", this->d_dist_to_boundary);
-            cgdata.read_contained_vals ("/d_xi", this->d_xi);
-            cgdata.read_contained_vals ("/d_yi", this->d_yi);
-            cgdata.read_contained_vals ("/d_ne", this->d_ne);
-            cgdata.read_contained_vals ("/d_nne", this->d_nne);
-            cgdata.read_contained_vals ("/d_nnw", this->d_nnw);
-            cgdata.read_contained_vals ("/d_nw", this->d_nw);
-            cgdata.read_contained_vals ("/d_nsw", this->d_nsw);
-            cgdata.read_contained_vals ("/d_nse", this->d_nse);
-            cgdata.read_contained_vals ("/d_flags", this->d_flags);
-
-            // Assume a boundary has been applied so set this true.
-            this->grid_reduced = true;
-
-            std::uint32_t rcount = 0;
-            cgdata.read_val ("/rcount", rcount);
-            for (std::uint32_t i = 0; i < rcount; ++i) {
-                std::string h5path = "/rects/" + std::to_string(i);
-                sm::rect r(cgdata, h5path);
-                this->rects.push_back (r);
-            }
-
-            // After creating rects list, need to set neighbour relations in each rect, as loaded in
-            // d_ne, etc.
-            for (sm::rect& _r : this->rects) {
-                // For each rect, six loops through rects:
-                if (_r.has_ne() == true) {
-                    bool matched = false;
-                    std::uint32_t neighb_it = (std::uint32_t) this->d_ne[_r.vi];
-                    std::list<sm::rect>::iterator ri = this->rects.begin();
-                    while (ri != this->rects.end()) {
-                        if (ri->vi == neighb_it) {
-                            matched = true;
-                            _r.ne = ri;
-                            break;
-                        }
-                        ++ri;
-                    }
-                    if (!matched) {
-                        throw std::runtime_error ("Failed to match rects neighbour E relation...");
-                    }
-                }
-
-                if (_r.has_nne() == true) {
-                    bool matched = false;
-                    std::uint32_t neighb_it = (std::uint32_t) this->d_nne[_r.vi];
-                    std::list<sm::rect>::iterator ri = this->rects.begin();
-                    while (ri != this->rects.end()) {
-                        if (ri->vi == neighb_it) {
-                            matched = true;
-                            _r.nne = ri;
-                            break;
-                        }
-                        ++ri;
-                    }
-                    if (!matched) {
-                        throw std::runtime_error ("Failed to match rects neighbour NE relation...");
-                    }
-                }
-
-                if (_r.has_nn() == true) {
-                    bool matched = false;
-                    std::uint32_t neighb_it = (std::uint32_t) this->d_nn[_r.vi];
-                    std::list<sm::rect>::iterator ri = this->rects.begin();
-                    while (ri != this->rects.end()) {
-                        if (ri->vi == neighb_it) {
-                            matched = true;
-                            _r.nn = ri;
-                            break;
-                        }
-                        ++ri;
-                    }
-                    if (!matched) {
-                        throw std::runtime_error ("Failed to match rects neighbour N relation...");
-                    }
-                }
+            const std::size_t n = this->d_x.size();
+            for (std::size_t sz : { this->d_y.size(), this->d_xi.size(), this->d_yi.size(), this->d_flags.size(),
+                                    this->d_dist_to_boundary.size(), this->d_ne.size(), this->d_nne.size(),
+                                    this->d_nn.size(), this->d_nnw.size(), this->d_nw.size(), this->d_nsw.size(),
+                                    this->d_ns.size(), this->d_nse.size() }) {
+                if (sz != n) { throw std::runtime_error ("cartgrid::rebuild_from_d_vectors: d_ vectors differ in size"); }
+            }
+            if (n == 0) { throw std::runtime_error ("cartgrid::rebuild_from_d_vectors: d_ vectors are empty"); }
+            if (this->storage == cartgridstorage::contiguous && this->domain_shape != griddomainshape::rectangle) {
+                throw std::runtime_error ("cartgrid: contiguous storage is only available with griddomainshape::rectangle");
+            }
 
-                if (_r.has_nnw() == true) {
-                    bool matched = false;
-                    std::uint32_t neighb_it = (std::uint32_t) this->d_nnw[_r.vi];
-                    std::list<sm::rect>::iterator ri = this->rects.begin();
-                    while (ri != this->rects.end()) {
-                        if (ri->vi == neighb_it) {
-                            matched = true;
-                            _r.nnw = ri;
-                            break;
-                        }
-                        ++ri;
-                    }
-                    if (!matched) {
-                        throw std::runtime_error ("Failed to match rects neighbour NW relation...");
-                    }
-                }
+            this->d = _d;
+            this->v = _v;
+            this->x_span = _x_span;
+            this->y_span = _y_span;
+            this->z = _z;
+            this->grid_reduced = _grid_reduced;
+            this->xi_minmax = sm::interval<std::int32_t>(this->d_xi[0], this->d_xi[n - 1]);
+            this->yi_minmax = sm::interval<std::int32_t>(this->d_yi[0], this->d_yi[n - 1]);
 
-                if (_r.has_nw() == true) {
-                    bool matched = false;
-                    std::uint32_t neighb_it = (std::uint32_t) this->d_nw[_r.vi];
-                    std::list<sm::rect>::iterator ri = this->rects.begin();
-                    while (ri != this->rects.end()) {
-                        if (ri->vi == neighb_it) {
-                            matched = true;
-                            _r.nw = ri;
-                            break;
-                        }
-                        ++ri;
-                    }
-                    if (!matched) {
-                        throw std::runtime_error ("Failed to match rects neighbour W relation...");
-                    }
-                }
+            this->rects.clear();
+            this->vrects.clear();
+            this->brects.clear();
+            if (this->storage == cartgridstorage::contiguous) { return; }
+
+            std::vector<std::list<rect>::iterator> its (n);
+            for (std::size_t i = 0; i < n; ++i) {
+                its[i] = this->rects.emplace (this->rects.end(), static_cast<std::uint32_t>(i), this->d, this->v, this->d_xi[i], this->d_yi[i]);
+                its[i]->di = static_cast<std::uint32_t>(i);
+                its[i]->dist_to_boundary = this->d_dist_to_boundary[i];
+                its[i]->set_flags (this->d_flags[i]);
+                this->vrects.push_back (&(*its[i]));
+            }
+            for (std::size_t i = 0; i < n; ++i) {
+                if (this->d_ne[i] >= 0) { its[i]->set_ne (its[this->d_ne[i]]); }
+                if (this->d_nne[i] >= 0) { its[i]->set_nne (its[this->d_nne[i]]); }
+                if (this->d_nn[i] >= 0) { its[i]->set_nn (its[this->d_nn[i]]); }
+                if (this->d_nnw[i] >= 0) { its[i]->set_nnw (its[this->d_nnw[i]]); }
+                if (this->d_nw[i] >= 0) { its[i]->set_nw (its[this->d_nw[i]]); }
+                if (this->d_nsw[i] >= 0) { its[i]->set_nsw (its[this->d_nsw[i]]); }
+                if (this->d_ns[i] >= 0) { its[i]->set_ns (its[this->d_ns[i]]); }
+                if (this->d_nse[i] >= 0) { its[i]->set_nse (its[this->d_nse[i]]); }
+            }
 
-                if (_r.has_nsw() == true) {
-                    bool matched = false;
-                    std::uint32_t neighb_it = (std::uint32_t) this->d_nsw[_r.vi];
-                    std::list<sm::rect>::iterator ri = this->rects.begin();
-                    while (ri != this->rects.end()) {
-                        if (ri->vi == neighb_it) {
-                            matched = true;
-                            _r.nsw = ri;
-                            break;
-                        }
-                        ++ri;
-                    }
-                    if (!matched) {
-                        throw std::runtime_error ("Failed to match rects neighbour SW relation...");
-                    }
-                }
+            this->boundary_contiguous();
+        }
 
-                if (_r.has_ns() == true) {
-                    bool matched = false;
-                    std::uint32_t neighb_it = (std::uint32_t) this->d_ns[_r.vi];
-                    std::list<sm::rect>::iterator ri = this->rects.begin();
-                    while (ri != this->rects.end()) {
-                        if (ri->vi == neighb_it) {
-                            matched = true;
-                            _r.ns = ri;
-                            break;
-                        }
-                        ++ri;
-                    }
-                    if (!matched) {
-                        throw std::runtime_error ("Failed to match rects neighbour S relation...");
-                    }
-                }
+        //! Has a boundary or domain been applied to the initial rectangular grid?
+        bool is_grid_reduced() const { return this->grid_reduced; }
 
-                if (_r.has_nse() == true) {
-                    bool matched = false;
-                    std::uint32_t neighb_it = (std::uint32_t) this->d_nse[_r.vi];
-                    std::list<sm::rect>::iterator ri = this->rects.begin();
-                    while (ri != this->rects.end()) {
-                        if (ri->vi == neighb_it) {
-                            matched = true;
-                            _r.nse = ri;
-                            break;
-                        }
-                        ++ri;
-                    }
-                    if (!matched) {
-                        throw std::runtime_error ("Failed to match rects neighbour SE relation...");
-                    }
-                }
-            }
-        }
-#endif // CARTGRID_COMPILE_LOAD_AND_SAVE
+        //! Get the z coordinate of this grid layer
+        float get_z() const { return this->z; }
 
         //! Default constructor creates symmetric grid centered about 0,0.
         cartgrid(): d(1.0f), v(1.0f), x_span(1.0f), y_span(1.0f), z(0.0f) {}
 
-#ifdef CARTGRID_COMPILE_LOAD_AND_SAVE
-        //! Construct then load from file.
-        cartgrid (const std::string& path) : d(1.0f), v(1.0f), x_span(1.0f), z(0.0f) { this->load (path); }
-#endif
-
         //! Construct the a symmetric, centered grid with a square element distance of \a d_ and
         //! square size length x_span. The number of elements will be computed. If x_ and x_span_ do
         //! not permit a symmetric, zero-centred grid to be created, an error will be thrown.
-        cartgrid (float d_, float x_span_, float z_ = 0.0f, griddomainshape shape = griddomainshape::rectangle)
-            : cartgrid (d_, d_, x_span_, x_span_, z_, shape) {}
+        cartgrid (float d_, float x_span_, float z_ = 0.0f, griddomainshape shape = griddomainshape::rectangle,
+                  cartgridstorage _storage = cartgridstorage::list)
+            : cartgrid (d_, d_, x_span_, x_span_, z_, shape, _storage) {}
 
         //! Construct a grid with rectangular element width d_, height v_ but still symmetric and
         //! centred. x_span_ is the distance from the centre of the left-most element to the centre
@@ -614,7 +517,8 @@ export namespace sm
         //! calculated based on d_, v_, x_span_ and y_span_. If the passed values do not permit a
         //! symmetric, zero-centred grid to be created an error will be thrown.
         cartgrid (float d_, float v_, float x_span_, float y_span_, float z_ = 0.0f,
-                  griddomainshape shape = griddomainshape::rectangle)
+                  griddomainshape shape = griddomainshape::rectangle,
+                  cartgridstorage _storage = cartgridstorage::list)
         {
             this->d = d_;
             this->v = v_;
@@ -622,6 +526,7 @@ export namespace sm
             this->y_span = y_span_;
             this->z = z_;
             this->domain_shape = shape;
+            this->storage = _storage;
 
             // Test we can make a symmetric grid, if not throw an error
             float half_x = this->x_span / 2.0f;
@@ -649,7 +554,8 @@ export namespace sm
         //! from these. This is a non-symmetric constructor.
         cartgrid (float d_, float v_, float x1, float y1, float x2, float y2, float z_ = 0.0f,
                   griddomainshape shape = griddomainshape::rectangle,
-                  griddomainwrap wrap = griddomainwrap::none)
+                  griddomainwrap wrap = griddomainwrap::none,
+                  cartgridstorage _storage = cartgridstorage::list)
         {
             if constexpr (debug_cartgrid) {
                 std::cout << "cartgrid constructor (x1,y1 to x2,y2 version) called. 0x" << (std::uint64_t)this << "\n";
@@ -661,6 +567,7 @@ export namespace sm
             this->z = z_;
             this->domain_shape = shape;
             this->domain_wrap = wrap;
+            this->storage = _storage;
 
             // init2 is the non-symmetic initialisation for making arbitrary rectangular grids.
             this->init2 (x1, y1, x2, y2);
@@ -715,37 +622,25 @@ export namespace sm
          */
         void set_boundary (const std::list<rect>& p_rects)
         {
+            this->require_list_storage ("set_boundary");
             this->boundary_centroid = this->compute_centroid (p_rects);
 
-            std::list<sm::rect>::iterator bpoint = this->rects.begin();
-            std::list<sm::rect>::iterator bpi = this->rects.begin();
-            while (bpi != this->rects.end()) {
-                std::list<sm::rect>::const_iterator ppi = p_rects.begin();
-                while (ppi != p_rects.end()) {
-                    // NB: The assumption right now is that the p_rects are from the same dimension grid
-                    // as this->rects.
-                    if (bpi->xi == ppi->xi && bpi->yi == ppi->yi) {
-                        // Set h as boundary rect.
-                        bpi->set_flag (RECT_IS_BOUNDARY | RECT_INSIDE_BOUNDARY);
-                        bpoint = bpi;
-                        break;
-                    }
-                    ++ppi;
-                }
-                ++bpi;
+            // NB: The assumption right now is that the p_rects are from the same dimension grid
+            // as this->rects. Each is found by its (xi, yi) in a lookup table, rather than by a search.
+            const index_table tbl = this->make_index_table();
+            for (const auto& pr : p_rects) {
+                std::list<sm::rect>::iterator bpi = tbl.at (pr.xi, pr.yi, this->rects.end());
+                if (bpi != this->rects.end()) { bpi->set_flag (RECT_IS_BOUNDARY | RECT_INSIDE_BOUNDARY); }
             }
 
             // Check that the boundary is contiguous.
-            std::set<std::uint32_t> seen;
-            std::list<sm::rect>::iterator ri = bpoint;
-            if (this->boundary_contiguous (bpoint, ri, seen, RECT_NEIGHBOUR_POS_E) == false) {
-                std::cout << "Uh oh\n";
+            if (this->boundary_contiguous() == false) {
                 throw std::runtime_error ("The boundary is not a contiguous sequence of rects.");
             }
 
             if (this->domain_shape == sm::griddomainshape::boundary) {
                 // Boundary IS contiguous, discard rects outside the boundary.
-                this->discard_outside_boundary();
+                this->discard_outside_boundary (tbl);
             } else {
                 throw std::runtime_error ("For now, set_boundary (const list<rect>& p_rects) doesn't know what to "
                                           "do if domain shape is not griddomainshape::boundary.");
@@ -802,6 +697,7 @@ export namespace sm
          */
         void set_boundary (std::vector<sm::bezcoord<float>>& bpoints, bool loffset = true)
         {
+            this->require_list_storage ("set_boundary");
             this->boundary_centroid = sm::bezcurvepath<float>::get_centroid (bpoints);
 
             auto bpi = bpoints.begin();
@@ -818,24 +714,15 @@ export namespace sm
                 bpi = bpoints.begin();
             }
 
-            // now proceed with centroid changed or unchanged
-            std::list<sm::rect>::iterator nearby_boundary_point = this->rects.begin(); // i.e the rect at 0,0
-            bpi = bpoints.begin();
-            while (bpi != bpoints.end()) {
-                nearby_boundary_point = this->set_boundary (*bpi++, nearby_boundary_point);
-            }
-
-            // Check that the boundary is contiguous.
-            {
-                std::set<std::uint32_t> seen;
-                std::list<sm::rect>::iterator hi = nearby_boundary_point;
-                if (this->boundary_contiguous (nearby_boundary_point, hi, seen, RECT_NEIGHBOUR_POS_E) == false) {
-                    throw std::runtime_error ("The constructed boundary is not a contiguous sequence of rectangular elements.");
-                }
+            // now proceed with centroid changed or unchanged. Mark the boundary rects (checking
+            // contiguity as we go), then find the interior and discard the rest.
+            const index_table tbl = this->make_index_table();
+            if (this->trace_boundary (bpoints, tbl, this->brects) == false) {
+                throw std::runtime_error ("The constructed boundary is not a contiguous sequence of rects.");
             }
 
             if (this->domain_shape == sm::griddomainshape::boundary) {
-                this->discard_outside_boundary();
+                this->discard_outside_boundary (tbl, &bpoints);
                 this->populate_d_vectors();
             } else {
                 throw std::runtime_error ("Use griddomainshape::boundary when setting a boundary");
@@ -857,6 +744,7 @@ export namespace sm
                                 sm::cartgrid& cg_polar, sm::vvec<float>& polar_data,
                                 sm::vec<float, 2> view_pos, float view_angle, sm::scaling_function radscale = sm::scaling_function::linear)
         {
+            this->require_list_storage ("resample_to_polar");
             polar_data.zero();
 
             // distance per pixel in the image. This defines the Gaussian width (sigma) for the resample:
@@ -937,6 +825,7 @@ export namespace sm
          */
         void set_boundary_only (std::vector<sm::bezcoord<float>>& bpoints, bool loffset)
         {
+            this->require_list_storage ("set_boundary_only");
             this->boundary_centroid = sm::bezcurvepath<float>::get_centroid (bpoints);
 
             auto bpi = bpoints.begin();
@@ -954,21 +843,10 @@ export namespace sm
             }
 
             // now proceed with centroid changed or unchanged. First: clear all boundary flags
-            for (auto r : this->rects) { r.unset_user_flag (RECT_IS_BOUNDARY); }
+            for (auto& r : this->rects) { r.unset_flag (RECT_IS_BOUNDARY); }
 
-            std::list<sm::rect>::iterator nearby_boundary_point = this->rects.begin(); // i.e the rect at 0,0
-            bpi = bpoints.begin();
-            while (bpi != bpoints.end()) {
-                nearby_boundary_point = this->set_boundary (*bpi++, nearby_boundary_point);
-            }
-
-            // Check that the boundary is contiguous.
-            {
-                std::set<std::uint32_t> seen;
-                std::list<sm::rect>::iterator ri = nearby_boundary_point;
-                if (this->boundary_contiguous (nearby_boundary_point, ri, seen, RECT_NEIGHBOUR_POS_E) == false) {
-                    throw std::runtime_error ("The constructed boundary is not a contiguous sequence of rects.");
-                }
+            if (this->trace_boundary (bpoints, this->make_index_table(), this->brects) == false) {
+                throw std::runtime_error ("The constructed boundary is not a contiguous sequence of rects.");
             }
         }
 
@@ -982,6 +860,16 @@ export namespace sm
         static constexpr bool debug_set_boundary = false;
         void set_boundary_on_outer_edge()
         {
+            if (this->storage == cartgridstorage::contiguous) {
+                // The outer edge is known from the element indices
+                for (std::uint32_t i = 0; i < this->num(); ++i) {
+                    if (this->d_xi[i] == this->xi_minmax.min || this->d_xi[i] == this->xi_minmax.max
+                        || this->d_yi[i] == this->yi_minmax.min || this->d_yi[i] == this->yi_minmax.max) {
+                        this->d_flags[i] |= (RECT_IS_BOUNDARY | RECT_INSIDE_BOUNDARY);
+                    }
+                }
+                return;
+            }
             // From centre head to boundary, then mark boundary and walk
             // around the edge.
             std::list<sm::rect>::iterator bpi = this->rects.begin();
@@ -1023,15 +911,13 @@ export namespace sm
 
             // Check that the boundary is contiguous, starting from SW corner and
             // heading E (to go anticlockwise)
-            std::set<std::uint32_t> seen;
-            std::list<sm::rect>::iterator ri = bpi;
-            if (this->boundary_contiguous (bpi, ri, seen, RECT_NEIGHBOUR_POS_E) == false) {
+            if (this->boundary_contiguous (bpi) == false) {
                 throw std::runtime_error ("The boundary is not a contiguous sequence of rects.");
             }
 
             if (this->domain_shape == sm::griddomainshape::boundary) {
                 // Boundary IS contiguous, discard rects outside the boundary.
-                this->discard_outside_boundary();
+                this->discard_outside_boundary (this->make_index_table());
             }
 
             this->populate_d_vectors();
@@ -1141,14 +1027,20 @@ export namespace sm
          *
          * return The number of rects in the grid.
          */
-        std::uint32_t num() const { return this->rects.size(); }
+        std::uint32_t num() const
+        {
+            return this->storage == cartgridstorage::contiguous ? this->d_x.size() : this->rects.size();
+        }
 
         /*!
          * \brief Obtain the vector index of the last rect in rects.
          *
          * return rect::vi from the last rect in the grid.
          */
-        std::uint32_t last_vector_index() const { return this->rects.rbegin()->vi; }
+        std::uint32_t last_vector_index() const
+        {
+            return this->storage == cartgridstorage::contiguous ? this->d_x.size() - 1u : this->rects.rbegin()->vi;
+        }
 
         /*!
          * Output some text information about the hexgrid.
@@ -1156,6 +1048,14 @@ export namespace sm
         std::string output() const
         {
             std::stringstream ss;
+            if (this->storage == cartgridstorage::contiguous) {
+                ss << "rect grid with " << this->num() << " rects (contiguous storage):\n";
+                for (std::uint32_t i = 0; i < this->num(); ++i) {
+                    ss << "rect " << i << " (" << this->d_xi[i] << "," << this->d_yi[i] << ") at ("
+                       << this->d_x[i] << "," << this->d_y[i] << ")" << std::endl;
+                }
+                return ss.str();
+            }
             ss << "rect grid with " << this->rects.size() << " rects:\n";
             auto i = this->rects.begin();
             while (i != this->rects.end()) {
@@ -1297,6 +1197,7 @@ export namespace sm
          */
         void compute_distance_to_boundary()
         {
+            this->require_list_storage ("compute_distance_to_boundary");
             std::list<sm::rect>::iterator r = this->rects.begin();
             while (r != this->rects.end()) {
                 if (r->test_flags(RECT_IS_BOUNDARY) == true) {
@@ -1341,6 +1242,9 @@ export namespace sm
          */
         void populate_d_vectors (const std::array<std::int32_t, 4>& extnts)
         {
+            // In contiguous storage, the d_ vectors are the only copy of the grid and are always populated
+            if (this->storage == cartgridstorage::contiguous) { return; }
+
             // A rectangle iterator
             std::list<sm::rect>::iterator ri = this->rects.begin();
             // Bottom left rectangle
@@ -1442,6 +1346,7 @@ export namespace sm
                                                            sm::vec<float, 2>& region_centroid,
                                                            bool apply_original_boundary_centroid = true)
         {
+            this->require_list_storage ("get_region");
             // First clear all region boundary flags, as we'll be defining a new region boundary
             this->clear_region_boundary_flags();
 
@@ -1462,28 +1367,20 @@ export namespace sm
                 region_centroid -= this->original_boundary_centroid;
             }
 
-            // Now find the rects on the boundary of the region
-            std::list<sm::rect>::iterator nearby_region_boundary_point = this->rects.begin(); // i.e the rect at 0,0
-            typename std::vector<sm::bezcoord<float>>::iterator bpi = bpoints.begin();
-            while (bpi != bpoints.end()) {
-                nearby_region_boundary_point = this->set_region_boundary (*bpi++, nearby_region_boundary_point);
+            // Now find the rects on the boundary of the region, checking that they are contiguous
+            std::list<const sm::rect*> region_brects;
+            if (this->trace_boundary (bpoints, this->make_index_table(), region_brects,
+                                      RECT_IS_REGION_BOUNDARY, RECT_INSIDE_REGION) == false) {
+                return the_region;
             }
 
-            // Check that the region boundary is contiguous.
-            {
-                std::set<std::uint32_t> seen;
-                std::list<sm::rect>::iterator hi = nearby_region_boundary_point;
-                if (this->region_boundary_contiguous (nearby_region_boundary_point, hi, seen) == false) {
-                    std::stringstream ee;
-                    ee << "The constructed region boundary is not a contiguous sequence of rects.";
-                    return the_region;
-                }
+            // Mark rects inside region by testing all the rect centres against the region path at once
+            std::vector<std::uint8_t> inside;
+            this->classify_centres (sm::polygon_index<float>(bpoints), inside);
+            for (auto& rr : this->rects) {
+                if (inside[rr.vi]) { rr.set_flag (RECT_INSIDE_REGION); }
             }
 
-            // Mark rects inside region. Use centroid of the region.
-            std::list<sm::rect>::iterator inside_region_rect = this->find_rect_nearest (region_centroid);
-            this->mark_rects_inside (inside_region_rect, RECT_IS_REGION_BOUNDARY, RECT_INSIDE_REGION);
-
             // Populate the_region, then return it
             std::list<sm::rect>::iterator hi = this->rects.begin();
             while (hi != this->rects.end()) {
@@ -1517,38 +1414,220 @@ export namespace sm
         template<typename T>
         void oncentre_offsurround (const std::vector<T>& data, std::vector<T>& result) const
         {
-            if (result.size() != this->rects.size()) {
-                throw std::runtime_error ("The result vector is not the same size as the cartgrid.");
-            }
-            if (result.size() != data.size()) {
-                throw std::runtime_error ("The data vector is not the same size as the cartgrid.");
-            }
-            if (&data == &result) {
-                throw std::runtime_error ("Pass in separate memory for the result.");
-            }
-            // For each rect in this cartgrid, compute the convolution kernel
-            for (std::list<rect>::const_iterator ri = this->rects.cbegin(); ri != this->rects.cend(); ++ri) {
-                result[ri->vi] = data[ri->vi]; // The 'on' part of the filter
-                T count = T{0};
-                T offpart = T{0};
-                offpart += ri->has_ne()  ? count+=T{1}, data[ri->ne->vi]  : T{0};
-                offpart += ri->has_nne() ? count+=T{1}, data[ri->nne->vi] : T{0};
-                offpart += ri->has_nn()  ? count+=T{1}, data[ri->nn->vi]  : T{0};
-                offpart += ri->has_nnw() ? count+=T{1}, data[ri->nnw->vi] : T{0};
-                offpart += ri->has_nw()  ? count+=T{1}, data[ri->nw->vi]  : T{0};
-                offpart += ri->has_nsw() ? count+=T{1}, data[ri->nsw->vi] : T{0};
-                offpart += ri->has_ns()  ? count+=T{1}, data[ri->ns->vi]  : T{0};
-                offpart += ri->has_nse() ? count+=T{1}, data[ri->nse->vi] : T{0};
-                //std::cout << "subtract " << offpart << "/" << count << std::endl;
-                result[ri->vi] -= offpart / count;
-            }
+            this->check_filter_args (data, result);
+            const std::array<const std::int32_t*, 8> nbrs = this->neighbour_arrays();
+            this->apply_3x3 (
+                [&data, &result](const std::int32_t i0, const std::int32_t len, const std::int32_t w)
+                {
+                    const T* c = data.data() + i0;
+                    const T* nr = c + w;
+                    const T* sr = c - w;
+                    T* out = result.data() + i0;
+                    for (std::int32_t k = 0; k < len; ++k) {
+                        const T offpart = c[k + 1] + nr[k + 1] + nr[k] + nr[k - 1] + c[k - 1] + sr[k - 1] + sr[k] + sr[k + 1];
+                        out[k] = c[k] - offpart / T{8};
+                    }
+                },
+                [this, &nbrs, &data, &result](const std::int32_t i)
+                {
+                    T offpart = T{0};
+                    for (const std::int32_t* nb : nbrs) {
+                        if (nb[i] >= 0) { offpart += data[nb[i]]; }
+                    }
+                    // The number of neighbours is given by the neighbour bits in d_flags
+                    const int count = std::popcount (this->d_flags[i] & RECT_HAS_NEIGHB_ALL);
+                    // The 'on' part of the filter, less the 'off' part
+                    result[i] = count > 0 ? data[i] - offpart / static_cast<T>(count) : data[i];
+                });
+        }
+
+        /*!
+         * Compute the five point Laplacian of data, (E + W - 2C) / d^2 + (N + S - 2C) / v^2. At
+         * the edges, the missing neighbours are omitted along with one of the 2C terms for
+         * each, which is a zero-flux (Neumann) boundary condition.
+         */
+        template<typename T>
+        void laplacian (const std::vector<T>& data, std::vector<T>& result) const
+        {
+            static_assert (std::is_floating_point_v<T>, "cartgrid::laplacian requires floating point data");
+            this->check_filter_args (data, result);
+            const T idx2 = T{1} / (static_cast<T>(this->d) * static_cast<T>(this->d));
+            const T idy2 = T{1} / (static_cast<T>(this->v) * static_cast<T>(this->v));
+            this->apply_3x3 (
+                [&data, &result, idx2, idy2](const std::int32_t i0, const std::int32_t len, const std::int32_t w)
+                {
+                    const T* c = data.data() + i0;
+                    const T* nr = c + w;
+                    const T* sr = c - w;
+                    T* out = result.data() + i0;
+                    for (std::int32_t k = 0; k < len; ++k) {
+                        out[k] = (c[k + 1] + c[k - 1] - T{2} * c[k]) * idx2 + (nr[k] + sr[k] - T{2} * c[k]) * idy2;
+                    }
+                },
+                [this, &data, &result, idx2, idy2](const std::int32_t i)
+                {
+                    const std::uint32_t f = this->d_flags[i];
+                    const T cx = static_cast<T>(std::popcount (f & (RECT_HAS_NE | RECT_HAS_NW)));
+                    const T cy = static_cast<T>(std::popcount (f & (RECT_HAS_NN | RECT_HAS_NS)));
+                    T sx = T{0};
+                    T sy = T{0};
+                    if (this->d_ne[i] >= 0) { sx += data[this->d_ne[i]]; }
+                    if (this->d_nw[i] >= 0) { sx += data[this->d_nw[i]]; }
+                    if (this->d_nn[i] >= 0) { sy += data[this->d_nn[i]]; }
+                    if (this->d_ns[i] >= 0) { sy += data[this->d_ns[i]]; }
+                    result[i] = (sx - cx * data[i]) * idx2 + (sy - cy * data[i]) * idy2;
+                });
+        }
+
+        /*!
+         * The adjacency matrix of the rects, indexed like the d_ vectors: element (i, j) is 1
+         * if rect j is a neighbour of rect i to the E, N, W or S (d_ne, d_nn, d_nw, d_ns), or
+         * also a diagonal neighbour if diagonals is true.
+         */
+        template<typename T = float>
+        sm::csr<T> adjacency_matrix (const bool diagonals = false) const
+        {
+            this->check_d_neighbours();
+            const std::array<const std::int32_t*, 8> nbrs = this->neighbour_arrays();
+            return sm::csr<T>::template from_rows<8> (
+                this->num(),
+                [&nbrs, diagonals](const std::uint32_t i, std::uint32_t* c, T* v)
+                {
+                    std::uint32_t m = 0;
+                    // neighbour_arrays alternates the four sides with the four diagonals
+                    for (std::uint32_t k = 0; k < 8u; k += (diagonals ? 1u : 2u)) {
+                        if (nbrs[k][i] >= 0) {
+                            c[m] = static_cast<std::uint32_t>(nbrs[k][i]);
+                            v[m++] = T{1};
+                        }
+                    }
+                    return m;
+                });
+        }
+
+        /*!
+         * The matrix L of the five point Laplacian, indexed like the d_ vectors, so that L u
+         * is laplacian(u) (to within rounding) when bc is neumann. With bc dirichlet, rects
+         * beyond the edge of the domain are taken to hold 0. L is symmetric and negative
+         * (semi-)definite, so I - D dt L (see csr::identity_plus) can be solved with
+         * sm::conjugate_gradient for an implicit diffusion step.
+         */
+        template<typename T = float>
+        sm::csr<T> laplacian_matrix (const sm::boundary_condition bc = sm::boundary_condition::neumann) const
+        {
+            this->check_d_neighbours();
+            const T idx2 = T{1} / (static_cast<T>(this->d) * static_cast<T>(this->d));
+            const T idy2 = T{1} / (static_cast<T>(this->v) * static_cast<T>(this->v));
+            const bool neumann = bc == sm::boundary_condition::neumann;
+            return sm::csr<T>::template from_rows<5> (
+                this->num(),
+                [this, idx2, idy2, neumann](const std::uint32_t i, std::uint32_t* c, T* v)
+                {
+                    std::uint32_t m = 0;
+                    T diag = T{0};
+                    auto link = [&](const std::int32_t nb, const T w)
+                    {
+                        if (nb >= 0) {
+                            c[m] = static_cast<std::uint32_t>(nb);
+                            v[m++] = w;
+                            diag -= w;
+                        } else if (!neumann) {
+                            diag -= w;
+                        }
+                    };
+                    link (this->d_ne[i], idx2);
+                    link (this->d_nw[i], idx2);
+                    link (this->d_nn[i], idy2);
+                    link (this->d_ns[i], idy2);
+                    c[m] = i;
+                    v[m] = diag;
+                    return m + 1u;
+                });
+        }
+
+        /*!
+         * Estimate the gradient of data with the 3x3 Sobel operator, placing the x component in
+         * gx and the y component in gy. The Sobel sums are divided by 8d (or 8v) so that the
+         * results are gradients in units of data per unit distance. A missing neighbour at an
+         * edge takes the value of the central element.
+         */
+        template<typename T>
+        void sobel (const std::vector<T>& data, std::vector<T>& gx, std::vector<T>& gy) const
+        {
+            static_assert (std::is_floating_point_v<T>, "cartgrid::sobel requires floating point data");
+            this->check_filter_args (data, gx);
+            this->check_filter_args (data, gy);
+            const T sx = T{1} / (T{8} * static_cast<T>(this->d));
+            const T sy = T{1} / (T{8} * static_cast<T>(this->v));
+            this->apply_3x3 (
+                [&data, &gx, &gy, sx, sy](const std::int32_t i0, const std::int32_t len, const std::int32_t w)
+                {
+                    const T* c = data.data() + i0;
+                    const T* nr = c + w;
+                    const T* sr = c - w;
+                    T* ox = gx.data() + i0;
+                    T* oy = gy.data() + i0;
+                    for (std::int32_t k = 0; k < len; ++k) {
+                        ox[k] = ((nr[k + 1] + T{2} * c[k + 1] + sr[k + 1]) - (nr[k - 1] + T{2} * c[k - 1] + sr[k - 1])) * sx;
+                        oy[k] = ((nr[k - 1] + T{2} * nr[k] + nr[k + 1]) - (sr[k - 1] + T{2} * sr[k] + sr[k + 1])) * sy;
+                    }
+                },
+                [this, &data, &gx, &gy, sx, sy](const std::int32_t i)
+                {
+                    auto val = [&data, i](const std::int32_t nb) { return nb >= 0 ? data[nb] : data[i]; };
+                    const T e = val (this->d_ne[i]);
+                    const T ne = val (this->d_nne[i]);
+                    const T n = val (this->d_nn[i]);
+                    const T nw = val (this->d_nnw[i]);
+                    const T w = val (this->d_nw[i]);
+                    const T sw = val (this->d_nsw[i]);
+                    const T s = val (this->d_ns[i]);
+                    const T se = val (this->d_nse[i]);
+                    gx[i] = ((ne + T{2} * e + se) - (nw + T{2} * w + sw)) * sx;
+                    gy[i] = ((nw + T{2} * n + ne) - (sw + T{2} * s + se)) * sy;
+                });
+        }
+
+        /*!
+         * Apply a 3x3 median filter. Each result is the median of the element and its (up to
+         * 8) neighbours. Where there is an even number of values (at edges), the upper of the
+         * two middle values is chosen.
+         */
+        template<typename T>
+        void median3x3 (const std::vector<T>& data, std::vector<T>& result) const
+        {
+            this->check_filter_args (data, result);
+            const std::array<const std::int32_t*, 8> nbrs = this->neighbour_arrays();
+            this->apply_3x3 (
+                [&data, &result](const std::int32_t i0, const std::int32_t len, const std::int32_t w)
+                {
+                    const T* c = data.data() + i0;
+                    const T* nr = c + w;
+                    const T* sr = c - w;
+                    T* out = result.data() + i0;
+                    for (std::int32_t k = 0; k < len; ++k) {
+                        std::array<T, 9> p = { sr[k - 1], sr[k], sr[k + 1], c[k - 1], c[k], c[k + 1], nr[k - 1], nr[k], nr[k + 1] };
+                        out[k] = cartgrid::median_of_9 (p);
+                    }
+                },
+                [&nbrs, &data, &result](const std::int32_t i)
+                {
+                    std::array<T, 9> p;
+                    p[0] = data[i];
+                    std::size_t m = 1;
+                    for (const std::int32_t* nb : nbrs) {
+                        if (nb[i] >= 0) { p[m++] = data[nb[i]]; }
+                    }
+                    std::nth_element (p.begin(), p.begin() + m / 2, p.begin() + m);
+                    result[i] = p[m / 2];
+                });
         }
 
         //! Apply a box filter. SLOOOOOW algorithm.
         template<typename T, bool onlysum=false>
-        void boxfilter (const std::vector<T>& data, std::vector<T>& result, const std::uint32_t boxside)
+        void boxfilter (const std::vector<T>& data, std::vector<T>& result, const std::uint32_t boxside) const
         {
-            if (result.size() != this->rects.size()) {
+            if (result.size() != this->num()) {
                 throw std::runtime_error ("The result vector is not the same size as the cartgrid.");
             }
             if (result.size() != data.size()) {
@@ -1568,58 +1647,60 @@ export namespace sm
             std::uint32_t pos_steps = boxside%2==0 ? (boxside/2) : (boxside-1)/2;
             T oneover_boxa = T{1} / (static_cast<T>(boxside) * static_cast<T>(boxside)); // 1/ square box area
 
-            // Now can go through the rects
-            std::list<rect>::iterator ri = this->rects.begin();
-            for (; ri != this->rects.end(); ++ri) {
-                // On each rect, sum up the contributions from neighbours. This is a
+            // Now can go through the elements
+            const std::int32_t n = static_cast<std::int32_t>(this->num());
+#pragma omp parallel for
+            for (std::int32_t i = 0; i < n; ++i) {
+                // On each element, sum up the contributions from neighbours. This is a
                 // naive, slow, but easy to code algorithm. It can be a bit faster if
                 // you keep a track of the sum in the box filter.
-                std::list<rect>::iterator ri_col = ri;
-                std::list<rect>::iterator ri_row = ri;
+                std::int32_t i_row = i;
 
                 // First step down to a starting point, without summing
                 std::uint32_t act_neg_steps = 0;
-                for (std::uint32_t i = 0; i < neg_steps; ++i) {
-                    if (ri_row->has_ns()) {
-                        ri_row = ri_row->ns;
+                for (std::uint32_t k = 0; k < neg_steps; ++k) {
+                    if (this->d_ns[i_row] >= 0) {
+                        i_row = this->d_ns[i_row];
                         ++act_neg_steps;
                     }
                 }
 
-                result[ri->vi] = T{0};
+                T sum = T{0};
 
                 // Should now be at the bottom of the square.
                 for (std::uint32_t j = 0; j < (act_neg_steps + 1 + pos_steps); ++j) {
 
-                    ri_col = ri_row; // middle of row
+                    std::int32_t i_col = i_row; // middle of row
 
-                    result[ri->vi] += data[ri_col->vi]; // add value of middle pixel in row
+                    sum += data[i_col]; // add value of middle pixel in row
 
                     // Step left neg_steps, first, summing
-                    for (std::uint32_t i = 0; i < neg_steps; ++i) {
-                        if (ri_col->has_nw()) { // May wrap, that's ok
-                            ri_col = ri_col->nw;
-                            result[ri->vi] += data[ri_col->vi];
+                    for (std::uint32_t k = 0; k < neg_steps; ++k) {
+                        if (this->d_nw[i_col] >= 0) { // May wrap, that's ok
+                            i_col = this->d_nw[i_col];
+                            sum += data[i_col];
                         } // else nothing to add.
                     }
                     // Step right pos_steps, summing
-                    ri_col = ri_row; // back to middle
-                    for (std::uint32_t i = 0; i < pos_steps; ++i) {
-                        if (ri_col->has_ne()) {
-                            ri_col = ri_col->ne;
-                            result[ri->vi] += data[ri_col->vi];
+                    i_col = i_row; // back to middle
+                    for (std::uint32_t k = 0; k < pos_steps; ++k) {
+                        if (this->d_ne[i_col] >= 0) {
+                            i_col = this->d_ne[i_col];
+                            sum += data[i_col];
                         }
                     }
 
-                    if (ri_row->has_nn()) {
-                        ri_row = ri_row->nn;
+                    if (this->d_nn[i_row] >= 0) {
+                        i_row = this->d_nn[i_row];
                     } else {
                         break;
                     }
                 }
 
                 if constexpr (onlysum == false) {
-                    result[ri->vi] *= oneover_boxa;
+                    result[i] = sum * oneover_boxa;
+                } else {
+                    result[i] = sum;
                 }
             }
         }
@@ -1628,7 +1709,7 @@ export namespace sm
         template<typename T, std::int32_t boxside, bool onlysum = false>
         void boxfilter_f (const sm::vvec<T>& data, sm::vvec<T>& result) const
         {
-            if (result.size() != this->rects.size()) {
+            if (result.size() != this->num()) {
                 throw std::runtime_error ("The result vector is not the same size as the cartgrid.");
             }
             if (this->domain_shape != griddomainshape::rectangle) {
@@ -1652,9 +1733,9 @@ export namespace sm
          */
         template<typename T>
         void convolve (const cartgrid& kernelgrid, const std::vector<T>& kerneldata,
-                       const std::vector<T>& data, std::vector<T>& result)
+                       const std::vector<T>& data, std::vector<T>& result) const
         {
-            if (result.size() != this->rects.size()) {
+            if (result.size() != this->num()) {
                 throw std::runtime_error ("The result vector is not the same size as the cartgrid.");
             }
             if (result.size() != data.size()) {
@@ -1668,56 +1749,61 @@ export namespace sm
                 throw std::runtime_error ("Pass in separate memory for the result.");
             }
 
-            // For each rect in this cartgrid, compute the convolution kernel
-            std::list<rect>::iterator ri = this->rects.begin();
+            if (kerneldata.size() != kernelgrid.num()) {
+                throw std::runtime_error ("The kernel data vector is not the same size as the kernel cartgrid.");
+            }
+
+            // A complete rectangle can be convolved with dense (separable, direct or FFT) methods
+            if (this->is_complete_rectangle()) {
+                this->convolve_rectangle (kernelgrid, kerneldata, data, result);
+                return;
+            }
 
-            for (; ri != this->rects.end(); ++ri) {
+            // For each element in this cartgrid, compute the convolution kernel
+            const std::int32_t n = static_cast<std::int32_t>(this->num());
+            const std::int32_t nk = static_cast<std::int32_t>(kernelgrid.num());
+#pragma omp parallel for
+            for (std::int32_t i = 0; i < n; ++i) {
                 T sum = T{0};
-                // For each kernel rect, sum up.
-                for (auto kr : kernelgrid.rects) {
-                    std::list<rect>::iterator dri = ri;
-                    std::int32_t xx = kr.xi;
-                    std::int32_t yy = kr.yi;
+                // For each kernel element, sum up.
+                for (std::int32_t k = 0; k < nk; ++k) {
+                    std::int32_t di = i;
+                    std::int32_t xx = kernelgrid.d_xi[k];
+                    std::int32_t yy = kernelgrid.d_yi[k];
                     bool failed = false;
-                    bool finished = false;
 
-                    while (!finished) {
+                    while (xx != 0 || yy != 0) {
                         bool moved = false;
                         // Try to move in x direction
-                        if (xx > 0) { // Then kernel rect is to right of 0, so relevant rect on Cartgrid is to east
-                            if (dri->has_ne()) {
-                                dri = dri->ne;
+                        if (xx > 0) { // Then kernel element is to right of 0, so relevant element on cartgrid is to east
+                            if (this->d_ne[di] >= 0) {
+                                di = this->d_ne[di];
                                 --xx;
                                 moved = true;
                             } // Didn't move in +x direction
                         } else if (xx < 0) {
-                            if (dri->has_nw()) {
-                                dri = dri->nw;
+                            if (this->d_nw[di] >= 0) {
+                                di = this->d_nw[di];
                                 ++xx;
                                 moved = true;
                             } // Didn't move in -x direction
                         }
                         // Try to move in y direction
                         if (yy > 0) {
-                            if (dri->has_nn()) {
-                                dri = dri->nn;
+                            if (this->d_nn[di] >= 0) {
+                                di = this->d_nn[di];
                                 --yy;
                                 moved = true;
                             } // Didn't move in +y direction
                         } else if (yy < 0) {
-                            if (dri->has_ns()) {
-                                dri = dri->ns;
+                            if (this->d_ns[di] >= 0) {
+                                di = this->d_ns[di];
                                 ++yy;
                                 moved = true;
                             } // Didn't move in -y direction
                         }
 
-                        if (xx == 0 && yy == 0) {
-                            finished = true;
-                            break;
-                        }
-
-                        if (!moved) {
+                        if (!moved && (xx != 0 || yy != 0)) {
                             // We're stuck; Can't move in x or y direction, so can't add a contribution
                             failed = true;
                             break;
@@ -1726,14 +1812,55 @@ export namespace sm
 
                     if (!failed) {
                         // Can do the sum
-                        sum +=  data[dri->vi] * kerneldata[kr.vi];
+                        sum += data[di] * kerneldata[k];
                     }
                 }
 
-                result[ri->vi] = sum;
+                result[i] = sum;
             }
         }
 
+        /*!
+         * Convolve data with a separable kernel whose 2D form is the outer product
+         * kernel_y (x) kernel_x, returning the result in \a result. Both kernels must have an
+         * odd number of elements; the centre element of each has offset 0. As in convolve(), the
+         * kernel is not flipped, elements beyond a non-wrapped edge contribute zero and x wraps
+         * if domain_wrap is horizontal (or both). This cartgrid must be a complete rectangle.
+         */
+        template<typename T>
+        void convolve_separable (const std::vector<T>& kernel_x, const std::vector<T>& kernel_y,
+                                 const std::vector<T>& data, std::vector<T>& result) const
+        {
+            if (!this->is_complete_rectangle()) {
+                throw std::runtime_error ("cartgrid::convolve_separable requires a complete, rectangular cartgrid");
+            }
+            if (kernel_x.size() % 2 == 0 || kernel_y.size() % 2 == 0) {
+                throw std::runtime_error ("cartgrid::convolve_separable: kernels must have an odd number of elements");
+            }
+            if (data.size() != this->num() || result.size() != this->num()) {
+                throw std::runtime_error ("The data and result vectors must be the same size as the cartgrid.");
+            }
+            if (&data == &result) {
+                throw std::runtime_error ("Pass in separate memory for the result.");
+            }
+            const std::int32_t kx0 = -static_cast<std::int32_t>(kernel_x.size() / 2);
+            const std::int32_t ky0 = -static_cast<std::int32_t>(kernel_y.size() / 2);
+            std::fill (result.begin(), result.end(), T{0});
+            this->add_separable_term (kernel_x, kx0, kernel_y, ky0, data, result);
+        }
+
+        //! True if the elements form a complete w by h rectangle, stored row by row from the bottom left
+        bool is_complete_rectangle() const
+        {
+            if (this->domain_shape != griddomainshape::rectangle || this->d_xi.empty()) { return false; }
+            const std::size_t w = static_cast<std::size_t>(this->xi_minmax.span() + 1);
+            const std::size_t h = static_cast<std::size_t>(this->yi_minmax.span() + 1);
+            const std::size_t n = this->d_xi.size();
+            return n == w * h && n == this->num()
+            && this->d_xi[0] == this->xi_minmax.min && this->d_yi[0] == this->yi_minmax.min
+            && this->d_xi[n - 1] == this->xi_minmax.max && this->d_yi[n - 1] == this->yi_minmax.max;
+        }
+
         /*!
          * What shape domain to set? Set this to the non-default BEFORE calling
          * cartgrid::set_boundary (const bezcurvepath& p) - that's where the domain_shape
@@ -1744,6 +1871,17 @@ export namespace sm
         //! Edge wrapping? none, horizontal, vertical or both.
         griddomainwrap domain_wrap = griddomainwrap::none;
 
+        /*!
+         * How are the elements stored? With cartgridstorage::list (the default), there is an
+         * sm::rect for each element in rects, and the d_ vectors are populated from them. With
+         * cartgridstorage::contiguous, no rects are created; the elements exist only in the d_
+         * vectors, with neighbours given by the int32 indices in d_ne, d_nn, etc. This is much
+         * faster to construct and uses a fraction of the memory for large grids, but only
+         * rectangular domains are possible: the set_boundary methods, get_region and the other
+         * methods that need rects will throw. Set via the constructor (or before calling init()).
+         */
+        cartgridstorage storage = cartgridstorage::list;
+
         /*!
          * The list of rects that make up this cartgrid.
          */
@@ -1776,7 +1914,336 @@ export namespace sm
          */
         sm::vec<float, 2> original_boundary_centroid = { 0.0f, 0.0f };
 
+        /*!
+         * How set_boundary() finds the rects inside a boundary. The default,
+         * boundaryfill::flood, fills outwards from the rect nearest the boundary
+         * centroid. boundaryfill::scanline keeps the rects whose centres lie inside the
+         * boundary polygon, processing rows in parallel; use it for boundaries whose
+         * centroid may lie outside the enclosed region.
+         */
+        sm::boundaryfill boundary_fill = sm::boundaryfill::flood;
+
     private:
+        //! The eight neighbour index arrays, in the order E, NE, N, NW, W, SW, S, SE
+        std::array<const std::int32_t*, 8> neighbour_arrays() const
+        {
+            return {
+                this->d_ne.data(), this->d_nne.data(), this->d_nn.data(), this->d_nnw.data(),
+                this->d_nw.data(), this->d_nsw.data(), this->d_ns.data(), this->d_nse.data()
+            };
+        }
+
+        //! Throw if the d_ neighbour vectors have not been built
+        void check_d_neighbours() const
+        {
+            if (this->d_ne.size() != this->num() || this->d_nn.size() != this->num()) {
+                throw std::runtime_error ("The cartgrid d_ vectors are not populated. Call populate_d_vectors() first.");
+            }
+        }
+
+        //! Common argument checks for the neighbourhood filters
+        template<typename T>
+        void check_filter_args (const std::vector<T>& data, const std::vector<T>& result) const
+        {
+            if (result.size() != this->num()) {
+                throw std::runtime_error ("The result vector is not the same size as the cartgrid.");
+            }
+            if (result.size() != data.size()) {
+                throw std::runtime_error ("The data vector is not the same size as the cartgrid.");
+            }
+            if (&data == &result) {
+                throw std::runtime_error ("Pass in separate memory for the result.");
+            }
+        }
+
+        /*!
+         * Run a 3x3 neighbourhood filter over every element. If this cartgrid is a complete
+         * rectangle of at least 3x3 elements, interior_row (i0, len, w) is called for each row of
+         * len interior elements starting at index i0, whose neighbours lie at the fixed strides
+         * +-1 and +-w, so that its loop can be vectorised. All other elements (or all elements of
+         * a non-rectangular cartgrid) are passed to edge_element (i), which follows the d_
+         * neighbour indices.
+         */
+        template<typename Fr, typename Fe>
+        void apply_3x3 (Fr interior_row, Fe edge_element) const
+        {
+            const std::int32_t n = static_cast<std::int32_t>(this->num());
+            if (!this->is_complete_rectangle() || this->xi_minmax.span() < 2 || this->yi_minmax.span() < 2) {
+#pragma omp parallel for
+                for (std::int32_t i = 0; i < n; ++i) { edge_element (i); }
+                return;
+            }
+            const std::int32_t w = this->xi_minmax.span() + 1;
+            const std::int32_t h = this->yi_minmax.span() + 1;
+#pragma omp parallel for
+            for (std::int32_t y = 1; y < h - 1; ++y) {
+                interior_row (y * w + 1, w - 2, w);
+                edge_element (y * w);
+                edge_element (y * w + w - 1);
+            }
+#pragma omp parallel for
+            for (std::int32_t x = 0; x < w; ++x) {
+                edge_element (x);
+                edge_element ((h - 1) * w + x);
+            }
+        }
+
+        //! The median of 9 values by a fixed, branch-free network of 19 compare-exchanges
+        template<typename T>
+        static T median_of_9 (std::array<T, 9>& p)
+        {
+            auto cx = [&p](const int a, const int b)
+            {
+                const T lo = std::min (p[a], p[b]);
+                p[b] = std::max (p[a], p[b]);
+                p[a] = lo;
+            };
+            cx (1, 2); cx (4, 5); cx (7, 8);
+            cx (0, 1); cx (3, 4); cx (6, 7);
+            cx (1, 2); cx (4, 5); cx (7, 8);
+            cx (0, 3); cx (5, 8); cx (4, 7);
+            cx (3, 6); cx (1, 4); cx (2, 5);
+            cx (4, 7); cx (4, 2); cx (6, 4);
+            cx (4, 2);
+            return p[4];
+        }
+
+        /*!
+         * convolve() for a complete rectangle. The kernel is copied into a dense kw by kh array
+         * covering the bounding box of its offsets. If that array has a low rank (as do
+         * Gaussians, rank 1, and differences of Gaussians, rank 2), it is applied as a sum of
+         * separable terms, each of which is a pass along x followed by a pass along y. Otherwise,
+         * large floating point kernels are applied by FFT and small ones directly. The results
+         * are those of the neighbour-walking convolution: out-of-domain elements contribute zero
+         * and x wraps if domain_wrap is horizontal.
+         */
+        template<typename T>
+        void convolve_rectangle (const cartgrid& kernelgrid, const std::vector<T>& kerneldata,
+                                 const std::vector<T>& data, std::vector<T>& result) const
+        {
+            const auto [kx_min, kx_max] = std::minmax_element (kernelgrid.d_xi.begin(), kernelgrid.d_xi.end());
+            const auto [ky_min, ky_max] = std::minmax_element (kernelgrid.d_yi.begin(), kernelgrid.d_yi.end());
+            const std::int32_t kx0 = *kx_min;
+            const std::int32_t ky0 = *ky_min;
+            const std::int32_t kw = *kx_max - kx0 + 1;
+            const std::int32_t kh = *ky_max - ky0 + 1;
+            std::vector<T> kd (static_cast<std::size_t>(kw) * kh, T{0});
+            for (std::size_t k = 0; k < kerneldata.size(); ++k) {
+                kd[(kernelgrid.d_yi[k] - ky0) * kw + (kernelgrid.d_xi[k] - kx0)] += kerneldata[k];
+            }
+
+            std::fill (result.begin(), result.end(), T{0});
+
+            std::vector<std::vector<T>> terms_x;
+            std::vector<std::vector<T>> terms_y;
+            if (cartgrid::separable_terms (kd, kw, kh, terms_x, terms_y)) {
+                for (std::size_t t = 0; t < terms_x.size(); ++t) {
+                    this->add_separable_term (terms_x[t], kx0, terms_y[t], ky0, data, result);
+                }
+                return;
+            }
+
+            if constexpr (std::is_floating_point_v<T>) {
+                // Beyond this size, the FFT beats the direct sum
+                constexpr std::int32_t fft_threshold = 64;
+                if (kw * kh > fft_threshold) {
+                    this->convolve_rectangle_fft (kd, kx0, kw, ky0, kh, data, result);
+                    return;
+                }
+            }
+            this->convolve_rectangle_direct (kd, kx0, kw, ky0, kh, data, result);
+        }
+
+        /*!
+         * Try to express the dense kw by kh kernel kd as a sum of a few outer products,
+         * kd(x, y) = sum_t terms_y[t][y] * terms_x[t][x], using full-pivot rank-one deflation.
+         * Return false if more terms would be required than would make it worthwhile.
+         */
+        template<typename T>
+        static bool separable_terms (std::vector<T> kd, const std::int32_t kw, const std::int32_t kh,
+                                     std::vector<std::vector<T>>& terms_x, std::vector<std::vector<T>>& terms_y)
+        {
+            if constexpr (!std::is_floating_point_v<T>) {
+                return false;
+            } else {
+                T kmax = T{0};
+                for (const T& k : kd) { kmax = std::max (kmax, std::abs (k)); }
+                if (kmax == T{0}) { return false; }
+                const T tol = T{64} * std::numeric_limits<T>::epsilon() * kmax;
+                constexpr std::int32_t max_terms = 3;
+                for (std::int32_t t = 0; t <= max_terms; ++t) {
+                    // Find the largest residual element
+                    std::size_t p = 0;
+                    for (std::size_t i = 1; i < kd.size(); ++i) {
+                        if (std::abs (kd[i]) > std::abs (kd[p])) { p = i; }
+                    }
+                    if (std::abs (kd[p]) <= tol) { return t > 0; }
+                    // Only worthwhile if the separable passes need fewer operations than the 2D sum
+                    if (t == max_terms || (t + 1) * (kw + kh) >= kw * kh) { return false; }
+                    const std::int32_t px = static_cast<std::int32_t>(p) % kw;
+                    const std::int32_t py = static_cast<std::int32_t>(p) / kw;
+                    std::vector<T> tx (kw);
+                    std::vector<T> ty (kh);
+                    for (std::int32_t x = 0; x < kw; ++x) { tx[x] = kd[py * kw + x] / kd[p]; }
+                    for (std::int32_t y = 0; y < kh; ++y) { ty[y] = kd[y * kw + px]; }
+                    for (std::int32_t y = 0; y < kh; ++y) {
+                        for (std::int32_t x = 0; x < kw; ++x) { kd[y * kw + x] -= ty[y] * tx[x]; }
+                    }
+                    terms_x.push_back (std::move (tx));
+                    terms_y.push_back (std::move (ty));
+                }
+                return false;
+            }
+        }
+
+        /*!
+         * Copy row y of the complete rectangle's data into prow, such that prow[e] holds the
+         * element at column e + kx0, wrapping in x if domain_wrap is horizontal and otherwise
+         * placing zeros beyond the edges.
+         */
+        template<typename T>
+        void padded_row (const std::vector<T>& data, const std::int32_t y, const std::int32_t kx0, std::vector<T>& prow) const
+        {
+            const std::int32_t w = this->xi_minmax.span() + 1;
+            const bool wrap_x = this->domain_wrap == griddomainwrap::horizontal || this->domain_wrap == griddomainwrap::both;
+            const T* row = data.data() + static_cast<std::size_t>(y) * w;
+            const std::int32_t np = static_cast<std::int32_t>(prow.size());
+            for (std::int32_t e = 0; e < np; ++e) {
+                std::int32_t x = e + kx0;
+                if (wrap_x) {
+                    x %= w;
+                    if (x < 0) { x += w; }
+                    prow[e] = row[x];
+                } else {
+                    prow[e] = (x >= 0 && x < w) ? row[x] : T{0};
+                }
+            }
+        }
+
+        /*!
+         * Add to result the convolution of data with the separable kernel ky (x) kx, whose first
+         * elements have offsets kx0 and ky0. One pass along x, then one along y.
+         */
+        template<typename T>
+        void add_separable_term (const std::vector<T>& kx, const std::int32_t kx0,
+                                 const std::vector<T>& ky, const std::int32_t ky0,
+                                 const std::vector<T>& data, std::vector<T>& result) const
+        {
+            const std::int32_t w = this->xi_minmax.span() + 1;
+            const std::int32_t h = this->yi_minmax.span() + 1;
+            const std::int32_t kw = static_cast<std::int32_t>(kx.size());
+            const std::int32_t kh = static_cast<std::int32_t>(ky.size());
+
+            std::vector<T> tmp (data.size());
+#pragma omp parallel for
+            for (std::int32_t y = 0; y < h; ++y) {
+                std::vector<T> prow (w + kw - 1);
+                this->padded_row (data, y, kx0, prow);
+                T* out = tmp.data() + static_cast<std::size_t>(y) * w;
+                for (std::int32_t x = 0; x < w; ++x) { out[x] = T{0}; }
+                for (std::int32_t i = 0; i < kw; ++i) {
+                    const T ki = kx[i];
+                    const T* in = prow.data() + i;
+                    for (std::int32_t x = 0; x < w; ++x) { out[x] += ki * in[x]; }
+                }
+            }
+
+#pragma omp parallel for
+            for (std::int32_t y = 0; y < h; ++y) {
+                T* out = result.data() + static_cast<std::size_t>(y) * w;
+                for (std::int32_t j = 0; j < kh; ++j) {
+                    const std::int32_t yy = y + ky0 + j;
+                    if (yy < 0 || yy >= h) { continue; }
+                    const T kj = ky[j];
+                    const T* in = tmp.data() + static_cast<std::size_t>(yy) * w;
+                    for (std::int32_t x = 0; x < w; ++x) { out[x] += kj * in[x]; }
+                }
+            }
+        }
+
+        //! Direct convolution of the complete rectangle's data with the dense kernel kd
+        template<typename T>
+        void convolve_rectangle_direct (const std::vector<T>& kd, const std::int32_t kx0, const std::int32_t kw,
+                                        const std::int32_t ky0, const std::int32_t kh,
+                                        const std::vector<T>& data, std::vector<T>& result) const
+        {
+            const std::int32_t w = this->xi_minmax.span() + 1;
+            const std::int32_t h = this->yi_minmax.span() + 1;
+#pragma omp parallel for
+            for (std::int32_t y = 0; y < h; ++y) {
+                std::vector<T> prow (w + kw - 1);
+                T* out = result.data() + static_cast<std::size_t>(y) * w;
+                for (std::int32_t j = 0; j < kh; ++j) {
+                    const std::int32_t yy = y + ky0 + j;
+                    if (yy < 0 || yy >= h) { continue; }
+                    this->padded_row (data, yy, kx0, prow);
+                    for (std::int32_t i = 0; i < kw; ++i) {
+                        const T kji = kd[j * kw + i];
+                        if (kji == T{0}) { continue; }
+                        const T* in = prow.data() + i;
+                        for (std::int32_t x = 0; x < w; ++x) { out[x] += kji * in[x]; }
+                    }
+                }
+            }
+        }
+
+        /*!
+         * FFT convolution of the complete rectangle's data with the dense kernel kd. The data is
+         * extended by the kernel size (with wrapped columns or zeros) and zero padded to power of
+         * two dimensions so that the circular correlation computed by FFT equals the required
+         * linear one over the w by h output.
+         */
+        template<typename T>
+        void convolve_rectangle_fft (const std::vector<T>& kd, const std::int32_t kx0, const std::int32_t kw,
+                                     const std::int32_t ky0, const std::int32_t kh,
+                                     const std::vector<T>& data, std::vector<T>& result) const
+        {
+            using cplx = std::complex<double>;
+            const std::int32_t w = this->xi_minmax.span() + 1;
+            const std::int32_t h = this->yi_minmax.span() + 1;
+            const std::size_t pw = sm::algo::next_pow2 (static_cast<std::size_t>(w + kw - 1));
+            const std::size_t ph = sm::algo::next_pow2 (static_cast<std::size_t>(h + kh - 1));
+
+            // Extended data: element (ex, ey) holds the data at (ex + kx0, ey + ky0)
+            std::vector<cplx> fd (pw * ph, cplx{0.0, 0.0});
+#pragma omp parallel for
+            for (std::int32_t ey = 0; ey < h + kh - 1; ++ey) {
+                const std::int32_t y = ey + ky0;
+                if (y < 0 || y >= h) { continue; }
+                std::vector<T> prow (w + kw - 1);
+                this->padded_row (data, y, kx0, prow);
+                cplx* out = fd.data() + static_cast<std::size_t>(ey) * pw;
+                for (std::size_t e = 0; e < prow.size(); ++e) { out[e] = cplx{static_cast<double>(prow[e]), 0.0}; }
+            }
+            std::vector<cplx> fk (pw * ph, cplx{0.0, 0.0});
+            for (std::int32_t j = 0; j < kh; ++j) {
+                for (std::int32_t i = 0; i < kw; ++i) { fk[j * pw + i] = cplx{static_cast<double>(kd[j * kw + i]), 0.0}; }
+            }
+
+            sm::algo::fft_2d<double> (fd, pw, ph);
+            sm::algo::fft_2d<double> (fk, pw, ph);
+            // Correlation (rather than convolution) with the kernel is multiplication by its conjugate
+            for (std::size_t i = 0; i < fd.size(); ++i) { fd[i] *= std::conj (fk[i]); }
+            sm::algo::fft_2d<double> (fd, pw, ph, true);
+
+#pragma omp parallel for
+            for (std::int32_t y = 0; y < h; ++y) {
+                for (std::int32_t x = 0; x < w; ++x) {
+                    result[static_cast<std::size_t>(y) * w + x] = static_cast<T>(fd[static_cast<std::size_t>(y) * pw + x].real());
+                }
+            }
+        }
+
+        //! Throw if this cartgrid has no rects because it uses contiguous storage
+        void require_list_storage (const char* fn) const
+        {
+            if (this->storage == cartgridstorage::contiguous) {
+                std::stringstream ee;
+                ee << "cartgrid::" << fn << " requires cartgridstorage::list";
+                throw std::runtime_error (ee.str());
+            }
+        }
+
         /*!
          * Initialise a grid of rects in a raster fashion, setting neighbours as we
          * go. This method populates rects based on the grid parameters set in d, v and
@@ -1799,6 +2266,10 @@ export namespace sm
             this->x_minmax = sm::interval<float>(-half_cols * this->d, half_cols * this->d);
             this->y_minmax = sm::interval<float>(-half_rows * this->v, half_rows * this->v);
 
+            // The symmetric grid is never wrapped
+            this->init_d_vectors (-half_cols, half_cols, -half_rows, half_rows, false);
+            if (this->storage == cartgridstorage::contiguous) { return; }
+
             // The "vector iterator" - this is an identity iterator that is added to each rect in the grid.
             std::uint32_t vi = 0;
 
@@ -1870,6 +2341,10 @@ export namespace sm
                 this->h_px = _yf-_yi+1;
             }
 
+            this->init_d_vectors (_xi, _xf, _yi, _yf, (this->domain_wrap == sm::griddomainwrap::horizontal
+                                                       || this->domain_wrap == sm::griddomainwrap::both));
+            if (this->storage == cartgridstorage::contiguous) { return; }
+
             // The "vector iterator" - this is an identity iterator that is added to each rect in the grid.
             std::uint32_t vi = 0;
 
@@ -1928,21 +2403,6 @@ export namespace sm
             }
         }
 
-        /*!
-         * Starting from \a start_from, and following nearest-neighbour relations, find
-         * the closest rect in rects to the coordinate point \a point, and set its
-         * rect::on_boundary attribute to true.
-         *
-         * \return An iterator into cartgrid::rects which refers to the closest rect to \a point.
-         */
-        std::list<sm::rect>::iterator set_boundary (const sm::bezcoord<float>& point,
-                                                    std::list<sm::rect>::iterator start_from)
-        {
-            std::list<sm::rect>::iterator h = this->find_rect_near_point (point, start_from);
-            h->set_flag (RECT_IS_BOUNDARY | RECT_INSIDE_BOUNDARY);
-            return h;
-        }
-
         // ASSUMING that the boundary is rectangular, is the point inside the rectangle?
         bool is_inside_rectangular_boundary (const sm::vec<float, 2>& point)
         {
@@ -1954,135 +2414,213 @@ export namespace sm
         }
 
         /*!
-         * Determine whether the boundary is contiguous. Whilst doing so, populate a
-         * list<rect> containing just the boundary rects.
+         * A dense lookup table from the (xi, yi) indices of the rects in rects to the
+         * rects themselves, covering the bounding box of those indices. The boundary
+         * code uses it to find the rect under a point in O(1).
          */
-        bool boundary_contiguous()
+        struct index_table
         {
-            this->brects.clear();
-            std::list<sm::rect>::const_iterator bhi = this->rects.begin();
-            if (this->find_boundary_rect (bhi) == false) {
-                // Found no boundary rect
-                return false;
-            }
-            std::set<std::uint32_t> seen;
-            std::list<sm::rect>::const_iterator hi = bhi;
-            return this->boundary_contiguous (bhi, hi, seen, RECT_NEIGHBOUR_POS_E);
-        }
+            std::int32_t xmin = 0;
+            std::int32_t ymin = 0;
+            std::int32_t w = 0;
+            std::int32_t h = 0;
+            //! Row by row from ymin; an empty cell holds rects.end()
+            std::vector<std::list<rect>::iterator> cells;
 
-        /*!
-         * Determine whether the boundary is contiguous, starting from the boundary
-         * rect iterator \a bhi.
-         *
-         * If following the boundary clockwise, then need to search neighbours "starting
-         * from the one that's clockwise around from the last one that was on the
-         * boundary"
-         *
-         * The overload with brects takes a list of rect pointers and populates it with
-         * pointers to the rects on the boundary.
-         */
-        bool boundary_contiguous (std::list<rect>::const_iterator bri,
-                                  std::list<rect>::const_iterator ri, std::set<std::uint32_t>& seen, std::int32_t dirn)
-        {
-            bool rtn = false;
-            std::list<sm::rect>::const_iterator ri_next;
-            seen.insert (ri->vi);
-            // Insert into the std::list of rect pointers, too
-            this->brects.push_back (&(*ri));
-
-            // increasing direction is an anticlockwise sense
-            for (std::int32_t i = 0; i < 8; ++i) {
-                if (rtn == false
-                    && ri->has_neighbour(dirn+i)
-                    && ri->get_neighbour(dirn+i)->test_flags(RECT_IS_BOUNDARY) == true
-                    && seen.find(ri->get_neighbour(dirn+i)->vi) == seen.end()) {
-                    //std::cout << ri->neighbour_pos(dirn+i) << std::endl;
-                    ri_next = ri->get_neighbour(dirn+i);
-                    rtn = (this->boundary_contiguous (bri, ri_next, seen, dirn+i));
+            std::list<rect>::iterator at (const std::int32_t xi, const std::int32_t yi,
+                                          const std::list<rect>::iterator none) const
+            {
+                if (xi < this->xmin || xi >= this->xmin + this->w || yi < this->ymin || yi >= this->ymin + this->h) {
+                    return none;
                 }
+                return this->cells[(yi - this->ymin) * this->w + (xi - this->xmin)];
             }
+        };
 
-            if (rtn == false) {
-                // Checked all neighbours
-                if (ri == bri) {
-                    // Back at start, nowhere left to go! return true.
-                    rtn = true;
-                }
+        //! Build the index_table for the current rects. O(N).
+        index_table make_index_table()
+        {
+            index_table tbl;
+            if (this->rects.empty()) { return tbl; }
+            std::int32_t xmax = std::numeric_limits<std::int32_t>::lowest();
+            std::int32_t ymax = std::numeric_limits<std::int32_t>::lowest();
+            tbl.xmin = std::numeric_limits<std::int32_t>::max();
+            tbl.ymin = std::numeric_limits<std::int32_t>::max();
+            for (const auto& r : this->rects) {
+                tbl.xmin = std::min (tbl.xmin, r.xi);
+                tbl.ymin = std::min (tbl.ymin, r.yi);
+                xmax = std::max (xmax, r.xi);
+                ymax = std::max (ymax, r.yi);
             }
-
-            return rtn;
+            tbl.w = xmax - tbl.xmin + 1;
+            tbl.h = ymax - tbl.ymin + 1;
+            tbl.cells.assign (static_cast<std::size_t>(tbl.w) * tbl.h, this->rects.end());
+            for (auto ri = this->rects.begin(); ri != this->rects.end(); ++ri) {
+                tbl.cells[(ri->yi - tbl.ymin) * tbl.w + (ri->xi - tbl.xmin)] = ri;
+            }
+            return tbl;
         }
 
         /*!
-         * Set the rect closest to point as being on the region boundary. Region
-         * boundaries are supposed to be temporary, so that client code can find a
-         * region, extract the pointers to all the rects in that region and store that
-         * information for later use.
+         * Find the rect nearest to \a point. The rect is found directly by rounding the
+         * point's coordinates to element indices. If the point is off the grid, the
+         * nearest-neighbour walk of find_rect_near_point() is used, starting from
+         * \a start_from.
          */
-        std::list<rect>::iterator set_region_boundary (const sm::bezcoord<float>& point, std::list<rect>::iterator start_from)
+        std::list<rect>::iterator locate_rect (const sm::bezcoord<float>& point, std::list<rect>::iterator start_from,
+                                               const index_table& tbl)
         {
-            std::list<sm::rect>::iterator h = this->find_rect_near_point (point, start_from);
-            h->set_flag (RECT_IS_REGION_BOUNDARY | RECT_INSIDE_REGION);
-            return h;
+            std::list<sm::rect>::iterator c = tbl.at (static_cast<std::int32_t>(std::round (point.x() / this->d)),
+                                                      static_cast<std::int32_t>(std::round (point.y() / this->v)),
+                                                      this->rects.end());
+            if (c != this->rects.end()) { return c; }
+            return this->find_rect_near_point (point, start_from);
         }
 
-        /*!
-         * Set the rect closest to point as being on the region boundary. Region
-         * boundaries are supposed to be temporary, so that client code can find a
-         * region, extract the pointers to all the rects in that region and store that
-         * information for later use.
-         */
-        std::list<rect>::iterator set_region_boundary (const sm::vec<float, 2>& point, std::list<rect>::iterator start_from)
+        //! Are a and b neighbours (including diagonal neighbours) in the grid?
+        static bool rects_adjacent (std::list<rect>::const_iterator a, std::list<rect>::const_iterator b)
         {
-            std::list<sm::rect>::iterator h = this->find_rect_near_point (point, start_from);
-            h->set_flag (RECT_IS_REGION_BOUNDARY | RECT_INSIDE_REGION);
-            return h;
+            for (std::uint16_t i = 0; i < 8; ++i) {
+                if (a->has_neighbour (i) && std::list<rect>::const_iterator(a->get_neighbour (i)) == b) { return true; }
+            }
+            return false;
         }
 
         /*!
-         * Determine whether the region boundary is contiguous, starting from the
-         * boundary rect iterator #bhi.
+         * Mark the rects under the closed path \a bpoints with \a bdry_flag and
+         * \a inside_flag and place them, in path order, in \a bdry. Each point is
+         * located in O(1) with \a tbl. Contiguity (with diagonal steps allowed) is
+         * checked in the same pass: where consecutive points land on rects that are not
+         * neighbours, the segment between them is resampled at a quarter of the element
+         * width.
+         *
+         * \return false if that does not close a gap, i.e. the boundary is not contiguous.
          */
-        bool region_boundary_contiguous (std::list<rect>::const_iterator bhi,
-                                         std::list<rect>::const_iterator hi, std::set<std::uint32_t>& seen)
+        bool trace_boundary (const std::vector<sm::bezcoord<float>>& bpoints, const index_table& tbl,
+                             std::list<const rect*>& bdry,
+                             const std::uint32_t bdry_flag = RECT_IS_BOUNDARY,
+                             const std::uint32_t inside_flag = RECT_INSIDE_BOUNDARY)
         {
-            bool rtn = false;
-            std::list<sm::rect>::const_iterator hi_next;
-            seen.insert (hi->vi);
-            // Insert into the list of rect pointers, too
-            this->brects.push_back (&(*hi));
+            bdry.clear();
+            if (bpoints.empty() || this->rects.empty()) { return true; }
 
-            if (rtn == false && hi->has_ne() && hi->ne->test_flags(RECT_IS_REGION_BOUNDARY) == true && seen.find(hi->ne->vi) == seen.end()) {
-                hi_next = hi->ne;
-                rtn = (this->region_boundary_contiguous (bhi, hi_next, seen));
-            }
-            if (rtn == false && hi->has_nne() && hi->nne->test_flags(RECT_IS_REGION_BOUNDARY) == true && seen.find(hi->nne->vi) == seen.end()) {
-                hi_next = hi->nne;
-                rtn = this->region_boundary_contiguous (bhi, hi_next, seen);
-            }
-            if (rtn == false && hi->has_nnw() && hi->nnw->test_flags(RECT_IS_REGION_BOUNDARY) == true && seen.find(hi->nnw->vi) == seen.end()) {
-                hi_next = hi->nnw;
-                rtn =  (this->region_boundary_contiguous (bhi, hi_next, seen));
+            std::vector<std::list<rect>::iterator> chain;
+            bool contiguous = true;
+            auto extend = [&chain, &contiguous](std::list<rect>::iterator r)
+            {
+                if (chain.empty()) {
+                    chain.push_back (r);
+                } else if (r != chain.back()) {
+                    if (!rects_adjacent (chain.back(), r)) { contiguous = false; }
+                    chain.push_back (r);
+                }
+            };
+
+            const float step = 0.25f * std::min (this->d, this->v);
+            const std::size_t np = bpoints.size();
+            std::list<sm::rect>::iterator prev = this->rects.begin();
+            // Visit each point, then return to the first point to close the loop
+            for (std::size_t i = 0; i <= np && contiguous; ++i) {
+                const sm::bezcoord<float>& pt = bpoints[i % np];
+                std::list<sm::rect>::iterator r = this->locate_rect (pt, prev, tbl);
+                if (!chain.empty() && r != chain.back() && !rects_adjacent (chain.back(), r)) {
+                    // Fill the gap by stepping along the segment from the previous point
+                    const sm::bezcoord<float>& p0 = bpoints[i - 1];
+                    const float dx = pt.x() - p0.x();
+                    const float dy = pt.y() - p0.y();
+                    const std::int32_t nsteps = static_cast<std::int32_t>(std::ceil (std::sqrt (dx * dx + dy * dy) / step));
+                    for (std::int32_t k = 1; k < nsteps; ++k) {
+                        const float t = static_cast<float>(k) / nsteps;
+                        sm::bezcoord<float> pk (sm::vec<float, 2>{ p0.x() + t * dx, p0.y() + t * dy });
+                        extend (this->locate_rect (pk, chain.back(), tbl));
+                    }
+                }
+                extend (r);
+                prev = r;
             }
-            if (rtn == false && hi->has_nw() && hi->nw->test_flags(RECT_IS_REGION_BOUNDARY) == true && seen.find(hi->nw->vi) == seen.end()) {
-                hi_next = hi->nw;
-                rtn =  (this->region_boundary_contiguous (bhi, hi_next, seen));
+            // The loop closed on the first rect, which is already in the chain
+            if (chain.size() > 1 && chain.back() == chain.front()) { chain.pop_back(); }
+
+            for (auto r : chain) {
+                if (r->test_flags (bdry_flag) == false) { bdry.push_back (&(*r)); }
+                r->set_flag (bdry_flag | inside_flag);
             }
-            if (rtn == false && hi->has_nsw() && hi->nsw->test_flags(RECT_IS_REGION_BOUNDARY) == true && seen.find(hi->nsw->vi) == seen.end()) {
-                hi_next = hi->nsw;
-                rtn =  (this->region_boundary_contiguous (bhi, hi_next, seen));
+            return contiguous;
+        }
+
+        /*!
+         * Classify the centre of every rect against the polygon \a pi, in parallel,
+         * setting inside[vi] to 1 for the rects inside it. Uses d_x and d_y if they are
+         * up to date.
+         */
+        void classify_centres (const sm::polygon_index<float>& pi, std::vector<std::uint8_t>& inside) const
+        {
+            if (this->d_x.size() == this->rects.size()) {
+                pi.contains (this->d_x, this->d_y, inside);
+                return;
             }
-            if (rtn == false && hi->has_nse() && hi->nse->test_flags(RECT_IS_REGION_BOUNDARY) == true && seen.find(hi->nse->vi) == seen.end()) {
-                hi_next = hi->nse;
-                rtn =  (this->region_boundary_contiguous (bhi, hi_next, seen));
+            std::vector<float> xs (this->rects.size());
+            std::vector<float> ys (this->rects.size());
+            for (const auto& rr : this->rects) {
+                xs[rr.vi] = rr.x;
+                ys[rr.vi] = rr.y;
             }
+            pi.contains (xs, ys, inside);
+        }
 
-            if (rtn == false) {
-                // Checked all neighbours
-                if (hi == bhi) { rtn = true; }
+        /*!
+         * Determine whether the boundary is contiguous. Whilst doing so, populate a
+         * list<rect> containing just the boundary rects.
+         */
+        bool boundary_contiguous()
+        {
+            this->brects.clear();
+            std::list<sm::rect>::const_iterator bri = this->rects.begin();
+            while (bri != this->rects.end() && bri->test_flags (RECT_IS_BOUNDARY) == false) { ++bri; }
+            if (bri == this->rects.end()) {
+                // Found no boundary rect
+                return false;
             }
+            return this->boundary_contiguous (bri);
+        }
 
-            return rtn;
+        /*!
+         * Determine whether the boundary is contiguous, starting from the boundary rect
+         * iterator \a bri. The boundary rects are walked depth first, with an explicit
+         * stack so that long boundaries can't overflow the call stack. As when following
+         * the boundary anticlockwise, the neighbours of each rect are tried starting from
+         * the direction in which it was reached. Each rect reached is added to brects.
+         * The boundary is contiguous if every boundary rect was reached.
+         */
+        bool boundary_contiguous (std::list<rect>::const_iterator bri)
+        {
+            this->brects.clear();
+            std::uint32_t n_boundary = 0;
+            std::uint32_t vi_max = 0;
+            for (const auto& r : this->rects) {
+                if (r.test_flags (RECT_IS_BOUNDARY)) { ++n_boundary; }
+                vi_max = std::max (vi_max, r.vi);
+            }
+
+            std::vector<char> seen (vi_max + 1, 0);
+            // Each entry is a rect and the direction it was reached in
+            std::vector<std::pair<const rect*, std::uint16_t>> stack = { { &(*bri), RECT_NEIGHBOUR_POS_E } };
+            while (!stack.empty()) {
+                auto [r, dirn] = stack.back();
+                stack.pop_back();
+                if (seen[r->vi]) { continue; }
+                seen[r->vi] = 1;
+                this->brects.push_back (r);
+                // Push in reverse, so that direction dirn is visited first
+                for (std::uint16_t i = 8; i-- > 0;) {
+                    const std::uint16_t dn = (dirn + i) % 8;
+                    if (r->has_neighbour (dn)) {
+                        const sm::rect* rn = &(*r->get_neighbour (dn));
+                        if (rn->test_flags (RECT_IS_BOUNDARY) && !seen[rn->vi]) { stack.push_back ({ rn, dn }); }
+                    }
+                }
+            }
+            return this->brects.size() == n_boundary;
         }
 
         /*!
@@ -2469,13 +3007,88 @@ export namespace sm
         }
 
         /*!
-         * Discard rects in this->rects that are outside the boundary #boundary.
+         * Mark the rects inside the boundary with RECT_INSIDE_BOUNDARY, according to
+         * #boundary_fill. The scanline fill needs the boundary \a polygon; without it,
+         * the flood fill is used.
          */
-        void discard_outside_boundary()
+        void fill_boundary_interior (const index_table& tbl, const std::vector<sm::bezcoord<float>>* polygon)
+        {
+            if (this->boundary_fill == sm::boundaryfill::scanline && polygon != nullptr) {
+                this->scanline_fill (tbl, *polygon);
+                return;
+            }
+            std::list<sm::rect>::iterator seed = this->locate_rect (sm::bezcoord<float>(this->boundary_centroid),
+                                                                    this->rects.begin(), tbl);
+            if (seed->test_flags (RECT_IS_BOUNDARY) && polygon != nullptr) {
+                // The centroid is on the boundary, so it gives no inside rect to start from
+                this->scanline_fill (tbl, *polygon);
+            } else {
+                this->flood_fill (seed);
+            }
+        }
+
+        /*!
+         * Iterative flood fill, marking \a seed and every rect reachable from it by E, N,
+         * W and S steps without crossing a rect already marked RECT_INSIDE_BOUNDARY
+         * (which includes the boundary rects). Diagonal steps are not taken, because a
+         * boundary may itself take diagonal steps.
+         */
+        void flood_fill (std::list<rect>::iterator seed)
+        {
+            std::vector<sm::rect*> stack;
+            if (seed->test_flags (RECT_INSIDE_BOUNDARY) == false) {
+                seed->set_flag (RECT_INSIDE_BOUNDARY);
+                stack.push_back (&(*seed));
+            }
+            while (!stack.empty()) {
+                sm::rect* r = stack.back();
+                stack.pop_back();
+                for (std::uint16_t i = RECT_NEIGHBOUR_POS_E; i < 8; i += 2) {
+                    if (!r->has_neighbour (i)) { continue; }
+                    sm::rect* rn = &(*r->get_neighbour (i));
+                    if (rn->test_flags (RECT_INSIDE_BOUNDARY) == false) {
+                        rn->set_flag (RECT_INSIDE_BOUNDARY);
+                        stack.push_back (rn);
+                    }
+                }
+            }
+        }
+
+        /*!
+         * Mark each rect whose centre lies inside \a polygon (by the even-odd rule). Each
+         * row of rects is tested against the sorted crossings of the polygon with the
+         * row, and rows are processed in parallel.
+         */
+        void scanline_fill (const index_table& tbl, const std::vector<sm::bezcoord<float>>& polygon)
+        {
+            std::vector<float> ys (tbl.h);
+            for (std::int32_t k = 0; k < tbl.h; ++k) { ys[k] = this->v * static_cast<float>(tbl.ymin + k); }
+            std::vector<std::vector<float>> xs;
+            sm::algo::scanline_crossings (polygon, ys, xs);
+
+            const std::list<sm::rect>::iterator none = this->rects.end();
+#pragma omp parallel for
+            for (std::int32_t k = 0; k < tbl.h; ++k) {
+                const std::vector<float>& xk = xs[k];
+                std::size_t c = 0;
+                for (std::int32_t j = 0; j < tbl.w; ++j) {
+                    std::list<sm::rect>::iterator ri = tbl.cells[k * tbl.w + j];
+                    if (ri == none) { continue; }
+                    while (c < xk.size() && xk[c] < ri->x) { ++c; }
+                    if (c % 2 == 1) { ri->set_flag (RECT_INSIDE_BOUNDARY); }
+                }
+            }
+        }
+
+        /*!
+         * Discard rects in this->rects that are outside the boundary #boundary. The
+         * boundary rects must already be marked. \a polygon is the boundary path, if
+         * there is one, for use by the scanline fill.
+         */
+        void discard_outside_boundary (const index_table& tbl, const std::vector<sm::bezcoord<float>>* polygon = nullptr)
         {
             // Mark those rects inside the boundary
-            std::list<sm::rect>::iterator centroid_rect = this->find_rect_nearest (this->boundary_centroid);
-            this->mark_rects_inside (centroid_rect);
+            this->fill_boundary_interior (tbl, polygon);
             // Run through and discard those rects outside the boundary:
             auto hi = this->rects.begin();
             while (hi != this->rects.end()) {
@@ -2533,7 +3146,21 @@ export namespace sm
             // Find the furthest left and right rects and the furthest up and down rects.
             std::array<float, 4> limits = {{0,0,0,0}};
             bool first = true;
-            for (auto r : this->rects) {
+            if (this->storage == cartgridstorage::contiguous) {
+                for (std::uint32_t i = 0; i < this->num(); ++i) {
+                    if ((this->d_flags[i] & RECT_IS_BOUNDARY) == 0u) { continue; }
+                    if (first) {
+                        limits = { this->d_x[i], this->d_x[i], this->d_y[i], this->d_y[i] };
+                        extents = { this->d_xi[i], this->d_xi[i], this->d_yi[i], this->d_yi[i] };
+                        first = false;
+                    }
+                    if (this->d_x[i] < limits[0]) { limits[0] = this->d_x[i]; extents[0] = this->d_xi[i]; }
+                    if (this->d_x[i] > limits[1]) { limits[1] = this->d_x[i]; extents[1] = this->d_xi[i]; }
+                    if (this->d_y[i] < limits[2]) { limits[2] = this->d_y[i]; extents[2] = this->d_yi[i]; }
+                    if (this->d_y[i] > limits[3]) { limits[3] = this->d_y[i]; extents[3] = this->d_yi[i]; }
+                }
+            }
+            for (const auto& r : this->rects) {
                 if (r.test_flags(RECT_IS_BOUNDARY) == true) {
                     if (first) {
                         limits = {r.x, r.x, r.y, r.y};
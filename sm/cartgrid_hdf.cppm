@@ -0,0 +1,138 @@
+// -*- C++ -*-
+/*
+ * This file is part of sebsjames/maths, a library of maths code for modern C++
+ *
+ * See https://github.com/sebsjames/maths
+ *
+ * \file
+ *
+ * Defines save and load functions for cartgrid. The file format is columnar: each field of
+ * the grid's elements is stored in a single dataset (the cartgrid's d_ vectors), with the
+ * neighbour relations stored as int32 index arrays. There is no per-element HDF5 group, so
+ * saving and loading a large grid is fast, and loading is O(N).
+ *
+ * \author: Seb James
+ * \date: 2026
+ */
+module;
+
+#include <cstdint>
+#include <string>
+#include <ios>
+#include <stdexcept>
+
+export module sm.cartgrid.hdf;
+
+export import sm.cartgrid;
+import sm.hdfdata;
+import sm.vec;
+
+export namespace sm
+{
+    /*!
+     * Save cartgrid cg into the HDF5 file at the location path. Only the d_ vectors and the
+     * grid parameters are written; the bezcurvepath boundary is not saved, although which
+     * elements are boundary elements is recorded in /d_flags.
+     */
+    void cartgrid_save (const sm::cartgrid& cg, const std::string& path)
+    {
+        sm::hdfdata cgdata (path, std::ios::out | std::ios::trunc);
+        cgdata.add_val ("/d", cg.get_d());
+        cgdata.add_val ("/v", cg.get_v());
+        const sm::vec<float, 2> span = cg.get_span();
+        cgdata.add_val ("/x_span", span[0]);
+        cgdata.add_val ("/y_span", span[1]);
+        cgdata.add_val ("/z", cg.get_z());
+        cgdata.add_val ("/grid_reduced", cg.is_grid_reduced());
+        cgdata.add_val ("/d_growthbuffer_horz", cg.d_growthbuffer_horz);
+        cgdata.add_val ("/d_growthbuffer_vert", cg.d_growthbuffer_vert);
+        cgdata.add_val ("/domain_shape", static_cast<std::uint32_t>(cg.domain_shape));
+        cgdata.add_val ("/domain_wrap", static_cast<std::uint32_t>(cg.domain_wrap));
+        cgdata.add_val ("/storage", static_cast<std::uint32_t>(cg.storage));
+
+        // sm::vec<float, 2>
+        cgdata.add_contained_vals ("/boundary_centroid", cg.boundary_centroid);
+        cgdata.add_contained_vals ("/original_boundary_centroid", cg.original_boundary_centroid);
+        cgdata.add_contained_vals ("/x_minmax", sm::vec<float, 2>{ cg.x_minmax.min, cg.x_minmax.max });
+        cgdata.add_contained_vals ("/y_minmax", sm::vec<float, 2>{ cg.y_minmax.min, cg.y_minmax.max });
+
+        // vector<float>
+        cgdata.add_contained_vals ("/d_x", cg.d_x);
+        cgdata.add_contained_vals ("/d_y", cg.d_y);
+        cgdata.add_contained_vals ("/d_dist_to_boundary", cg.d_dist_to_boundary);
+        // vector<std::int32_t>
+        cgdata.add_contained_vals ("/d_xi", cg.d_xi);
+        cgdata.add_contained_vals ("/d_yi", cg.d_yi);
+
+        cgdata.add_contained_vals ("/d_ne", cg.d_ne);
+        cgdata.add_contained_vals ("/d_nne", cg.d_nne);
+        cgdata.add_contained_vals ("/d_nn", cg.d_nn);
+        cgdata.add_contained_vals ("/d_nnw", cg.d_nnw);
+        cgdata.add_contained_vals ("/d_nw", cg.d_nw);
+        cgdata.add_contained_vals ("/d_nsw", cg.d_nsw);
+        cgdata.add_contained_vals ("/d_ns", cg.d_ns);
+        cgdata.add_contained_vals ("/d_nse", cg.d_nse);
+
+        // vector<std::uint32_t>
+        cgdata.add_contained_vals ("/d_flags", cg.d_flags);
+    }
+
+    /*!
+     * Populate cartgrid cg from the HDF5 file at the location path, which should have been
+     * written by cartgrid_save. In list storage, the rects are rebuilt from the neighbour index
+     * arrays in a single pass (see cartgrid::rebuild_from_d_vectors).
+     */
+    void cartgrid_load (sm::cartgrid& cg, const std::string& path)
+    {
+        sm::hdfdata cgdata (path, std::ios::in);
+        float d = 1.0f;
+        float v = 1.0f;
+        float x_span = 1.0f;
+        float y_span = 1.0f;
+        float z = 0.0f;
+        bool grid_reduced = false;
+        std::uint32_t shape = 0;
+        std::uint32_t wrap = 0;
+        std::uint32_t storage = 0;
+        cgdata.read_val ("/d", d);
+        cgdata.read_val ("/v", v);
+        cgdata.read_val ("/x_span", x_span);
+        cgdata.read_val ("/y_span", y_span);
+        cgdata.read_val ("/z", z);
+        cgdata.read_val ("/grid_reduced", grid_reduced);
+        cgdata.read_val ("/d_growthbuffer_horz", cg.d_growthbuffer_horz);
+        cgdata.read_val ("/d_growthbuffer_vert", cg.d_growthbuffer_vert);
+        cgdata.read_val ("/domain_shape", shape);
+        cgdata.read_val ("/domain_wrap", wrap);
+        cgdata.read_val ("/storage", storage);
+        cg.domain_shape = static_cast<sm::griddomainshape>(shape);
+        cg.domain_wrap = static_cast<sm::griddomainwrap>(wrap);
+        cg.storage = static_cast<sm::cartgridstorage>(storage);
+
+        cgdata.read_contained_vals ("/boundary_centroid", cg.boundary_centroid);
+        cgdata.read_contained_vals ("/original_boundary_centroid", cg.original_boundary_centroid);
+        sm::vec<float, 2> mm = {};
+        cgdata.read_contained_vals ("/x_minmax", mm);
+        cg.x_minmax.set (mm[0], mm[1]);
+        cgdata.read_contained_vals ("/y_minmax", mm);
+        cg.y_minmax.set (mm[0], mm[1]);
+
+        cgdata.read_contained_vals ("/d_x", cg.d_x);
+        cgdata.read_contained_vals ("/d_y", cg.d_y);
+        cgdata.read_contained_vals ("/d_dist_to_boundary", cg.d_dist_to_boundary);
+        cgdata.read_contained_vals ("/d_xi", cg.d_xi);
+        cgdata.read_contained_vals ("/d_yi", cg.d_yi);
+        cgdata.read_contained_vals ("/d_ne", cg.d_ne);
+        cgdata.read_contained_vals ("/d_nne", cg.d_nne);
+        cgdata.read_contained_vals ("/d_nn", cg.d_nn);
+        cgdata.read_contained_vals ("/d_nnw", cg.d_nnw);
+        cgdata.read_contained_vals ("/d_nw", cg.d_nw);
+        cgdata.read_contained_vals ("/d_nsw", cg.d_nsw);
+        cgdata.read_contained_vals ("/d_ns", cg.d_ns);
+        cgdata.read_contained_vals ("/d_nse", cg.d_nse);
+        cgdata.read_contained_vals ("/d_flags", cg.d_flags);
+
+        cg.rebuild_from_d_vectors (d, v, x_span, y_span, z, grid_reduced);
+    }
+
+} // namespace
@@ -0,0 +1,316 @@
+// -*- C++ -*-
+/*!
+ * This file is part of sebsjames/maths, a library of maths code for modern C++
+ *
+ * See https://github.com/sebsjames/maths
+ *
+ * \file
+ *
+ * Provides sm::csr, a sparse matrix in compressed sparse row form with a parallel
+ * matrix-vector product, and sm::conjugate_gradient, which solves symmetric positive
+ * definite systems with it. The grids use these to export their neighbour relations as
+ * adjacency and Laplacian matrices.
+ *
+ * \author Seb James
+ * \date 2026
+ */
+module;
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+export module sm.csr;
+
+export namespace sm
+{
+    //! The boundary condition applied by the grids' laplacian_matrix methods
+    enum class boundary_condition
+    {
+        neumann,  // zero flux: missing neighbours are left out, as in the grids' laplacian methods
+        dirichlet // zero value: missing neighbours are taken to hold 0
+    };
+
+    /*!
+     * A sparse matrix in compressed sparse row (CSR) form. The entries of row r are at
+     * positions row_start[r] to row_start[r + 1] - 1 of col and val, in order of column.
+     *
+     * \tparam T The element type
+     */
+    template <typename T = float>
+    struct csr
+    {
+        std::uint32_t rows = 0;
+        std::uint32_t cols = 0;
+        //! rows + 1 offsets into col and val
+        std::vector<std::uint32_t> row_start = { 0u };
+        //! The column of each stored entry
+        std::vector<std::uint32_t> col;
+        //! The value of each stored entry
+        std::vector<T> val;
+
+        csr() = default;
+
+        //! An empty (all zero) matrix of _rows by _cols
+        csr (const std::uint32_t _rows, const std::uint32_t _cols)
+            : rows(_rows), cols(_cols), row_start(_rows + 1u, 0u) {}
+
+        /*!
+         * Build a square matrix of n rows, one row at a time and in parallel. row (i, c, v)
+         * writes the entries of row i into c[0..m) and v[0..m), for m <= N, and returns m.
+         * The entries may be in any order, and entries in the same column are summed.
+         */
+        template <std::size_t N, typename F>
+        static csr<T> from_rows (const std::uint32_t n, F&& row)
+        {
+            csr<T> m (n, n);
+            std::vector<std::uint32_t> c (static_cast<std::size_t>(n) * N);
+            std::vector<T> v (static_cast<std::size_t>(n) * N);
+            std::vector<std::uint32_t> count (n);
+            const std::int64_t nr = n;
+#pragma omp parallel for
+            for (std::int64_t i = 0; i < nr; ++i) {
+                std::uint32_t* ci = c.data() + i * N;
+                T* vi = v.data() + i * N;
+                const std::uint32_t k = row (static_cast<std::uint32_t>(i), ci, vi);
+                // Insertion sort the (few) entries by column, merging repeated columns
+                std::uint32_t u = 0;
+                for (std::uint32_t j = 0; j < k; ++j) {
+                    std::uint32_t p = 0;
+                    while (p < u && ci[p] < ci[j]) { ++p; }
+                    if (p < u && ci[p] == ci[j]) {
+                        vi[p] += vi[j];
+                        continue;
+                    }
+                    const std::uint32_t cj = ci[j];
+                    const T vj = vi[j];
+                    for (std::uint32_t q = u; q > p; --q) {
+                        ci[q] = ci[q - 1];
+                        vi[q] = vi[q - 1];
+                    }
+                    ci[p] = cj;
+                    vi[p] = vj;
+                    ++u;
+                }
+                count[i] = u;
+            }
+            for (std::uint32_t i = 0; i < n; ++i) { m.row_start[i + 1] = m.row_start[i] + count[i]; }
+            m.col.resize (m.row_start[n]);
+            m.val.resize (m.row_start[n]);
+#pragma omp parallel for
+            for (std::int64_t i = 0; i < nr; ++i) {
+                std::copy_n (c.data() + i * N, count[i], m.col.data() + m.row_start[i]);
+                std::copy_n (v.data() + i * N, count[i], m.val.data() + m.row_start[i]);
+            }
+            return m;
+        }
+
+        //! The n by n identity matrix
+        static csr<T> identity (const std::uint32_t n)
+        {
+            return from_rows<1> (n, [](std::uint32_t i, std::uint32_t* c, T* v)
+            {
+                c[0] = i;
+                v[0] = T{1};
+                return 1u;
+            });
+        }
+
+        //! The number of stored entries
+        std::size_t nnz() const { return this->val.size(); }
+
+        //! The element at row r, column c (zero if it is not stored)
+        T at (const std::uint32_t r, const std::uint32_t c) const
+        {
+            if (r >= this->rows || c >= this->cols) { throw std::runtime_error ("csr::at: index out of range"); }
+            const auto b = this->col.begin() + this->row_start[r];
+            const auto e = this->col.begin() + this->row_start[r + 1];
+            const auto p = std::lower_bound (b, e, c);
+            return (p != e && *p == c) ? this->val[p - this->col.begin()] : T{0};
+        }
+
+        /*!
+         * The matrix-vector product y = A x. The rows are shared between threads if you
+         * compile with OpenMP. x and y must be different vectors.
+         */
+        void multiply (const std::vector<T>& x, std::vector<T>& y) const
+        {
+            if (x.size() != this->cols) { throw std::runtime_error ("csr::multiply: x is the wrong size"); }
+            if (&x == &y) { throw std::runtime_error ("csr::multiply: x and y must be different vectors"); }
+            y.resize (this->rows);
+            const std::uint32_t* rs = this->row_start.data();
+            const std::uint32_t* c = this->col.data();
+            const T* v = this->val.data();
+            const T* xp = x.data();
+            T* yp = y.data();
+            const std::int64_t n = this->rows;
+#pragma omp parallel for
+            for (std::int64_t i = 0; i < n; ++i) {
+                T sum = T{0};
+                for (std::uint32_t k = rs[i]; k < rs[i + 1]; ++k) { sum += v[k] * xp[c[k]]; }
+                yp[i] = sum;
+            }
+        }
+
+        //! Return A x
+        std::vector<T> operator* (const std::vector<T>& x) const
+        {
+            std::vector<T> y;
+            this->multiply (x, y);
+            return y;
+        }
+
+        //! Multiply every entry by s
+        csr<T>& operator*= (const T s)
+        {
+            for (T& e : this->val) { e *= s; }
+            return *this;
+        }
+
+        //! The diagonal elements
+        std::vector<T> diagonal() const
+        {
+            std::vector<T> dg (std::min (this->rows, this->cols), T{0});
+            for (std::uint32_t r = 0; r < dg.size(); ++r) { dg[r] = this->at (r, r); }
+            return dg;
+        }
+
+        /*!
+         * Return I + beta A for a square matrix A. For a Laplacian matrix L, I - D dt L is
+         * the matrix of an implicit (backward Euler) diffusion step.
+         */
+        csr<T> identity_plus (const T beta) const
+        {
+            if (this->rows != this->cols) { throw std::runtime_error ("csr::identity_plus: the matrix is not square"); }
+            csr<T> m (this->rows, this->cols);
+            m.col.reserve (this->nnz() + this->rows);
+            m.val.reserve (this->nnz() + this->rows);
+            for (std::uint32_t r = 0; r < this->rows; ++r) {
+                bool diag_done = false;
+                for (std::uint32_t k = this->row_start[r]; k < this->row_start[r + 1]; ++k) {
+                    if (!diag_done && this->col[k] >= r) {
+                        if (this->col[k] == r) {
+                            m.col.push_back (r);
+                            m.val.push_back (T{1} + beta * this->val[k]);
+                            diag_done = true;
+                            continue;
+                        }
+                        m.col.push_back (r);
+                        m.val.push_back (T{1});
+                        diag_done = true;
+                    }
+                    m.col.push_back (this->col[k]);
+                    m.val.push_back (beta * this->val[k]);
+                }
+                if (!diag_done) {
+                    m.col.push_back (r);
+                    m.val.push_back (T{1});
+                }
+                m.row_start[r + 1] = static_cast<std::uint32_t>(m.col.size());
+            }
+            return m;
+        }
+
+        //! Is the matrix symmetric, to within tol?
+        bool is_symmetric (const T tol = T{0}) const
+        {
+            if (this->rows != this->cols) { return false; }
+            for (std::uint32_t r = 0; r < this->rows; ++r) {
+                for (std::uint32_t k = this->row_start[r]; k < this->row_start[r + 1]; ++k) {
+                    if (std::abs (this->val[k] - this->at (this->col[k], r)) > tol) { return false; }
+                }
+            }
+            return true;
+        }
+    };
+
+    //! What happened in a call to conjugate_gradient
+    template <typename T = float>
+    struct cg_result
+    {
+        std::uint32_t iterations = 0;
+        //! The final residual |b - Ax| relative to |b|
+        T residual = T{0};
+        bool converged = false;
+    };
+
+    /*!
+     * Solve A x = b for a symmetric positive definite matrix A by the conjugate gradient
+     * method, preconditioned with the diagonal of A (Jacobi). x holds the initial guess
+     * (if it is not the right size, the guess is zero) and receives the solution. The
+     * iteration stops when |b - Ax| <= tol |b|, or after max_iterations.
+     */
+    template <typename T>
+    cg_result<T> conjugate_gradient (const sm::csr<T>& A, const std::vector<T>& b, std::vector<T>& x,
+                                     const T tol = std::sqrt (std::numeric_limits<T>::epsilon()),
+                                     const std::uint32_t max_iterations = 1000)
+    {
+        if (A.rows != A.cols || b.size() != A.rows) {
+            throw std::runtime_error ("conjugate_gradient: A must be square and the same size as b");
+        }
+        const std::int64_t n = A.rows;
+        if (x.size() != b.size()) { x.assign (b.size(), T{0}); }
+
+        auto dot = [n](const std::vector<T>& a1, const std::vector<T>& a2)
+        {
+            T s = T{0};
+#pragma omp parallel for reduction(+:s)
+            for (std::int64_t i = 0; i < n; ++i) { s += a1[i] * a2[i]; }
+            return s;
+        };
+
+        std::vector<T> inv_diag = A.diagonal();
+        for (T& dg : inv_diag) {
+            if (!(dg > T{0})) { throw std::runtime_error ("conjugate_gradient: A must have a positive diagonal"); }
+            dg = T{1} / dg;
+        }
+
+        cg_result<T> res;
+        const T bnorm = std::sqrt (dot (b, b));
+        if (bnorm == T{0}) {
+            std::fill (x.begin(), x.end(), T{0});
+            res.converged = true;
+            return res;
+        }
+
+        std::vector<T> r (n);
+        std::vector<T> z (n);
+        std::vector<T> p (n);
+        std::vector<T> ap (n);
+        A.multiply (x, ap);
+#pragma omp parallel for
+        for (std::int64_t i = 0; i < n; ++i) {
+            r[i] = b[i] - ap[i];
+            z[i] = inv_diag[i] * r[i];
+            p[i] = z[i];
+        }
+        T rz = dot (r, z);
+        res.residual = std::sqrt (dot (r, r)) / bnorm;
+
+        while (res.residual > tol && res.iterations < max_iterations) {
+            A.multiply (p, ap);
+            const T pap = dot (p, ap);
+            if (!(pap > T{0})) { break; } // A is not positive definite (or p has vanished)
+            const T alpha = rz / pap;
+#pragma omp parallel for
+            for (std::int64_t i = 0; i < n; ++i) {
+                x[i] += alpha * p[i];
+                r[i] -= alpha * ap[i];
+                z[i] = inv_diag[i] * r[i];
+            }
+            const T rz_next = dot (r, z);
+            const T beta = rz_next / rz;
+            rz = rz_next;
+#pragma omp parallel for
+            for (std::int64_t i = 0; i < n; ++i) { p[i] = z[i] + beta * p[i]; }
+            ++res.iterations;
+            res.residual = std::sqrt (dot (r, r)) / bnorm;
+        }
+        res.converged = res.residual <= tol;
+        return res;
+    }
+}
@@ -0,0 +1,104 @@
+// -*- C++ -*-
+/*
+ * This file is part of sebsjames/maths, a library of maths code for modern C++
+ *
+ * See https://github.com/sebsjames/maths
+ *
+ * Fast Fourier transforms (radix-2, in place) for use in convolutions
+ *
+ * Author: Seb James
+ */
+module;
+
+#include <cstdint>
+#include <cstddef>
+#include <complex>
+#include <span>
+#include <vector>
+#include <cmath>
+#include <utility>
+#include <stdexcept>
+
+export module sm.fft;
+
+import sm.mathconst;
+
+export namespace sm::algo
+{
+    //! Return the smallest power of two that is >= n (and >= 1)
+    constexpr std::size_t next_pow2 (const std::size_t n)
+    {
+        std::size_t p = 1;
+        while (p < n) { p <<= 1; }
+        return p;
+    }
+
+    /*!
+     * In-place, radix-2 fast Fourier transform of the data in a, whose size must be a power of
+     * two. The forward transform computes A[k] = sum_j a[j] exp(-2 pi i j k / n). If inverse is
+     * true, the inverse transform is computed, including the 1/n normalisation, so that
+     * fft(fft(a), true) returns a.
+     */
+    template <typename F>
+    void fft (std::span<std::complex<F>> a, const bool inverse = false)
+    {
+        const std::size_t n = a.size();
+        if (n == 0 || (n & (n - 1)) != 0) {
+            throw std::runtime_error ("sm::algo::fft: size must be a power of two");
+        }
+
+        // Bit reversal permutation
+        for (std::size_t i = 1, j = 0; i < n; ++i) {
+            std::size_t bit = n >> 1;
+            for (; j & bit; bit >>= 1) { j ^= bit; }
+            j ^= bit;
+            if (i < j) { std::swap (a[i], a[j]); }
+        }
+
+        // Butterflies
+        for (std::size_t len = 2; len <= n; len <<= 1) {
+            const F ang = (inverse ? F{1} : F{-1}) * sm::mathconst<F>::two_pi / static_cast<F>(len);
+            const std::size_t half = len / 2;
+            for (std::size_t k = 0; k < half; ++k) {
+                // Compute each twiddle factor directly, which is more accurate than recurrence
+                const std::complex<F> wk = std::polar (F{1}, ang * static_cast<F>(k));
+                for (std::size_t i = 0; i < n; i += len) {
+                    const std::complex<F> u = a[i + k];
+                    const std::complex<F> v = a[i + k + half] * wk;
+                    a[i + k] = u + v;
+                    a[i + k + half] = u - v;
+                }
+            }
+        }
+
+        if (inverse) {
+            const F one_over_n = F{1} / static_cast<F>(n);
+            for (auto& ai : a) { ai *= one_over_n; }
+        }
+    }
+
+    /*!
+     * In-place 2D FFT of the w by h array a, stored row by row (element (x, y) at a[y * w + x]).
+     * w and h must both be powers of two. Rows are transformed, then columns.
+     */
+    template <typename F>
+    void fft_2d (std::span<std::complex<F>> a, const std::size_t w, const std::size_t h, const bool inverse = false)
+    {
+        if (a.size() != w * h) {
+            throw std::runtime_error ("sm::algo::fft_2d: size of a must be w * h");
+        }
+        const std::int64_t hh = static_cast<std::int64_t>(h);
+        const std::int64_t ww = static_cast<std::int64_t>(w);
+#pragma omp parallel for
+        for (std::int64_t y = 0; y < hh; ++y) {
+            sm::algo::fft<F> (a.subspan (y * w, w), inverse);
+        }
+#pragma omp parallel for
+        for (std::int64_t x = 0; x < ww; ++x) {
+            std::vector<std::complex<F>> col (h);
+            for (std::size_t y = 0; y < h; ++y) { col[y] = a[y * w + x]; }
+            sm::algo::fft<F> (std::span<std::complex<F>>(col), inverse);
+            for (std::size_t y = 0; y < h; ++y) { a[y * w + x] = col[y]; }
+        }
+    }
+}
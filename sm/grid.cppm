@@ -22,7 +22,10 @@ module;
 #include <limits>
 #include <type_traits>
 #include <vector>
-#include <set>
+#include <array>
+#include <span>
+#include <algorithm>
+#include <utility>
 
 export module sm.grid;
 
@@ -80,6 +83,13 @@ export namespace sm
         topleft_to_bottomright_colmaj
     };
 
+    //! How values beyond a non-wrapped edge of the grid are treated by operations such as grid::apply_stencil
+    enum class gridedge
+    {
+        zero,  // Elements beyond the edge are taken to have the value 0
+        clamp  // Elements beyond the edge take the value of the nearest element on the grid
+    };
+
     /*!
      * \brief A grid class to define a rectangular Cartesian grid of locations
      *
@@ -119,8 +129,13 @@ export namespace sm
      * cases a floating point type will be used, but this could also be a signed integer type. A
      * compiled time test will be performed to ensure it is a signed type.
      *
+     * \tparam store_coords If true (the default), the coordinate of every element is computed once,
+     * in init(), and stored in v_c. If false, v_c is left empty and coordinates are computed on the
+     * fly whenever they are requested. This makes construction O(1) and saves 2 * sizeof(C) bytes
+     * per element, which matters for very large grids, at the cost of a little arithmetic per
+     * coordinate lookup.
      */
-    template<typename I = std::uint32_t, typename C = float>
+    template<typename I = std::uint32_t, typename C = float, bool store_coords = true>
     struct grid
     {
     private:
@@ -215,7 +230,7 @@ export namespace sm
                     // re-call this function until we find something that works.
                     const I possible_additional = std::numeric_limits<I>::max() - num_elements;
                     for (I j = num_elements + I{1}; j < num_elements + possible_additional; ++j) {
-                        w_h = sm::grid<I, C>::suggest_dims (j, false);
+                        w_h = sm::grid<I, C, store_coords>::suggest_dims (j, false);
                         if (w_h != sm::vec<I, 2>{ std::numeric_limits<I>::max(), std::numeric_limits<I>::max() }) {
                             // success!
                             break;
@@ -302,8 +317,8 @@ export namespace sm
             this->init();
         }
 
-        //! Set up memory and populate v_c. Called if parameters w, h, offset
-        //! or order change. Does not need to change if wrap changes, as neighbour
+        //! Set up memory and populate v_c (if store_coords is true). Called if parameters w, h,
+        //! offset or order change. Does not need to change if wrap changes, as neighbour
         //! relationships are always runtime computed.
         void init()
         {
@@ -331,14 +346,23 @@ export namespace sm
                 }
             }
 
-            this->v_c.resize (this->n());
-            for (I i = 0; i < this->n(); ++i) { this->v_c[i] = this->coord (i); }
+            if constexpr (store_coords) {
+                this->v_c.resize (this->n());
+                for (I i = 0; i < this->n(); ++i) { this->v_c[i] = this->coord (i); }
+            } else {
+                this->v_c.clear();
+            }
         }
 
-        //! Indexing the grid will return a memorized vec location.
+        //! Indexing the grid will return a memorized vec location (or, if store_coords is false, a
+        //! computed location).
         sm::vec<C, 2> operator[] (const I index) const
         {
-            return index >= this->n() ? sm::vec<C, 2>{std::numeric_limits<C>::max(), std::numeric_limits<C>::max()} : this->v_c[index];
+            if constexpr (store_coords) {
+                return index >= this->n() ? sm::vec<C, 2>{std::numeric_limits<C>::max(), std::numeric_limits<C>::max()} : this->v_c[index];
+            } else {
+                return this->coord (index);
+            }
         }
 
         //! A function to find the index of the grid that is closest to the given coordinate.
@@ -379,10 +403,7 @@ export namespace sm
         }
 
         //! A named function that does the same as operator[]
-        sm::vec<C, 2> coord_lookup (const I index) const
-        {
-            return index >= this->n() ? sm::vec<C, 2>{std::numeric_limits<C>::max(), std::numeric_limits<C>::max()} : this->v_c[index];
-        }
+        sm::vec<C, 2> coord_lookup (const I index) const { return (*this)[index]; }
 
         //! Return the coordinate in polar coordinates
         sm::vec<C, 2> polar_lookup (const I index) const
@@ -696,10 +717,10 @@ export namespace sm
             sm::vvec<C> abscissae (w, C{0});
             if (order == gridorder::bottomleft_to_topright || order == gridorder::topleft_to_bottomright) {
                 // abscissae is just the first width values.
-                for (I i = I{0}; i < w; ++i) { abscissae[i] = v_c[i][0]; }
+                for (I i = I{0}; i < w; ++i) { abscissae[i] = (*this)[i][0]; }
             } else {
                 // For column major, we have to skip each row
-                for (I i = I{0}; i < w; ++i) { abscissae[i] = v_c[i*h][0]; }
+                for (I i = I{0}; i < w; ++i) { abscissae[i] = (*this)[i*h][0]; }
             }
             return abscissae;
         }
@@ -709,10 +730,10 @@ export namespace sm
         {
             sm::vvec<C> ordinates (h, C{0});
             if (order == gridorder::bottomleft_to_topright || order == gridorder::topleft_to_bottomright) {
-                for (I i = I{0}; i < h; ++i) { ordinates[i] = v_c[i*w][1]; }
+                for (I i = I{0}; i < h; ++i) { ordinates[i] = (*this)[i*w][1]; }
             } else {
                 // For column major, ordinates is just the first height values
-                for (I i = I{0}; i < h; ++i) { ordinates[i] = v_c[i][1]; }
+                for (I i = I{0}; i < h; ++i) { ordinates[i] = (*this)[i][1]; }
             }
             return ordinates;
         }
@@ -799,6 +820,141 @@ export namespace sm
             return this->rowmaj() ? new_row * this->w + new_col : new_col * this->h + new_row;
         }
 
+        /*!
+         * Apply a 5-point or 9-point stencil to the data in, writing the result into out (which
+         * must not be the same memory as in). Both in and out must contain n() elements.
+         *
+         * The weights are given in the order in which you would write the stencil down: the
+         * northern row first, each row from west to east:
+         *
+         *   9-point: { nw, n, ne, w, c, e, sw, s, se }
+         *   5-point: {     n,     w, c, e,     s     }
+         *
+         * so that a 5-point Laplacian is { 1, 1, -4, 1, 1 }. Neighbours beyond a wrapped edge
+         * are taken from the opposite side of the grid. Beyond a non-wrapped edge, the value is
+         * set by edge: 0 for gridedge::zero, or the value of the nearest element on the grid for
+         * gridedge::clamp.
+         *
+         * The stencil is first transformed into the memory layout given by the grid's order, so
+         * that the interior of each line of memory is computed by a branch-free loop over
+         * contiguous data. The first and last element of each line, and the lines beyond the
+         * edges, are handled separately.
+         */
+        template <std::uint32_t Npts, typename T> requires (Npts == 5 || Npts == 9)
+        void apply_stencil (const sm::vec<T, Npts>& weights,
+                            const std::type_identity_t<std::span<const T>> in,
+                            const std::type_identity_t<std::span<T>> out,
+                            const gridedge edge = gridedge::zero) const
+        {
+            if (in.size() != static_cast<std::size_t>(this->n()) || out.size() != static_cast<std::size_t>(this->n())) {
+                throw std::runtime_error ("grid::apply_stencil: in and out must have n() elements");
+            }
+            if (in.data() == out.data()) {
+                throw std::runtime_error ("grid::apply_stencil: in and out must not be the same data");
+            }
+
+            // Expand the weights to a 3x3 array indexed [dy + 1][dx + 1], with dy positive to the north
+            std::array<std::array<T, 3>, 3> wxy = {};
+            if constexpr (Npts == 9) {
+                for (std::uint32_t r = 0; r < 3; ++r) {
+                    for (std::uint32_t c = 0; c < 3; ++c) { wxy[2 - r][c] = weights[r * 3 + c]; }
+                }
+            } else {
+                wxy[2][1] = weights[0];
+                wxy[1][0] = weights[1];
+                wxy[1][1] = weights[2];
+                wxy[1][2] = weights[3];
+                wxy[0][1] = weights[4];
+            }
+
+            // Transform to memory space: wm[d_outer + 1][d_inner + 1], where the inner dimension
+            // is the contiguous one (along a row for row-major orders, along a column otherwise)
+            const bool rm = this->rowmaj();
+            const bool ydown = (this->order == gridorder::topleft_to_bottomright
+                                || this->order == gridorder::topleft_to_bottomright_colmaj);
+            std::array<std::array<T, 3>, 3> wm = {};
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    const int my = ydown ? -dy : dy;
+                    const int di = rm ? dx : my;
+                    const int dout = rm ? my : dx;
+                    wm[dout + 1][di + 1] = wxy[dy + 1][dx + 1];
+                }
+            }
+
+            const bool wrap_x = (this->wrap == griddomainwrap::horizontal || this->wrap == griddomainwrap::both);
+            const bool wrap_y = (this->wrap == griddomainwrap::vertical || this->wrap == griddomainwrap::both);
+            const bool wrap_inner = rm ? wrap_x : wrap_y;
+            const bool wrap_outer = rm ? wrap_y : wrap_x;
+            const std::int64_t ni = rm ? this->w : this->h;
+            const std::int64_t no = rm ? this->h : this->w;
+            const T* src = in.data();
+            T* dst = out.data();
+
+#pragma omp parallel for
+            for (std::int64_t o = 0; o < no; ++o) {
+                // The three lines of memory that the stencil covers. A line beyond a non-wrapped
+                // edge is replaced by the centre line, with zero weights for gridedge::zero.
+                std::array<const T*, 3> line = {};
+                std::array<std::array<T, 3>, 3> lw = wm;
+                for (std::int64_t k = -1; k <= 1; ++k) {
+                    std::int64_t ok = o + k;
+                    if (ok < 0 || ok >= no) {
+                        if (wrap_outer) {
+                            ok = (ok + no) % no;
+                        } else {
+                            ok = o;
+                            if (edge == gridedge::zero) { lw[k + 1] = { T{0}, T{0}, T{0} }; }
+                        }
+                    }
+                    line[k + 1] = src + ok * ni;
+                }
+                T* d = dst + o * ni;
+
+                // The branch-free interior of the line
+                const T* l0 = line[0];
+                const T* l1 = line[1];
+                const T* l2 = line[2];
+                const T w01 = lw[0][1], w10 = lw[1][0], w11 = lw[1][1], w12 = lw[1][2], w21 = lw[2][1];
+                if constexpr (Npts == 9) {
+                    const T w00 = lw[0][0], w02 = lw[0][2], w20 = lw[2][0], w22 = lw[2][2];
+                    for (std::int64_t i = 1; i < ni - 1; ++i) {
+                        d[i] = w00 * l0[i - 1] + w01 * l0[i] + w02 * l0[i + 1]
+                        + w10 * l1[i - 1] + w11 * l1[i] + w12 * l1[i + 1]
+                        + w20 * l2[i - 1] + w21 * l2[i] + w22 * l2[i + 1];
+                    }
+                } else {
+                    for (std::int64_t i = 1; i < ni - 1; ++i) {
+                        d[i] = w01 * l0[i] + w10 * l1[i - 1] + w11 * l1[i] + w12 * l1[i + 1] + w21 * l2[i];
+                    }
+                }
+
+                // The first and last elements of the line, which may wrap or lie on an edge
+                auto line_end = [&](const std::int64_t i)
+                {
+                    T v = T{0};
+                    for (std::uint32_t k = 0; k < 3; ++k) {
+                        for (std::int64_t m = -1; m <= 1; ++m) {
+                            std::int64_t ii = i + m;
+                            if (ii < 0 || ii >= ni) {
+                                if (wrap_inner) {
+                                    ii = (ii + ni) % ni;
+                                } else if (edge == gridedge::clamp) {
+                                    ii = i;
+                                } else {
+                                    continue;
+                                }
+                            }
+                            v += lw[k][m + 1] * line[k][ii];
+                        }
+                    }
+                    d[i] = v;
+                };
+                line_end (0);
+                if (ni > 1) { line_end (ni - 1); }
+            }
+        }
+
         /*!
          * Resampling function (monochrome).
          *
@@ -862,15 +1018,16 @@ export namespace sm
             sm::vec<float, 2> threesig = 3.0f * dist_per_pix;
 
 #pragma omp parallel for // parallel on this outer loop gives best result (5.8 s vs 7 s)
-            for (typename std::vector<float>::size_type xi = 0u; xi < this->v_c.size(); ++xi) {
+            for (typename std::vector<float>::size_type xi = 0u; xi < static_cast<std::size_t>(this->n()); ++xi) {
                 float expr = 0.0f;
+                const sm::vec<C, 2> c_xi = (*this)[static_cast<I>(xi)];
                 for (std::uint32_t i = 0; i < csz; ++i) {
                     // Get x/y pixel coords:
                     sm::vec<std::uint32_t, 2> idx = {(i % image_pixelsz[0]), (i / image_pixelsz[0])};
                     // Get the coordinates of the input pixel at index idx (in target units):
                     sm::vec<float, 2> posn = (dist_per_pix * idx) + image_offset;
                     // Distance from input pixel to output pixel:
-                    sm::vec<float, 2> _v_c = this->v_c[xi] - posn;
+                    sm::vec<float, 2> _v_c = c_xi - posn;
                     // Compute contributions to each grid pixel, using 2D (elliptical) Gaussian
                     if (_v_c < threesig) { // Testing for distance gives slight speedup
                         expr += std::exp ( - ( (params[0] * _v_c[0] * _v_c[0]) + (params[1] * _v_c[1] * _v_c[1]) ) ) * image_data[i];
@@ -883,47 +1040,214 @@ export namespace sm
             return expr_resampled;
         }
 
+        /*!
+         * Call f(index) for every element whose coordinate p lies within the axis-aligned box of
+         * half-widths half_extent centred on loc and for which inside(p) returns true. This is
+         * the core of the range queries below. Only the elements in the index bounding box of
+         * the region are visited (row by row), so the cost is proportional to the area of the
+         * region, not to the size of the grid.
+         *
+         * If the grid wraps, the region may extend across the domain edges; p is then the
+         * coordinate of the periodic image of the element that lies within the bounding box. If
+         * the box is wider (or taller) than the grid, each element is visited once, using the
+         * image closest to loc.
+         */
+        template <typename P, typename F>
+        void for_each_in_box (const sm::vec<C, 2> loc, const sm::vec<C, 2> half_extent, P&& inside, F&& f) const
+        {
+            const bool ydown = (order == sm::gridorder::topleft_to_bottomright
+                                || order == sm::gridorder::topleft_to_bottomright_colmaj);
+            const bool wrap_x = (wrap == griddomainwrap::horizontal || wrap == griddomainwrap::both);
+            const bool wrap_y = (wrap == griddomainwrap::vertical || wrap == griddomainwrap::both);
+            const C ystep = ydown ? -this->dx[1] : this->dx[1];
+
+            // Find the range [lo, hi] of column (or row) numbers that covers [centre - half,
+            // centre + half]. The range is widened by one element at each end so that rounding
+            // never loses an element on the boundary; inside() makes the final decision.
+            auto index_range = [](const C centre, const C half, const C origin, const C step,
+                                  const I n, const bool wrapped, std::int64_t& lo, std::int64_t& hi)
+            {
+                double a = (static_cast<double>(centre) - static_cast<double>(half) - static_cast<double>(origin)) / static_cast<double>(step);
+                double b = (static_cast<double>(centre) + static_cast<double>(half) - static_cast<double>(origin)) / static_cast<double>(step);
+                if (a > b) { std::swap (a, b); }
+                lo = static_cast<std::int64_t>(std::floor (a)) - 1;
+                hi = static_cast<std::int64_t>(std::ceil (b)) + 1;
+                const std::int64_t nn = static_cast<std::int64_t>(n);
+                if (wrapped) {
+                    if (hi - lo + 1 > nn) {
+                        const double mid = (static_cast<double>(centre) - static_cast<double>(origin)) / static_cast<double>(step);
+                        lo = static_cast<std::int64_t>(std::llround (mid)) - (nn - 1) / 2;
+                        hi = lo + nn - 1;
+                    }
+                } else {
+                    lo = std::max (lo, std::int64_t{0});
+                    hi = std::min (hi, nn - 1);
+                }
+            };
+
+            std::int64_t c_lo = 0, c_hi = 0, r_lo = 0, r_hi = 0;
+            index_range (loc[0], half_extent[0], this->offset[0], this->dx[0], this->w, wrap_x, c_lo, c_hi);
+            index_range (loc[1], half_extent[1], this->offset[1], ystep, this->h, wrap_y, r_lo, r_hi);
+
+            const std::int64_t iw = static_cast<std::int64_t>(this->w);
+            const std::int64_t ih = static_cast<std::int64_t>(this->h);
+            const bool rm = this->rowmaj();
+            sm::vec<C, 2> p = { C{0}, C{0} };
+            for (std::int64_t r = r_lo; r <= r_hi; ++r) {
+                const I r_mem = static_cast<I>(wrap_y ? ((r % ih) + ih) % ih : r);
+                p[1] = this->offset[1] + ystep * static_cast<C>(r);
+                for (std::int64_t c = c_lo; c <= c_hi; ++c) {
+                    p[0] = this->offset[0] + this->dx[0] * static_cast<C>(c);
+                    if (!inside (p)) { continue; }
+                    const I c_mem = static_cast<I>(wrap_x ? ((c % iw) + iw) % iw : c);
+                    f (rm ? r_mem * this->w + c_mem : c_mem * this->h + r_mem);
+                }
+            }
+        }
+
+        //! Call f(index) for each element whose coordinate is less than radius from loc
+        template <typename F>
+        void for_each_in_radius (const sm::vec<C, 2> loc, const C radius, F&& f) const
+        {
+            const C r2 = radius * radius;
+            this->for_each_in_box (loc, sm::vec<C, 2>{ radius, radius },
+                                   [loc, r2](const sm::vec<C, 2>& p) { return (p - loc).sos() < r2; },
+                                   std::forward<F>(f));
+        }
+
+        //! Call f(index) for each element whose coordinate lies in the rectangle with corners
+        //! lo and hi (inclusive of the edges)
+        template <typename F>
+        void for_each_in_rectangle (const sm::vec<C, 2> lo, const sm::vec<C, 2> hi, F&& f) const
+        {
+            this->for_each_in_box ((lo + hi) / C{2}, (hi - lo) / C{2},
+                                   [lo, hi](const sm::vec<C, 2>& p) {
+                                       return p[0] >= lo[0] && p[0] <= hi[0] && p[1] >= lo[1] && p[1] <= hi[1];
+                                   },
+                                   std::forward<F>(f));
+        }
+
+        //! Call f(index) for each element whose distance d from loc satisfies r_inner <= d < r_outer
+        template <typename F>
+        void for_each_in_annulus (const sm::vec<C, 2> loc, const C r_inner, const C r_outer, F&& f) const
+        {
+            const C ri2 = r_inner * r_inner;
+            const C ro2 = r_outer * r_outer;
+            this->for_each_in_box (loc, sm::vec<C, 2>{ r_outer, r_outer },
+                                   [loc, ri2, ro2](const sm::vec<C, 2>& p) {
+                                       const C d2 = (p - loc).sos();
+                                       return d2 >= ri2 && d2 < ro2;
+                                   },
+                                   std::forward<F>(f));
+        }
+
+        //! Call f(index) for each element inside the axis-aligned ellipse centred on loc with
+        //! semi-axes semi_axes[0] (in x) and semi_axes[1] (in y)
+        template <typename F>
+        void for_each_in_ellipse (const sm::vec<C, 2> loc, const sm::vec<C, 2> semi_axes, F&& f) const
+        {
+            this->for_each_in_box (loc, semi_axes,
+                                   [loc, semi_axes](const sm::vec<C, 2>& p) {
+                                       const sm::vec<C, 2> d = (p - loc) / semi_axes;
+                                       return d.sos() < C{1};
+                                   },
+                                   std::forward<F>(f));
+        }
+
         /*!
          * Returns all the indices of the grid with a given radius (radius argument) of a given (x,y) location (loc argument)
          *
+         * The first index is always that of the element nearest to loc (index_lookup (loc)),
+         * even if its centre lies outside the circle. The others follow ring by ring outwards
+         * from it, where ring k holds the elements that are k row and column steps (across
+         * any wrapped edges) from the first. Within a ring they are in memory order.
+         *
+         * The indices are found by visiting the elements in the bounding box of the circle row
+         * by row, so the cost is proportional to radius squared. If the grid wraps, the circle
+         * extends across the wrapped edges. loc must lie on the grid; the callback and output
+         * iterator forms have no such requirement.
+         *
          * \param loc (x,y) metric location of the center of the circle
          * \param radius radius defining the circle
-         * \param inds_in_radius A vector of indices within the circle - supplied as a reference
+         * \param inds_in_radius A vector of indices within the circle - supplied as a reference. The indices are appended.
          */
         void indices_in_radius (const sm::vec<C,2> loc,
                                 const C radius,
                                 sm::vvec<I>& inds_in_radius) const
         {
-            sm::vvec<I> inds_in_circle;
-            sm::vvec<I> inds_in_previous_circle;
-            std::set<I> seen;
-
             // Find first index (middle of circle)
-            I current_ind = this->index_lookup (loc);
-            inds_in_radius.push_back (current_ind);
-            seen.insert (current_ind);
-            inds_in_circle.push_back (current_ind);
-
-            while (!inds_in_circle.empty()) {
-
-                inds_in_previous_circle = inds_in_circle;
-                inds_in_circle.clear();
-                sm::vvec<I> nearest_neighbours;
-                this->find_nearest_neighbours (inds_in_previous_circle, nearest_neighbours);
-
-                for (auto n : nearest_neighbours) {
-                    if (!seen.count(n)) {
-                        if ((this->coord_lookup (n) - loc).length() < radius) {
-                            inds_in_circle.push_back (n);
-                        }
-                    }
-                    seen.insert(n);
-                }
-
-                if (!inds_in_circle.empty()) {
-                    inds_in_radius.concat (inds_in_circle);
-                }
+            const I centre = this->index_lookup (loc);
+            inds_in_radius.push_back (centre);
+            const std::size_t first = inds_in_radius.size();
+            this->for_each_in_radius (loc, radius, [&inds_in_radius, centre](const I i) {
+                if (i != centre) { inds_in_radius.push_back (i); }
+            });
+
+            // The number of row and column steps from the centre to element i
+            const std::int64_t iw = static_cast<std::int64_t>(this->w);
+            const std::int64_t ih = static_cast<std::int64_t>(this->h);
+            const bool wrap_x = (wrap == griddomainwrap::horizontal || wrap == griddomainwrap::both);
+            const bool wrap_y = (wrap == griddomainwrap::vertical || wrap == griddomainwrap::both);
+            const bool rm = this->rowmaj();
+            auto col_row = [iw, ih, rm](const I i) -> std::array<std::int64_t, 2>
+            {
+                const std::int64_t ii = static_cast<std::int64_t>(i);
+                return rm ? std::array<std::int64_t, 2>{ ii % iw, ii / iw } : std::array<std::int64_t, 2>{ ii / ih, ii % ih };
+            };
+            const std::array<std::int64_t, 2> cr0 = col_row (centre);
+
+            // Counting sort by ring, which keeps memory order within each ring. Each ring is
+            // computed once; count per ring, prefix-sum the counts, then scatter.
+            const std::size_t n = inds_in_radius.size() - first;
+            std::vector<std::size_t> rings (n);
+            std::size_t max_ring = 0;
+            for (std::size_t k = 0; k < n; ++k) {
+                const std::array<std::int64_t, 2> cr = col_row (inds_in_radius[first + k]);
+                std::int64_t dc = std::abs (cr[0] - cr0[0]);
+                std::int64_t dr = std::abs (cr[1] - cr0[1]);
+                if (wrap_x) { dc = std::min (dc, iw - dc); }
+                if (wrap_y) { dr = std::min (dr, ih - dr); }
+                rings[k] = static_cast<std::size_t>(dc + dr);
+                max_ring = std::max (max_ring, rings[k]);
             }
+            std::vector<std::size_t> offsets (max_ring + 2, 0);
+            for (std::size_t k = 0; k < n; ++k) { ++offsets[rings[k] + 1]; }
+            for (std::size_t r = 1; r < offsets.size(); ++r) { offsets[r] += offsets[r - 1]; }
+            std::vector<I> sorted (n);
+            for (std::size_t k = 0; k < n; ++k) { sorted[offsets[rings[k]]++] = inds_in_radius[first + k]; }
+            std::copy (sorted.begin(), sorted.end(), inds_in_radius.begin() + first);
+        }
+
+        //! Write the indices within radius of loc to the output iterator out
+        template <typename OutputIt>
+        OutputIt indices_in_radius (const sm::vec<C,2> loc, const C radius, OutputIt out) const
+        {
+            this->for_each_in_radius (loc, radius, [&out](const I i) { *out++ = i; });
+            return out;
+        }
+
+        //! Write the indices in the rectangle with corners lo and hi to the output iterator out
+        template <typename OutputIt>
+        OutputIt indices_in_rectangle (const sm::vec<C,2> lo, const sm::vec<C,2> hi, OutputIt out) const
+        {
+            this->for_each_in_rectangle (lo, hi, [&out](const I i) { *out++ = i; });
+            return out;
+        }
+
+        //! Write the indices in the annulus r_inner <= d < r_outer around loc to the output iterator out
+        template <typename OutputIt>
+        OutputIt indices_in_annulus (const sm::vec<C,2> loc, const C r_inner, const C r_outer, OutputIt out) const
+        {
+            this->for_each_in_annulus (loc, r_inner, r_outer, [&out](const I i) { *out++ = i; });
+            return out;
+        }
+
+        //! Write the indices in the axis-aligned ellipse around loc to the output iterator out
+        template <typename OutputIt>
+        OutputIt indices_in_ellipse (const sm::vec<C,2> loc, const sm::vec<C,2> semi_axes, OutputIt out) const
+        {
+            this->for_each_in_ellipse (loc, semi_axes, [&out](const I i) { *out++ = i; });
+            return out;
         }
 
         /*!
@@ -949,7 +1273,7 @@ export namespace sm
         }
 
         //! This vector structure contains the coords for this grid. Note that it is public and so
-        //! acccessible by client code
+        //! acccessible by client code. It is empty if store_coords is false.
         sm::vvec<sm::vec<C, 2>> v_c;
     };
 
@@ -0,0 +1,275 @@
+// -*- C++ -*-
+/*!
+ * This file is part of sebsjames/maths, a library of maths code for modern C++
+ *
+ * See https://github.com/sebsjames/maths
+ *
+ * \file
+ *
+ * This file contains sm::grid_pyramid, a sequence of successively coarser sm::grids, along with
+ * the full-weighting restriction and bilinear prolongation operators that move data between
+ * them. These are the building blocks of multigrid solvers.
+ *
+ * \author Seb James
+ * \date 2026
+ */
+module;
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <stdexcept>
+
+export module sm.grid_pyramid;
+
+export import sm.vec;
+export import sm.vvec;
+export import sm.grid;
+
+export namespace sm
+{
+    /*!
+     * \brief A multiresolution pyramid of sm::grids
+     *
+     * Level 0 is the finest grid (the one passed to the constructor). Each subsequent level has
+     * twice the element spacing, dx, of the level before. Element (c, r) of level l+1 lies at the
+     * same location as element (2c, 2r) of level l, so all levels share the same offset, order
+     * and wrapping. In a non-wrapped dimension of n elements, the coarser level has (n + 1) / 2
+     * elements; in a wrapped dimension the number of elements must be even and the coarser
+     * level has n / 2.
+     *
+     * restriction() transfers data from a level to the next coarser one using the 'full
+     * weighting' 3x3 stencil (1/16)[1 2 1; 2 4 2; 1 2 1]. prolongation() transfers data from a
+     * level to the next finer one by bilinear interpolation. Together these let you write
+     * multigrid (V-cycle) solvers for Poisson or diffusion problems on sm::grid data.
+     *
+     * \tparam I The index type of the grids
+     *
+     * \tparam C The coordinate type of the grids
+     *
+     * \tparam store_coords Passed on to each sm::grid in the pyramid
+     */
+    template<typename I = std::uint32_t, typename C = float, bool store_coords = true>
+    struct grid_pyramid
+    {
+        using grid_t = sm::grid<I, C, store_coords>;
+
+        //! Construct with the finest grid, g. Coarser levels are added until max_levels levels
+        //! exist, or until a level could not be coarsened further (a dimension would drop below
+        //! 2 elements, or a wrapped dimension has an odd number of elements).
+        grid_pyramid (const grid_t& g, const std::uint32_t max_levels = 32)
+        {
+            if (max_levels == 0u) { throw std::runtime_error ("grid_pyramid: max_levels must be at least 1"); }
+            this->levels.push_back (g);
+            while (this->levels.size() < max_levels) {
+                const grid_t& f = this->levels.back();
+                I cw = I{0};
+                I ch = I{0};
+                if (!grid_pyramid::coarsened (f.get_w(), wraps_x (f), cw)
+                    || !grid_pyramid::coarsened (f.get_h(), wraps_y (f), ch)) {
+                    break;
+                }
+                this->levels.emplace_back (cw, ch, f.get_dx() * C{2}, f.get_offset(), f.get_wrap(), f.get_order());
+            }
+        }
+
+        //! The number of levels in the pyramid
+        std::size_t size() const { return this->levels.size(); }
+
+        //! Access the grid at level l (0 is the finest)
+        const grid_t& operator[] (const std::size_t l) const { return this->levels[l]; }
+
+        /*!
+         * Restrict the data fine, which lives on level l, to the next coarser level, l+1, placing
+         * the result in coarse (which is resized if necessary).
+         *
+         * Each coarse value is the full-weighting average of the 3x3 block of fine values
+         * centred on the coincident fine element. At a non-wrapped edge, the weights of the
+         * elements that lie beyond the edge are dropped and the remaining weights renormalised,
+         * so that a constant field restricts to the same constant.
+         */
+        template <typename T>
+        void restriction (const std::size_t l, const sm::vvec<T>& fine, sm::vvec<T>& coarse) const
+        {
+            this->check_level (l);
+            const grid_t& gf = this->levels[l];
+            const grid_t& gc = this->levels[l + 1];
+            if (fine.size() != static_cast<std::size_t>(gf.n())) {
+                throw std::runtime_error ("grid_pyramid::restriction: fine data size does not match its grid");
+            }
+            coarse.resize (gc.n());
+
+            const layout f = layout::of (gf);
+            const layout c = layout::of (gc);
+
+#pragma omp parallel for
+            for (std::int64_t co = 0; co < c.n_outer; ++co) {
+                // The three fine lines that contribute to this coarse line, and their weights
+                const std::int64_t fo = 2 * co;
+                const T* line[3] = { nullptr, nullptr, nullptr };
+                T wl[3] = { T{1}, T{2}, T{1} };
+                for (std::int64_t k = 0; k < 3; ++k) {
+                    std::int64_t o = fo + k - 1;
+                    if (f.wrap_outer) { o = (o + f.n_outer) % f.n_outer; }
+                    if (o < 0 || o >= f.n_outer) {
+                        wl[k] = T{0};
+                        o = fo;
+                    }
+                    line[k] = fine.data() + o * f.n_inner;
+                }
+                const T wsum = wl[0] + wl[1] + wl[2];
+                T* out = coarse.data() + co * c.n_inner;
+
+                // Interior of the line, for which fine elements 2ci - 1 and 2ci + 1 always exist
+                const std::int64_t ci_last = (2 * (c.n_inner - 1) + 1 < f.n_inner) ? c.n_inner - 1 : c.n_inner - 2;
+                const T norm = T{1} / (wsum * T{4});
+                for (std::int64_t ci = 1; ci <= ci_last; ++ci) {
+                    const std::int64_t fi = 2 * ci;
+                    T s = T{0};
+                    for (std::int64_t k = 0; k < 3; ++k) {
+                        s += wl[k] * (line[k][fi - 1] + T{2} * line[k][fi] + line[k][fi + 1]);
+                    }
+                    out[ci] = s * norm;
+                }
+                // The ends of the line
+                for (std::int64_t ci : { std::int64_t{0}, c.n_inner - 1 }) {
+                    if (ci >= 1 && ci <= ci_last) { continue; }
+                    const std::int64_t fi = 2 * ci;
+                    T s = T{0};
+                    T wi_sum = T{0};
+                    for (std::int64_t j = -1; j <= 1; ++j) {
+                        std::int64_t i = fi + j;
+                        if (f.wrap_inner) { i = (i + f.n_inner) % f.n_inner; }
+                        if (i < 0 || i >= f.n_inner) { continue; }
+                        const T wi = (j == 0) ? T{2} : T{1};
+                        wi_sum += wi;
+                        for (std::int64_t k = 0; k < 3; ++k) { s += wl[k] * wi * line[k][i]; }
+                    }
+                    out[ci] = s / (wsum * wi_sum);
+                }
+            }
+        }
+
+        /*!
+         * Prolong (interpolate) the data coarse, which lives on level l+1, to the next finer
+         * level, l, placing the result in fine (which is resized if necessary).
+         *
+         * Fine elements that coincide with coarse elements take the coarse value; the others
+         * are bilinearly interpolated from the two or four surrounding coarse elements. A fine
+         * element beyond the last coarse element of a non-wrapped dimension (which exists when
+         * that dimension of the fine grid has an even number of elements) takes the value of the
+         * last coarse element.
+         */
+        template <typename T>
+        void prolongation (const std::size_t l, const sm::vvec<T>& coarse, sm::vvec<T>& fine) const
+        {
+            this->check_level (l);
+            const grid_t& gf = this->levels[l];
+            const grid_t& gc = this->levels[l + 1];
+            if (coarse.size() != static_cast<std::size_t>(gc.n())) {
+                throw std::runtime_error ("grid_pyramid::prolongation: coarse data size does not match its grid");
+            }
+            fine.resize (gf.n());
+
+            const layout f = layout::of (gf);
+            const layout c = layout::of (gc);
+
+#pragma omp parallel for
+            for (std::int64_t fo = 0; fo < f.n_outer; ++fo) {
+                // The one or two coarse lines that this fine line is interpolated from
+                const std::int64_t co0 = fo / 2;
+                std::int64_t co1 = co0;
+                if (fo % 2 == 1) {
+                    co1 = co0 + 1;
+                    if (co1 >= c.n_outer) { co1 = c.wrap_outer ? 0 : co0; }
+                }
+                const T* l0 = coarse.data() + co0 * c.n_inner;
+                const T* l1 = coarse.data() + co1 * c.n_inner;
+                T* out = fine.data() + fo * f.n_inner;
+
+                // Pairs of fine elements (2ci, 2ci + 1) for which coarse element ci + 1 exists
+                const std::int64_t ci_last = c.n_inner - 2;
+                for (std::int64_t ci = 0; ci <= ci_last; ++ci) {
+                    const T a = (l0[ci] + l1[ci]) / T{2};
+                    const T b = (l0[ci + 1] + l1[ci + 1]) / T{2};
+                    out[2 * ci] = a;
+                    out[2 * ci + 1] = (a + b) / T{2};
+                }
+                // The last coarse element, and the fine element beyond it if there is one
+                const std::int64_t ci = c.n_inner - 1;
+                const T a = (l0[ci] + l1[ci]) / T{2};
+                out[2 * ci] = a;
+                if (2 * ci + 1 < f.n_inner) {
+                    out[2 * ci + 1] = f.wrap_inner ? (a + (l0[0] + l1[0]) / T{2}) / T{2} : a;
+                }
+            }
+        }
+
+        //! The grids, finest first
+        std::vector<grid_t> levels;
+
+    private:
+
+        //! The size of the coarsened dimension of n elements. Return false if it can't be coarsened.
+        static bool coarsened (const I n, const bool wrapped, I& nc)
+        {
+            if (wrapped) {
+                if (n % I{2} != I{0}) { return false; }
+                nc = n / I{2};
+            } else {
+                nc = (n + I{1}) / I{2};
+            }
+            return nc >= I{2};
+        }
+
+        static bool wraps_x (const grid_t& g)
+        {
+            return g.get_wrap() == griddomainwrap::horizontal || g.get_wrap() == griddomainwrap::both;
+        }
+
+        static bool wraps_y (const grid_t& g)
+        {
+            return g.get_wrap() == griddomainwrap::vertical || g.get_wrap() == griddomainwrap::both;
+        }
+
+        /*!
+         * The data layout of a grid, described as n_outer lines each of n_inner contiguous
+         * elements. For row-major orders a line is a row; for column-major orders it is a column.
+         * Because full weighting and bilinear interpolation are symmetric in x and y, the
+         * operators need only this description, and not which of the dimensions is which.
+         */
+        struct layout
+        {
+            std::int64_t n_outer = 0;
+            std::int64_t n_inner = 0;
+            bool wrap_outer = false;
+            bool wrap_inner = false;
+
+            static layout of (const grid_t& g)
+            {
+                layout lo;
+                const std::int64_t w = static_cast<std::int64_t>(g.get_w());
+                const std::int64_t h = static_cast<std::int64_t>(g.get_h());
+                if (g.rowmaj()) {
+                    lo.n_outer = h;
+                    lo.n_inner = w;
+                    lo.wrap_outer = wraps_y (g);
+                    lo.wrap_inner = wraps_x (g);
+                } else {
+                    lo.n_outer = w;
+                    lo.n_inner = h;
+                    lo.wrap_outer = wraps_x (g);
+                    lo.wrap_inner = wraps_y (g);
+                }
+                return lo;
+            }
+        };
+
+        void check_level (const std::size_t l) const
+        {
+            if (l + 1 >= this->levels.size()) {
+                throw std::runtime_error ("grid_pyramid: level has no coarser level");
+            }
+        }
+    };
+}
@@ -13,7 +13,6 @@
 module;
 
 #include <cstdint>
-#include <set>
 #include <list>
 #include <string>
 #include <array>
@@ -25,6 +24,10 @@ module;
 #include <vector>
 #include <stdexcept>
 #include <limits>
+#include <algorithm>
+#include <type_traits>
+#include <numeric>
+#include <utility>
 
 export module sm.hexgrid;
 
@@ -32,11 +35,68 @@ export import sm.mathconst;
 export import sm.bezcurvepath;
 export import sm.vec;
 export import sm.hex;
+export import sm.boundaryfill;
+export import sm.csr;
 import sm.vvec;
 import sm.mat;
+import sm.polygon_index;
 
 export namespace sm
 {
+    //! The order of the elements in the d_ vectors of a hexgrid
+    enum class hexorder
+    {
+        //! The order of hexgrid::hexen (ring by ring from the centre, as the grid is built)
+        list,
+        //! Along a Morton (Z order) curve in the axial coordinates (ri, gi)
+        morton,
+        //! Along a Hilbert curve in the axial coordinates (ri, gi)
+        hilbert,
+        //! Row by row: by gi, then by ri. Neighbours are then at constant offsets along each row.
+        rows
+    };
+
+    namespace algo
+    {
+        //! The position of (x, y) along a Morton (Z order) curve, found by interleaving the bits of x and y
+        std::uint64_t morton_index (const std::uint32_t x, const std::uint32_t y)
+        {
+            auto spread = [](std::uint64_t a)
+            {
+                a = (a | (a << 16)) & 0x0000ffff0000ffffull;
+                a = (a | (a << 8)) & 0x00ff00ff00ff00ffull;
+                a = (a | (a << 4)) & 0x0f0f0f0f0f0f0f0full;
+                a = (a | (a << 2)) & 0x3333333333333333ull;
+                a = (a | (a << 1)) & 0x5555555555555555ull;
+                return a;
+            };
+            return spread (x) | (spread (y) << 1);
+        }
+
+        /*!
+         * The position of (x, y) along a Hilbert curve that fills a square of side \a side
+         * (which must be a power of 2), with 0 <= x, y < side.
+         */
+        std::uint64_t hilbert_index (const std::uint32_t side, std::uint32_t x, std::uint32_t y)
+        {
+            std::uint64_t d = 0;
+            for (std::uint32_t s = side / 2u; s > 0u; s /= 2u) {
+                const std::uint32_t rx = (x & s) > 0u ? 1u : 0u;
+                const std::uint32_t ry = (y & s) > 0u ? 1u : 0u;
+                d += static_cast<std::uint64_t>(s) * s * ((3u * rx) ^ ry);
+                // Rotate the quadrant so that the curve inside it is in the standard orientation
+                if (ry == 0u) {
+                    if (rx == 1u) {
+                        x = side - 1u - x;
+                        y = side - 1u - y;
+                    }
+                    std::swap (x, y);
+                }
+            }
+            return d;
+        }
+    }
+
     /*!
      * This class is used to build an hexagonal grid of hexagons. The member hexagons
      * are all arranged with a vertex pointing vertically - "point up". The extent of
@@ -79,6 +139,12 @@ export namespace sm
         alignas(8) std::vector<std::int32_t> d_gi;
         alignas(8) std::vector<std::int32_t> d_bi;
 
+        /*!
+         * The hex::vi of the hex at each d_ index. This is the index itself unless the
+         * d_ vectors have been reordered (see reorder_d_vectors).
+         */
+        alignas(8) std::vector<std::uint32_t> d_vi;
+
         /*
          * Neighbour iterators. For use when the stride to the neighbour ne or nw is
          * not constant. i.e. for use when the domain of computation is not a
@@ -106,13 +172,13 @@ export namespace sm
         alignas(8) std::vector<float> d_dist_to_boundary;
 
         /*!
-         * The length of a row in the domain. The first hex in the first row will
-         * overhang to the left.
+         * The length of a row in the domain, if the d_ vectors are regular (see
+         * is_regular), otherwise 0.
          */
         std::uint32_t d_rowlen = 0;
 
         /*!
-         * The number of rows in the domain.
+         * The number of rows in the domain, if the d_ vectors are regular, otherwise 0.
          */
         std::uint32_t d_numrows = 0;
 
@@ -123,6 +189,18 @@ export namespace sm
          */
         std::uint32_t d_size = 0;
 
+        /*!
+         * True if the d_ vectors hold whole rows of equal length, row by row: d_rowlen
+         * hexes with consecutive ri in each of d_numrows rows of consecutive gi. The hex in
+         * row j (counted from the lowest gi) and column k then has d index j * d_rowlen + k.
+         * This is so for a parallelogram domain in hexorder::rows, and for a rectangular
+         * domain whose rows happen to be of equal length.
+         */
+        bool is_regular() const
+        {
+            return this->d_rowlen > 0u && this->d_rowlen * this->d_numrows == this->d_ne.size();
+        }
+
         /*!
          * How many additional hexes to grow out to the left and right; top and
          * bottom? Set this to a larger number if the boundary is expected to grow
@@ -139,6 +217,7 @@ export namespace sm
             d_ri.push_back (hi->ri);
             d_gi.push_back (hi->gi);
             d_bi.push_back (hi->bi);
+            d_vi.push_back (hi->vi);
             d_flags.push_back (hi->get_flags());
             d_dist_to_boundary.push_back (hi->dist_to_boundary);
 
@@ -198,17 +277,63 @@ export namespace sm
 
                 ++hi;
             }
+
+            ++this->d_neighbours_generation;
+            this->update_stencil();
+            this->index_d_axial();
+        }
+
+        /*!
+         * Rebuild the interior run/edge split used by apply_hex_stencil (and so by laplacian
+         * and the other operators), and set d_rowlen, d_numrows and d_size (0 unless
+         * is_regular). populate_d_neighbours, reorder_d_vectors and hexgrid_load call this.
+         * If you change d_ne, d_nne, d_nnw, d_nw, d_nsw or d_nse yourself, call it before
+         * using the operators: changes made in place cannot be detected.
+         */
+        void update_stencil()
+        {
+            this->stencil = this->make_stencil_sets();
+            this->stencil.generation = this->d_neighbours_generation;
+
+            this->d_rowlen = 0;
+            this->d_numrows = 0;
+            this->d_size = 0;
+            const std::size_t n = this->d_gi.size();
+            if (n == 0u || this->d_ri.size() != n) { return; }
+            // Rows of consecutive gi, each holding consecutive ri, all of one length
+            std::uint32_t rowlen = 0;
+            std::uint32_t numrows = 1;
+            std::uint32_t len = 1;
+            for (std::size_t i = 1; i <= n; ++i) {
+                if (i < n && this->d_gi[i] == this->d_gi[i - 1] && this->d_ri[i] == this->d_ri[i - 1] + 1) {
+                    ++len;
+                    continue;
+                }
+                if (rowlen == 0u) { rowlen = len; }
+                if (len != rowlen) { return; }
+                if (i == n) { break; }
+                if (this->d_gi[i] != this->d_gi[i - 1] + 1) { return; }
+                len = 1;
+                ++numrows;
+            }
+            this->d_rowlen = rowlen;
+            this->d_numrows = numrows;
+            this->d_size = rowlen * numrows;
         }
 
         //! Clear out all the d_ vectors
         void d_clear()
         {
+            // The stencil sets no longer describe the d_ vectors
+            ++this->d_neighbours_generation;
             this->d_x.clear();
             this->d_y.clear();
             this->d_ri.clear();
             this->d_gi.clear();
             this->d_bi.clear();
+            this->d_vi.clear();
             this->d_flags.clear();
+            this->d_dist_to_boundary.clear();
         }
 
         /*
@@ -240,6 +365,134 @@ export namespace sm
         std::int32_t nsw (const std::uint32_t hi) const { return this->d_nsw[hi]; }
         std::int32_t has_nsw (const std::uint32_t hi) const { return this->d_nsw[hi] == -1 ? false : true; }
 
+        /*!
+         * The d index of the hex at axial coordinates (ri, gi), or -1 if there is no hex
+         * there. O(1), using the lookup made by index_d_axial.
+         */
+        std::int32_t d_index_at (const std::int32_t ri, const std::int32_t gi) const
+        {
+            const d_axial_table& t = this->d_axial;
+            if (ri < t.rmin || ri >= t.rmin + t.w || gi < t.gmin || gi >= t.gmin + t.h) { return -1; }
+            return t.cells[static_cast<std::size_t>(gi - t.gmin) * t.w + (ri - t.rmin)];
+        }
+
+        /*!
+         * Call f(di) for the d index of each hex on the ring of hexes that are n steps from
+         * the hex with d index \a di. Cells are enumerated by axial arithmetic, in
+         * O(6n), starting at the South-West corner and going anticlockwise. Positions on
+         * the ring that lie outside the grid are skipped, and the ring does not follow
+         * the links made by set_parallelogram_wrap. n = 0 gives the hex di itself.
+         */
+        template <typename F>
+        void for_each_in_ring (const std::uint32_t di, const std::uint32_t n, F&& f) const
+        {
+            this->check_d_axial (di);
+            std::int32_t r = this->d_ri[di];
+            std::int32_t g = this->d_gi[di];
+            if (n == 0u) { f (static_cast<std::int32_t>(di)); return; }
+            // Axial steps E, NE, NW, W, SW, SE
+            static constexpr std::int32_t step_r[6] = { 1, 0, -1, -1, 0, 1 };
+            static constexpr std::int32_t step_g[6] = { 0, 1, 1, 0, -1, -1 };
+            const std::int32_t ni = static_cast<std::int32_t>(n);
+            g -= ni; // Start n steps to the SW
+            for (std::uint32_t side = 0; side < 6u; ++side) {
+                for (std::int32_t j = 0; j < ni; ++j) {
+                    const std::int32_t dj = this->d_index_at (r, g);
+                    if (dj >= 0) { f (dj); }
+                    r += step_r[side];
+                    g += step_g[side];
+                }
+            }
+        }
+
+        /*!
+         * Call f(di) for the d index of each hex that is no more than n steps from the hex
+         * with d index \a di (a filled hexagon), row by row from the bottom. O(result).
+         */
+        template <typename F>
+        void for_each_in_hexagon (const std::uint32_t di, const std::uint32_t n, F&& f) const
+        {
+            this->check_d_axial (di);
+            const std::int32_t ni = static_cast<std::int32_t>(n);
+            for (std::int32_t dg = -ni; dg <= ni; ++dg) {
+                this->for_each_in_row (this->d_ri[di] + std::max (-ni, -dg - ni), this->d_ri[di] + std::min (ni, -dg + ni),
+                                       this->d_gi[di] + dg, f);
+            }
+        }
+
+        /*!
+         * Call f(di) for the d index of each hex whose centre is within \a radius of the
+         * centre of the hex with d index \a di, row by row from the bottom. Distances are
+         * measured on the hex lattice (the hex to hex distance is get_d()) and hexes
+         * exactly at the radius are included. O(result).
+         */
+        template <typename F>
+        void for_each_in_disc (const std::uint32_t di, const float radius, F&& f) const
+        {
+            this->check_d_axial (di);
+            if (!(radius >= 0.0f)) { return; }
+            // Work in units of d. A hex dr, dg steps away is at squared distance
+            // (dr + dg/2)^2 + 3/4 dg^2, which is exact in double precision.
+            const double rr = static_cast<double>(radius) / this->d;
+            const double rr2 = rr * rr * (1.0 + 1e-6);
+            const std::int32_t n = static_cast<std::int32_t>(std::floor (std::sqrt (rr2 / 0.75)));
+            for (std::int32_t dg = -n; dg <= n; ++dg) {
+                const double half_width = std::sqrt (std::max (0.0, rr2 - 0.75 * dg * dg));
+                const std::int32_t dr0 = static_cast<std::int32_t>(std::ceil (-half_width - 0.5 * dg));
+                const std::int32_t dr1 = static_cast<std::int32_t>(std::floor (half_width - 0.5 * dg));
+                this->for_each_in_row (this->d_ri[di] + dr0, this->d_ri[di] + dr1, this->d_gi[di] + dg, f);
+            }
+        }
+
+        //! The d indices of the ring of hexes n steps from hex di (see for_each_in_ring)
+        std::vector<std::int32_t> get_ring_indices (const std::uint32_t di, const std::uint32_t n) const
+        {
+            std::vector<std::int32_t> rtn;
+            rtn.reserve (n == 0u ? 1u : 6u * n);
+            this->for_each_in_ring (di, n, [&rtn](std::int32_t dj) { rtn.push_back (dj); });
+            return rtn;
+        }
+
+        //! The d indices of the hexes within n steps of hex di (see for_each_in_hexagon)
+        std::vector<std::int32_t> get_hexagon_indices (const std::uint32_t di, const std::uint32_t n) const
+        {
+            std::vector<std::int32_t> rtn;
+            rtn.reserve (3u * n * (n + 1u) + 1u);
+            this->for_each_in_hexagon (di, n, [&rtn](std::int32_t dj) { rtn.push_back (dj); });
+            return rtn;
+        }
+
+        //! The d indices of the hexes within radius of hex di (see for_each_in_disc)
+        std::vector<std::int32_t> get_disc_indices (const std::uint32_t di, const float radius) const
+        {
+            std::vector<std::int32_t> rtn;
+            this->for_each_in_disc (di, radius, [&rtn](std::int32_t dj) { rtn.push_back (dj); });
+            return rtn;
+        }
+
+        /*!
+         * Make the lookup from axial coordinates to d index that d_index_at and the
+         * for_each_in_ring/hexagon/disc queries use. O(N). This is done whenever the d_
+         * vectors are built or reordered; call it if you change d_ri or d_gi yourself.
+         */
+        void index_d_axial()
+        {
+            d_axial_table t;
+            t.n = this->d_ri.size();
+            if (t.n == 0u) { this->d_axial = t; return; }
+            const auto [rmin, rmax] = std::minmax_element (this->d_ri.begin(), this->d_ri.end());
+            const auto [gmin, gmax] = std::minmax_element (this->d_gi.begin(), this->d_gi.end());
+            t.rmin = *rmin;
+            t.gmin = *gmin;
+            t.w = *rmax - *rmin + 1;
+            t.h = *gmax - *gmin + 1;
+            t.cells.assign (static_cast<std::size_t>(t.w) * t.h, -1);
+            for (std::size_t i = 0; i < t.n; ++i) {
+                t.cells[static_cast<std::size_t>(this->d_gi[i] - t.gmin) * t.w + (this->d_ri[i] - t.rmin)] = static_cast<std::int32_t>(i);
+            }
+            this->d_axial = std::move (t);
+        }
+
         /*!
          * Default constructor
          */
@@ -277,8 +530,9 @@ export namespace sm
          */
         sm::vec<float, 2> compute_centroid (const std::list<hex>& phexes)
         {
+            this->sync_hexen();
             sm::vec<float, 2> centroid = {0,0};
-            for (auto h : phexes) {
+            for (const auto& h : phexes) {
                 centroid[0] += h.x;
                 centroid[1] += h.y;
             }
@@ -292,6 +546,7 @@ export namespace sm
          */
         std::list<hex>::iterator find_hex_nearest (const sm::vec<float, 2>& pos)
         {
+            this->sync_hexen();
             std::list<sm::hex>::iterator nearest = this->hexen.end();
             std::list<sm::hex>::iterator hi = this->hexen.begin();
             float dist = std::numeric_limits<float>::max();
@@ -355,34 +610,22 @@ export namespace sm
         {
             this->boundary_centroid = this->compute_centroid (phexes);
 
-            std::list<sm::hex>::iterator bpoint = this->hexen.begin();
-            std::list<sm::hex>::iterator bpi = this->hexen.begin();
-            while (bpi != this->hexen.end()) {
-                std::list<sm::hex>::const_iterator ppi = phexes.begin();
-                while (ppi != phexes.end()) {
-                    // NB: The assumption right now is that the phexes are from the same dimension hex grid
-                    // as this->hexen.
-                    if (bpi->ri == ppi->ri && bpi->gi == ppi->gi) {
-                        // Set h as boundary hex.
-                        bpi->set_flag (sm::HEX_IS_BOUNDARY | sm::HEX_INSIDE_BOUNDARY);
-                        bpoint = bpi;
-                        break;
-                    }
-                    ++ppi;
-                }
-                ++bpi;
+            // NB: The assumption right now is that the phexes are from the same dimension hex grid
+            // as this->hexen. Each is found by its (ri, gi) in a lookup table, rather than by a search.
+            const axial_table tbl = this->make_axial_table();
+            for (const auto& ph : phexes) {
+                std::list<sm::hex>::iterator bpi = tbl.at (ph.ri, ph.gi, this->hexen.end());
+                if (bpi != this->hexen.end()) { bpi->set_flag (sm::HEX_IS_BOUNDARY | sm::HEX_INSIDE_BOUNDARY); }
             }
 
             // Check that the boundary is contiguous.
-            std::set<std::uint32_t> seen;
-            std::list<sm::hex>::iterator hi = bpoint;
-            if (this->boundary_contiguous (bpoint, hi, seen) == false) {
+            if (this->boundary_contiguous() == false) {
                 std::stringstream ee;
                 ee << "The boundary is not a contiguous sequence of hexes.";
                 throw std::runtime_error (ee.str());
             }
 
-            this->discard_outside_boundary();
+            this->discard_outside_boundary (tbl);
             this->populate_d_vectors();
         }
 
@@ -450,25 +693,15 @@ export namespace sm
                 bpi = bpoints.begin();
             }
 
-            // now proceed with centroid changed or unchanged
-            std::list<sm::hex>::iterator nearby_boundary_point = this->hexen.begin(); // i.e the hex at 0,0
-            bpi = bpoints.begin();
-            while (bpi != bpoints.end()) {
-                nearby_boundary_point = this->set_boundary (*bpi++, nearby_boundary_point);
-            }
-
-            // Check that the boundary is contiguous.
-            {
-                std::set<std::uint32_t> seen;
-                std::list<sm::hex>::iterator hi = nearby_boundary_point;
-                if (this->boundary_contiguous (nearby_boundary_point, hi, seen) == false) {
-                    std::stringstream ee;
-                    ee << "The constructed boundary is not a contiguous sequence of hexes.";
-                    throw std::runtime_error (ee.str());
-                }
+            // now proceed with centroid changed or unchanged. Mark the boundary hexes (checking
+            // contiguity as we go), then find the interior and discard the rest.
+            const axial_table tbl = this->make_axial_table();
+            if (this->trace_boundary (bpoints, tbl, this->bhexen) == false) {
+                std::stringstream ee;
+                ee << "The constructed boundary is not a contiguous sequence of hexes.";
+                throw std::runtime_error (ee.str());
             }
-
-            this->discard_outside_boundary();
+            this->discard_outside_boundary (tbl, &bpoints);
             this->populate_d_vectors();
         }
 
@@ -500,23 +733,12 @@ export namespace sm
             }
 
             // now proceed with centroid changed or unchanged. First: clear all boundary flags
-            for (auto h : this->hexen) { h.unset_user_flag (sm::HEX_IS_BOUNDARY); }
-
-            std::list<sm::hex>::iterator nearby_boundary_point = this->hexen.begin(); // i.e the hex at 0,0
-            bpi = bpoints.begin();
-            while (bpi != bpoints.end()) {
-                nearby_boundary_point = this->set_boundary (*bpi++, nearby_boundary_point);
-            }
+            for (auto& h : this->hexen) { h.unset_flag (sm::HEX_IS_BOUNDARY); }
 
-            // Check that the boundary is contiguous.
-            {
-                std::set<std::uint32_t> seen;
-                std::list<sm::hex>::iterator hi = nearby_boundary_point;
-                if (this->boundary_contiguous (nearby_boundary_point, hi, seen) == false) {
-                    std::stringstream ee;
-                    ee << "The constructed boundary is not a contiguous sequence of hexes.";
-                    throw std::runtime_error (ee.str());
-                }
+            if (this->trace_boundary (bpoints, this->make_axial_table(), this->bhexen) == false) {
+                std::stringstream ee;
+                ee << "The constructed boundary is not a contiguous sequence of hexes.";
+                throw std::runtime_error (ee.str());
             }
         }
 
@@ -563,16 +785,14 @@ export namespace sm
                 bpi->set_flag (sm::HEX_IS_BOUNDARY | sm::HEX_INSIDE_BOUNDARY);
             }
             // Check that the boundary is contiguous.
-            std::set<std::uint32_t> seen;
-            std::list<sm::hex>::iterator hi = bpi;
-            if (this->boundary_contiguous (bpi, hi, seen) == false) {
+            if (this->boundary_contiguous (bpi) == false) {
                 std::stringstream ee;
                 ee << "The boundary is not a contiguous sequence of hexes.";
                 throw std::runtime_error (ee.str());
             }
 
             // _boundary IS contiguous, discard hexes outside the boundary.
-            this->discard_outside_boundary();
+            this->discard_outside_boundary (this->make_axial_table());
             this->populate_d_vectors();
         }
 
@@ -815,13 +1035,13 @@ export namespace sm
             std::stringstream ss;
             ss << "hex grid with " << this->hexen.size() << " hexes.\n";
             auto i = this->hexen.begin();
-            float lasty = this->hexen.front().y;
+            float lasty = this->hex_position (this->hexen.front())[1];
             std::uint32_t rownum = 0;
             ss << "\nRow/Ring " << rownum++ << ":\n";
             while (i != this->hexen.end()) {
-                if (i->y > lasty) {
+                if (this->hex_position (*i)[1] > lasty) {
                     ss << "\nRow/Ring " << rownum++ << ":\n";
-                    lasty = i->y;
+                    lasty = this->hex_position (*i)[1];
                 }
                 ss << i->output() << std::endl;
                 ++i;
@@ -836,13 +1056,19 @@ export namespace sm
         {
             std::stringstream ss;
             if (grid_reduced == false) {
+                const sm::vec<float, 2> nw = this->hex_position (*this->vertex_nw);
+                const sm::vec<float, 2> ne = this->hex_position (*this->vertex_ne);
+                const sm::vec<float, 2> w = this->hex_position (*this->vertex_w);
+                const sm::vec<float, 2> e = this->hex_position (*this->vertex_e);
+                const sm::vec<float, 2> sw = this->hex_position (*this->vertex_sw);
+                const sm::vec<float, 2> se = this->hex_position (*this->vertex_se);
                 ss << "Grid vertices: \n"
-                   << "           NW: (" << this->vertex_nw->x << "," << this->vertex_nw->y << ") "
-                   << "      NE: (" << this->vertex_ne->x << "," << this->vertex_ne->y << ")\n"
-                   << "     W: (" << this->vertex_w->x << "," << this->vertex_w->y << ") "
-                   << "                              E: (" << this->vertex_e->x << "," << this->vertex_e->y << ")\n"
-                   << "           SW: (" << this->vertex_sw->x << "," << this->vertex_sw->y << ") "
-                   << "      SE: (" << this->vertex_se->x << "," << this->vertex_se->y << ")";
+                   << "           NW: (" << nw[0] << "," << nw[1] << ") "
+                   << "      NE: (" << ne[0] << "," << ne[1] << ")\n"
+                   << "     W: (" << w[0] << "," << w[1] << ") "
+                   << "                              E: (" << e[0] << "," << e[1] << ")\n"
+                   << "           SW: (" << sw[0] << "," << sw[1] << ") "
+                   << "      SE: (" << se[0] << "," << se[1] << ")";
             } else {
                 ss << "Initial grid vertices are no longer valid.";
             }
@@ -912,18 +1138,17 @@ export namespace sm
          */
         float get_x_min (float phi = 0.0f) const
         {
-            float xmin = 0.0f;
-            float x_ = 0.0f;
-            bool first = true;
-            for (auto h : this->hexen) {
-                x_ = h.x * std::cos (phi) + h.y * std::sin (phi);
-                if (first) {
-                    xmin = x_;
-                    first = false;
-                }
-                if (x_ < xmin) {
-                    xmin = x_;
+            if (this->hexen.empty()) { return 0.0f; }
+            const float cos_phi = std::cos (phi);
+            const float sin_phi = std::sin (phi);
+            float xmin = std::numeric_limits<float>::max();
+            // The d_ vectors hold the same positions contiguously, so prefer them
+            if (this->d_x.size() == this->hexen.size()) {
+                for (std::size_t i = 0; i < this->d_x.size(); ++i) {
+                    xmin = std::min (xmin, this->d_x[i] * cos_phi + this->d_y[i] * sin_phi);
                 }
+            } else {
+                for (const auto& h : this->hexen) { xmin = std::min (xmin, h.x * cos_phi + h.y * sin_phi); }
             }
             return xmin;
         }
@@ -934,18 +1159,17 @@ export namespace sm
          */
         float get_x_max (float phi = 0.0f) const
         {
-            float xmax = 0.0f;
-            float x_ = 0.0f;
-            bool first = true;
-            for (auto h : this->hexen) {
-                x_ = h.x * std::cos (phi) + h.y * std::sin (phi);
-                if (first) {
-                    xmax = x_;
-                    first = false;
-                }
-                if (x_ > xmax) {
-                    xmax = x_;
+            if (this->hexen.empty()) { return 0.0f; }
+            const float cos_phi = std::cos (phi);
+            const float sin_phi = std::sin (phi);
+            float xmax = std::numeric_limits<float>::lowest();
+            // The d_ vectors hold the same positions contiguously, so prefer them
+            if (this->d_x.size() == this->hexen.size()) {
+                for (std::size_t i = 0; i < this->d_x.size(); ++i) {
+                    xmax = std::max (xmax, this->d_x[i] * cos_phi + this->d_y[i] * sin_phi);
                 }
+            } else {
+                for (const auto& h : this->hexen) { xmax = std::max (xmax, h.x * cos_phi + h.y * sin_phi); }
             }
             return xmax;
         }
@@ -954,48 +1178,85 @@ export namespace sm
         // be used by client code (such as mathplot's HexGridVisual)
         sm::mat<float, 4> tfm = sm::mat<float, 4>::identity();
 
-        // Transform the positions of the hexes. After transforming, the domain vectors may have to be recomputed
+        /*!
+         * If true, transform updates only d_x and d_y and leaves the positions in hexen to
+         * be brought up to date when they are next needed. The hexgrid methods that use
+         * hex positions do this themselves; client code that reads hex::x and hex::y
+         * directly should call sync_hexen first.
+         */
+        bool lazy_transform = false;
+
+        /*!
+         * Transform the positions of the hexes. If the d_ vectors are populated, d_x and d_y
+         * are transformed in place and the other d_ vectors (which a transform does not
+         * change) are left as they are.
+         */
         void transform (const sm::mat<float, 4>& tf)
         {
             this->tfm = tf;
-            std::list<sm::hex>::iterator h = this->hexen.begin();
-            while (h != this->hexen.end()) {
-                h->transform (this->tfm);
-                ++h;
+            if (this->d_x.empty() || this->d_x.size() != this->hexen.size()) {
+                this->sync_hexen();
+                for (auto& h : this->hexen) { h.transform (this->tfm); }
+                if (this->d_x.empty() == false) { this->populate_d_vectors(); }
+                return;
+            }
+            this->transform_d_positions (this->tfm);
+            this->hexen_stale = true;
+            if (!this->lazy_transform) { this->sync_hexen(); }
+        }
+
+        //! Copy the positions in d_x and d_y into hexen, if a lazy transform has left them out of date
+        void sync_hexen()
+        {
+            if (!this->hexen_stale) { return; }
+            for (auto& h : this->hexen) {
+                if (h.di < this->d_x.size()) {
+                    h.x = this->d_x[h.di];
+                    h.y = this->d_y[h.di];
+                }
             }
+            this->hexen_stale = false;
+        }
+
+        //! Are the positions in hexen up to date with d_x and d_y?
+        bool hexen_synced() const { return !this->hexen_stale; }
 
-            if (this->d_x.empty() == false) { this->populate_d_vectors(); }
+        //! The position of hex h, which is correct even if hexen has not been synced after a lazy transform
+        sm::vec<float, 2> hex_position (const sm::hex& h) const
+        {
+            if (this->hexen_stale && h.di < this->d_x.size()) { return { this->d_x[h.di], this->d_y[h.di] }; }
+            return { h.x, h.y };
         }
 
         /*!
          * Run through all the hexes and compute the distance to the nearest boundary
-         * hex.
+         * hex. The distance is written into each hex's dist_to_boundary, and into
+         * d_dist_to_boundary if the d_ vectors are populated.
          */
         void compute_distance_to_boundary()
         {
-            std::list<sm::hex>::iterator h = this->hexen.begin();
-            while (h != this->hexen.end()) {
-                if (h->test_flags(sm::HEX_IS_BOUNDARY) == true) {
-                    h->dist_to_boundary = 0.0f;
+            this->sync_hexen();
+            std::vector<const hex*> bhexes;
+            for (const auto& hh : this->hexen) {
+                if (hh.test_flags(sm::HEX_IS_BOUNDARY) == true) { bhexes.push_back (&hh); }
+            }
+            const bool have_d = this->d_dist_to_boundary.size() == this->hexen.size();
+            for (auto& hh : this->hexen) {
+                float& dist = hh.dist_to_boundary;
+                if (hh.test_flags(sm::HEX_IS_BOUNDARY) == true) {
+                    dist = 0.0f;
+                } else if (hh.test_flags(sm::HEX_INSIDE_BOUNDARY) == false) {
+                    // Set to a dummy, negative value
+                    dist = -100.0;
                 } else {
-                    if (h->test_flags(sm::HEX_INSIDE_BOUNDARY) == false) {
-                        // Set to a dummy, negative value
-                        h->dist_to_boundary = -100.0;
-                    } else {
-                        // Not a boundary hex, but inside boundary
-                        std::list<sm::hex>::iterator bh = this->hexen.begin();
-                        while (bh != this->hexen.end()) {
-                            if (bh->test_flags(sm::HEX_IS_BOUNDARY) == true) {
-                                float delta = h->distance_from (*bh);
-                                if (delta < h->dist_to_boundary || h->dist_to_boundary < 0.0f) {
-                                    h->dist_to_boundary = delta;
-                                }
-                            }
-                            ++bh;
-                        }
+                    // Not a boundary hex, but inside boundary
+                    dist = -1.0f;
+                    for (const hex* bh : bhexes) {
+                        float delta = hh.distance_from (*bh);
+                        if (delta < dist || dist < 0.0f) { dist = delta; }
                     }
                 }
-                ++h;
+                if (have_d) { this->d_dist_to_boundary[hh.di] = dist; }
             }
         }
 
@@ -1004,6 +1265,10 @@ export namespace sm
          */
         void populate_d_vectors()
         {
+            // Take any positions left in d_x and d_y by a lazy transform before they are cleared
+            this->sync_hexen();
+            // Shift operators refer to the hexes as they were
+            this->clear_shift_cache();
             // The starting hex is always the centre one.
             std::list<sm::hex>::iterator hi = this->hexen.begin();
             // Clear the d_ vectors.
@@ -1015,6 +1280,117 @@ export namespace sm
             }
             // Set up the neighbour relations
             this->populate_d_neighbours();
+            if (this->d_order != sm::hexorder::list) { this->reorder_d_vectors (this->d_order); }
+        }
+
+        /*!
+         * The order of the d_ vectors. populate_d_vectors (which is called whenever a
+         * boundary is applied) builds them in the order of hexen, then reorders them to
+         * match d_order. Set this before applying a boundary, or call
+         * reorder_d_vectors to change the order of existing d_ vectors.
+         */
+        sm::hexorder d_order = sm::hexorder::list;
+
+        /*!
+         * Reorder the d_ vectors and set d_order. Along a Hilbert or Morton curve, hexes
+         * that are near each other in the grid are mostly near each other in memory, so
+         * that loops over the d_ neighbour vectors (such as laplacian) make better use of
+         * the cache on large grids.
+         *
+         * Every d_ vector is permuted, the d_ neighbour indices are remapped and hex::di is
+         * updated for each hex. hex::vi is not changed; d_vi gives the vi of each element.
+         * Use to_d_order and from_d_order to move data between the two orders.
+         */
+        void reorder_d_vectors (const sm::hexorder order)
+        {
+            this->d_order = order;
+            const std::size_t n = this->d_x.size();
+            if (n == 0u) { return; }
+
+            // new_to_old[k] is the current d_ index of the element that will be at index k
+            std::vector<std::uint32_t> new_to_old (n);
+            std::iota (new_to_old.begin(), new_to_old.end(), 0u);
+            std::vector<std::uint64_t> key (n);
+            if (order == sm::hexorder::list) {
+                for (std::size_t i = 0; i < n; ++i) { key[i] = this->d_vi[i]; }
+            } else {
+                const auto [rmin, rmax] = std::minmax_element (this->d_ri.begin(), this->d_ri.end());
+                const auto [gmin, gmax] = std::minmax_element (this->d_gi.begin(), this->d_gi.end());
+                const std::uint32_t extent = static_cast<std::uint32_t>(std::max (*rmax - *rmin, *gmax - *gmin)) + 1u;
+                std::uint32_t side = 1u;
+                while (side < extent) { side <<= 1; }
+                const std::int32_t r0 = *rmin;
+                const std::int32_t g0 = *gmin;
+                const std::int64_t ni = static_cast<std::int64_t>(n);
+#pragma omp parallel for
+                for (std::int64_t i = 0; i < ni; ++i) {
+                    const std::uint32_t x = static_cast<std::uint32_t>(this->d_ri[i] - r0);
+                    const std::uint32_t y = static_cast<std::uint32_t>(this->d_gi[i] - g0);
+                    if (order == sm::hexorder::rows) {
+                        key[i] = (static_cast<std::uint64_t>(y) << 32) | x;
+                    } else {
+                        key[i] = order == sm::hexorder::morton ? sm::algo::morton_index (x, y) : sm::algo::hilbert_index (side, x, y);
+                    }
+                }
+            }
+            std::stable_sort (new_to_old.begin(), new_to_old.end(),
+                              [&key](const std::uint32_t a, const std::uint32_t b) { return key[a] < key[b]; });
+            std::vector<std::int32_t> old_to_new (n);
+            for (std::size_t k = 0; k < n; ++k) { old_to_new[new_to_old[k]] = static_cast<std::int32_t>(k); }
+
+            hexgrid::permute (this->d_x, new_to_old);
+            hexgrid::permute (this->d_y, new_to_old);
+            hexgrid::permute (this->d_ri, new_to_old);
+            hexgrid::permute (this->d_gi, new_to_old);
+            hexgrid::permute (this->d_bi, new_to_old);
+            hexgrid::permute (this->d_vi, new_to_old);
+            hexgrid::permute (this->d_flags, new_to_old);
+            hexgrid::permute (this->d_dist_to_boundary, new_to_old);
+            for (std::vector<std::int32_t>* nb : { &this->d_ne, &this->d_nne, &this->d_nnw, &this->d_nw, &this->d_nsw, &this->d_nse }) {
+                hexgrid::permute (*nb, new_to_old);
+                for (std::int32_t& j : *nb) { if (j >= 0) { j = old_to_new[j]; } }
+            }
+            for (auto& hh : this->hexen) { hh.di = old_to_new[hh.di]; }
+
+            ++this->d_neighbours_generation;
+            this->update_stencil();
+            this->index_d_axial();
+        }
+
+        /*!
+         * Copy \a by_vi, data indexed by hex::vi, into \a by_di, indexed like the d_
+         * vectors, which is the order used by the d_ vector operators such as laplacian.
+         * Only needed if the d_ vectors have been reordered.
+         */
+        template<typename T>
+        void to_d_order (const std::vector<T>& by_vi, std::vector<T>& by_di) const
+        {
+            if (by_vi.size() != this->d_vi.size()) {
+                throw std::runtime_error ("The data vector is not the same size as the hexgrid d_ vectors.");
+            }
+            if (&by_vi == &by_di) {
+                throw std::runtime_error ("Pass in separate memory for the result.");
+            }
+            by_di.resize (by_vi.size());
+            const std::int64_t n = static_cast<std::int64_t>(by_vi.size());
+#pragma omp parallel for
+            for (std::int64_t k = 0; k < n; ++k) { by_di[k] = by_vi[this->d_vi[k]]; }
+        }
+
+        //! The inverse of to_d_order: copy \a by_di, in d_ order, into \a by_vi, indexed by hex::vi.
+        template<typename T>
+        void from_d_order (const std::vector<T>& by_di, std::vector<T>& by_vi) const
+        {
+            if (by_di.size() != this->d_vi.size()) {
+                throw std::runtime_error ("The data vector is not the same size as the hexgrid d_ vectors.");
+            }
+            if (&by_vi == &by_di) {
+                throw std::runtime_error ("Pass in separate memory for the result.");
+            }
+            by_vi.resize (by_di.size());
+            const std::int64_t n = static_cast<std::int64_t>(by_di.size());
+#pragma omp parallel for
+            for (std::int64_t k = 0; k < n; ++k) { by_vi[this->d_vi[k]] = by_di[k]; }
         }
 
         /*!
@@ -1069,28 +1445,20 @@ export namespace sm
                 region_centroid -= this->original_boundary_centroid;
             }
 
-            // Now find the hexes on the boundary of the region
-            std::list<sm::hex>::iterator nearby_region_boundary_point = this->hexen.begin(); // i.e the hex at 0,0
-            typename std::vector<sm::bezcoord<float>>::iterator bpi = bpoints.begin();
-            while (bpi != bpoints.end()) {
-                nearby_region_boundary_point = this->set_region_boundary (*bpi++, nearby_region_boundary_point);
+            // Now find the hexes on the boundary of the region, checking that they are contiguous
+            std::list<const sm::hex*> region_bhexen;
+            if (this->trace_boundary (bpoints, this->make_axial_table(), region_bhexen,
+                                      sm::HEX_IS_REGION_BOUNDARY, sm::HEX_INSIDE_REGION) == false) {
+                return the_region;
             }
 
-            // Check that the region boundary is contiguous.
-            {
-                std::set<std::uint32_t> seen;
-                std::list<sm::hex>::iterator hi = nearby_region_boundary_point;
-                if (this->region_boundary_contiguous (nearby_region_boundary_point, hi, seen) == false) {
-                    std::stringstream ee;
-                    ee << "The constructed region boundary is not a contiguous sequence of hexes.";
-                    return the_region;
-                }
+            // Mark hexes inside region by testing all the hex centres against the region path at once
+            std::vector<std::uint8_t> inside;
+            this->classify_centres (sm::polygon_index<float>(bpoints), inside);
+            for (auto& hh : this->hexen) {
+                if (inside[hh.vi]) { hh.set_flag (sm::HEX_INSIDE_REGION); }
             }
 
-            // Mark hexes inside region. Use centroid of the region.
-            std::list<sm::hex>::iterator inside_regionhex = this->find_hex_nearest (region_centroid);
-            this->mark_hexes_inside (inside_regionhex, sm::HEX_IS_REGION_BOUNDARY, sm::HEX_INSIDE_REGION);
-
             // Populate the_region, then return it
             std::list<sm::hex>::iterator hi = this->hexen.begin();
             while (hi != this->hexen.end()) {
@@ -1165,6 +1533,271 @@ export namespace sm
             }
         }
 
+        /*!
+         * The neighbours of the hexes in an interior run, read from the d_ neighbour
+         * vectors. Passed to the interior_run function of apply_hex_stencil.
+         */
+        struct gathered_neighbours
+        {
+            std::array<const std::int32_t*, 6> p;
+            std::int32_t ne (const std::int32_t i) const { return this->p[0][i]; }
+            std::int32_t nne (const std::int32_t i) const { return this->p[1][i]; }
+            std::int32_t nnw (const std::int32_t i) const { return this->p[2][i]; }
+            std::int32_t nw (const std::int32_t i) const { return this->p[3][i]; }
+            std::int32_t nsw (const std::int32_t i) const { return this->p[4][i]; }
+            std::int32_t nse (const std::int32_t i) const { return this->p[5][i]; }
+        };
+
+        /*!
+         * The neighbours of the hexes in an interior run that lie at the same offsets from
+         * every hex in the run, as they do along the rows of hexorder::rows. Loops that
+         * read u[nb.ne (i)] are then loops over contiguous memory, which the compiler can
+         * vectorise.
+         */
+        struct strided_neighbours
+        {
+            std::array<std::int32_t, 6> offset;
+            std::int32_t ne (const std::int32_t i) const { return i + this->offset[0]; }
+            std::int32_t nne (const std::int32_t i) const { return i + this->offset[1]; }
+            std::int32_t nnw (const std::int32_t i) const { return i + this->offset[2]; }
+            std::int32_t nw (const std::int32_t i) const { return i + this->offset[3]; }
+            std::int32_t nsw (const std::int32_t i) const { return i + this->offset[4]; }
+            std::int32_t nse (const std::int32_t i) const { return i + this->offset[5]; }
+        };
+
+        /*!
+         * Run a six neighbour stencil over every hex. interior_run (i0, i1, nb) is called,
+         * in parallel, for each run of hexes i0 <= i < i1 that have all six neighbours, and
+         * edge_element (i) for each of the other hexes. nb gives the neighbours of hex i as
+         * nb.ne (i), nb.nne (i) and so on. In hexorder::rows it is a strided_neighbours,
+         * with constant offsets along each run; otherwise it is a gathered_neighbours, so
+         * interior_run should be a generic lambda.
+         *
+         * The run/edge split is made by update_stencil. If the d_ vectors have been
+         * rebuilt or resized since then, a fresh split is made for this call. Edits made in
+         * place to the d_ neighbour vectors are not detected; call update_stencil after
+         * making them, or a hex that has lost a neighbour will be treated as interior.
+         */
+        template<typename Fi, typename Fe>
+        void apply_hex_stencil (Fi interior_run, Fe edge_element) const
+        {
+            stencil_sets fresh;
+            const bool current = this->stencil.n == this->d_ne.size() && this->stencil.generation == this->d_neighbours_generation;
+            if (!current) { fresh = this->make_stencil_sets(); }
+            const stencil_sets& ss = current ? this->stencil : fresh;
+
+            const std::int64_t nr = static_cast<std::int64_t>(ss.interior_runs.size());
+            if (!ss.run_offsets.empty()) {
+#pragma omp parallel for
+                for (std::int64_t r = 0; r < nr; ++r) {
+                    interior_run (ss.interior_runs[r][0], ss.interior_runs[r][1], strided_neighbours{ ss.run_offsets[r] });
+                }
+            } else {
+                const gathered_neighbours g = { { this->d_ne.data(), this->d_nne.data(), this->d_nnw.data(),
+                                                  this->d_nw.data(), this->d_nsw.data(), this->d_nse.data() } };
+#pragma omp parallel for
+                for (std::int64_t r = 0; r < nr; ++r) { interior_run (ss.interior_runs[r][0], ss.interior_runs[r][1], g); }
+            }
+            const std::int64_t ne = static_cast<std::int64_t>(ss.edge.size());
+#pragma omp parallel for
+            for (std::int64_t k = 0; k < ne; ++k) { edge_element (ss.edge[k]); }
+        }
+
+        /*!
+         * Compute the Laplacian of data, which is indexed like the d_ vectors:
+         * 2 / (3d^2) times the sum over the six neighbours of (neighbour - centre). A
+         * missing neighbour at the edge of the domain is omitted, which is a zero-flux
+         * (Neumann) boundary condition.
+         */
+        template<typename T>
+        void laplacian (const std::vector<T>& data, std::vector<T>& result) const
+        {
+            static_assert (std::is_floating_point_v<T>, "hexgrid::laplacian requires floating point data");
+            this->check_d_args (data, result);
+            const T k = T{2} / (T{3} * static_cast<T>(this->d) * static_cast<T>(this->d));
+            this->apply_hex_stencil (
+                [&data, &result, k](const std::int32_t i0, const std::int32_t i1, const auto nb)
+                {
+                    const T* u = data.data();
+                    T* out = result.data();
+                    for (std::int32_t i = i0; i < i1; ++i) {
+                        out[i] = (u[nb.ne (i)] + u[nb.nne (i)] + u[nb.nnw (i)] + u[nb.nw (i)] + u[nb.nsw (i)] + u[nb.nse (i)] - T{6} * u[i]) * k;
+                    }
+                },
+                [this, &data, &result, k](const std::int32_t i)
+                {
+                    T sum = T{0};
+                    T count = T{0};
+                    for (const std::int32_t nb : this->neighbours_of (i)) {
+                        if (nb >= 0) {
+                            sum += data[nb];
+                            count += T{1};
+                        }
+                    }
+                    result[i] = (sum - count * data[i]) * k;
+                });
+        }
+
+        /*!
+         * Estimate the gradient of data, placing the x component in gx and the y component
+         * in gy. Each is 1 / (3d) times the sum over the six neighbours of (neighbour -
+         * centre) multiplied by the x or y component of the unit vector towards the
+         * neighbour. In the interior, this is a central difference. A missing neighbour at
+         * the edge of the domain takes the value of the central hex.
+         */
+        template<typename T>
+        void gradient (const std::vector<T>& data, std::vector<T>& gx, std::vector<T>& gy) const
+        {
+            static_assert (std::is_floating_point_v<T>, "hexgrid::gradient requires floating point data");
+            this->check_d_args (data, gx);
+            this->check_d_args (data, gy);
+            const T s = T{1} / (T{3} * static_cast<T>(this->d));
+            const T sy = s * sm::mathconst<T>::root_3_over_2;
+            this->apply_hex_stencil (
+                [&data, &gx, &gy, s, sy](const std::int32_t i0, const std::int32_t i1, const auto nb)
+                {
+                    const T* u = data.data();
+                    T* ox = gx.data();
+                    T* oy = gy.data();
+                    for (std::int32_t i = i0; i < i1; ++i) {
+                        ox[i] = (u[nb.ne (i)] - u[nb.nw (i)] + T{0.5} * (u[nb.nne (i)] - u[nb.nnw (i)] - u[nb.nsw (i)] + u[nb.nse (i)])) * s;
+                        oy[i] = (u[nb.nne (i)] + u[nb.nnw (i)] - u[nb.nsw (i)] - u[nb.nse (i)]) * sy;
+                    }
+                },
+                [this, &data, &gx, &gy, s, sy](const std::int32_t i)
+                {
+                    const std::array<std::int32_t, 6> nb = this->neighbours_of (i);
+                    std::array<T, 6> u;
+                    for (std::size_t j = 0; j < 6; ++j) { u[j] = nb[j] >= 0 ? data[nb[j]] : data[i]; }
+                    gx[i] = (u[0] - u[3] + T{0.5} * (u[1] - u[2] - u[4] + u[5])) * s;
+                    gy[i] = (u[1] + u[2] - u[4] - u[5]) * sy;
+                });
+        }
+
+        /*!
+         * Estimate the divergence of the vector field (fx, fy), with the same stencil as
+         * gradient: 1 / (3d) times the sum over the six neighbours of the difference
+         * between the neighbour's and the centre's field, dotted with the unit vector
+         * towards the neighbour. A missing neighbour at the edge of the domain takes the
+         * value of the central hex.
+         */
+        template<typename T>
+        void divergence (const std::vector<T>& fx, const std::vector<T>& fy, std::vector<T>& result) const
+        {
+            static_assert (std::is_floating_point_v<T>, "hexgrid::divergence requires floating point data");
+            this->check_d_args (fx, result);
+            this->check_d_args (fy, result);
+            const T s = T{1} / (T{3} * static_cast<T>(this->d));
+            const T sy = s * sm::mathconst<T>::root_3_over_2;
+            this->apply_hex_stencil (
+                [&fx, &fy, &result, s, sy](const std::int32_t i0, const std::int32_t i1, const auto nb)
+                {
+                    const T* ux = fx.data();
+                    const T* uy = fy.data();
+                    T* out = result.data();
+                    for (std::int32_t i = i0; i < i1; ++i) {
+                        out[i] = (ux[nb.ne (i)] - ux[nb.nw (i)] + T{0.5} * (ux[nb.nne (i)] - ux[nb.nnw (i)] - ux[nb.nsw (i)] + ux[nb.nse (i)])) * s
+                        + (uy[nb.nne (i)] + uy[nb.nnw (i)] - uy[nb.nsw (i)] - uy[nb.nse (i)]) * sy;
+                    }
+                },
+                [this, &fx, &fy, &result, s, sy](const std::int32_t i)
+                {
+                    const std::array<std::int32_t, 6> nb = this->neighbours_of (i);
+                    std::array<T, 6> ux;
+                    std::array<T, 6> uy;
+                    for (std::size_t j = 0; j < 6; ++j) {
+                        ux[j] = nb[j] >= 0 ? fx[nb[j]] : fx[i];
+                        uy[j] = nb[j] >= 0 ? fy[nb[j]] : fy[i];
+                    }
+                    result[i] = (ux[0] - ux[3] + T{0.5} * (ux[1] - ux[2] - ux[4] + ux[5])) * s
+                    + (uy[1] + uy[2] - uy[4] - uy[5]) * sy;
+                });
+        }
+
+        /*!
+         * One explicit Euler step of diffusion with coefficient D and time step dt:
+         * u_next = u + D dt laplacian(u), with zero flux at the edges of the domain. The
+         * Laplacian is fused into the update, so no intermediate vector is needed. The step
+         * is stable for D dt <= d^2 / 3.
+         */
+        template<typename T>
+        void diffusion_step (const std::vector<T>& u, std::vector<T>& u_next, const T D, const T dt) const
+        {
+            this->diffuse (u, static_cast<const std::vector<T>*>(nullptr), u_next, D, dt);
+        }
+
+        /*!
+         * One explicit Euler step of reaction-diffusion: u_next = u + dt (D laplacian(u) +
+         * f), where f holds the reaction term for each hex (for example, computed from the
+         * current state of a Turing or Keller-Segel model).
+         */
+        template<typename T>
+        void diffusion_step (const std::vector<T>& u, const std::vector<T>& f, std::vector<T>& u_next,
+                             const T D, const T dt) const
+        {
+            if (f.size() != u.size()) {
+                throw std::runtime_error ("The reaction vector is not the same size as the hexgrid.");
+            }
+            this->diffuse (u, &f, u_next, D, dt);
+        }
+
+        /*!
+         * The adjacency matrix of the hexes, indexed like the d_ vectors: element (i, j) is
+         * 1 if hex j is one of the six neighbours of hex i (including neighbours across a
+         * wrapped edge).
+         */
+        template<typename T = float>
+        sm::csr<T> adjacency_matrix() const
+        {
+            if (this->d_ne.size() != this->hexen.size()) {
+                throw std::runtime_error ("The hexgrid d_ vectors are not populated. Call populate_d_vectors() first.");
+            }
+            return sm::csr<T>::template from_rows<6> (
+                static_cast<std::uint32_t>(this->d_x.size()),
+                [this](const std::uint32_t i, std::uint32_t* c, T* v)
+                {
+                    std::uint32_t m = 0;
+                    for (const std::int32_t nb : this->neighbours_of (i)) {
+                        if (nb >= 0) {
+                            c[m] = static_cast<std::uint32_t>(nb);
+                            v[m++] = T{1};
+                        }
+                    }
+                    return m;
+                });
+        }
+
+        /*!
+         * The matrix L of the Laplacian, indexed like the d_ vectors, so that L u is
+         * laplacian(u) (to within rounding) when bc is neumann. With bc dirichlet, hexes
+         * beyond the edge of the domain are taken to hold 0. L is symmetric and negative
+         * (semi-)definite, so I - D dt L (see csr::identity_plus) can be solved with
+         * sm::conjugate_gradient for an implicit diffusion step.
+         */
+        template<typename T = float>
+        sm::csr<T> laplacian_matrix (const sm::boundary_condition bc = sm::boundary_condition::neumann) const
+        {
+            if (this->d_ne.size() != this->hexen.size()) {
+                throw std::runtime_error ("The hexgrid d_ vectors are not populated. Call populate_d_vectors() first.");
+            }
+            const T k = T{2} / (T{3} * static_cast<T>(this->d) * static_cast<T>(this->d));
+            return sm::csr<T>::template from_rows<7> (
+                static_cast<std::uint32_t>(this->d_x.size()),
+                [this, k, bc](const std::uint32_t i, std::uint32_t* c, T* v)
+                {
+                    std::uint32_t m = 0;
+                    for (const std::int32_t nb : this->neighbours_of (i)) {
+                        if (nb >= 0) {
+                            c[m] = static_cast<std::uint32_t>(nb);
+                            v[m++] = k;
+                        }
+                    }
+                    c[m] = i;
+                    v[m] = (bc == sm::boundary_condition::neumann ? -static_cast<T>(m) : T{-6}) * k;
+                    return m + 1u;
+                });
+        }
+
         /*!
          * Using this hexgrid as the domain, convolve the domain data \a data with the
          * kernel data \a kerneldata, which exists on another hexgrid, \a
@@ -1326,7 +1959,7 @@ export namespace sm
                         expr += std::exp ( - ( (params[0] * _d_x * _d_x) + (params[1] * _d_y * _d_y) ) ) * image_data[i];
                     }
                 }
-                expr_resampled[xi] = expr;
+                expr_resampled[this->d_vi[xi]] = expr;
             }
 
             expr_resampled /= expr_resampled.max(); // renormalise result
@@ -1396,21 +2029,206 @@ export namespace sm
         vec<float, 2> pll2_bot = {std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::quiet_NaN()};
         vec<float, 2> pll2_tr = {std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::quiet_NaN()};
 
+        /*!
+         * A shift of per-hex data by a fixed Cartesian vector, precomputed by
+         * make_shift_operator. Row i of the table holds the hexes whose data moves
+         * (partly) into hex i and the proportion that each contributes, so applying the
+         * shift is a gather that can run in parallel. Rows and sources are indexed by
+         * hex::vi.
+         */
+        struct shift_operator
+        {
+            //! The shift that this operator applies
+            vec<float, 2> dx = { 0.0f, 0.0f };
+            //! False if the overlap geometry could not be resolved for dx
+            bool valid = false;
+            //! Row i of the table is the entries [row_start[i], row_start[i+1])
+            std::vector<std::uint32_t> row_start;
+            //! The source hex (vi) of each entry
+            std::vector<std::uint32_t> src;
+            //! The proportion of the source's data that the entry moves into the row's hex
+            std::vector<float> weight;
+        };
+
+        /*!
+         * Compute the operator that shifts data by dx. The shift is split into whole
+         * hex-hops (following neighbour links, so that any wrapping is respected) plus a
+         * sub-hex remainder that is shared between the destination hex and its
+         * neighbours in proportion to the overlap of the shifted hex with each of them.
+         * The operator is only valid for the hexgrid in its current state.
+         */
+        shift_operator make_shift_operator (const sm::vec<float, 2>& dx)
+        {
+            shift_operator op;
+            op.dx = dx;
+
+            vec<std::int32_t, 2> int_rg = { 0, 0 };
+            vec<float, 19> overlap = this->shift_overlap (dx, int_rg);
+            if (overlap[0] == -100.0f) {
+                if constexpr (debug_hexshift) { std::cout << "overlap[0] is -100\n"; }
+                return op;
+            }
+
+            // Each source hex contributes to up to 19 destination hexes. Record the
+            // contributions in the order that a scatter over the hexes would add them, so
+            // that the sum in each row of the gather is made in the same order.
+            struct contribution
+            {
+                std::uint32_t dst;
+                std::uint32_t src;
+                std::uint32_t k;
+            };
+            std::vector<contribution> contribs;
+            contribs.reserve (this->hexen.size() * 7u);
+
+            for (std::list<hex>::iterator h = this->hexen.begin(); h != this->hexen.end(); ++h) {
+                auto add = [&contribs, &overlap, h](std::list<hex>::iterator target, std::uint32_t k)
+                {
+                    // Zero weights add nothing to the sum, so leave them out of the table
+                    if (overlap[k] != 0.0f) { contribs.push_back ({ static_cast<std::uint32_t>(target->vi), static_cast<std::uint32_t>(h->vi), k }); }
+                };
+
+                std::list<hex>::iterator dest_hex = h;
+                if (int_rg[1] > 0) {
+                    for (std::int32_t j = 0; j < int_rg[1] && dest_hex->has_nne(); ++j) {
+                        dest_hex = dest_hex->nne;
+                    }
+                } else {
+                    for (std::int32_t j = 0; j > int_rg[1] && dest_hex->has_nsw(); --j) {
+                        dest_hex = dest_hex->nsw;
+                    }
+                }
+                if (int_rg[0] > 0) {
+                    for (std::int32_t j = 0; j < int_rg[0] && dest_hex->has_ne(); ++j) {
+                        dest_hex = dest_hex->ne;
+                    }
+                } else {
+                    for (std::int32_t j = 0; j > int_rg[0] && dest_hex->has_nw(); --j) {
+                        dest_hex = dest_hex->nw;
+                    }
+                }
+
+                // The destination hex, then each neighbour followed by the two hexes beyond it
+                add (dest_hex, 0);
+                if (dest_hex->has_ne()) {
+                    add (dest_hex->ne, 1);
+                    if (dest_hex->ne->has_ne()) { add (dest_hex->ne->ne, 8); }
+                    if (dest_hex->ne->has_nne()) { add (dest_hex->ne->nne, 9); }
+                }
+                if (dest_hex->has_nne()) {
+                    add (dest_hex->nne, 2);
+                    if (dest_hex->nne->has_nne()) { add (dest_hex->nne->nne, 10); }
+                    if (dest_hex->nne->has_nnw()) { add (dest_hex->nne->nnw, 11); }
+                }
+                if (dest_hex->has_nnw()) {
+                    add (dest_hex->nnw, 3);
+                    if (dest_hex->nnw->has_nnw()) { add (dest_hex->nnw->nnw, 12); }
+                    if (dest_hex->nnw->has_nw()) { add (dest_hex->nnw->nw, 13); }
+                }
+                if (dest_hex->has_nw()) {
+                    add (dest_hex->nw, 4);
+                    if (dest_hex->nw->has_nw()) { add (dest_hex->nw->nw, 14); }
+                    if (dest_hex->nw->has_nsw()) { add (dest_hex->nw->nsw, 15); }
+                }
+                if (dest_hex->has_nsw()) {
+                    add (dest_hex->nsw, 5);
+                    if (dest_hex->nsw->has_nsw()) { add (dest_hex->nsw->nsw, 16); }
+                    if (dest_hex->nsw->has_nse()) { add (dest_hex->nsw->nse, 17); }
+                }
+                if (dest_hex->has_nse()) {
+                    add (dest_hex->nse, 6);
+                    if (dest_hex->nse->has_nse()) { add (dest_hex->nse->nse, 18); }
+                    if (dest_hex->nse->has_ne()) { add (dest_hex->nse->ne, 7); }
+                }
+            }
+
+            // Transpose the contributions into rows by destination with a stable counting sort
+            const std::uint32_t n = this->hexen.size();
+            op.row_start.assign (n + 1u, 0u);
+            for (const contribution& c : contribs) { ++op.row_start[c.dst + 1u]; }
+            std::partial_sum (op.row_start.begin(), op.row_start.end(), op.row_start.begin());
+            op.src.resize (contribs.size());
+            op.weight.resize (contribs.size());
+            std::vector<std::uint32_t> next (op.row_start.begin(), op.row_start.end() - 1);
+            for (const contribution& c : contribs) {
+                const std::uint32_t e = next[c.dst]++;
+                op.src[e] = c.src;
+                op.weight[e] = overlap[c.k];
+            }
+
+            op.valid = true;
+            return op;
+        }
+
+        /*!
+         * Return the operator that shifts data by dx, from a small cache of the most
+         * recently used operators, computing it if necessary. The reference remains
+         * valid until the operator is evicted from the cache (after shift_cache_capacity
+         * other shifts have been requested) or the cache is cleared.
+         */
+        const shift_operator& get_shift_operator (const sm::vec<float, 2>& dx)
+        {
+            auto hit = std::find_if (this->shift_cache.begin(), this->shift_cache.end(),
+                                     [&dx](const shift_operator& op) { return op.dx == dx; });
+            if (hit != this->shift_cache.end()) {
+                // Move to the front, which holds the most recently used operator
+                this->shift_cache.splice (this->shift_cache.begin(), this->shift_cache, hit);
+                return this->shift_cache.front();
+            }
+            this->shift_cache.push_front (this->make_shift_operator (dx));
+            while (this->shift_cache.size() > std::max (this->shift_cache_capacity, std::size_t{1})) {
+                this->shift_cache.pop_back();
+            }
+            return this->shift_cache.front();
+        }
+
+        //! The number of shift operators that get_shift_operator keeps (at least 1)
+        std::size_t shift_cache_capacity = 8;
+
+        //! Forget the cached shift operators. This is done whenever the grid changes.
+        void clear_shift_cache() { this->shift_cache.clear(); }
+
         static constexpr bool debug_hexshift = false;
 
         // Shift data by dx, with wrapping if set for the hexgrid
         template <typename T>
         bool shiftdata (sm::vvec<T>& image_data, const sm::vec<float, 2>& dx)
         {
-            std::uint32_t csz = image_data.size();
-            sm::vvec<T> shifted(csz, T{0});
-
-            // If g and r are purely integral, then the transform is simple; copy data
-            // from hex(i,j) in image_data to hex(i+r,j+g) in shifted, where the +r and
-            // +g are steps via neighbour relations (to ensure wrapping works)
+            return this->shiftdata (image_data, this->get_shift_operator (dx));
+        }
 
-            // Otherwise, distribute data from hex(i,j) of image_data proportionally between 4 hexes.
+        /*!
+         * Shift data with a precomputed operator. Returns false, leaving image_data
+         * unmodified, if the operator is not valid.
+         */
+        template <typename T>
+        bool shiftdata (sm::vvec<T>& image_data, const shift_operator& op) const
+        {
+            if (!op.valid) { return false; }
+            if (image_data.size() + 1u != op.row_start.size()) {
+                throw std::runtime_error ("hexgrid::shiftdata: data size does not match the shift operator");
+            }
+            const std::int64_t n = static_cast<std::int64_t>(image_data.size());
+            sm::vvec<T> shifted (image_data.size(), T{0});
+#pragma omp parallel for
+            for (std::int64_t i = 0; i < n; ++i) {
+                T sum = T{0};
+                for (std::uint32_t e = op.row_start[i]; e < op.row_start[i + 1]; ++e) {
+                    sum += op.weight[e] * image_data[op.src[e]];
+                }
+                shifted[i] = sum;
+            }
+            std::copy (shifted.begin(), shifted.end(), image_data.begin());
+            return true;
+        }
 
+        /*!
+         * Compute the overlap weights for a shift by dx (see compute_hex_overlap) and the
+         * whole number of r and g steps (int_rg) that precede the sub-hex remainder. Sets
+         * the member attributes that describe the overlap geometry.
+         */
+        vec<float, 19> shift_overlap (const sm::vec<float, 2>& dx, vec<std::int32_t, 2>& int_rg)
+        {
             // How many 'r' steps and how many 'g' steps does the vector dx represent?
             if constexpr (debug_hexshift) { std::cout << "d = " << this->d << ", dx = " << dx << std::endl; }
             vec<float, 2> rg = {
@@ -1421,7 +2239,7 @@ export namespace sm
             // How many integral steps in r and g axes?
             vec<float, 2> int_rg_f = rg.trunc();
             // Convert to int
-            vec<std::int32_t, 2> int_rg = { static_cast<std::int32_t>(std::round (int_rg_f[0])), static_cast<std::int32_t>(std::round (int_rg_f[1])) };
+            int_rg = { static_cast<std::int32_t>(std::round (int_rg_f[0])), static_cast<std::int32_t>(std::round (int_rg_f[1])) };
             if constexpr (debug_hexshift) { std::cout << "integral steps: " << int_rg << std::endl; }
             vec<float, 2> int_xy = {
                 (int_rg_f[0] * this->d + int_rg_f[1] * this->d * 0.5f),
@@ -1462,133 +2280,7 @@ export namespace sm
             n_sft = n_loc + rem_xy;
             s_sft = s_loc + rem_xy;
 
-            vec<float, 19> overlap = this->compute_hex_overlap (rem_xy);
-
-            if (overlap[0] == -100.0f) {
-                if constexpr (debug_hexshift) { std::cout << "overlap[0] is -100\n"; }
-                return false;
-            }
-
-            static constexpr bool debugdata = false;
-
-            std::list<hex>::iterator h = this->hexen.begin();
-            while (h != this->hexen.end()) {
-                // image_data[i] is the data to shift.
-                bool datatocopy = false;
-                if constexpr (debugdata) {
-                    datatocopy = image_data[h->vi] > T{0} ? true : false;
-                }
-                std::list<hex>::iterator dest_hex = h;
-                if (datatocopy) std::cout << "Copying hex data at " << h->output_rg() << "...";
-                if (int_rg[1] > 0) {
-                    for (std::int32_t j = 0; j < int_rg[1] && dest_hex->has_nne(); ++j) {
-                        dest_hex = dest_hex->nne;
-                    }
-                } else {
-                    for (std::int32_t j = 0; j > int_rg[1] && dest_hex->has_nsw(); --j) {
-                        dest_hex = dest_hex->nsw;
-                    }
-                }
-                if (int_rg[0] > 0) {
-                    for (std::int32_t j = 0; j < int_rg[0] && dest_hex->has_ne(); ++j) {
-                        dest_hex = dest_hex->ne;
-                    }
-                } else {
-                    for (std::int32_t j = 0; j > int_rg[0] && dest_hex->has_nw(); --j) {
-                        dest_hex = dest_hex->nw;
-                    }
-                }
-                // dest_hex should now be set
-                if constexpr (debugdata) { if (datatocopy) { std::cout << " to desthex: " << dest_hex->output_rg() << std::endl; } }
-
-                // Having computed all the overlaps:
-                if (datatocopy && overlap[0]) std::cout << "Adding [0] " << (overlap[0]*100.0f) << "% to dest_hex itself\n";
-                shifted[dest_hex->vi] += overlap[0] * image_data[h->vi];
-
-                if (dest_hex->has_ne()) {
-                    if constexpr (debugdata) { if (datatocopy && overlap[1]) { std::cout << "Adding [1] " << (overlap[1]*100.0f) << "% to dest_hex ne\n"; } }
-                    shifted[dest_hex->ne->vi] += overlap[1] * image_data[h->vi];
-
-                    if (dest_hex->ne->has_ne()) {
-                        if constexpr (debugdata) { if (datatocopy && overlap[8]) { std::cout << "Adding [8] " << (overlap[8]*100.0f) << "% to dest_hex ne->ne\n";} }
-                        shifted[dest_hex->ne->ne->vi] += overlap[8] * image_data[h->vi];
-                    }
-                    if (dest_hex->ne->has_nne()) {
-                        if constexpr (debugdata) { if (datatocopy && overlap[9]) { std::cout << "Adding [9] " << (overlap[9]*100.0f) << "% to dest_hex ne->nne\n"; } }
-                        shifted[dest_hex->ne->nne->vi] += overlap[9] * image_data[h->vi];
-                    }
-                } else {
-                    std::cout << "No Neighbour E?? dest_hex " << dest_hex->output_cart() << " has no neighbour east.\n";
-                }
-
-                if (dest_hex->has_nne()) {
-                    if constexpr (debugdata) { if (datatocopy && overlap[2]) { std::cout << "Adding [2] " << (overlap[2]*100.0f) << "% to dest_hex nne\n"; } }
-                    shifted[dest_hex->nne->vi] += overlap[2] * image_data[h->vi];
-                    if (dest_hex->nne->has_nne()) {
-                        if constexpr (debugdata) { if (datatocopy && overlap[10]) { std::cout << "Adding [10] " << (overlap[10]*100.0f) << "% to dest_hex nne->nne\n"; } }
-                        shifted[dest_hex->nne->nne->vi] += overlap[10] * image_data[h->vi];
-                    }
-                    if (dest_hex->nne->has_nnw()) {
-                        if constexpr (debugdata) { if (datatocopy && overlap[11]) { std::cout << "Adding [11] " << (overlap[11]*100.0f) << "% to dest_hex nne->nnw\n"; } }
-                        shifted[dest_hex->nne->nnw->vi] += overlap[11] * image_data[h->vi];
-                    }
-                }
-                if (dest_hex->has_nnw()) {
-                    if constexpr (debugdata) { if (datatocopy && overlap[3]) { std::cout << "Adding [3] " << (overlap[3]*100.0f) << "% to dest_hex nnw\n"; } }
-                    shifted[dest_hex->nnw->vi] += overlap[3] * image_data[h->vi];
-                    if (dest_hex->nnw->has_nnw()) {
-                        if constexpr (debugdata) { if (datatocopy && overlap[12]) { std::cout << "Adding [12] " << (overlap[12]*100.0f) << "% to dest_hex nnw->nnw\n"; } }
-                        shifted[dest_hex->nnw->nnw->vi] += overlap[12] * image_data[h->vi];
-                    }
-                    if (dest_hex->nnw->has_nw()) {
-                        if constexpr (debugdata) { if (datatocopy && overlap[13]) { std::cout << "Adding [13] " << (overlap[13]*100.0f) << "% to dest_hex nnw->nw\n"; } }
-                        shifted[dest_hex->nnw->nw->vi] += overlap[13] * image_data[h->vi];
-                    }
-                }
-                if (dest_hex->has_nw()) {
-                    if constexpr (debugdata) { if (datatocopy && overlap[4]) { std::cout << "Adding [4] " << (overlap[4]*100.0f) << "% to dest_hex nw\n"; } }
-                    shifted[dest_hex->nw->vi] += overlap[4] * image_data[h->vi];
-                    if (dest_hex->nw->has_nw()) {
-                        if constexpr (debugdata) { if (datatocopy && overlap[14]) { std::cout << "Adding [14] " << (overlap[14]*100.0f) << "% to dest_hex nw->nw\n"; } }
-                        shifted[dest_hex->nw->nw->vi] += overlap[14] * image_data[h->vi];
-                    }
-                    if (dest_hex->nw->has_nsw()) {
-                        if constexpr (debugdata) { if (datatocopy && overlap[15]) { std::cout << "Adding [15] " << (overlap[15]*100.0f) << "% to dest_hex nw->nsw\n"; } }
-                        shifted[dest_hex->nw->nsw->vi] += overlap[15] * image_data[h->vi];
-                    }
-                }
-                if (dest_hex->has_nsw()) {
-                    if constexpr (debugdata) { if (datatocopy && overlap[5]) { std::cout << "Adding [5] " << (overlap[5]*100.0f) << "% to dest_hex nsw\n"; } }
-                    shifted[dest_hex->nsw->vi] += overlap[5] * image_data[h->vi];
-                    if (dest_hex->nsw->has_nsw()) {
-                        if constexpr (debugdata) { if (datatocopy && overlap[16]) { std::cout << "Adding [16] " << (overlap[16]*100.0f) << "% to dest_hex nsw->nsw\n"; } }
-                        shifted[dest_hex->nsw->nsw->vi] += overlap[16] * image_data[h->vi];
-                    }
-                    if (dest_hex->nsw->has_nse()) {
-                        if constexpr (debugdata) { if (datatocopy && overlap[17]) { std::cout << "Adding [17] " << (overlap[17]*100.0f) << "% to dest_hex nsw->nse\n"; } }
-                        shifted[dest_hex->nsw->nse->vi] += overlap[17] * image_data[h->vi];
-                    }
-                }
-                if (dest_hex->has_nse()) {
-                    if constexpr (debugdata) { if (datatocopy && overlap[6]) { std::cout << "Adding [6] " << (overlap[6]*100.0f) << "% to dest_hex nse\n"; } }
-                    shifted[dest_hex->nse->vi] += overlap[6] * image_data[h->vi];
-                    if (dest_hex->nse->has_nse()) {
-                        if constexpr (debugdata) { if (datatocopy && overlap[18]) { std::cout << "Adding [18] " << (overlap[18]*100.0f) << "% to dest_hex nse->nse\n"; } }
-                        shifted[dest_hex->nse->nse->vi] += overlap[18] * image_data[h->vi];
-                    }
-                    if (dest_hex->nse->has_ne()) {
-                        if constexpr (debugdata) { if (datatocopy && overlap[7]) { std::cout << "Adding [7] " << (overlap[7]*100.0f) << "% to dest_hex nse->ne\n"; } }
-                        shifted[dest_hex->nse->ne->vi] += overlap[7] * image_data[h->vi];
-                    }
-                } else {
-                    if constexpr (debugdata) { std::cout << "No nse for hex " << dest_hex->output_rg() << "\n"; }
-                }
-
-                ++h;
-            }
-
-            std::copy (shifted.begin(), shifted.end(), image_data.begin());
-            return true;
+            return this->compute_hex_overlap (rem_xy);
         }
 
         /*!
@@ -2560,6 +3252,10 @@ export namespace sm
         // Set up wrapping. This works only on parallelogram shaped domains.
         void set_parallelogram_wrap (bool on_r, bool on_g)
         {
+            this->sync_hexen();
+            // Wrapping changes where shifted data goes
+            this->clear_shift_cache();
+
             if (!(on_r && on_g)) {
                 throw std::runtime_error ("Test single axis wrapping then remove this exception.");
             }
@@ -2664,6 +3360,9 @@ export namespace sm
                     cur_hex->set_nse(row_start->nsw);
                 }
             }
+
+            // Carry the new links into the d_ neighbour vectors used by laplacian and friends
+            if (this->d_ne.size() == this->hexen.size()) { this->populate_d_neighbours(); }
         }
 
         /*!
@@ -2698,6 +3397,15 @@ export namespace sm
          */
         sm::vec<float, 2> original_boundary_centroid = {0.0f, 0.0f};
 
+        /*!
+         * How set_boundary() finds the hexes inside a boundary. The default,
+         * boundaryfill::flood, fills outwards from the hex nearest the boundary
+         * centroid. boundaryfill::scanline keeps the hexes whose centres lie inside the
+         * boundary polygon, processing rows in parallel; use it for boundaries whose
+         * centroid may lie outside the enclosed region.
+         */
+        sm::boundaryfill boundary_fill = sm::boundaryfill::flood;
+
     private:
         /*!
          * Initialise a grid of hexes in a hex spiral, setting neighbours as the grid
@@ -2729,6 +3437,9 @@ export namespace sm
             std::int32_t ri = 0;
             std::int32_t gi = 0;
 
+            // The new hexes are where they should be
+            this->hexen_stale = false;
+
             // Create central "ring" first (the single hex)
             this->hexen.emplace_back (vi++, this->d, ri, gi);
 
@@ -3071,146 +3782,447 @@ export namespace sm
         }
 
         /*!
-         * Starting from \a start_from, and following nearest-neighbour relations, find
-         * the closest hex in hexen to the coordinate point \a point, and set its
-         * hex::on_boundary attribute to true.
-         *
-         * \return An iterator into hexgrid::hexen which refers to the closest hex to \a point.
+         * A dense lookup table from the (ri, gi) indices of the hexes in hexen to the
+         * hexes themselves, covering the bounding box of those indices. The boundary
+         * code uses it to find the hex under a point in O(1).
          */
-        std::list<sm::hex>::iterator set_boundary (const sm::bezcoord<float>& point,
-                                                   std::list<sm::hex>::iterator start_from)
+        struct axial_table
         {
-            std::list<sm::hex>::iterator h = this->find_hex_near_point (point, start_from);
-            h->set_flag (sm::HEX_IS_BOUNDARY | sm::HEX_INSIDE_BOUNDARY);
-            return h;
+            std::int32_t rmin = 0;
+            std::int32_t gmin = 0;
+            std::int32_t w = 0;
+            std::int32_t h = 0;
+            //! Row by row from gmin; an empty cell holds hexen.end()
+            std::vector<std::list<hex>::iterator> cells;
+            //! True if every hex sits at the position given by its (ri, gi) indices
+            bool on_lattice = true;
+
+            std::list<hex>::iterator at (const std::int32_t ri, const std::int32_t gi,
+                                         const std::list<hex>::iterator none) const
+            {
+                if (ri < this->rmin || ri >= this->rmin + this->w || gi < this->gmin || gi >= this->gmin + this->h) {
+                    return none;
+                }
+                return this->cells[(gi - this->gmin) * this->w + (ri - this->rmin)];
+            }
+        };
+
+        //! Build the axial_table for the current hexen. O(N).
+        axial_table make_axial_table()
+        {
+            this->sync_hexen();
+            axial_table tbl;
+            if (this->hexen.empty()) { return tbl; }
+            std::int32_t rmax = std::numeric_limits<std::int32_t>::lowest();
+            std::int32_t gmax = std::numeric_limits<std::int32_t>::lowest();
+            tbl.rmin = std::numeric_limits<std::int32_t>::max();
+            tbl.gmin = std::numeric_limits<std::int32_t>::max();
+            const float tol = 1e-3f * this->d;
+            for (const auto& hh : this->hexen) {
+                tbl.rmin = std::min (tbl.rmin, hh.ri);
+                tbl.gmin = std::min (tbl.gmin, hh.gi);
+                rmax = std::max (rmax, hh.ri);
+                gmax = std::max (gmax, hh.gi);
+                // A transformed grid no longer has its hexes at their lattice positions
+                if (hh.bi != 0
+                    || std::abs (hh.x - (this->d * hh.ri + (this->d / 2.0f) * hh.gi)) > tol
+                    || std::abs (hh.y - this->v * hh.gi) > tol) {
+                    tbl.on_lattice = false;
+                }
+            }
+            tbl.w = rmax - tbl.rmin + 1;
+            tbl.h = gmax - tbl.gmin + 1;
+            tbl.cells.assign (static_cast<std::size_t>(tbl.w) * tbl.h, this->hexen.end());
+            for (auto hi = this->hexen.begin(); hi != this->hexen.end(); ++hi) {
+                tbl.cells[(hi->gi - tbl.gmin) * tbl.w + (hi->ri - tbl.rmin)] = hi;
+            }
+            return tbl;
         }
 
         /*!
-         * Determine whether the boundary is contiguous. Whilst doing so, populate a
-         * list<hex> containing just the boundary hexes.
+         * Find the hex nearest to \a point. If the grid is on its lattice, the hex is
+         * found directly by rounding the point's fractional axial coordinates. Otherwise
+         * (or if the point is off the grid) the nearest-neighbour walk of
+         * find_hex_near_point() is used, starting from \a start_from.
          */
-        bool boundary_contiguous()
+        std::list<hex>::iterator locate_hex (const bezcoord<float>& point, std::list<hex>::iterator start_from,
+                                             const axial_table& tbl)
         {
-            this->bhexen.clear();
-            std::list<sm::hex>::const_iterator bhi = this->hexen.begin();
-            if (this->find_boundaryhex (bhi) == false) {
-                // Found no boundary hex
-                return false;
+            if (tbl.on_lattice) {
+                // Cube coordinate rounding, in which the component with the largest rounding
+                // error is recomputed from the other two.
+                const float gf = point.y() / this->v;
+                const float rf = point.x() / this->d - 0.5f * gf;
+                const float sf = -rf - gf;
+                float rr = std::round (rf);
+                float gr = std::round (gf);
+                const float sr = std::round (sf);
+                const float dr = std::abs (rr - rf);
+                const float dg = std::abs (gr - gf);
+                const float ds = std::abs (sr - sf);
+                if (dr > dg && dr > ds) {
+                    rr = -gr - sr;
+                } else if (dg > ds) {
+                    gr = -rr - sr;
+                }
+                std::list<sm::hex>::iterator c = tbl.at (static_cast<std::int32_t>(rr), static_cast<std::int32_t>(gr),
+                                                         this->hexen.end());
+                if (c != this->hexen.end()) { start_from = c; }
             }
-            std::set<std::uint32_t> seen;
-            std::list<sm::hex>::const_iterator hi = bhi;
-            return this->boundary_contiguous (bhi, hi, seen);
+            // On the lattice, this just confirms that no neighbour of start_from is nearer
+            return this->find_hex_near_point (point, start_from);
+        }
+
+        //! Reorder v so that element k is the old element new_to_old[k]. Does nothing if v is not in use.
+        template<typename T>
+        static void permute (std::vector<T>& v, const std::vector<std::uint32_t>& new_to_old)
+        {
+            if (v.size() != new_to_old.size()) { return; }
+            std::vector<T> tmp (v.size());
+            for (std::size_t k = 0; k < v.size(); ++k) { tmp[k] = v[new_to_old[k]]; }
+            v.swap (tmp);
         }
 
         /*!
-         * Determine whether the boundary is contiguous, starting from the boundary
-         * hex iterator \a bhi.
-         *
-         * The overload with bhexes takes a list of hex pointers and populates it with
-         * pointers to the hexes on the boundary.
+         * The d_ indices split into the hexes that have all six neighbours, stored as runs
+         * [first, second) of consecutive indices, and the rest (the edge hexes). Computed by
+         * populate_d_neighbours for the operators such as laplacian, so that their interior
+         * loops need no neighbour checks.
+         */
+        struct stencil_sets
+        {
+            std::vector<std::array<std::int32_t, 2>> interior_runs;
+            //! For each interior run, the offset d_nX[i] - i to each neighbour (hexorder::rows only)
+            std::vector<std::array<std::int32_t, 6>> run_offsets;
+            std::vector<std::int32_t> edge;
+            //! The number of hexes that the sets were made for
+            std::size_t n = 0;
+            //! The value of d_neighbours_generation that the sets were made for
+            std::uint64_t generation = 0;
+        };
+        stencil_sets stencil;
+
+        /*!
+         * Incremented whenever this class rewrites the d_ neighbour vectors (or clears the
+         * d_ vectors), so that apply_hex_stencil never uses stencil sets that are out of date
          */
-        bool boundary_contiguous (std::list<hex>::const_iterator bhi,
-                                  std::list<hex>::const_iterator hi, std::set<std::uint32_t>& seen)
+        std::uint64_t d_neighbours_generation = 0;
+
+        //! The shift operators most recently used by get_shift_operator, most recent first
+        std::list<shift_operator> shift_cache;
+
+        //! A dense table, row by row from gmin, of the d index at each axial coordinate (-1 for none)
+        struct d_axial_table
         {
-            bool rtn = false;
-            std::list<sm::hex>::const_iterator hi_next;
-            seen.insert (hi->vi);
-            // Insert into the std::list of hex pointers, too
-            this->bhexen.push_back (&(*hi));
+            std::int32_t rmin = 0;
+            std::int32_t gmin = 0;
+            std::int32_t w = 0;
+            std::int32_t h = 0;
+            std::vector<std::int32_t> cells;
+            //! The number of hexes that the table was made for
+            std::size_t n = 0;
+        };
+        d_axial_table d_axial;
+
+        //! True if a lazy transform has moved d_x and d_y but not the hexes in hexen
+        bool hexen_stale = false;
 
-            if (rtn == false && hi->has_ne() && hi->ne->test_flags(sm::HEX_IS_BOUNDARY) == true && seen.find(hi->ne->vi) == seen.end()) {
-                hi_next = hi->ne;
-                rtn = (this->boundary_contiguous (bhi, hi_next, seen));
+        /*!
+         * Apply the 2D part of the affine transform tf to d_x and d_y. This is the
+         * arithmetic of hex::transform (with z = 0), so the results are the same, but as a
+         * loop over contiguous arrays which the compiler can vectorise.
+         */
+        void transform_d_positions (const sm::mat<float, 4>& tf)
+        {
+            const float a00 = tf.arr[0];
+            const float a10 = tf.arr[1];
+            const float a01 = tf.arr[4];
+            const float a11 = tf.arr[5];
+            const float z0 = tf.arr[8] * 0.0f;
+            const float z1 = tf.arr[9] * 0.0f;
+            const float t0 = tf.arr[12];
+            const float t1 = tf.arr[13];
+            float* px = this->d_x.data();
+            float* py = this->d_y.data();
+            const std::int64_t n = static_cast<std::int64_t>(this->d_x.size());
+#pragma omp parallel for
+            for (std::int64_t i = 0; i < n; ++i) {
+                const float x = px[i];
+                const float y = py[i];
+                px[i] = a00 * x + a01 * y + z0 + t0;
+                py[i] = a10 * x + a11 * y + z1 + t1;
             }
-            if (rtn == false && hi->has_nne() && hi->nne->test_flags(sm::HEX_IS_BOUNDARY) == true && seen.find(hi->nne->vi) == seen.end()) {
-                hi_next = hi->nne;
-                rtn = (this->boundary_contiguous (bhi, hi_next, seen));
+        }
+
+        //! Throw if di is out of range or the axial lookup is out of date
+        void check_d_axial (const std::uint32_t di) const
+        {
+            if (this->d_axial.n != this->d_ri.size()) {
+                throw std::runtime_error ("hexgrid: the axial lookup is out of date. Call index_d_axial() first.");
             }
-            if (rtn == false && hi->has_nnw() && hi->nnw->test_flags(sm::HEX_IS_BOUNDARY) == true && seen.find(hi->nnw->vi) == seen.end()) {
-                hi_next = hi->nnw;
-                rtn =  (this->boundary_contiguous (bhi, hi_next, seen));
+            if (di >= this->d_ri.size()) { throw std::runtime_error ("hexgrid: d index out of range"); }
+        }
+
+        //! Call f(di) for each hex in row gi with ri0 <= ri <= ri1
+        template <typename F>
+        void for_each_in_row (std::int32_t ri0, std::int32_t ri1, const std::int32_t gi, F& f) const
+        {
+            const d_axial_table& t = this->d_axial;
+            if (gi < t.gmin || gi >= t.gmin + t.h) { return; }
+            ri0 = std::max (ri0, t.rmin);
+            ri1 = std::min (ri1, t.rmin + t.w - 1);
+            const std::size_t row = static_cast<std::size_t>(gi - t.gmin) * t.w;
+            for (std::int32_t ri = ri0; ri <= ri1; ++ri) {
+                const std::int32_t dj = t.cells[row + (ri - t.rmin)];
+                if (dj >= 0) { f (dj); }
             }
-            if (rtn == false && hi->has_nw() && hi->nw->test_flags(sm::HEX_IS_BOUNDARY) == true && seen.find(hi->nw->vi) == seen.end()) {
-                hi_next = hi->nw;
-                rtn =  (this->boundary_contiguous (bhi, hi_next, seen));
+        }
+
+        //! The longest interior run. Long runs are split so that threads share the work evenly.
+        static constexpr std::int32_t stencil_run_max = 2048;
+
+        /*!
+         * Find the interior runs and the edge hexes. In hexorder::rows, runs are also split
+         * wherever the offsets to the neighbours change, so that each run has constant
+         * offsets; these are stored in run_offsets.
+         */
+        stencil_sets make_stencil_sets() const
+        {
+            stencil_sets ss;
+            ss.n = this->d_ne.size();
+            const std::int32_t n = static_cast<std::int32_t>(ss.n);
+            const bool strided = this->d_order == sm::hexorder::rows;
+            std::array<std::int32_t, 6> run_offset = {};
+            std::int32_t run_start = -1;
+            for (std::int32_t i = 0; i <= n; ++i) {
+                bool interior = false;
+                std::array<std::int32_t, 6> offset = {};
+                if (i < n) {
+                    const std::array<std::int32_t, 6> nb = this->neighbours_of (i);
+                    interior = true;
+                    for (std::size_t k = 0; k < 6; ++k) {
+                        interior = interior && nb[k] >= 0;
+                        offset[k] = nb[k] - i;
+                    }
+                    if (!interior) { ss.edge.push_back (i); }
+                }
+                if (run_start >= 0 && (!interior || i - run_start == stencil_run_max || (strided && offset != run_offset))) {
+                    ss.interior_runs.push_back ({ run_start, i });
+                    if (strided) { ss.run_offsets.push_back (run_offset); }
+                    run_start = -1;
+                }
+                if (interior && run_start < 0) {
+                    run_start = i;
+                    run_offset = offset;
+                }
             }
-            if (rtn == false && hi->has_nsw() && hi->nsw->test_flags(sm::HEX_IS_BOUNDARY) == true && seen.find(hi->nsw->vi) == seen.end()) {
-                hi_next = hi->nsw;
-                rtn =  (this->boundary_contiguous (bhi, hi_next, seen));
+            return ss;
+        }
+
+        //! The neighbours of the hex with d_ index i, in the order E, NE, NW, W, SW, SE. -1 for none.
+        std::array<std::int32_t, 6> neighbours_of (const std::int32_t i) const
+        {
+            return { this->d_ne[i], this->d_nne[i], this->d_nnw[i], this->d_nw[i], this->d_nsw[i], this->d_nse[i] };
+        }
+
+        //! Common argument checks for the d_ vector operators
+        template<typename T>
+        void check_d_args (const std::vector<T>& data, const std::vector<T>& result) const
+        {
+            if (this->d_ne.size() != this->hexen.size()) {
+                throw std::runtime_error ("The hexgrid d_ vectors are not populated. Call populate_d_vectors() first.");
             }
-            if (rtn == false && hi->has_nse() && hi->nse->test_flags(sm::HEX_IS_BOUNDARY) == true && seen.find(hi->nse->vi) == seen.end()) {
-                hi_next = hi->nse;
-                rtn =  (this->boundary_contiguous (bhi, hi_next, seen));
+            if (result.size() != this->hexen.size()) {
+                throw std::runtime_error ("The result vector is not the same size as the hexgrid.");
             }
-
-            if (rtn == false) {
-                // Checked all neighbours
-                if (hi == bhi) {
-                    // Back at start, nowhere left to go! return true.
-                    rtn = true;
-                }
+            if (result.size() != data.size()) {
+                throw std::runtime_error ("The data vector is not the same size as the hexgrid.");
+            }
+            if (&data == &result) {
+                throw std::runtime_error ("Pass in separate memory for the result.");
             }
+        }
 
-            return rtn;
+        //! The fused diffusion (and optionally reaction, if f is not null) update for diffusion_step
+        template<typename T>
+        void diffuse (const std::vector<T>& u, const std::vector<T>* f, std::vector<T>& u_next, const T D, const T dt) const
+        {
+            static_assert (std::is_floating_point_v<T>, "hexgrid::diffusion_step requires floating point data");
+            this->check_d_args (u, u_next);
+            const T k = D * dt * T{2} / (T{3} * static_cast<T>(this->d) * static_cast<T>(this->d));
+            const T* fp = f == nullptr ? nullptr : f->data();
+            this->apply_hex_stencil (
+                [&u, &u_next, fp, k, dt](const std::int32_t i0, const std::int32_t i1, const auto nb)
+                {
+                    const T* c = u.data();
+                    T* out = u_next.data();
+                    if (fp == nullptr) {
+                        for (std::int32_t i = i0; i < i1; ++i) {
+                            out[i] = c[i] + (c[nb.ne (i)] + c[nb.nne (i)] + c[nb.nnw (i)] + c[nb.nw (i)] + c[nb.nsw (i)] + c[nb.nse (i)] - T{6} * c[i]) * k;
+                        }
+                    } else {
+                        for (std::int32_t i = i0; i < i1; ++i) {
+                            out[i] = c[i] + (c[nb.ne (i)] + c[nb.nne (i)] + c[nb.nnw (i)] + c[nb.nw (i)] + c[nb.nsw (i)] + c[nb.nse (i)] - T{6} * c[i]) * k
+                            + fp[i] * dt;
+                        }
+                    }
+                },
+                [this, &u, &u_next, fp, k, dt](const std::int32_t i)
+                {
+                    T sum = T{0};
+                    T count = T{0};
+                    for (const std::int32_t nb : this->neighbours_of (i)) {
+                        if (nb >= 0) {
+                            sum += u[nb];
+                            count += T{1};
+                        }
+                    }
+                    u_next[i] = u[i] + (sum - count * u[i]) * k + (fp == nullptr ? T{0} : fp[i] * dt);
+                });
         }
 
         /*!
-         * Set the hex closest to point as being on the region boundary. Region
-         * boundaries are supposed to be temporary, so that client code can find a
-         * region, extract the pointers to all the hexes in that region and store that
-         * information for later use.
+         * Classify the centre of every hex against the polygon \a pi, in parallel,
+         * setting inside[vi] to 1 for the hexes inside it (indexed by hex::vi). Uses d_x
+         * and d_y if they are up to date.
          */
-        std::list<hex>::iterator set_region_boundary (const bezcoord<float>& point, std::list<hex>::iterator start_from)
+        void classify_centres (const sm::polygon_index<float>& pi, std::vector<std::uint8_t>& inside) const
         {
-            std::list<sm::hex>::iterator h = this->find_hex_near_point (point, start_from);
-            h->set_flag (sm::HEX_IS_REGION_BOUNDARY | sm::HEX_INSIDE_REGION);
-            return h;
+            if (this->d_x.size() == this->hexen.size()) {
+                std::vector<std::uint8_t> inside_d;
+                pi.contains (this->d_x, this->d_y, inside_d);
+                this->from_d_order (inside_d, inside);
+                return;
+            }
+            std::vector<float> xs (this->hexen.size());
+            std::vector<float> ys (this->hexen.size());
+            for (const auto& hh : this->hexen) {
+                const sm::vec<float, 2> p = this->hex_position (hh);
+                xs[hh.vi] = p[0];
+                ys[hh.vi] = p[1];
+            }
+            pi.contains (xs, ys, inside);
+        }
+
+        //! Are a and b neighbours in the grid?
+        static bool hexes_adjacent (std::list<hex>::const_iterator a, std::list<hex>::const_iterator b)
+        {
+            for (std::uint32_t i = 0; i < 6; ++i) {
+                if (a->has_neighbour (i) && std::list<hex>::const_iterator(a->get_neighbour (i)) == b) { return true; }
+            }
+            return false;
         }
 
         /*!
-         * Determine whether the region boundary is contiguous, starting from the
-         * boundary hex iterator #bhi.
+         * Mark the hexes under the closed path \a bpoints with \a bdry_flag and
+         * \a inside_flag and place them, in path order, in \a bdry. Each point is
+         * located in O(1) with \a tbl. Contiguity is checked in the same pass: where
+         * consecutive points land on hexes that are not neighbours, the segment between
+         * them is resampled at a quarter of the hex to hex distance.
+         *
+         * \return false if that does not close a gap, i.e. the boundary is not contiguous.
          */
-        bool region_boundary_contiguous (std::list<hex>::const_iterator bhi,
-                                         std::list<hex>::const_iterator hi, std::set<std::uint32_t>& seen)
+        bool trace_boundary (const std::vector<bezcoord<float>>& bpoints, const axial_table& tbl,
+                             std::list<const hex*>& bdry,
+                             const std::uint32_t bdry_flag = sm::HEX_IS_BOUNDARY,
+                             const std::uint32_t inside_flag = sm::HEX_INSIDE_BOUNDARY)
         {
-            bool rtn = false;
-            std::list<sm::hex>::const_iterator hi_next;
-            seen.insert (hi->vi);
-            // Insert into the list of hex pointers, too
-            this->bhexen.push_back (&(*hi));
+            bdry.clear();
+            if (bpoints.empty() || this->hexen.empty()) { return true; }
 
-            if (rtn == false && hi->has_ne() && hi->ne->test_flags(sm::HEX_IS_REGION_BOUNDARY) == true && seen.find(hi->ne->vi) == seen.end()) {
-                hi_next = hi->ne;
-                rtn = (this->region_boundary_contiguous (bhi, hi_next, seen));
-            }
-            if (rtn == false && hi->has_nne() && hi->nne->test_flags(sm::HEX_IS_REGION_BOUNDARY) == true && seen.find(hi->nne->vi) == seen.end()) {
-                hi_next = hi->nne;
-                rtn = this->region_boundary_contiguous (bhi, hi_next, seen);
-            }
-            if (rtn == false && hi->has_nnw() && hi->nnw->test_flags(sm::HEX_IS_REGION_BOUNDARY) == true && seen.find(hi->nnw->vi) == seen.end()) {
-                hi_next = hi->nnw;
-                rtn =  (this->region_boundary_contiguous (bhi, hi_next, seen));
-            }
-            if (rtn == false && hi->has_nw() && hi->nw->test_flags(sm::HEX_IS_REGION_BOUNDARY) == true && seen.find(hi->nw->vi) == seen.end()) {
-                hi_next = hi->nw;
-                rtn =  (this->region_boundary_contiguous (bhi, hi_next, seen));
-            }
-            if (rtn == false && hi->has_nsw() && hi->nsw->test_flags(sm::HEX_IS_REGION_BOUNDARY) == true && seen.find(hi->nsw->vi) == seen.end()) {
-                hi_next = hi->nsw;
-                rtn =  (this->region_boundary_contiguous (bhi, hi_next, seen));
+            std::vector<std::list<hex>::iterator> chain;
+            bool contiguous = true;
+            auto extend = [&chain, &contiguous](std::list<hex>::iterator h)
+            {
+                if (chain.empty()) {
+                    chain.push_back (h);
+                } else if (h != chain.back()) {
+                    if (!hexes_adjacent (chain.back(), h)) { contiguous = false; }
+                    chain.push_back (h);
+                }
+            };
+
+            const std::size_t np = bpoints.size();
+            std::list<sm::hex>::iterator prev = this->hexen.begin();
+            // Visit each point, then return to the first point to close the loop
+            for (std::size_t i = 0; i <= np && contiguous; ++i) {
+                const bezcoord<float>& pt = bpoints[i % np];
+                std::list<sm::hex>::iterator h = this->locate_hex (pt, prev, tbl);
+                if (!chain.empty() && h != chain.back() && !hexes_adjacent (chain.back(), h)) {
+                    // Fill the gap by stepping along the segment from the previous point
+                    const bezcoord<float>& p0 = bpoints[i - 1];
+                    const float dx = pt.x() - p0.x();
+                    const float dy = pt.y() - p0.y();
+                    const std::int32_t nsteps = static_cast<std::int32_t>(std::ceil (std::sqrt (dx * dx + dy * dy) / (0.25f * this->d)));
+                    for (std::int32_t k = 1; k < nsteps; ++k) {
+                        const float t = static_cast<float>(k) / nsteps;
+                        bezcoord<float> pk (sm::vec<float, 2>{ p0.x() + t * dx, p0.y() + t * dy });
+                        extend (this->locate_hex (pk, chain.back(), tbl));
+                    }
+                }
+                extend (h);
+                prev = h;
             }
-            if (rtn == false && hi->has_nse() && hi->nse->test_flags(sm::HEX_IS_REGION_BOUNDARY) == true && seen.find(hi->nse->vi) == seen.end()) {
-                hi_next = hi->nse;
-                rtn =  (this->region_boundary_contiguous (bhi, hi_next, seen));
+            // The loop closed on the first hex, which is already in the chain
+            if (chain.size() > 1 && chain.back() == chain.front()) { chain.pop_back(); }
+
+            for (auto h : chain) {
+                if (h->test_flags (bdry_flag) == false) { bdry.push_back (&(*h)); }
+                h->set_flag (bdry_flag | inside_flag);
             }
+            return contiguous;
+        }
 
-            if (rtn == false) {
-                // Checked all neighbours
-                if (hi == bhi) { rtn = true; }
+        /*!
+         * Determine whether the boundary is contiguous. Whilst doing so, populate a
+         * list<hex> containing just the boundary hexes.
+         */
+        bool boundary_contiguous()
+        {
+            this->bhexen.clear();
+            std::list<sm::hex>::const_iterator bhi = this->hexen.begin();
+            while (bhi != this->hexen.end() && bhi->test_flags (sm::HEX_IS_BOUNDARY) == false) { ++bhi; }
+            if (bhi == this->hexen.end()) {
+                // Found no boundary hex
+                return false;
             }
+            return this->boundary_contiguous (bhi);
+        }
 
-            return rtn;
+        /*!
+         * Determine whether the boundary is contiguous, starting from the boundary hex
+         * iterator \a bhi. The boundary hexes are walked depth first (with an explicit
+         * stack, so that long boundaries can't overflow the call stack), preferring the
+         * E neighbour, then NE and so on anticlockwise. Each hex reached is added to
+         * bhexen. The boundary is contiguous if every boundary hex was reached.
+         */
+        bool boundary_contiguous (std::list<hex>::const_iterator bhi)
+        {
+            this->bhexen.clear();
+            std::uint32_t n_boundary = 0;
+            std::uint32_t vi_max = 0;
+            for (const auto& hh : this->hexen) {
+                if (hh.test_flags (sm::HEX_IS_BOUNDARY)) { ++n_boundary; }
+                vi_max = std::max (vi_max, hh.vi);
+            }
+
+            std::vector<char> seen (vi_max + 1, 0);
+            std::vector<const hex*> stack = { &(*bhi) };
+            while (!stack.empty()) {
+                const sm::hex* hh = stack.back();
+                stack.pop_back();
+                if (seen[hh->vi]) { continue; }
+                seen[hh->vi] = 1;
+                this->bhexen.push_back (hh);
+                // Push in reverse, so that the E neighbour is visited first
+                for (std::uint32_t i = 6; i-- > 0;) {
+                    if (hh->has_neighbour (i)) {
+                        const sm::hex* hn = &(*hh->get_neighbour (i));
+                        if (hn->test_flags (sm::HEX_IS_BOUNDARY) && !seen[hn->vi]) { stack.push_back (hn); }
+                    }
+                }
+            }
+            return this->bhexen.size() == n_boundary;
         }
 
         /*!
@@ -3277,6 +4289,7 @@ export namespace sm
          */
         std::list<hex>::iterator find_hex_near_point (const bezcoord<float>& point, std::list<hex>::iterator start_from)
         {
+            this->sync_hexen();
             bool neighbour_nearer = true;
 
             std::list<sm::hex>::iterator h = start_from;
@@ -3660,13 +4673,88 @@ export namespace sm
         }
 
         /*!
-         * Discard hexes in this->hexen that are outside the boundary #boundary.
+         * Mark the hexes inside the boundary with HEX_INSIDE_BOUNDARY, according to
+         * #boundary_fill. The scanline fill needs the boundary \a polygon and a grid on
+         * its lattice; without them, the flood fill is used.
+         */
+        void fill_boundary_interior (const axial_table& tbl, const std::vector<bezcoord<float>>* polygon)
+        {
+            const bool can_scan = polygon != nullptr && tbl.on_lattice;
+            if (this->boundary_fill == sm::boundaryfill::scanline && can_scan) {
+                this->scanline_fill (tbl, *polygon);
+                return;
+            }
+            std::list<sm::hex>::iterator seed = this->locate_hex (bezcoord<float>(this->boundary_centroid),
+                                                                 this->hexen.begin(), tbl);
+            if (seed->test_flags (sm::HEX_IS_BOUNDARY) && can_scan) {
+                // The centroid is on the boundary, so it gives no inside hex to start from
+                this->scanline_fill (tbl, *polygon);
+            } else {
+                this->flood_fill (seed);
+            }
+        }
+
+        /*!
+         * Iterative flood fill, marking \a seed and every hex reachable from it without
+         * crossing a hex already marked HEX_INSIDE_BOUNDARY (which includes the boundary
+         * hexes).
+         */
+        void flood_fill (std::list<hex>::iterator seed)
+        {
+            std::vector<sm::hex*> stack;
+            if (seed->test_flags (sm::HEX_INSIDE_BOUNDARY) == false) {
+                seed->set_flag (sm::HEX_INSIDE_BOUNDARY);
+                stack.push_back (&(*seed));
+            }
+            while (!stack.empty()) {
+                sm::hex* hh = stack.back();
+                stack.pop_back();
+                for (std::uint32_t i = 0; i < 6; ++i) {
+                    if (!hh->has_neighbour (i)) { continue; }
+                    sm::hex* hn = &(*hh->get_neighbour (i));
+                    if (hn->test_flags (sm::HEX_INSIDE_BOUNDARY) == false) {
+                        hn->set_flag (sm::HEX_INSIDE_BOUNDARY);
+                        stack.push_back (hn);
+                    }
+                }
+            }
+        }
+
+        /*!
+         * Mark each hex whose centre lies inside \a polygon (by the even-odd rule). Each
+         * row of hexes is tested against the sorted crossings of the polygon with the
+         * row, and rows are processed in parallel.
+         */
+        void scanline_fill (const axial_table& tbl, const std::vector<bezcoord<float>>& polygon)
+        {
+            std::vector<float> ys (tbl.h);
+            for (std::int32_t k = 0; k < tbl.h; ++k) { ys[k] = this->v * static_cast<float>(tbl.gmin + k); }
+            std::vector<std::vector<float>> xs;
+            sm::algo::scanline_crossings (polygon, ys, xs);
+
+            const std::list<sm::hex>::iterator none = this->hexen.end();
+#pragma omp parallel for
+            for (std::int32_t k = 0; k < tbl.h; ++k) {
+                const std::vector<float>& xk = xs[k];
+                std::size_t c = 0;
+                for (std::int32_t j = 0; j < tbl.w; ++j) {
+                    std::list<sm::hex>::iterator hi = tbl.cells[k * tbl.w + j];
+                    if (hi == none) { continue; }
+                    while (c < xk.size() && xk[c] < hi->x) { ++c; }
+                    if (c % 2 == 1) { hi->set_flag (sm::HEX_INSIDE_BOUNDARY); }
+                }
+            }
+        }
+
+        /*!
+         * Discard hexes in this->hexen that are outside the boundary #boundary. The
+         * boundary hexes must already be marked. \a polygon is the boundary path, if
+         * there is one, for use by the scanline fill.
          */
-        void discard_outside_boundary()
+        void discard_outside_boundary (const axial_table& tbl, const std::vector<bezcoord<float>>* polygon = nullptr)
         {
             // Mark those hexes inside the boundary
-            std::list<sm::hex>::iterator centroidhex = this->find_hex_nearest (this->boundary_centroid);
-            this->mark_hexes_inside (centroidhex);
+            this->fill_boundary_interior (tbl, polygon);
             // Run through and discard those hexes outside the boundary:
             auto hi = this->hexen.begin();
             while (hi != this->hexen.end()) {
@@ -3727,31 +4815,32 @@ export namespace sm
 
             // Check to see if there are any boundary hexes at all.
             std::uint32_t bhcount = 0;
-            for (auto h : this->hexen) { bhcount += h.test_flags(sm::HEX_IS_BOUNDARY) == true ? 1 : 0; }
+            for (const auto& h : this->hexen) { bhcount += h.test_flags(sm::HEX_IS_BOUNDARY) == true ? 1 : 0; }
             if (bhcount == 0) { return rtn; }
 
             // Find the furthest left and right hexes and the further up and down hexes.
             std::array<float, 4> limits = {{0,0,0,0}};
             bool first = true;
-            for (auto h : this->hexen) {
+            for (const auto& h : this->hexen) {
                 if (h.test_flags(sm::HEX_IS_BOUNDARY) == true) {
+                    const sm::vec<float, 2> p = this->hex_position (h);
                     if (first) {
-                        limits = {{h.x, h.x, h.y, h.y}};
+                        limits = {{p[0], p[0], p[1], p[1]}};
                         first = false;
                     }
-                    if (h.x < limits[0]) {
-                        limits[0] = h.x;
+                    if (p[0] < limits[0]) {
+                        limits[0] = p[0];
                         rtn[4] = h.gi;
                     }
-                    if (h.x > limits[1]) {
-                        limits[1] = h.x;
+                    if (p[0] > limits[1]) {
+                        limits[1] = p[0];
                         rtn[5] = h.gi;
                     }
-                    if (h.y < limits[2]) {
-                        limits[2] = h.y;
+                    if (p[1] < limits[2]) {
+                        limits[2] = p[1];
                     }
-                    if (h.y > limits[3]) {
-                        limits[3] = h.y;
+                    if (p[1] > limits[3]) {
+                        limits[3] = p[1];
                     }
                 }
             }
@@ -144,7 +144,12 @@ export namespace sm
         while (h != hg.hexen.end()) {
             // Make up a path
             std::string h5path = "/hexen/" + std::to_string(hcount);
-            sm::hex_save (*h, hgdata, h5path);
+            // After a lazy transform, the hex positions are up to date only in d_x and d_y
+            sm::hex hx = *h;
+            const sm::vec<float, 2> p = hg.hex_position (*h);
+            hx.x = p[0];
+            hx.y = p[1];
+            sm::hex_save (hx, hgdata, h5path);
             ++h;
             ++hcount;
         }
@@ -202,15 +207,16 @@ export namespace sm
         }
 
         // After creating hexen list, need to set neighbour relations in each hex, as loaded in d_ne,
-        // etc.
+        // etc. These hold d_ indices, which match hex::di (and match hex::vi unless the d_ vectors
+        // were reordered).
         for (sm::hex& _h : hg.hexen) {
             // For each hex, six loops through hexen:
             if (_h.has_ne() == true) {
                 bool matched = false;
-                uint32_t neighb_it = (uint32_t) hg.d_ne[_h.vi];
+                uint32_t neighb_it = (uint32_t) hg.d_ne[_h.di];
                 std::list<sm::hex>::iterator hi = hg.hexen.begin();
                 while (hi != hg.hexen.end()) {
-                    if (hi->vi == neighb_it) {
+                    if (hi->di == neighb_it) {
                         matched = true;
                         _h.ne = hi;
                         break;
@@ -224,10 +230,10 @@ export namespace sm
 
             if (_h.has_nne() == true) {
                 bool matched = false;
-                uint32_t neighb_it = (uint32_t) hg.d_nne[_h.vi];
+                uint32_t neighb_it = (uint32_t) hg.d_nne[_h.di];
                 std::list<sm::hex>::iterator hi = hg.hexen.begin();
                 while (hi != hg.hexen.end()) {
-                    if (hi->vi == neighb_it) {
+                    if (hi->di == neighb_it) {
                         matched = true;
                         _h.nne = hi;
                         break;
@@ -241,10 +247,10 @@ export namespace sm
 
             if (_h.has_nnw() == true) {
                 bool matched = false;
-                uint32_t neighb_it = (uint32_t) hg.d_nnw[_h.vi];
+                uint32_t neighb_it = (uint32_t) hg.d_nnw[_h.di];
                 std::list<sm::hex>::iterator hi = hg.hexen.begin();
                 while (hi != hg.hexen.end()) {
-                    if (hi->vi == neighb_it) {
+                    if (hi->di == neighb_it) {
                         matched = true;
                         _h.nnw = hi;
                         break;
@@ -258,10 +264,10 @@ export namespace sm
 
             if (_h.has_nw() == true) {
                 bool matched = false;
-                uint32_t neighb_it = (uint32_t) hg.d_nw[_h.vi];
+                uint32_t neighb_it = (uint32_t) hg.d_nw[_h.di];
                 std::list<sm::hex>::iterator hi = hg.hexen.begin();
                 while (hi != hg.hexen.end()) {
-                    if (hi->vi == neighb_it) {
+                    if (hi->di == neighb_it) {
                         matched = true;
                         _h.nw = hi;
                         break;
@@ -275,10 +281,10 @@ export namespace sm
 
             if (_h.has_nsw() == true) {
                 bool matched = false;
-                uint32_t neighb_it = (uint32_t) hg.d_nsw[_h.vi];
+                uint32_t neighb_it = (uint32_t) hg.d_nsw[_h.di];
                 std::list<sm::hex>::iterator hi = hg.hexen.begin();
                 while (hi != hg.hexen.end()) {
-                    if (hi->vi == neighb_it) {
+                    if (hi->di == neighb_it) {
                         matched = true;
                         _h.nsw = hi;
                         break;
@@ -292,10 +298,10 @@ export namespace sm
 
             if (_h.has_nse() == true) {
                 bool matched = false;
-                uint32_t neighb_it = (uint32_t) hg.d_nse[_h.vi];
+                uint32_t neighb_it = (uint32_t) hg.d_nse[_h.di];
                 std::list<sm::hex>::iterator hi = hg.hexen.begin();
                 while (hi != hg.hexen.end()) {
-                    if (hi->vi == neighb_it) {
+                    if (hi->di == neighb_it) {
                         matched = true;
                         _h.nse = hi;
                         break;
@@ -307,6 +313,16 @@ export namespace sm
                 }
             }
         }
+
+        // d_vi isn't saved; it's given by the hexes
+        hg.d_vi.assign (hg.d_x.size(), 0u);
+        for (const sm::hex& _h : hg.hexen) {
+            if (_h.di < hg.d_vi.size()) { hg.d_vi[_h.di] = _h.vi; }
+        }
+        // Split the loaded neighbour vectors for the operators; this also sets d_rowlen,
+        // d_numrows and d_size from the order of the loaded d_ vectors
+        hg.update_stencil();
+        hg.index_d_axial();
     }
 
 } // namespace
@@ -0,0 +1,390 @@
+// -*- C++ -*-
+/*!
+ * This file is part of sebsjames/maths, a library of maths code for modern C++
+ *
+ * See https://github.com/sebsjames/maths
+ *
+ * \file
+ *
+ * Domain decomposition of a hexgrid into tiles with halos, for stepping a simulation on
+ * many cores (or, through a user-supplied halo_transport, in many processes).
+ *
+ * \author Seb James
+ * \date 2026
+ */
+module;
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <array>
+#include <map>
+#include <deque>
+#include <utility>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+export module sm.hexgrid.tiles;
+
+export import sm.hexgrid;
+
+export namespace sm
+{
+    /*!
+     * One tile of a decomposed hexgrid. The tile has its own local index space: the hexes
+     * it owns have local indices 0 to num_owned() - 1, and the halo (ghost) hexes, which
+     * are the neighbours of owned hexes that belong to other tiles, follow on from
+     * num_owned(). Data for a tile is held in a vector of num_local() elements.
+     */
+    struct hextile
+    {
+        //! The index of this tile in hexgrid_tiles::tiles
+        std::uint32_t id = 0;
+        //! The hexgrid d_ index of each owned hex, by local index
+        std::vector<std::uint32_t> owned;
+        //! The hexgrid d_ index of each halo hex. Halo hex k has local index num_owned() + k.
+        std::vector<std::uint32_t> halo;
+        /*!
+         * Local neighbour indices of each owned hex, in the order E, NE, NW, W, SW, SE
+         * (matching hexgrid::d_ne, d_nne, d_nnw, d_nw, d_nsw, d_nse). -1 where there is
+         * no neighbour.
+         */
+        std::array<std::vector<std::int32_t>, 6> nb;
+        /*!
+         * Runs [first, second) of owned local indices whose hexes have all six neighbours,
+         * and the owned local indices of the other hexes, so that step functions can use a
+         * loop without neighbour checks for most hexes (as hexgrid::laplacian does).
+         */
+        std::vector<std::array<std::int32_t, 2>> interior_runs;
+        std::vector<std::int32_t> edge;
+
+        //! A list of local indices whose values are exchanged with another tile
+        struct exchange
+        {
+            //! The other tile
+            std::uint32_t peer = 0;
+            //! Local indices, in the order in which the values are sent
+            std::vector<std::uint32_t> local;
+        };
+        //! For each neighbouring tile, the owned hexes whose values it needs
+        std::vector<exchange> sends;
+        //! For each neighbouring tile, the halo hexes it fills. Each matches a send on the peer.
+        std::vector<exchange> recvs;
+
+        std::size_t num_owned() const { return this->owned.size(); }
+        std::size_t num_local() const { return this->owned.size() + this->halo.size(); }
+    };
+
+    /*!
+     * A decomposition of a hexgrid's domain into compact tiles of (nearly) equal size.
+     * The hexes are ordered along a Hilbert curve in their axial coordinates, and the
+     * curve is cut into n_tiles pieces, so each tile is a compact patch with a short
+     * boundary and thus a small halo.
+     *
+     * The hexgrid's d_ vectors must be populated. Indices are hexgrid d_ indices, and
+     * global data passed to scatter and gather is in d_ order.
+     */
+    class hexgrid_tiles
+    {
+    public:
+        hexgrid_tiles (const sm::hexgrid& hg, const std::uint32_t n_tiles)
+        {
+            const std::size_t n = hg.d_x.size();
+            if (n == 0u || hg.d_ne.size() != n) {
+                throw std::runtime_error ("hexgrid_tiles: the hexgrid d_ vectors are not populated.");
+            }
+            if (n_tiles == 0u || n_tiles > n) {
+                throw std::runtime_error ("hexgrid_tiles: n_tiles must be between 1 and the number of hexes.");
+            }
+
+            // Order the hexes along a Hilbert curve
+            const auto [rmin, rmax] = std::minmax_element (hg.d_ri.begin(), hg.d_ri.end());
+            const auto [gmin, gmax] = std::minmax_element (hg.d_gi.begin(), hg.d_gi.end());
+            const std::uint32_t extent = static_cast<std::uint32_t>(std::max (*rmax - *rmin, *gmax - *gmin)) + 1u;
+            std::uint32_t side = 1u;
+            while (side < extent) { side <<= 1; }
+            std::vector<std::uint64_t> key (n);
+            for (std::size_t i = 0; i < n; ++i) {
+                key[i] = sm::algo::hilbert_index (side, static_cast<std::uint32_t>(hg.d_ri[i] - *rmin),
+                                                  static_cast<std::uint32_t>(hg.d_gi[i] - *gmin));
+            }
+            std::vector<std::uint32_t> curve (n);
+            std::iota (curve.begin(), curve.end(), 0u);
+            std::stable_sort (curve.begin(), curve.end(),
+                              [&key](const std::uint32_t a, const std::uint32_t b) { return key[a] < key[b]; });
+
+            // Cut the curve into tiles
+            this->tile_of.resize (n);
+            this->local_of.resize (n);
+            this->tiles.resize (n_tiles);
+            for (std::uint32_t t = 0; t < n_tiles; ++t) {
+                hextile& tile = this->tiles[t];
+                tile.id = t;
+                const std::size_t c0 = (n * t) / n_tiles;
+                const std::size_t c1 = (n * (t + 1u)) / n_tiles;
+                for (std::size_t c = c0; c < c1; ++c) {
+                    this->tile_of[curve[c]] = t;
+                    this->local_of[curve[c]] = static_cast<std::uint32_t>(c - c0);
+                    tile.owned.push_back (curve[c]);
+                }
+            }
+
+            const std::array<const std::vector<std::int32_t>*, 6> gnb = { &hg.d_ne, &hg.d_nne, &hg.d_nnw, &hg.d_nw, &hg.d_nsw, &hg.d_nse };
+            for (hextile& tile : this->tiles) {
+                // The halo, grouped by peer tile and in d_ index order within each group
+                std::map<std::uint32_t, std::vector<std::uint32_t>> from_peer;
+                for (const std::uint32_t g : tile.owned) {
+                    for (const auto* nbv : gnb) {
+                        const std::int32_t gn = (*nbv)[g];
+                        if (gn >= 0 && this->tile_of[gn] != tile.id) { from_peer[this->tile_of[gn]].push_back (gn); }
+                    }
+                }
+                std::map<std::uint32_t, std::uint32_t> halo_local; // d_ index to local index
+                for (auto& [peer, gs] : from_peer) {
+                    std::sort (gs.begin(), gs.end());
+                    gs.erase (std::unique (gs.begin(), gs.end()), gs.end());
+                    hextile::exchange rx;
+                    rx.peer = peer;
+                    for (const std::uint32_t g : gs) {
+                        const std::uint32_t l = static_cast<std::uint32_t>(tile.num_owned() + tile.halo.size());
+                        halo_local[g] = l;
+                        tile.halo.push_back (g);
+                        rx.local.push_back (l);
+                    }
+                    tile.recvs.push_back (rx);
+                    // The peer sends the same hexes, in the same order
+                    hextile::exchange tx;
+                    tx.peer = tile.id;
+                    for (const std::uint32_t g : gs) { tx.local.push_back (this->local_of[g]); }
+                    this->tiles[peer].sends.push_back (tx);
+                }
+
+                // Local neighbour indices
+                for (std::size_t j = 0; j < 6; ++j) {
+                    tile.nb[j].resize (tile.num_owned());
+                    for (std::size_t l = 0; l < tile.num_owned(); ++l) {
+                        const std::int32_t gn = (*gnb[j])[tile.owned[l]];
+                        if (gn < 0) {
+                            tile.nb[j][l] = -1;
+                        } else if (this->tile_of[gn] == tile.id) {
+                            tile.nb[j][l] = static_cast<std::int32_t>(this->local_of[gn]);
+                        } else {
+                            tile.nb[j][l] = static_cast<std::int32_t>(halo_local[gn]);
+                        }
+                    }
+                }
+
+                // Interior runs and edge hexes
+                const std::int32_t no = static_cast<std::int32_t>(tile.num_owned());
+                std::int32_t run_start = -1;
+                for (std::int32_t l = 0; l <= no; ++l) {
+                    bool interior = l < no;
+                    for (std::size_t j = 0; interior && j < 6; ++j) { interior = tile.nb[j][l] >= 0; }
+                    if (l < no && !interior) { tile.edge.push_back (l); }
+                    if (interior && run_start < 0) { run_start = l; }
+                    if (!interior && run_start >= 0) {
+                        tile.interior_runs.push_back ({ run_start, l });
+                        run_start = -1;
+                    }
+                }
+            }
+            // Order the sends by peer, as the recvs are
+            for (hextile& tile : this->tiles) {
+                std::sort (tile.sends.begin(), tile.sends.end(),
+                           [](const hextile::exchange& a, const hextile::exchange& b) { return a.peer < b.peer; });
+            }
+        }
+
+        //! Copy global data (in d_ order) into per-tile vectors, filling both owned and halo hexes
+        template<typename T>
+        void scatter (const std::vector<T>& global, std::vector<std::vector<T>>& local) const
+        {
+            if (global.size() != this->tile_of.size()) {
+                throw std::runtime_error ("hexgrid_tiles::scatter: global data is not the size of the hexgrid.");
+            }
+            local.resize (this->tiles.size());
+            for (const hextile& tile : this->tiles) {
+                std::vector<T>& lt = local[tile.id];
+                lt.resize (tile.num_local());
+                for (std::size_t l = 0; l < tile.num_owned(); ++l) { lt[l] = global[tile.owned[l]]; }
+                for (std::size_t k = 0; k < tile.halo.size(); ++k) { lt[tile.num_owned() + k] = global[tile.halo[k]]; }
+            }
+        }
+
+        //! Copy the owned values of per-tile vectors into global data (in d_ order)
+        template<typename T>
+        void gather (const std::vector<std::vector<T>>& local, std::vector<T>& global) const
+        {
+            if (local.size() != this->tiles.size()) {
+                throw std::runtime_error ("hexgrid_tiles::gather: need one local vector per tile.");
+            }
+            global.resize (this->tile_of.size());
+            for (const hextile& tile : this->tiles) {
+                const std::vector<T>& lt = local[tile.id];
+                if (lt.size() < tile.num_owned()) {
+                    throw std::runtime_error ("hexgrid_tiles::gather: a local vector is smaller than its tile.");
+                }
+                for (std::size_t l = 0; l < tile.num_owned(); ++l) { global[tile.owned[l]] = lt[l]; }
+            }
+        }
+
+        //! The tiles
+        std::vector<hextile> tiles;
+        //! The tile that owns each hex, by d_ index
+        std::vector<std::uint32_t> tile_of;
+        //! The local index of each hex in its tile, by d_ index
+        std::vector<std::uint32_t> local_of;
+    };
+
+    /*!
+     * Moves halo values between tiles. tile_executor sends the values of each tile's
+     * sends lists and receives them into its recvs lists. To run tiles in several
+     * processes, derive from this class and map tile ids to processes (for example,
+     * wrapping MPI_Isend and MPI_Recv with the sending tile as the tag).
+     *
+     * Messages from one tile to another must be received in the order they were sent.
+     */
+    template <typename T>
+    class halo_transport
+    {
+    public:
+        virtual ~halo_transport() = default;
+        //! Send \a values from tile \a from to tile \a to. Must not wait for the matching receive.
+        virtual void send (const std::uint32_t from, const std::uint32_t to, const std::vector<T>& values) = 0;
+        //! Wait for the next message from tile \a from to tile \a to and place it in \a values
+        virtual void receive (const std::uint32_t from, const std::uint32_t to, std::vector<T>& values) = 0;
+    };
+
+    //! A halo_transport for tiles in one process, passing messages through mailboxes in memory
+    template <typename T>
+    class local_transport : public halo_transport<T>
+    {
+    public:
+        void send (const std::uint32_t from, const std::uint32_t to, const std::vector<T>& values) override
+        {
+            {
+                std::lock_guard<std::mutex> lk (this->m);
+                this->mailbox[{ from, to }].push_back (values);
+            }
+            this->cv.notify_all();
+        }
+
+        void receive (const std::uint32_t from, const std::uint32_t to, std::vector<T>& values) override
+        {
+            std::unique_lock<std::mutex> lk (this->m);
+            std::deque<std::vector<T>>& box = this->mailbox[{ from, to }];
+            this->cv.wait (lk, [&box]() { return !box.empty(); });
+            values.swap (box.front());
+            box.pop_front();
+        }
+
+    private:
+        std::mutex m;
+        std::condition_variable cv;
+        std::map<std::pair<std::uint32_t, std::uint32_t>, std::deque<std::vector<T>>> mailbox;
+    };
+
+    /*!
+     * Steps tiles of a hexgrid_tiles decomposition in parallel threads. Each thread owns a
+     * fixed set of tiles, so a tile's data stays in one core's cache and no two threads
+     * write to the same memory. In each step, every tile sends its halo values, receives
+     * its halo from its neighbours, then calls the user's step function. Neighbouring
+     * tiles need not be in step with each other beyond what their halo messages enforce,
+     * so there is no global barrier.
+     *
+     * An executor may step only some of the tiles (\a my_tiles), with the rest stepped
+     * elsewhere (in another executor, or another process) and reached through the
+     * transport.
+     */
+    template <typename T>
+    class tile_executor
+    {
+    public:
+        /*!
+         * \param dec The decomposition
+         * \param tr The transport used to exchange halos
+         * \param n_threads The number of threads. If 0, use one per hardware thread.
+         * \param my_tiles The tiles to step. If empty, step every tile.
+         */
+        tile_executor (const hexgrid_tiles& dec, halo_transport<T>& tr, std::uint32_t n_threads = 0,
+                       const std::vector<std::uint32_t>& my_tiles = {})
+            : decomp(dec), transport(tr)
+        {
+            if (my_tiles.empty()) {
+                this->mine.resize (dec.tiles.size());
+                std::iota (this->mine.begin(), this->mine.end(), 0u);
+            } else {
+                this->mine = my_tiles;
+            }
+            if (n_threads == 0u) { n_threads = std::max (1u, std::thread::hardware_concurrency()); }
+            this->n_threads = std::min (n_threads, static_cast<std::uint32_t>(this->mine.size()));
+        }
+
+        /*!
+         * Run \a n_steps steps. \a state holds one vector per tile (see
+         * hexgrid_tiles::scatter) and only the entries for this executor's tiles are used.
+         * Each step calls step (tile, current, next), which must compute the owned values
+         * of next (local indices 0 to tile.num_owned() - 1) from current, whose halo values
+         * have been filled. step must not throw. On return, the owned values in state are
+         * those after the last step; the halo values are out of date.
+         */
+        template <typename F>
+        void run (std::vector<std::vector<T>>& state, const std::uint32_t n_steps, F step)
+        {
+            if (state.size() != this->decomp.tiles.size()) {
+                throw std::runtime_error ("tile_executor::run: need one state vector per tile.");
+            }
+            for (const std::uint32_t t : this->mine) {
+                if (state[t].size() != this->decomp.tiles[t].num_local()) {
+                    throw std::runtime_error ("tile_executor::run: a state vector is not the size of its tile.");
+                }
+            }
+
+            auto worker = [this, &state, n_steps, &step](const std::uint32_t w)
+            {
+                std::vector<std::uint32_t> my;
+                for (std::size_t k = w; k < this->mine.size(); k += this->n_threads) { my.push_back (this->mine[k]); }
+                std::vector<std::vector<T>> next (my.size());
+                for (std::size_t k = 0; k < my.size(); ++k) { next[k].resize (state[my[k]].size()); }
+                std::vector<T> buf;
+                for (std::uint32_t s = 0; s < n_steps; ++s) {
+                    // Send all halos first so that no thread waits on a tile that is itself waiting
+                    for (const std::uint32_t t : my) {
+                        const hextile& tile = this->decomp.tiles[t];
+                        for (const hextile::exchange& tx : tile.sends) {
+                            buf.resize (tx.local.size());
+                            for (std::size_t i = 0; i < tx.local.size(); ++i) { buf[i] = state[t][tx.local[i]]; }
+                            this->transport.send (t, tx.peer, buf);
+                        }
+                    }
+                    for (std::size_t k = 0; k < my.size(); ++k) {
+                        const std::uint32_t t = my[k];
+                        const hextile& tile = this->decomp.tiles[t];
+                        for (const hextile::exchange& rx : tile.recvs) {
+                            this->transport.receive (rx.peer, t, buf);
+                            for (std::size_t i = 0; i < rx.local.size(); ++i) { state[t][rx.local[i]] = buf[i]; }
+                        }
+                        step (tile, static_cast<const std::vector<T>&>(state[t]), next[k]);
+                        // The halo values in next are stale, but are refilled before they are next read
+                        state[t].swap (next[k]);
+                    }
+                }
+            };
+
+            std::vector<std::thread> pool;
+            for (std::uint32_t w = 1; w < this->n_threads; ++w) { pool.emplace_back (worker, w); }
+            worker (0u);
+            for (auto& th : pool) { th.join(); }
+        }
+
+    private:
+        const hexgrid_tiles& decomp;
+        halo_transport<T>& transport;
+        std::vector<std::uint32_t> mine;
+        std::uint32_t n_threads = 1;
+    };
+}
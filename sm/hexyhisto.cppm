@@ -9,6 +9,9 @@
 module;
 
 #include <cstdint>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
 
 export module sm.hexyhisto;
 
@@ -18,39 +21,182 @@ import sm.hexgrid;
 
 export namespace sm
 {
+    /*!
+     * A 2D histogram of points on a hexgrid. Each point is counted in the hex that is
+     * nearest to it, as long as it is no further than hexgrid::get_v() from that hex's
+     * centre.
+     *
+     * A point's hex is found directly by rounding its axial coordinates, then comparing
+     * the distances to that hex and its six neighbours. This gives the same hex as a search
+     * of the whole grid: if two hexes are equally near, it is the one with the lower vi. If
+     * the grid has been transformed, so that its hexes are no longer at their lattice
+     * positions, every hex is searched instead. Batches of points are binned in parallel.
+     * Each thread adds into its own copy of the counts, and the copies are summed at the
+     * end.
+     */
     template <typename T=float>
     struct hexyhisto
     {
-        // Data is a vvec of coordinates. data[2] is ignored. hg is a hex grid, assumed to be in
-        // same coordinate frame as data.
-        hexyhisto (const sm::vvec<sm::vec<T>>& data, sm::hexgrid* hg)
+        //! An empty histogram on the hexgrid hg, whose d_ vectors must be populated. Add points with add().
+        hexyhisto (const sm::hexgrid* _hg) : hg(_hg)
         {
-            std::uint32_t n = hg->num();
+            if (this->hg->d_x.size() != this->hg->num()) {
+                throw std::runtime_error ("hexyhisto: the hexgrid's d_ vectors are not populated");
+            }
+            std::uint32_t n = this->hg->num();
             this->counts.resize (n, T{0});
             this->proportions.resize (n, T{0});
 
-            // For each coordinate, add it to a hex
-            for (const sm::vec<T, 3>& datum : data) {
-                if (datum[2] < T{0}) { continue; }
-                // if datum is in a hex hi, then counts[hi->vg] += T{1};
-                auto hi = hg->find_hex_nearest (datum.less_one_dim());
-
-                // dist from hi to datum:
-                sm::vec<T> hipos = { hi->x, hi->y, T{0} };
-                T _d = (hipos - datum.less_one_dim()).length();
-                if (_d <= hg->get_v()) {
-                    counts[hi->vi] += T{1};
-                    //std::cout << "crossing at " << datum << " has nearest hex: " << hi->output_xy() << " for which count = " << counts[hi->vi] << std::endl;
-                    this->datacount++;
+            // Are the hexes where their axial coordinates put them?
+            const float d = this->hg->get_d();
+            const float v = this->hg->get_v();
+            const float tol = 1e-3f * d;
+            for (std::uint32_t i = 0; i < n && this->on_lattice; ++i) {
+                if (std::abs (this->hg->d_x[i] - (d * this->hg->d_ri[i] + (d / 2.0f) * this->hg->d_gi[i])) > tol
+                    || std::abs (this->hg->d_y[i] - v * this->hg->d_gi[i]) > tol) {
+                    this->on_lattice = false;
                 }
             }
-            this->proportions = counts;
-            this->proportions /= this->datacount;
+        }
+
+        // Data is a vvec of coordinates. data[2] is a flag: points with data[2] < 0 are
+        // ignored. hg is a hex grid, assumed to be in same coordinate frame as data.
+        hexyhisto (const sm::vvec<sm::vec<T>>& data, const sm::hexgrid* _hg) : hexyhisto (_hg)
+        {
+            this->add (data);
             // Now just plot hexyhisto::proportions on your hexgrid. Simples.
         }
 
-        T datacount = T{0}; // how many elements were there in data?
+        //! Add a batch of points to the histogram, each counting 1
+        void add (const sm::vvec<sm::vec<T>>& batch)
+        {
+            this->accumulate (batch, static_cast<const sm::vvec<T>*>(nullptr));
+        }
+
+        //! Add a batch of points to the histogram, point i counting weights[i]
+        void add (const sm::vvec<sm::vec<T>>& batch, const sm::vvec<T>& weights)
+        {
+            if (weights.size() != batch.size()) {
+                throw std::runtime_error ("hexyhisto::add: there must be one weight per point");
+            }
+            this->accumulate (batch, &weights);
+        }
+
+        //! The vi of the hex in which the point pt would be counted, or -1 if it would not be counted
+        std::int32_t bin_of (const sm::vec<T, 2>& pt) const
+        {
+            const sm::vec<float, 2> pos = pt.as_float();
+            if (!std::isfinite (pos[0]) || !std::isfinite (pos[1])) { return -1; }
+            const std::int32_t di = this->on_lattice ? this->nearest_on_lattice (pos) : this->nearest_by_search (pos);
+            if (di < 0) { return -1; }
+            sm::vec<T, 2> hipos = { static_cast<T>(this->hg->d_x[di]), static_cast<T>(this->hg->d_y[di]) };
+            T _d = (hipos - pt).length();
+            return _d <= this->hg->get_v() ? static_cast<std::int32_t>(this->hg->d_vi[di]) : -1;
+        }
+
+        T datacount = T{0}; // how many elements were there in data? (the sum of their weights, if weighted)
         sm::vvec<T> counts;
         sm::vvec<T> proportions;
+
+    private:
+        const sm::hexgrid* hg = nullptr;
+        //! True if every hex is at the position given by its axial coordinates
+        bool on_lattice = true;
+
+        template <typename W>
+        void accumulate (const sm::vvec<sm::vec<T>>& batch, const W* weights)
+        {
+            const std::int64_t m = static_cast<std::int64_t>(batch.size());
+            const std::size_t n = this->counts.size();
+            T* c = this->counts.data();
+            T total = T{0};
+#pragma omp parallel for reduction(+:c[:n]) reduction(+:total)
+            for (std::int64_t k = 0; k < m; ++k) {
+                if (batch[k][2] < T{0}) { continue; }
+                const std::int32_t b = this->bin_of (batch[k].less_one_dim());
+                if (b < 0) { continue; }
+                const T w = weights == nullptr ? T{1} : (*weights)[k];
+                c[b] += w;
+                total += w;
+            }
+            this->datacount += total;
+            this->proportions = this->counts;
+            this->proportions /= this->datacount;
+        }
+
+        // The distance that hexgrid::find_hex_nearest uses
+        float dist (const sm::vec<float, 2>& pos, const std::int32_t di) const
+        {
+            float dx = pos[0] - this->hg->d_x[di];
+            float dy = pos[1] - this->hg->d_y[di];
+            return std::sqrt (dx*dx + dy*dy);
+        }
+
+        // Is hex a nearer than hex b (at distance db)? Ties go to the hex that comes first in hexen.
+        bool nearer (const float da, const std::int32_t a, const float db, const std::int32_t b) const
+        {
+            return b < 0 || da < db || (da == db && this->hg->d_vi[a] < this->hg->d_vi[b]);
+        }
+
+        /*!
+         * The d index of the nearest hex to pos, if it is within get_v(). The rounded hex
+         * contains pos and any hex within get_v() of pos is within d(sqrt(3)/2 + 1/sqrt(3))
+         * of the rounded hex, so it is the rounded hex or one of its six neighbours.
+         */
+        std::int32_t nearest_on_lattice (const sm::vec<float, 2>& pos) const
+        {
+            // Cube coordinate rounding, in which the component with the largest rounding
+            // error is recomputed from the other two.
+            const float gf = pos[1] / this->hg->get_v();
+            const float rf = pos[0] / this->hg->get_d() - 0.5f * gf;
+            // Far outside any grid (and beyond the range of the axial coordinates)
+            if (std::abs (rf) > 1e9f || std::abs (gf) > 1e9f) { return -1; }
+            const float sf = -rf - gf;
+            float rr = std::round (rf);
+            float gr = std::round (gf);
+            const float sr = std::round (sf);
+            const float dr = std::abs (rr - rf);
+            const float dg = std::abs (gr - gf);
+            const float ds = std::abs (sr - sf);
+            if (dr > dg && dr > ds) {
+                rr = -gr - sr;
+            } else if (dg > ds) {
+                gr = -rr - sr;
+            }
+            const std::int32_t r = static_cast<std::int32_t>(rr);
+            const std::int32_t g = static_cast<std::int32_t>(gr);
+
+            // The rounded hex, then its neighbours E, NE, NW, W, SW and SE
+            static constexpr std::int32_t step_r[7] = { 0, 1, 0, -1, -1, 0, 1 };
+            static constexpr std::int32_t step_g[7] = { 0, 0, 1, 1, 0, -1, -1 };
+            std::int32_t best = -1;
+            float best_dist = std::numeric_limits<float>::max();
+            for (std::uint32_t k = 0; k < 7u; ++k) {
+                const std::int32_t di = this->hg->d_index_at (r + step_r[k], g + step_g[k]);
+                if (di < 0) { continue; }
+                const float dl = this->dist (pos, di);
+                if (this->nearer (dl, di, best_dist, best)) {
+                    best = di;
+                    best_dist = dl;
+                }
+            }
+            return best;
+        }
+
+        //! The d index of the nearest hex to pos, found by comparing every hex
+        std::int32_t nearest_by_search (const sm::vec<float, 2>& pos) const
+        {
+            std::int32_t best = -1;
+            float best_dist = std::numeric_limits<float>::max();
+            const std::int32_t n = static_cast<std::int32_t>(this->hg->d_x.size());
+            for (std::int32_t di = 0; di < n; ++di) {
+                const float dl = this->dist (pos, di);
+                if (this->nearer (dl, di, best_dist, best)) {
+                    best = di;
+                    best_dist = dl;
+                }
+            }
+            return best;
+        }
     };
 }
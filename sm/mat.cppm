@@ -895,12 +895,13 @@ export namespace sm
          * Complex conjugate pairs naturally appear adjacent.
          */
         template<typename Fy=F> requires std::is_floating_point_v<Fy>
-        sm::vec<std::complex<F>, Nr> eigenvalues() const noexcept
+        constexpr sm::vec<std::complex<F>, Nr> eigenvalues() const noexcept
         {
             static_assert ((Nr == Nc) && (Nr >= 2u), "eigenvalues method is valid only for square matrices");
 
-            // Use Faddeev-LeVerrier algorithm to get characteristic polynomial
-            std::vector<F> coeffs(Nr + 1, F{0});
+            // Use Faddeev-LeVerrier algorithm to get characteristic polynomial. Fixed size arrays
+            // are used throughout so that this function does not allocate.
+            std::array<F, Nr + 1> coeffs = {};
             coeffs[Nr] = F{1};  // Leading coefficient
 
             sm::mat<F, Nr> M;
@@ -917,11 +918,9 @@ export namespace sm
                 }
             }
 
-            std::vector<std::complex<F>> roots_vvec = sm::polysolve::solve<F> (coeffs);
-
-            // Convert from std::vector to sm::vec for return type
+            // The leading coefficient is 1, so there are always Nr roots
             sm::vec<std::complex<F>, Nr> roots;
-            for (std::uint32_t k = 0u; k < Nr; ++k) { roots[k] = roots_vvec[k]; }
+            sm::polysolve::solve<F, Nr> (coeffs, roots);
 
             return roots;
         }
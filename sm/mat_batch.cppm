@@ -0,0 +1,388 @@
+// -*- C++ -*-
+/*!
+ * This file is part of sebsjames/maths, a library of maths code for modern C++
+ *
+ * See https://github.com/sebsjames/maths
+ *
+ * \file
+ *
+ * A batch of many small (2x2 or 3x3) matrices, with closed form determinant, inverse, linear solve
+ * and eigenvalue computations applied across the whole batch.
+ *
+ * The storage is interleaved: element k of every matrix in the batch is held contiguously, so
+ * that element k of matrix i is found at data[k * size() + i]. The element index k follows the
+ * column-major ordering of sm::mat. With this layout, the loops in the batched functions run
+ * across matrices, and each SIMD lane corresponds to a different matrix.
+ */
+module;
+
+#include <cstdint>
+#include <cmath>
+#include <array>
+#include <complex>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+export module sm.mat_batch;
+
+export import sm.vec;
+export import sm.vvec;
+export import sm.mat;
+import sm.mathconst;
+
+export namespace sm
+{
+    /*!
+     * A batch of N x N matrices with interleaved (structure of arrays) storage.
+     *
+     * \tparam F The floating point element type
+     * \tparam N The size of each (square) matrix. 2 or 3.
+     */
+    template <typename F, std::uint32_t N> requires std::is_floating_point_v<F> && (N == 2 || N == 3)
+    struct mat_batch
+    {
+        //! The number of elements in each matrix
+        static constexpr std::uint32_t N2 = N * N;
+
+        //! An empty batch
+        mat_batch() = default;
+
+        //! A batch of n identity matrices
+        explicit mat_batch (const std::size_t n) { this->resize (n); }
+
+        //! The matrix data. Element k of matrix i is at data[k * size() + i].
+        sm::vvec<F> data;
+
+        //! The number of matrices in the batch
+        std::size_t size() const noexcept { return this->n; }
+
+        //! Resize the batch to contain n matrices, all of which are set to the identity matrix
+        void resize (const std::size_t _n)
+        {
+            this->n = _n;
+            this->data.assign (N2 * _n, F{0});
+            for (std::uint32_t d = 0; d < N2; d += N + 1) {
+                F* lane = this->element (d);
+                for (std::size_t i = 0; i < _n; ++i) { lane[i] = F{1}; }
+            }
+        }
+
+        //! Pointer to the contiguous array holding element k (column-major index) of every matrix
+        F* element (const std::uint32_t k) noexcept { return this->data.data() + k * this->n; }
+        //! Const pointer to the contiguous array holding element k of every matrix
+        const F* element (const std::uint32_t k) const noexcept { return this->data.data() + k * this->n; }
+        //! Pointer to the contiguous array holding element (r, c) of every matrix
+        F* element (const std::uint32_t r, const std::uint32_t c) noexcept { return this->element (r + c * N); }
+        //! Const pointer to the contiguous array holding element (r, c) of every matrix
+        const F* element (const std::uint32_t r, const std::uint32_t c) const noexcept { return this->element (r + c * N); }
+
+        //! Return matrix i as an sm::mat
+        sm::mat<F, N> get (const std::size_t i) const noexcept
+        {
+            sm::mat<F, N> m;
+            for (std::uint32_t k = 0; k < N2; ++k) { m[k] = this->data[k * this->n + i]; }
+            return m;
+        }
+
+        //! Set matrix i from an sm::mat
+        void set (const std::size_t i, const sm::mat<F, N>& m) noexcept
+        {
+            for (std::uint32_t k = 0; k < N2; ++k) { this->data[k * this->n + i] = m[k]; }
+        }
+
+        //! Compute the determinant of each matrix into det (which is resized to match)
+        void determinant (sm::vvec<F>& det) const
+        {
+            det.resize (this->n);
+            F* d = det.data();
+            if constexpr (N == 2) {
+                const F* a = this->element (0);
+                const F* b = this->element (1);
+                const F* c = this->element (2);
+                const F* e = this->element (3);
+                for (std::size_t i = 0; i < this->n; ++i) { d[i] = a[i] * e[i] - c[i] * b[i]; }
+            } else {
+                // Column-major: m0 m3 m6 / m1 m4 m7 / m2 m5 m8
+                const F* m0 = this->element (0);
+                const F* m1 = this->element (1);
+                const F* m2 = this->element (2);
+                const F* m3 = this->element (3);
+                const F* m4 = this->element (4);
+                const F* m5 = this->element (5);
+                const F* m6 = this->element (6);
+                const F* m7 = this->element (7);
+                const F* m8 = this->element (8);
+                for (std::size_t i = 0; i < this->n; ++i) {
+                    d[i] = m0[i] * (m4[i] * m8[i] - m7[i] * m5[i])
+                    - m3[i] * (m1[i] * m8[i] - m7[i] * m2[i])
+                    + m6[i] * (m1[i] * m5[i] - m4[i] * m2[i]);
+                }
+            }
+        }
+
+        //! Return the determinants of all the matrices
+        sm::vvec<F> determinant() const
+        {
+            sm::vvec<F> det;
+            this->determinant (det);
+            return det;
+        }
+
+        /*!
+         * Compute the inverse of each matrix into inv (which is resized to match; it must not be
+         * *this). As for mat::inverse, a matrix with zero determinant has an inverse with all
+         * elements set to 0.
+         */
+        void inverse (mat_batch<F, N>& inv) const
+        {
+            if (&inv == this) { throw std::runtime_error ("mat_batch::inverse: output must not be the input batch"); }
+            inv.n = this->n;
+            inv.data.resize (this->data.size());
+            if constexpr (N == 2) {
+                const F* a = this->element (0);
+                const F* b = this->element (1);
+                const F* c = this->element (2);
+                const F* e = this->element (3);
+                F* o0 = inv.element (0);
+                F* o1 = inv.element (1);
+                F* o2 = inv.element (2);
+                F* o3 = inv.element (3);
+                for (std::size_t i = 0; i < this->n; ++i) {
+                    const F det = a[i] * e[i] - c[i] * b[i];
+                    const F id = det == F{0} ? F{0} : F{1} / det;
+                    o0[i] = e[i] * id;
+                    o1[i] = -b[i] * id;
+                    o2[i] = -c[i] * id;
+                    o3[i] = a[i] * id;
+                }
+            } else {
+                const F* m0 = this->element (0);
+                const F* m1 = this->element (1);
+                const F* m2 = this->element (2);
+                const F* m3 = this->element (3);
+                const F* m4 = this->element (4);
+                const F* m5 = this->element (5);
+                const F* m6 = this->element (6);
+                const F* m7 = this->element (7);
+                const F* m8 = this->element (8);
+                F* o0 = inv.element (0);
+                F* o1 = inv.element (1);
+                F* o2 = inv.element (2);
+                F* o3 = inv.element (3);
+                F* o4 = inv.element (4);
+                F* o5 = inv.element (5);
+                F* o6 = inv.element (6);
+                F* o7 = inv.element (7);
+                F* o8 = inv.element (8);
+                for (std::size_t i = 0; i < this->n; ++i) {
+                    // Cofactors, which make up the transposed adjugate
+                    const F c0 = m4[i] * m8[i] - m7[i] * m5[i];
+                    const F c1 = m7[i] * m2[i] - m1[i] * m8[i];
+                    const F c2 = m1[i] * m5[i] - m4[i] * m2[i];
+                    const F det = m0[i] * c0 + m3[i] * c1 + m6[i] * c2;
+                    const F id = det == F{0} ? F{0} : F{1} / det;
+                    o0[i] = c0 * id;
+                    o1[i] = c1 * id;
+                    o2[i] = c2 * id;
+                    o3[i] = (m6[i] * m5[i] - m3[i] * m8[i]) * id;
+                    o4[i] = (m0[i] * m8[i] - m6[i] * m2[i]) * id;
+                    o5[i] = (m3[i] * m2[i] - m0[i] * m5[i]) * id;
+                    o6[i] = (m3[i] * m7[i] - m6[i] * m4[i]) * id;
+                    o7[i] = (m6[i] * m1[i] - m0[i] * m7[i]) * id;
+                    o8[i] = (m0[i] * m4[i] - m3[i] * m1[i]) * id;
+                }
+            }
+        }
+
+        //! Return the inverses of all the matrices
+        mat_batch<F, N> inverse() const
+        {
+            mat_batch<F, N> inv;
+            this->inverse (inv);
+            return inv;
+        }
+
+        /*!
+         * Solve A_i x_i = b_i for every matrix A_i in the batch. The right hand side vectors are
+         * given as N component arrays, so that b[j][i] is component j of b_i. The solutions are
+         * written into x in the same form (x must not be b). If A_i is singular, x_i is set to 0.
+         */
+        void solve (const std::array<sm::vvec<F>, N>& b, std::array<sm::vvec<F>, N>& x) const
+        {
+            for (std::uint32_t j = 0; j < N; ++j) {
+                if (b[j].size() != this->n) { throw std::runtime_error ("mat_batch::solve: b must have one vector per matrix"); }
+                if (&b[j] == &x[j]) { throw std::runtime_error ("mat_batch::solve: x must not be b"); }
+                x[j].resize (this->n);
+            }
+            if constexpr (N == 2) {
+                const F* a = this->element (0);
+                const F* bb = this->element (1);
+                const F* c = this->element (2);
+                const F* e = this->element (3);
+                const F* b0 = b[0].data();
+                const F* b1 = b[1].data();
+                F* x0 = x[0].data();
+                F* x1 = x[1].data();
+                for (std::size_t i = 0; i < this->n; ++i) {
+                    const F det = a[i] * e[i] - c[i] * bb[i];
+                    const F id = det == F{0} ? F{0} : F{1} / det;
+                    x0[i] = (e[i] * b0[i] - c[i] * b1[i]) * id;
+                    x1[i] = (a[i] * b1[i] - bb[i] * b0[i]) * id;
+                }
+            } else {
+                const F* m0 = this->element (0);
+                const F* m1 = this->element (1);
+                const F* m2 = this->element (2);
+                const F* m3 = this->element (3);
+                const F* m4 = this->element (4);
+                const F* m5 = this->element (5);
+                const F* m6 = this->element (6);
+                const F* m7 = this->element (7);
+                const F* m8 = this->element (8);
+                const F* b0 = b[0].data();
+                const F* b1 = b[1].data();
+                const F* b2 = b[2].data();
+                F* x0 = x[0].data();
+                F* x1 = x[1].data();
+                F* x2 = x[2].data();
+                for (std::size_t i = 0; i < this->n; ++i) {
+                    const F c0 = m4[i] * m8[i] - m7[i] * m5[i];
+                    const F c1 = m7[i] * m2[i] - m1[i] * m8[i];
+                    const F c2 = m1[i] * m5[i] - m4[i] * m2[i];
+                    const F det = m0[i] * c0 + m3[i] * c1 + m6[i] * c2;
+                    const F id = det == F{0} ? F{0} : F{1} / det;
+                    // x = adj(A) b / det
+                    x0[i] = (c0 * b0[i] + (m6[i] * m5[i] - m3[i] * m8[i]) * b1[i] + (m3[i] * m7[i] - m6[i] * m4[i]) * b2[i]) * id;
+                    x1[i] = (c1 * b0[i] + (m0[i] * m8[i] - m6[i] * m2[i]) * b1[i] + (m6[i] * m1[i] - m0[i] * m7[i]) * b2[i]) * id;
+                    x2[i] = (c2 * b0[i] + (m3[i] * m2[i] - m0[i] * m5[i]) * b1[i] + (m0[i] * m4[i] - m3[i] * m1[i]) * b2[i]) * id;
+                }
+            }
+        }
+
+        //! Solve A_i x_i = b_i for every matrix, with vectors given (and returned) as a vvec of vecs
+        sm::vvec<sm::vec<F, N>> solve (const sm::vvec<sm::vec<F, N>>& b) const
+        {
+            if (b.size() != this->n) { throw std::runtime_error ("mat_batch::solve: b must have one vector per matrix"); }
+            std::array<sm::vvec<F>, N> bc;
+            std::array<sm::vvec<F>, N> xc;
+            for (std::uint32_t j = 0; j < N; ++j) {
+                bc[j].resize (this->n);
+                for (std::size_t i = 0; i < this->n; ++i) { bc[j][i] = b[i][j]; }
+            }
+            this->solve (bc, xc);
+            sm::vvec<sm::vec<F, N>> x (this->n);
+            for (std::size_t i = 0; i < this->n; ++i) {
+                for (std::uint32_t j = 0; j < N; ++j) { x[i][j] = xc[j][i]; }
+            }
+            return x;
+        }
+
+        /*!
+         * Compute the eigenvalues of each (real) matrix in closed form. Eigenvalue j of matrix i
+         * is written as the complex number (re[j][i], im[j][i]).
+         *
+         * The eigenvalues of each matrix are ordered as for mat::eigenvalues: lexicographically
+         * by (real, imag), so that real eigenvalues come first, in ascending order.
+         */
+        void eigenvalues (std::array<sm::vvec<F>, N>& re, std::array<sm::vvec<F>, N>& im) const
+        {
+            for (std::uint32_t j = 0; j < N; ++j) {
+                re[j].resize (this->n);
+                im[j].resize (this->n);
+            }
+            if constexpr (N == 2) {
+                const F* a = this->element (0);
+                const F* b = this->element (1);
+                const F* c = this->element (2);
+                const F* e = this->element (3);
+                F* r0 = re[0].data();
+                F* r1 = re[1].data();
+                F* i0 = im[0].data();
+                F* i1 = im[1].data();
+                for (std::size_t i = 0; i < this->n; ++i) {
+                    // lambda^2 - tr lambda + det = 0
+                    const F half_tr = (a[i] + e[i]) * F{0.5};
+                    const F det = a[i] * e[i] - c[i] * b[i];
+                    const F disc = half_tr * half_tr - det;
+                    const F sq = std::sqrt (std::abs (disc));
+                    const bool real_roots = disc >= F{0};
+                    r0[i] = real_roots ? half_tr - sq : half_tr;
+                    r1[i] = real_roots ? half_tr + sq : half_tr;
+                    i0[i] = real_roots ? F{0} : -sq;
+                    i1[i] = real_roots ? F{0} : sq;
+                }
+            } else {
+                const F* m0 = this->element (0);
+                const F* m1 = this->element (1);
+                const F* m2 = this->element (2);
+                const F* m3 = this->element (3);
+                const F* m4 = this->element (4);
+                const F* m5 = this->element (5);
+                const F* m6 = this->element (6);
+                const F* m7 = this->element (7);
+                const F* m8 = this->element (8);
+                constexpr F one_third = F{1} / F{3};
+                constexpr F eps = std::numeric_limits<F>::epsilon();
+                for (std::size_t i = 0; i < this->n; ++i) {
+                    // Characteristic polynomial lambda^3 + a2 lambda^2 + a1 lambda + a0 = 0
+                    const F a2 = -(m0[i] + m4[i] + m8[i]);
+                    const F a1 = (m0[i] * m4[i] - m3[i] * m1[i]) + (m0[i] * m8[i] - m6[i] * m2[i]) + (m4[i] * m8[i] - m7[i] * m5[i]);
+                    const F a0 = -(m0[i] * (m4[i] * m8[i] - m7[i] * m5[i])
+                                   - m3[i] * (m1[i] * m8[i] - m7[i] * m2[i])
+                                   + m6[i] * (m1[i] * m5[i] - m4[i] * m2[i]));
+                    // Cardano's method, as in polysolve::cubic
+                    const F q = (a2 * a2 - F{3} * a1) / F{9};
+                    const F r = (F{2} * a2 * a2 * a2 - F{9} * a2 * a1 + F{27} * a0) / F{54};
+                    const F q3 = q * q * q;
+                    const F r2 = r * r;
+                    const F a2_over_3 = a2 / F{3};
+                    std::array<std::complex<F>, 3> l;
+                    if (r2 < q3) { // three real roots
+                        const F theta = std::acos (r / std::sqrt (q3));
+                        const F m2rootq = F{-2} * std::sqrt (q);
+                        l[0] = { m2rootq * std::cos (theta / F{3}) - a2_over_3, F{0} };
+                        l[1] = { m2rootq * std::cos ((theta + sm::mathconst<F>::two_pi) / F{3}) - a2_over_3, F{0} };
+                        l[2] = { m2rootq * std::cos ((theta - sm::mathconst<F>::two_pi) / F{3}) - a2_over_3, F{0} };
+                    } else { // one real and two complex roots
+                        const F sa = -(r < F{0} ? F{-1} : F{1}) * std::pow (std::abs (r) + std::sqrt (r2 - q3), one_third);
+                        const F sb = sa == F{0} ? F{0} : q / sa;
+                        l[0] = { (sa + sb) - a2_over_3, F{0} };
+                        l[1] = { F{-0.5} * (sa + sb) - a2_over_3, sm::mathconst<F>::root_3_over_2 * (sa - sb) };
+                        l[2] = { F{-0.5} * (sa + sb) - a2_over_3, -sm::mathconst<F>::root_3_over_2 * (sa - sb) };
+                    }
+                    // Three element sort, with the comparison used in polysolve::sort_roots
+                    auto less = [eps](const std::complex<F>& u, const std::complex<F>& v) {
+                        if (std::abs (u.real() - v.real()) > eps) { return u.real() < v.real(); }
+                        return u.imag() < v.imag();
+                    };
+                    if (less (l[1], l[0])) { std::swap (l[0], l[1]); }
+                    if (less (l[2], l[1])) { std::swap (l[1], l[2]); }
+                    if (less (l[1], l[0])) { std::swap (l[0], l[1]); }
+                    for (std::uint32_t j = 0; j < 3; ++j) {
+                        re[j][i] = l[j].real();
+                        im[j][i] = l[j].imag();
+                    }
+                }
+            }
+        }
+
+        //! Return the eigenvalues of each matrix as a vvec of vecs of complex numbers
+        sm::vvec<sm::vec<std::complex<F>, N>> eigenvalues() const
+        {
+            std::array<sm::vvec<F>, N> re;
+            std::array<sm::vvec<F>, N> im;
+            this->eigenvalues (re, im);
+            sm::vvec<sm::vec<std::complex<F>, N>> ev (this->n);
+            for (std::size_t i = 0; i < this->n; ++i) {
+                for (std::uint32_t j = 0; j < N; ++j) { ev[i][j] = { re[j][i], im[j][i] }; }
+            }
+            return ev;
+        }
+
+    private:
+        //! The number of matrices
+        std::size_t n = 0;
+    };
+
+} // namespace sm
@@ -26,6 +26,11 @@
  * - Coefficient order when presented in an array is [a0, a1, ..., an] for a_n*x^n + ... + a_1*x + a_0 = 0
  * - Functions return complex roots (may be real with zero imaginary part)
  * - All solvers return roots in sorted order: lexicographic by (real, imag)
+ * - Batch quadratic/cubic/quartic solvers take structure of arrays coefficients and write roots
+ *   into preallocated outputs, looping across the batch of polynomials
+ * - The fixed degree solve_fixed<T, N>() and solve<T, N> (coeffs, roots) (with std::array
+ *   coefficients) and the overloads of the analytical solvers that write into std::array outputs
+ *   do not allocate, and are constexpr capable
  *
  * See polysolve_1.cpp in mathplot/maths/tests/ for a set of tests
  *
@@ -46,6 +51,7 @@ module;
 #include <type_traits>
 #include <array>
 #include <vector>
+#include <span>
 
 export module sm.polysolve;
 
@@ -87,6 +93,77 @@ export namespace sm::polysolve
         return result;
     }
 
+    namespace internal
+    {
+        // The lexicographic (real, imag) ordering used when sorting roots
+        template <typename T> requires std::is_floating_point_v<T>
+        constexpr bool root_less (const std::complex<T>& a, const std::complex<T>& b)
+        {
+            if (sm::cem::abs (a.real() - b.real()) > std::numeric_limits<T>::epsilon()) {
+                return a.real() < b.real();
+            }
+            return a.imag() < b.imag();
+        }
+
+        // constexpr capable magnitude of a complex number
+        template <typename T> requires std::is_floating_point_v<T>
+        constexpr T cabs (const std::complex<T>& z)
+        {
+            if (std::is_constant_evaluated()) {
+                return sm::cem::sqrt (z.real() * z.real() + z.imag() * z.imag());
+            } else {
+                return std::abs (z);
+            }
+        }
+
+        // constexpr capable principal square root of a complex number
+        template <typename T> requires std::is_floating_point_v<T>
+        constexpr std::complex<T> csqrt (const std::complex<T>& z)
+        {
+            if (std::is_constant_evaluated()) {
+                const T m = internal::cabs (z);
+                const T re = sm::cem::sqrt (std::max (T{0}, (m + z.real()) / T{2}));
+                const T im = sm::cem::sqrt (std::max (T{0}, (m - z.real()) / T{2}));
+                return { re, (z.imag() < T{0} ? -im : im) };
+            } else {
+                return std::sqrt (z);
+            }
+        }
+
+        /*
+         * The Durand-Kerner iteration, finding the degree roots of the polynomial with
+         * coefficients c[0] to c[degree]. Writes roots[0] to roots[degree - 1].
+         */
+        template <typename T> requires std::is_floating_point_v<T>
+        constexpr void durand_kerner (const T* c, const std::int32_t degree, std::complex<T>* roots)
+        {
+            // Initialize roots in a circle
+            const T radius = T{1} + sm::cem::abs (c[degree - 1]);
+            for (std::int32_t i = 0; i < degree; ++i) {
+                const T angle = sm::mathconst<T>::two_pi * T(i) / T(degree) + T{0.4};
+                roots[i] = radius * std::complex<T>{ sm::cem::cos (angle), sm::cem::sin (angle) };
+            }
+            // The iterative solver
+            for (std::int32_t iter = 0; iter < 100; ++iter) {
+                bool converged = true;
+                for (std::int32_t i = 0; i < degree; ++i) {
+                    // Horner's method for the numerator
+                    std::complex<T> numerator = { T{0}, T{0} };
+                    for (std::int32_t j = degree; j >= 0; --j) { numerator = numerator * roots[i] + c[j]; }
+                    std::complex<T> denominator = { T{1}, T{0} };
+                    for (std::int32_t j = 0; j < degree; ++j) {
+                        if (i != j) { denominator *= (roots[i] - roots[j]); }
+                    }
+                    if (internal::cabs (denominator) < std::numeric_limits<T>::epsilon()) { continue; }
+                    std::complex<T> delta = numerator / denominator;
+                    roots[i] -= delta;
+                    if (internal::cabs (delta) > std::numeric_limits<T>::epsilon()) { converged = false; }
+                }
+                if (converged) { break; }
+            }
+        }
+    }
+
     /*
      * Sort complex roots in standard order:
      * Lexicographic ordering by (real, imag) components.
@@ -96,12 +173,16 @@ export namespace sm::polysolve
     template <typename T> requires std::is_floating_point_v<T>
     constexpr void sort_roots (std::vector<std::complex<T>>& roots)
     {
-        std::sort (roots.begin(), roots.end(), [](const std::complex<T>& a, const std::complex<T>& b) {
-            if (sm::cem::abs (a.real() - b.real()) > std::numeric_limits<T>::epsilon()) {
-                return a.real() < b.real();
-            }
-            return a.imag() < b.imag();
-        });
+        std::sort (roots.begin(), roots.end(), internal::root_less<T>);
+    }
+
+    /*
+     * Sort the first n roots in a fixed size array into the standard order
+     */
+    template <typename T, std::size_t K> requires std::is_floating_point_v<T>
+    constexpr void sort_roots (std::array<std::complex<T>, K>& roots, const std::size_t n = K)
+    {
+        std::sort (roots.begin(), roots.begin() + n, internal::root_less<T>);
     }
 
     /*
@@ -132,10 +213,11 @@ export namespace sm::polysolve
     }
 
     /*
-     * Return the roots of the quadratic polynomial f = a2 x^2 + a1 x + a0
+     * Find the roots of the quadratic polynomial f = a2 x^2 + a1 x + a0, writing them, sorted,
+     * into roots. Does not allocate.
      */
     template <typename T, typename Ty=T> requires std::is_floating_point_v<T> && std::is_floating_point_v<Ty>
-    constexpr std::vector<std::complex<T>> quadratic (const Ty a2, const Ty a1, const Ty a0)
+    constexpr void quadratic (const Ty a2, const Ty a1, const Ty a0, std::array<std::complex<T>, 2>& roots)
     {
         // Normalize: divide by leading coefficient a2
         const T a1_norm = static_cast<T>(a1 / a2);
@@ -143,7 +225,6 @@ export namespace sm::polysolve
         // x^2 + a1_norm * x + a0_norm = 0
         // x = (-a1_norm +/- sqrt(a1_norm^2 - 4 * a0_norm)) / 2
         const T discriminant = a1_norm * a1_norm - T{4} * a0_norm;
-        std::vector<std::complex<T>> roots = {};
         if (discriminant >= T{0}) {
             const T sqrt_d = sm::cem::sqrt (discriminant);
             const T r1 = (-a1_norm + sqrt_d) / T{2};
@@ -155,14 +236,26 @@ export namespace sm::polysolve
             roots = { std::complex<T>{ real_part, -imag_part }, std::complex<T>{ real_part, imag_part } };
         }
         polysolve::sort_roots (roots);
-        return roots;
     }
 
     /*
-     * Return the roots of the complex quadratic polynomial f = a2 z^2 + a1 z + a0
+     * Return the roots of the quadratic polynomial f = a2 x^2 + a1 x + a0
      */
     template <typename T, typename Ty=T> requires std::is_floating_point_v<T> && std::is_floating_point_v<Ty>
-    std::vector<std::complex<T>> quadratic (const std::complex<Ty>& a2, const std::complex<Ty>& a1, const std::complex<Ty>& a0)
+    constexpr std::vector<std::complex<T>> quadratic (const Ty a2, const Ty a1, const Ty a0)
+    {
+        std::array<std::complex<T>, 2> roots = {};
+        polysolve::quadratic<T, Ty> (a2, a1, a0, roots);
+        return { roots[0], roots[1] };
+    }
+
+    /*
+     * Find the roots of the complex quadratic polynomial f = a2 z^2 + a1 z + a0, writing them,
+     * sorted, into roots. Does not allocate.
+     */
+    template <typename T, typename Ty=T> requires std::is_floating_point_v<T> && std::is_floating_point_v<Ty>
+    constexpr void quadratic (const std::complex<Ty>& a2, const std::complex<Ty>& a1, const std::complex<Ty>& a0,
+                              std::array<std::complex<T>, 2>& roots)
     {
         // Solve a2 z^2 + a1 z + a0 = 0 with complex coefficients
         // z = (-a1 +/- sqrt(a1^2 - 4 a2 a0)) / (2 a2)
@@ -170,22 +263,32 @@ export namespace sm::polysolve
         const std::complex<T> a1_conv = { static_cast<T>(a1.real()), static_cast<T>(a1.imag()) };
         const std::complex<T> a0_conv = { static_cast<T>(a0.real()), static_cast<T>(a0.imag()) };
         const std::complex<T> discriminant = a1_conv * a1_conv - T{4} * a2_conv * a0_conv;
-        const std::complex<T> sqrt_disc = std::sqrt (discriminant);
+        const std::complex<T> sqrt_disc = internal::csqrt (discriminant);
         const std::complex<T> denom = T{2} * a2_conv;
-        const std::complex<T> root1 = (-a1_conv + sqrt_disc) / denom;
-        const std::complex<T> root2 = (-a1_conv - sqrt_disc) / denom;
-        std::vector<std::complex<T>> roots = { root1, root2 };
+        roots[0] = (-a1_conv + sqrt_disc) / denom;
+        roots[1] = (-a1_conv - sqrt_disc) / denom;
         polysolve::sort_roots (roots);
-        return roots;
     }
 
     /*
-     * Return the roots of the cubic polynomial f = a3 x^3 + a2 x^2 + a1 x + a0
+     * Return the roots of the complex quadratic polynomial f = a2 z^2 + a1 z + a0
+     */
+    template <typename T, typename Ty=T> requires std::is_floating_point_v<T> && std::is_floating_point_v<Ty>
+    std::vector<std::complex<T>> quadratic (const std::complex<Ty>& a2, const std::complex<Ty>& a1, const std::complex<Ty>& a0)
+    {
+        std::array<std::complex<T>, 2> roots = {};
+        polysolve::quadratic<T, Ty> (a2, a1, a0, roots);
+        return { roots[0], roots[1] };
+    }
+
+    /*
+     * Find the roots of the cubic polynomial f = a3 x^3 + a2 x^2 + a1 x + a0, writing them,
+     * sorted, into roots. Does not allocate.
      *
      * Follows the Numerical Recipes in C, 2nd ed. description of Cardano's method (p 184)
      */
     template <typename T, typename Ty=T> requires std::is_floating_point_v<T> && std::is_floating_point_v<Ty>
-    std::vector<std::complex<T>> cubic (const Ty a3, const Ty a2, const Ty a1, const Ty a0)
+    constexpr void cubic (const Ty a3, const Ty a2, const Ty a1, const Ty a0, std::array<std::complex<T>, 3>& roots)
     {
         const T a2_norm = static_cast<T>(a2 / a3);
         const T a1_norm = static_cast<T>(a1 / a3);
@@ -195,30 +298,41 @@ export namespace sm::polysolve
         const T q3 = q * q * q;
         const T r2 = r * r;
         const T a2n_over_3 = a2_norm / T{3};
-        std::vector<std::complex<T>> roots = {};
         if (r2 < q3) { // three real roots
             const T theta = sm::cem::acos (r / sm::cem::sqrt (q3));
             const T m2rootq = -T{2} * sm::cem::sqrt (q);
-            roots.push_back (std::complex<T>{ m2rootq * sm::cem::cos (theta / T{3}) - a2n_over_3,                               T{0} });
-            roots.push_back (std::complex<T>{ m2rootq * sm::cem::cos ((theta + sm::mathconst<T>::two_pi) / T{3})  - a2n_over_3, T{0} });
-            roots.push_back (std::complex<T>{ m2rootq * sm::cem::cos ((theta - sm::mathconst<T>::two_pi) / T{3})  - a2n_over_3, T{0} });
+            roots[0] = std::complex<T>{ m2rootq * sm::cem::cos (theta / T{3}) - a2n_over_3,                               T{0} };
+            roots[1] = std::complex<T>{ m2rootq * sm::cem::cos ((theta + sm::mathconst<T>::two_pi) / T{3})  - a2n_over_3, T{0} };
+            roots[2] = std::complex<T>{ m2rootq * sm::cem::cos ((theta - sm::mathconst<T>::two_pi) / T{3})  - a2n_over_3, T{0} };
         } else { // one real and two complex roots
             constexpr T one_third = T{1} / T{3};
-            const T a = -sm::cem::sgn (r) * std::pow ((sm::cem::abs (r) + sm::cem::sqrt (r2 - q3)), one_third);
+            const T a = -sm::cem::sgn (r) * sm::cem::pow ((sm::cem::abs (r) + sm::cem::sqrt (r2 - q3)), one_third);
             const T b = (a == T{0} ? T{0} : (q / a));
-            roots.push_back (std::complex<T>{ (a + b) - a2n_over_3          ,  T{0}                                      });
-            roots.push_back (std::complex<T>{ T{-0.5} * (a + b) - a2n_over_3,  sm::mathconst<T>::root_3_over_2 * (a - b) });
-            roots.push_back (std::complex<T>{ T{-0.5} * (a + b) - a2n_over_3, -sm::mathconst<T>::root_3_over_2 * (a - b) });
+            roots[0] = std::complex<T>{ (a + b) - a2n_over_3          ,  T{0}                                      };
+            roots[1] = std::complex<T>{ T{-0.5} * (a + b) - a2n_over_3,  sm::mathconst<T>::root_3_over_2 * (a - b) };
+            roots[2] = std::complex<T>{ T{-0.5} * (a + b) - a2n_over_3, -sm::mathconst<T>::root_3_over_2 * (a - b) };
         }
         polysolve::sort_roots (roots);
-        return roots;
     }
 
     /*
-     * Return the roots of the quartic polynomial f = a4 x^4 + a3 x^3 + a2 x^2 + a1 x + a0
+     * Return the roots of the cubic polynomial f = a3 x^3 + a2 x^2 + a1 x + a0
      */
     template <typename T, typename Ty=T> requires std::is_floating_point_v<T> && std::is_floating_point_v<Ty>
-    std::vector<std::complex<T>> quartic (const Ty a4, const Ty a3, const Ty a2, const Ty a1, const Ty a0)
+    std::vector<std::complex<T>> cubic (const Ty a3, const Ty a2, const Ty a1, const Ty a0)
+    {
+        std::array<std::complex<T>, 3> roots = {};
+        polysolve::cubic<T, Ty> (a3, a2, a1, a0, roots);
+        return { roots[0], roots[1], roots[2] };
+    }
+
+    /*
+     * Find the roots of the quartic polynomial f = a4 x^4 + a3 x^3 + a2 x^2 + a1 x + a0, writing
+     * them into roots. Does not allocate. The roots are sorted unless sorted is false.
+     */
+    template <typename T, typename Ty=T> requires std::is_floating_point_v<T> && std::is_floating_point_v<Ty>
+    constexpr void quartic (const Ty a4, const Ty a3, const Ty a2, const Ty a1, const Ty a0, std::array<std::complex<T>, 4>& roots,
+                            const bool sorted = true)
     {
         // Normalize and solve x^4 + a3_norm * x^3 + a2_norm * x^2 + a1_norm * x + a0_norm = 0 using Ferrari's method
         const T a3_norm = static_cast<T>(a3 / a4);
@@ -229,47 +343,60 @@ export namespace sm::polysolve
         const T p = a2_norm - T{3} * a3_norm * a3_norm / T{8};
         const T q = a3_norm * a3_norm * a3_norm / T{8} - a3_norm * a2_norm / T{2} + a1_norm;
         const T r = -T{3} * a3_norm * a3_norm * a3_norm * a3_norm / T{256} + a3_norm * a3_norm * a2_norm / T{16} - a3_norm * a1_norm / T{4} + a0_norm;
-        std::vector<std::complex<T>> roots = {};
         if (sm::cem::abs (q) < std::numeric_limits<T>::epsilon()) {
             // Biquadratic case: y^4 + p * y^2 + r = 0
             // Solve as quadratic in y^2
-            std::vector<std::complex<T>> quad_roots = polysolve::quadratic<T> (T{1}, p, r);
-            for (const auto& root : quad_roots) {
-                const std::complex<T> sqrt_root = std::sqrt (root);
-                roots.push_back (sqrt_root);
-                roots.push_back (-sqrt_root);
+            std::array<std::complex<T>, 2> quad_roots = {};
+            polysolve::quadratic<T> (T{1}, p, r, quad_roots);
+            for (std::uint32_t i = 0; i < 2; ++i) {
+                const std::complex<T> sqrt_root = internal::csqrt (quad_roots[i]);
+                roots[2 * i] = sqrt_root;
+                roots[2 * i + 1] = -sqrt_root;
             }
         } else {
             // Resolve using cubic resolvent: z^3 + 2 * p * z^2 + (p^2 - 4 * r) * z - q^2 = 0
-            std::vector<std::complex<T>> cubic_roots = polysolve::cubic<T> (T{1}, T{2} * p, p * p - T{4} * r, -q * q);
+            std::array<std::complex<T>, 3> cubic_roots = {};
+            polysolve::cubic<T> (T{1}, T{2} * p, p * p - T{4} * r, -q * q, cubic_roots);
             // Pick the real root (or root with smallest imaginary part)
             std::complex<T> m = cubic_roots[0];
             for (const auto& root : cubic_roots) {
-                if (std::abs (root.imag()) < std::abs (m.imag())) { m = root; }
+                if (sm::cem::abs (root.imag()) < sm::cem::abs (m.imag())) { m = root; }
             }
             // Ferrari's factorization: y^4 + p * y^2 + q * y + r = (y^2 + s * y + t)(y^2 - s * y + u)
             // Where: s^2 = m, t + u = p + m, t * u = r
-            const std::complex<T> s = std::sqrt(m);
+            const std::complex<T> s = internal::csqrt (m);
             // Find t and u as roots of: z^2 - (p + m) * z + r = 0
             const std::complex<T> sum_tu = p + m;
             const std::complex<T> prod_tu = { r, T{0} };
-            std::vector<std::complex<T>> tu_roots = polysolve::quadratic<T> (std::complex<T>{ T{1}, T{0} }, -sum_tu, prod_tu);
+            std::array<std::complex<T>, 2> tu_roots = {};
+            polysolve::quadratic<T> (std::complex<T>{ T{1}, T{0} }, -sum_tu, prod_tu, tu_roots);
             // Verify and swap if needed to ensure s(u-t) = q (t = tu_roots[0], u = tu_roots[1])
             const std::complex<T> q_check = s * (tu_roots[1] - tu_roots[0]);
-            if (std::abs (q_check - std::complex<T>{ q, T{0} }) > std::abs (s * (tu_roots[0] - tu_roots[1]) - std::complex<T>{ q, T{0} })) {
+            if (internal::cabs (q_check - std::complex<T>{ q, T{0} }) > internal::cabs (s * (tu_roots[0] - tu_roots[1]) - std::complex<T>{ q, T{0} })) {
                 std::swap (tu_roots[0], tu_roots[1]);
             }
             // Solve two quadratics: y^2 + s * y + t = 0 and y^2 - s * y + u = 0
-            std::vector<std::complex<T>> quad1 = polysolve::quadratic<T> (std::complex<T>{ T{1}, T{0} }, s, tu_roots[0]);
-            std::vector<std::complex<T>> quad2 = polysolve::quadratic<T> (std::complex<T>{ T{1}, T{0} }, -s, tu_roots[1]);
-            roots.insert (roots.end(), quad1.begin(), quad1.end());
-            roots.insert (roots.end(), quad2.begin(), quad2.end());
+            std::array<std::complex<T>, 2> quad1 = {};
+            std::array<std::complex<T>, 2> quad2 = {};
+            polysolve::quadratic<T> (std::complex<T>{ T{1}, T{0} }, s, tu_roots[0], quad1);
+            polysolve::quadratic<T> (std::complex<T>{ T{1}, T{0} }, -s, tu_roots[1], quad2);
+            roots = { quad1[0], quad1[1], quad2[0], quad2[1] };
         }
         // Transform back: x = y - a3_norm/4
         const T offset = -a3_norm / T{4};
         for (auto& root : roots) { root += offset; }
-        polysolve::sort_roots (roots);
-        return roots;
+        if (sorted) { polysolve::sort_roots (roots); }
+    }
+
+    /*
+     * Return the roots of the quartic polynomial f = a4 x^4 + a3 x^3 + a2 x^2 + a1 x + a0
+     */
+    template <typename T, typename Ty=T> requires std::is_floating_point_v<T> && std::is_floating_point_v<Ty>
+    std::vector<std::complex<T>> quartic (const Ty a4, const Ty a3, const Ty a2, const Ty a1, const Ty a0)
+    {
+        std::array<std::complex<T>, 4> roots = {};
+        polysolve::quartic<T, Ty> (a4, a3, a2, a1, a0, roots);
+        return { roots[0], roots[1], roots[2], roots[3] };
     }
 
     /*
@@ -290,72 +417,115 @@ export namespace sm::polysolve
         } else {
             c = coeffs.template as<T>(); // FIXME
         }
-        // Initialize roots in a circle
         std::vector<std::complex<T>> roots (degree);
-        const T radius = T{1} + sm::cem::abs (c[degree - 1]);
-
-        for (std::int32_t i = 0; i < degree; ++i) {
-            const T angle = sm::mathconst<T>::two_pi * T(i) / T(degree) + T{0.4};
-            roots[i] = radius * std::complex<T>{ sm::cem::cos (angle), sm::cem::sin (angle) };
-        }
-        // The iterative solver
-        for (std::int32_t iter = 0; iter < 100; ++iter) {
-            bool converged = true;
-            for (std::int32_t i = 0; i < degree; ++i) {
-                std::complex<T> numerator = polysolve::evaluate<T> (c, roots[i]);
-                std::complex<T> denominator = { T{1}, T{0} };
-                for (std::int32_t j = 0; j < degree; ++j) {
-                    if (i != j) { denominator *= (roots[i] - roots[j]); }
-                }
-                if (std::abs (denominator) < std::numeric_limits<T>::epsilon()) { continue; }
-                std::complex<T> delta = numerator / denominator;
-                roots[i] -= delta;
-                if (std::abs (delta) > std::numeric_limits<T>::epsilon()) { converged = false; }
-            }
-            if (converged) { break; }
-        }
+        internal::durand_kerner (c.data(), degree, roots.data());
         polysolve::sort_roots (roots);
         return roots;
     }
 
     /*
-     * Solve polynomial: a[n]*x^n + a[n-1]*x^(n-1) + ... + a[1]*x + a[0] = 0
+     * Durand-Kerner solver working on fixed size arrays. Finds the roots of the polynomial of the
+     * given degree (<= N) with coefficients c[0] to c[degree], writing them, sorted, into the
+     * first degree elements of roots. Does not allocate.
+     */
+    template <typename T, std::uint32_t N> requires std::is_floating_point_v<T>
+    constexpr void high_order (const std::array<T, N + 1>& c, const std::uint32_t degree, std::array<std::complex<T>, N>& roots)
+    {
+        internal::durand_kerner (c.data(), static_cast<std::int32_t>(degree), roots.data());
+        polysolve::sort_roots (roots, degree);
+    }
+
+    /*
+     * Solve polynomial: a[n]*x^n + a[n-1]*x^(n-1) + ... + a[1]*x + a[0] = 0 without allocating
+     * memory. Can be used in constexpr functions.
+     *
      * \tparam Ty Type of input coefficients
-     * \tparam N Size of coefficient array (degree + 1)
+     * \tparam N Degree of the polynomial (the coefficient array has N + 1 elements)
      * \tparam T Type of output roots, and type used in solvers (defaults to input type Ty if not specified)
      * \param coeffs Coefficients from lowest to highest degree [a0, a1, ..., an]
-     * \return Vector of complex roots sorted lexicographically by (real, imag).
-     *         Real roots appear first in ascending order, followed by complex roots.
+     * \param roots Output for the roots, sorted lexicographically by (real, imag). If the
+     *        polynomial has trailing (near) zero coefficients, it has fewer than N roots, and the
+     *        unused elements of roots are set to NaN.
+     * \return The number of roots written into roots (the degree of the polynomial)
      */
     template <typename T, std::uint32_t N, typename Ty = T> requires (N >= 1) && std::is_floating_point_v<T> && std::is_floating_point_v<Ty>
-    std::vector<std::complex<T>> solve (const std::array<Ty, N + 1>& coeffs)
+    constexpr std::uint32_t solve (const std::array<Ty, N + 1>& coeffs, std::array<std::complex<T>, N>& roots)
     {
         // Make a copy of coefficients in type T
-        std::vector<T> c (N + 1, T{0});
+        std::array<T, N + 1> c = {};
         for (std::uint32_t i = 0u; i < N + 1; ++i) { c[i] = static_cast<T>(coeffs[i]); }
-        polysolve::remove_trailing_zeros (c);
 
-        if (c.empty() || (c.size() == 1 && sm::cem::abs (c[0]) < std::numeric_limits<T>::epsilon())) {
-            throw std::invalid_argument("All coefficients are zero");
-        }
-
-        const std::int32_t degree = c.size() - 1;
+        // Find the degree, ignoring trailing zero and near-zero coefficients
+        std::int32_t degree = N;
+        while (degree >= 0 && sm::cem::abs (c[degree]) < std::numeric_limits<T>::epsilon()) { --degree; }
+        if (degree < 0) { throw std::invalid_argument("All coefficients are zero"); }
 
-        // Handle constant polynomial which has no roots
-        if (degree == 0) { return {}; }
+        constexpr T nan = std::numeric_limits<T>::quiet_NaN();
+        roots.fill (std::complex<T>{ nan, nan });
 
         // Use analytical solutions for degrees 1-4, numerical method for higher orders
         if (degree == 1) {
-            return polysolve::linear<T> (c[1], c[0]);
+            roots[0] = std::complex<T>{ -(c[0] / c[1]), T{0} };
         } else if (degree == 2) {
-            return polysolve::quadratic<T> (c[2], c[1], c[0]);
+            if constexpr (N >= 2) {
+                std::array<std::complex<T>, 2> r = {};
+                polysolve::quadratic<T> (c[2], c[1], c[0], r);
+                std::copy (r.begin(), r.end(), roots.begin());
+            }
         } else if (degree == 3) {
-            return polysolve::cubic<T> (c[3], c[2], c[1], c[0]);
+            if constexpr (N >= 3) {
+                std::array<std::complex<T>, 3> r = {};
+                polysolve::cubic<T> (c[3], c[2], c[1], c[0], r);
+                std::copy (r.begin(), r.end(), roots.begin());
+            }
         } else if (degree == 4) {
-            return polysolve::quartic<T> (c[4], c[3], c[2], c[1], c[0]);
-        } else {
-            return polysolve::high_order<T> (c);
+            if constexpr (N >= 4) {
+                std::array<std::complex<T>, 4> r = {};
+                polysolve::quartic<T> (c[4], c[3], c[2], c[1], c[0], r);
+                std::copy (r.begin(), r.end(), roots.begin());
+            }
+        } else if (degree > 4) {
+            if constexpr (N > 4) { polysolve::high_order<T, N> (c, degree, roots); }
         }
+        // A constant polynomial (degree 0) has no roots
+        return static_cast<std::uint32_t>(degree);
+    }
+
+    /*
+     * Solve polynomial: a[n]*x^n + a[n-1]*x^(n-1) + ... + a[1]*x + a[0] = 0, returning the roots
+     * in a std::array without allocating memory. Can be used in constexpr functions.
+     * \tparam Ty Type of input coefficients
+     * \tparam N Degree of the polynomial (the coefficient array has N + 1 elements)
+     * \tparam T Type of output roots, and type used in solvers (defaults to input type Ty if not specified)
+     * \param coeffs Coefficients from lowest to highest degree [a0, a1, ..., an]
+     * \return Array of complex roots sorted lexicographically by (real, imag).
+     *         Real roots appear first in ascending order, followed by complex roots. If the
+     *         polynomial has fewer than N roots, the remaining elements are NaN.
+     */
+    template <typename T, std::uint32_t N, typename Ty = T> requires (N >= 1) && std::is_floating_point_v<T> && std::is_floating_point_v<Ty>
+    constexpr std::array<std::complex<T>, N> solve_fixed (const std::array<Ty, N + 1>& coeffs)
+    {
+        std::array<std::complex<T>, N> roots = {};
+        polysolve::solve<T, N, Ty> (coeffs, roots);
+        return roots;
+    }
+
+    /*
+     * Solve polynomial: a[n]*x^n + a[n-1]*x^(n-1) + ... + a[1]*x + a[0] = 0
+     * \tparam Ty Type of input coefficients
+     * \tparam N Degree of the polynomial (the coefficient array has N + 1 elements)
+     * \tparam T Type of output roots, and type used in solvers (defaults to input type Ty if not specified)
+     * \param coeffs Coefficients from lowest to highest degree [a0, a1, ..., an]
+     * \return Vector of complex roots sorted lexicographically by (real, imag).
+     *         Real roots appear first in ascending order, followed by complex roots. It holds
+     *         one root per degree of the polynomial once trailing zero coefficients are removed.
+     */
+    template <typename T, std::uint32_t N, typename Ty = T> requires (N >= 1) && std::is_floating_point_v<T> && std::is_floating_point_v<Ty>
+    std::vector<std::complex<T>> solve (const std::array<Ty, N + 1>& coeffs)
+    {
+        std::array<std::complex<T>, N> roots = {};
+        const std::uint32_t n_roots = polysolve::solve<T, N, Ty> (coeffs, roots);
+        return std::vector<std::complex<T>> (roots.begin(), roots.begin() + n_roots);
     }
 
     /*
@@ -434,13 +604,269 @@ export namespace sm::polysolve
     template <typename T, std::uint32_t N, typename Ty = T> requires std::is_floating_point_v<T> && std::is_floating_point_v<Ty>
     constexpr std::vector<T> real (const std::array<Ty, N + 1>& coeffs, const T tolerance = T{100} * std::numeric_limits<T>::epsilon())
     {
-        std::vector<std::complex<T>> complex_roots = polysolve::solve<T, N, Ty> (coeffs);
+        std::array<std::complex<T>, N> complex_roots = {};
+        const std::uint32_t n_roots = polysolve::solve<T, N, Ty> (coeffs, complex_roots);
         std::vector<T> real_roots = {};
-        for (const std::complex<T>& root : complex_roots) {
-            if (sm::cem::abs (root.imag()) < tolerance) { real_roots.push_back (root.real()); }
+        for (std::uint32_t i = 0; i < n_roots; ++i) {
+            if (sm::cem::abs (complex_roots[i].imag()) < tolerance) { real_roots.push_back (complex_roots[i].real()); }
         }
         std::sort (real_roots.begin(), real_roots.end());
         return real_roots;
     }
 
+    /*
+     * Batch solvers
+     *
+     * These solve many polynomials of the same degree at once. The coefficients are given in
+     * structure of arrays form (so that a2[i], a1[i] and a0[i] are the coefficients of
+     * polynomial i) and the roots are written into preallocated outputs, again in structure of
+     * arrays form: root j of polynomial i is written to (re[j][i], im[j][i]). Every output span
+     * must have at least as many elements as there are polynomials. No memory is allocated.
+     *
+     * If sorted is true, the roots of each polynomial are ordered as for sort_roots. Callers that
+     * don't need ordered roots can pass false, and the roots are left in the order in which the
+     * solver computes them.
+     */
+    namespace internal
+    {
+        // Check that the sizes of the coefficient and root spans passed to a batch solver agree
+        template <typename T, std::size_t Nc, std::size_t Nr>
+        void check_batch_sizes (const std::array<std::span<const T>, Nc>& coeffs, const std::array<std::span<T>, Nr>& roots)
+        {
+            const std::size_t n = coeffs[0].size();
+            for (const auto& c : coeffs) {
+                if (c.size() != n) { throw std::invalid_argument ("Coefficient arrays differ in size"); }
+            }
+            for (const auto& r : roots) {
+                if (r.size() < n) { throw std::invalid_argument ("Root output arrays are too small"); }
+            }
+        }
+
+        // Roots of one quadratic, with the ordering of sort_roots obtained without a sort
+        template <typename T>
+        constexpr void quadratic_lane (const T a2, const T a1, const T a0,
+                                       std::array<T, 2>& re, std::array<T, 2>& im, const bool sorted)
+        {
+            const T a1_norm = a1 / a2;
+            const T a0_norm = a0 / a2;
+            const T discriminant = a1_norm * a1_norm - T{4} * a0_norm;
+            const T sqrt_d = sm::cem::sqrt (sm::cem::abs (discriminant));
+            const bool real_roots = discriminant >= T{0};
+            // Real roots: (-a1_norm +/- sqrt_d) / 2. Complex roots: -a1_norm / 2 +/- i sqrt_d / 2
+            const T lo = real_roots ? (-a1_norm - sqrt_d) / T{2} : -a1_norm / T{2};
+            const T hi = real_roots ? (-a1_norm + sqrt_d) / T{2} : -a1_norm / T{2};
+            const T ipart = real_roots ? T{0} : sqrt_d / T{2};
+            // Unsorted order is that of polysolve::quadratic before its sort
+            const bool swap = !sorted && real_roots;
+            re[0] = swap ? hi : lo;
+            re[1] = swap ? lo : hi;
+            im[0] = -ipart;
+            im[1] = ipart;
+        }
+
+        // Roots of one cubic (Cardano's method, as in polysolve::cubic), ordered without a sort
+        template <typename T>
+        constexpr void cubic_lane (const T a3, const T a2, const T a1, const T a0,
+                                   std::array<T, 3>& re, std::array<T, 3>& im, const bool sorted)
+        {
+            const T a2_norm = a2 / a3;
+            const T a1_norm = a1 / a3;
+            const T a0_norm = a0 / a3;
+            const T q = ((a2_norm * a2_norm) - (T{3} * a1_norm)) / T{9};
+            const T r = ((T{2} * a2_norm * a2_norm * a2_norm) - (T{9} * a2_norm * a1_norm) + (T{27} * a0_norm)) / T{54};
+            const T q3 = q * q * q;
+            const T r2 = r * r;
+            const T a2n_over_3 = a2_norm / T{3};
+            if (r2 < q3) {
+                // Three real roots. With theta in [0, pi], the first of these is the smallest and
+                // the second the largest.
+                const T theta = sm::cem::acos (r / sm::cem::sqrt (q3));
+                const T m2rootq = -T{2} * sm::cem::sqrt (q);
+                const T t0 = m2rootq * sm::cem::cos (theta / T{3}) - a2n_over_3;
+                const T t1 = m2rootq * sm::cem::cos ((theta + sm::mathconst<T>::two_pi) / T{3}) - a2n_over_3;
+                const T t2 = m2rootq * sm::cem::cos ((theta - sm::mathconst<T>::two_pi) / T{3}) - a2n_over_3;
+                re = { t0, (sorted ? t2 : t1), (sorted ? t1 : t2) };
+                im = { T{0}, T{0}, T{0} };
+            } else {
+                // One real root, rr, and a complex conjugate pair, p +/- i qi
+                constexpr T one_third = T{1} / T{3};
+                const T a = -sm::cem::sgn (r) * sm::cem::pow ((sm::cem::abs (r) + sm::cem::sqrt (r2 - q3)), one_third);
+                const T b = (a == T{0} ? T{0} : (q / a));
+                const T rr = (a + b) - a2n_over_3;
+                const T p = T{-0.5} * (a + b) - a2n_over_3;
+                const T qi = sm::mathconst<T>::root_3_over_2 * (a - b);
+                if (!sorted) {
+                    re = { rr, p, p };
+                    im = { T{0}, qi, -qi };
+                } else {
+                    // Place rr before, between or after the pair, as sort_roots would
+                    constexpr T eps = std::numeric_limits<T>::epsilon();
+                    const T qa = sm::cem::abs (qi);
+                    const bool r_first = rr < p - eps;
+                    const bool r_last = rr > p + eps;
+                    re = { (r_first ? rr : p), (r_first || r_last ? p : rr), (r_last ? rr : p) };
+                    im = { (r_first ? T{0} : -qa), (r_first ? -qa : (r_last ? qa : T{0})), (r_last ? T{0} : qa) };
+                }
+            }
+        }
+
+        /*
+         * Copy those roots that are real (within tolerance) to the front of out, in order, and
+         * fill the remainder of out with NaN.
+         */
+        template <typename T, std::size_t K>
+        constexpr void real_lane (const std::array<T, K>& re, const std::array<T, K>& im, std::array<T, K>& out)
+        {
+            constexpr T tolerance = T{100} * std::numeric_limits<T>::epsilon();
+            out.fill (std::numeric_limits<T>::quiet_NaN());
+            std::size_t j = 0;
+            for (std::size_t k = 0; k < K; ++k) {
+                if (sm::cem::abs (im[k]) < tolerance) { out[j++] = re[k]; }
+            }
+        }
+    }
+
+    /*
+     * Batch quadratic solver. Finds the roots of a2[i] x^2 + a1[i] x + a0[i] = 0 for all i,
+     * writing root j of polynomial i to (re[j][i], im[j][i]).
+     */
+    template <typename T> requires std::is_floating_point_v<T>
+    void quadratic (const std::span<const T> a2, const std::span<const T> a1, const std::span<const T> a0,
+                    const std::array<std::span<T>, 2>& re, const std::array<std::span<T>, 2>& im, const bool sorted = true)
+    {
+        internal::check_batch_sizes<T, 3, 2> ({ a2, a1, a0 }, re);
+        internal::check_batch_sizes<T, 3, 2> ({ a2, a1, a0 }, im);
+        const std::size_t n = a0.size();
+        const T* c2 = a2.data();
+        const T* c1 = a1.data();
+        const T* c0 = a0.data();
+        T* re0 = re[0].data();
+        T* re1 = re[1].data();
+        T* im0 = im[0].data();
+        T* im1 = im[1].data();
+        for (std::size_t i = 0; i < n; ++i) {
+            std::array<T, 2> lre;
+            std::array<T, 2> lim;
+            internal::quadratic_lane (c2[i], c1[i], c0[i], lre, lim, sorted);
+            re0[i] = lre[0];
+            re1[i] = lre[1];
+            im0[i] = lim[0];
+            im1[i] = lim[1];
+        }
+    }
+
+    /*
+     * Batch cubic solver. Finds the roots of a3[i] x^3 + a2[i] x^2 + a1[i] x + a0[i] = 0 for all
+     * i, writing root j of polynomial i to (re[j][i], im[j][i]).
+     */
+    template <typename T> requires std::is_floating_point_v<T>
+    void cubic (const std::span<const T> a3, const std::span<const T> a2, const std::span<const T> a1, const std::span<const T> a0,
+                const std::array<std::span<T>, 3>& re, const std::array<std::span<T>, 3>& im, const bool sorted = true)
+    {
+        internal::check_batch_sizes<T, 4, 3> ({ a3, a2, a1, a0 }, re);
+        internal::check_batch_sizes<T, 4, 3> ({ a3, a2, a1, a0 }, im);
+        const std::size_t n = a0.size();
+        const T* c3 = a3.data();
+        const T* c2 = a2.data();
+        const T* c1 = a1.data();
+        const T* c0 = a0.data();
+        for (std::size_t i = 0; i < n; ++i) {
+            std::array<T, 3> lre;
+            std::array<T, 3> lim;
+            internal::cubic_lane (c3[i], c2[i], c1[i], c0[i], lre, lim, sorted);
+            for (std::size_t j = 0; j < 3; ++j) {
+                re[j][i] = lre[j];
+                im[j][i] = lim[j];
+            }
+        }
+    }
+
+    /*
+     * Batch quartic solver. Finds the roots of a4[i] x^4 + a3[i] x^3 + a2[i] x^2 + a1[i] x +
+     * a0[i] = 0 for all i, writing root j of polynomial i to (re[j][i], im[j][i]).
+     */
+    template <typename T> requires std::is_floating_point_v<T>
+    void quartic (const std::span<const T> a4, const std::span<const T> a3, const std::span<const T> a2,
+                  const std::span<const T> a1, const std::span<const T> a0,
+                  const std::array<std::span<T>, 4>& re, const std::array<std::span<T>, 4>& im, const bool sorted = true)
+    {
+        internal::check_batch_sizes<T, 5, 4> ({ a4, a3, a2, a1, a0 }, re);
+        internal::check_batch_sizes<T, 5, 4> ({ a4, a3, a2, a1, a0 }, im);
+        const std::size_t n = a0.size();
+        for (std::size_t i = 0; i < n; ++i) {
+            std::array<std::complex<T>, 4> roots;
+            polysolve::quartic<T> (a4[i], a3[i], a2[i], a1[i], a0[i], roots, sorted);
+            for (std::size_t j = 0; j < 4; ++j) {
+                re[j][i] = roots[j].real();
+                im[j][i] = roots[j].imag();
+            }
+        }
+    }
+
+    /*
+     * Batch quadratic solver returning only real roots. Root j of polynomial i is written to
+     * roots[j][i]. Real roots come first (ascending, if sorted is true) and any roots that are
+     * not real (by the default tolerance of polysolve::real) are returned as NaN.
+     */
+    template <typename T> requires std::is_floating_point_v<T>
+    void quadratic_real (const std::span<const T> a2, const std::span<const T> a1, const std::span<const T> a0,
+                         const std::array<std::span<T>, 2>& roots, const bool sorted = true)
+    {
+        internal::check_batch_sizes<T, 3, 2> ({ a2, a1, a0 }, roots);
+        const std::size_t n = a0.size();
+        for (std::size_t i = 0; i < n; ++i) {
+            std::array<T, 2> lre;
+            std::array<T, 2> lim;
+            std::array<T, 2> lr;
+            internal::quadratic_lane (a2[i], a1[i], a0[i], lre, lim, sorted);
+            internal::real_lane (lre, lim, lr);
+            roots[0][i] = lr[0];
+            roots[1][i] = lr[1];
+        }
+    }
+
+    /*
+     * Batch cubic solver returning only real roots, with non-real roots returned as NaN.
+     */
+    template <typename T> requires std::is_floating_point_v<T>
+    void cubic_real (const std::span<const T> a3, const std::span<const T> a2, const std::span<const T> a1, const std::span<const T> a0,
+                     const std::array<std::span<T>, 3>& roots, const bool sorted = true)
+    {
+        internal::check_batch_sizes<T, 4, 3> ({ a3, a2, a1, a0 }, roots);
+        const std::size_t n = a0.size();
+        for (std::size_t i = 0; i < n; ++i) {
+            std::array<T, 3> lre;
+            std::array<T, 3> lim;
+            std::array<T, 3> lr;
+            internal::cubic_lane (a3[i], a2[i], a1[i], a0[i], lre, lim, sorted);
+            internal::real_lane (lre, lim, lr);
+            for (std::size_t j = 0; j < 3; ++j) { roots[j][i] = lr[j]; }
+        }
+    }
+
+    /*
+     * Batch quartic solver returning only real roots, with non-real roots returned as NaN.
+     */
+    template <typename T> requires std::is_floating_point_v<T>
+    void quartic_real (const std::span<const T> a4, const std::span<const T> a3, const std::span<const T> a2,
+                       const std::span<const T> a1, const std::span<const T> a0,
+                       const std::array<std::span<T>, 4>& roots, const bool sorted = true)
+    {
+        internal::check_batch_sizes<T, 5, 4> ({ a4, a3, a2, a1, a0 }, roots);
+        const std::size_t n = a0.size();
+        for (std::size_t i = 0; i < n; ++i) {
+            std::array<std::complex<T>, 4> croots;
+            polysolve::quartic<T> (a4[i], a3[i], a2[i], a1[i], a0[i], croots, sorted);
+            std::array<T, 4> lre;
+            std::array<T, 4> lim;
+            std::array<T, 4> lr;
+            for (std::size_t j = 0; j < 4; ++j) {
+                lre[j] = croots[j].real();
+                lim[j] = croots[j].imag();
+            }
+            internal::real_lane (lre, lim, lr);
+            for (std::size_t j = 0; j < 4; ++j) { roots[j][i] = lr[j]; }
+        }
+    }
+
 }   // end of sm::polysolve namespace
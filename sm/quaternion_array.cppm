@@ -0,0 +1,394 @@
+// -*- C++ -*-
+/*!
+ * This file is part of sebsjames/maths, a library of maths code for modern C++
+ *
+ * See https://github.com/sebsjames/maths
+ *
+ * \file
+ *
+ * A structure-of-arrays container of many quaternions. Where sm::quaternion operates on one
+ * rotation at a time, sm::quaternion_array holds the w, x, y and z elements of N quaternions in
+ * four separate, contiguous sm::vvecs. The bulk operations (multiply, renormalize, rotate
+ * vectors, slerp/nlerp and conversion to transform matrices) are written as simple loops over
+ * these arrays so that the compiler can vectorise them across the batch.
+ *
+ * Hamiltonian convention (w,x,y,z), as for sm::quaternion.
+ */
+module;
+
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+export module sm.quaternion_array;
+
+export import sm.vec;
+export import sm.vvec;
+export import sm.quaternion;
+export import sm.mat;
+
+export namespace sm
+{
+    template <typename F> requires std::is_floating_point_v<F>
+    struct quaternion_array
+    {
+        //! An empty array
+        quaternion_array() = default;
+
+        //! An array of n identity quaternions
+        explicit quaternion_array (const std::size_t n) { this->resize (n); }
+
+        //! The w (scalar) elements of all the quaternions
+        sm::vvec<F> w;
+        //! The x elements of all the quaternions
+        sm::vvec<F> x;
+        //! The y elements of all the quaternions
+        sm::vvec<F> y;
+        //! The z elements of all the quaternions
+        sm::vvec<F> z;
+
+        //! The number of quaternions in the array
+        std::size_t size() const noexcept { return this->w.size(); }
+
+        //! Resize the array. New quaternions are identity rotations (1,0,0,0).
+        void resize (const std::size_t n)
+        {
+            this->w.resize (n, F{1});
+            this->x.resize (n, F{0});
+            this->y.resize (n, F{0});
+            this->z.resize (n, F{0});
+        }
+
+        //! Set every quaternion in the array to the identity rotation
+        void reset() noexcept
+        {
+            this->w.set_from (F{1});
+            this->x.zero();
+            this->y.zero();
+            this->z.zero();
+        }
+
+        //! Return quaternion i as an sm::quaternion
+        constexpr sm::quaternion<F> get (const std::size_t i) const noexcept
+        {
+            return sm::quaternion<F>{ this->w[i], this->x[i], this->y[i], this->z[i] };
+        }
+
+        //! Set quaternion i from an sm::quaternion
+        constexpr void set (const std::size_t i, const sm::quaternion<F>& q) noexcept
+        {
+            this->w[i] = q.w;
+            this->x[i] = q.x;
+            this->y[i] = q.y;
+            this->z[i] = q.z;
+        }
+
+        //! Append the quaternion q to the end of the array
+        void push_back (const sm::quaternion<F>& q)
+        {
+            this->w.push_back (q.w);
+            this->x.push_back (q.x);
+            this->y.push_back (q.y);
+            this->z.push_back (q.z);
+        }
+
+        //! Renormalize every quaternion in the array to magnitude 1
+        void renormalize() noexcept
+        {
+            const std::size_t n = this->size();
+            F* _w = this->w.data();
+            F* _x = this->x.data();
+            F* _y = this->y.data();
+            F* _z = this->z.data();
+            for (std::size_t i = 0; i < n; ++i) {
+                const F oneovermag = F{1} / std::sqrt (_w[i] * _w[i] + _x[i] * _x[i] + _y[i] * _y[i] + _z[i] * _z[i]);
+                _w[i] *= oneovermag;
+                _x[i] *= oneovermag;
+                _y[i] *= oneovermag;
+                _z[i] *= oneovermag;
+            }
+        }
+
+        //! Return the magnitude of each quaternion in the array
+        sm::vvec<F> norm() const
+        {
+            const std::size_t n = this->size();
+            sm::vvec<F> nrm (n, F{0});
+            for (std::size_t i = 0; i < n; ++i) {
+                nrm[i] = std::sqrt (this->w[i] * this->w[i] + this->x[i] * this->x[i]
+                                    + this->y[i] * this->y[i] + this->z[i] * this->z[i]);
+            }
+            return nrm;
+        }
+
+        /*!
+         * Element-wise Hamilton product of the quaternions q1 and q2, written into qo. That is,
+         * qo[i] = q1[i] * q2[i]. qo may be the same object as q1 or q2. q1 and q2 must have the
+         * same size and qo will be resized to match.
+         */
+        static void multiply (const quaternion_array<F>& q1, const quaternion_array<F>& q2, quaternion_array<F>& qo)
+        {
+            const std::size_t n = q1.size();
+            if (q2.size() != n) { throw std::runtime_error ("quaternion_array::multiply: q1 and q2 differ in size"); }
+            qo.resize (n);
+            const F* aw = q1.w.data();
+            const F* ax = q1.x.data();
+            const F* ay = q1.y.data();
+            const F* az = q1.z.data();
+            const F* bw = q2.w.data();
+            const F* bx = q2.x.data();
+            const F* by = q2.y.data();
+            const F* bz = q2.z.data();
+            F* ow = qo.w.data();
+            F* ox = qo.x.data();
+            F* oy = qo.y.data();
+            F* oz = qo.z.data();
+            for (std::size_t i = 0; i < n; ++i) {
+                // Copy into locals, so that qo may alias q1 or q2
+                const F a_w = aw[i], a_x = ax[i], a_y = ay[i], a_z = az[i];
+                const F b_w = bw[i], b_x = bx[i], b_y = by[i], b_z = bz[i];
+                ow[i] = a_w * b_w - a_x * b_x - a_y * b_y - a_z * b_z;
+                ox[i] = a_w * b_x + a_x * b_w + a_y * b_z - a_z * b_y;
+                oy[i] = a_w * b_y - a_x * b_z + a_y * b_w + a_z * b_x;
+                oz[i] = a_w * b_z + a_x * b_y - a_y * b_x + a_z * b_w;
+            }
+        }
+
+        //! Multiply each quaternion in this array by q2[i] as: this[i] = this[i] * q2[i]
+        void postmultiply (const quaternion_array<F>& q2) { multiply (*this, q2, *this); }
+
+        //! Multiply each quaternion in this array by q1[i] as: this[i] = q1[i] * this[i]
+        void premultiply (const quaternion_array<F>& q1) { multiply (q1, *this, *this); }
+
+        //! Multiply every quaternion in this array by the single quaternion q2: this[i] = this[i] * q2
+        void postmultiply (const sm::quaternion<F>& q2) noexcept
+        {
+            const std::size_t n = this->size();
+            F* _w = this->w.data();
+            F* _x = this->x.data();
+            F* _y = this->y.data();
+            F* _z = this->z.data();
+            for (std::size_t i = 0; i < n; ++i) {
+                const F a_w = _w[i], a_x = _x[i], a_y = _y[i], a_z = _z[i];
+                _w[i] = a_w * q2.w - a_x * q2.x - a_y * q2.y - a_z * q2.z;
+                _x[i] = a_w * q2.x + a_x * q2.w + a_y * q2.z - a_z * q2.y;
+                _y[i] = a_w * q2.y - a_x * q2.z + a_y * q2.w + a_z * q2.x;
+                _z[i] = a_w * q2.z + a_x * q2.y - a_y * q2.x + a_z * q2.w;
+            }
+        }
+
+        //! Pre-multiply every quaternion in this array by the single quaternion q1: this[i] = q1 * this[i]
+        void premultiply (const sm::quaternion<F>& q1) noexcept
+        {
+            const std::size_t n = this->size();
+            F* _w = this->w.data();
+            F* _x = this->x.data();
+            F* _y = this->y.data();
+            F* _z = this->z.data();
+            for (std::size_t i = 0; i < n; ++i) {
+                const F b_w = _w[i], b_x = _x[i], b_y = _y[i], b_z = _z[i];
+                _w[i] = q1.w * b_w - q1.x * b_x - q1.y * b_y - q1.z * b_z;
+                _x[i] = q1.w * b_x + q1.x * b_w + q1.y * b_z - q1.z * b_y;
+                _y[i] = q1.w * b_y - q1.x * b_z + q1.y * b_w + q1.z * b_x;
+                _z[i] = q1.w * b_z + q1.x * b_y - q1.y * b_x + q1.z * b_w;
+            }
+        }
+
+        //! Return the element-wise product of this array and q2
+        quaternion_array<F> operator* (const quaternion_array<F>& q2) const
+        {
+            quaternion_array<F> qo;
+            multiply (*this, q2, qo);
+            return qo;
+        }
+
+        //! Return the element-wise conjugates of this array
+        quaternion_array<F> conjugate() const
+        {
+            quaternion_array<F> qc = *this;
+            qc.x = -qc.x;
+            qc.y = -qc.y;
+            qc.z = -qc.z;
+            return qc;
+        }
+
+        /*!
+         * Rotate the 3D vectors given in structure-of-arrays form (vx, vy, vz) in place, so that
+         * vector i is rotated by quaternion i. The arrays must have the same size as this
+         * quaternion_array.
+         *
+         * Uses v' = v + w t + q_v x t, where t = 2 q_v x v, which is equivalent to q v q* but
+         * requires fewer operations. As for quaternion::rotate_vec, the quaternions are ASSUMED to
+         * be normalized.
+         */
+        void rotate_vecs (sm::vvec<F>& vx, sm::vvec<F>& vy, sm::vvec<F>& vz) const
+        {
+            const std::size_t n = this->size();
+            if (vx.size() != n || vy.size() != n || vz.size() != n) {
+                throw std::runtime_error ("quaternion_array::rotate_vecs: vector arrays must match the quaternion count");
+            }
+            const F* _w = this->w.data();
+            const F* _x = this->x.data();
+            const F* _y = this->y.data();
+            const F* _z = this->z.data();
+            F* px = vx.data();
+            F* py = vy.data();
+            F* pz = vz.data();
+            for (std::size_t i = 0; i < n; ++i) {
+                const F tx = F{2} * (_y[i] * pz[i] - _z[i] * py[i]);
+                const F ty = F{2} * (_z[i] * px[i] - _x[i] * pz[i]);
+                const F tz = F{2} * (_x[i] * py[i] - _y[i] * px[i]);
+                px[i] += _w[i] * tx + (_y[i] * tz - _z[i] * ty);
+                py[i] += _w[i] * ty + (_z[i] * tx - _x[i] * tz);
+                pz[i] += _w[i] * tz + (_x[i] * ty - _y[i] * tx);
+            }
+        }
+
+        //! Rotate each vector in vs by the corresponding quaternion, returning the rotated vectors.
+        sm::vvec<sm::vec<F, 3>> rotate_vecs (const sm::vvec<sm::vec<F, 3>>& vs) const
+        {
+            const std::size_t n = this->size();
+            if (vs.size() != n) {
+                throw std::runtime_error ("quaternion_array::rotate_vecs: vector array must match the quaternion count");
+            }
+            sm::vvec<F> vx (n), vy (n), vz (n);
+            for (std::size_t i = 0; i < n; ++i) {
+                vx[i] = vs[i][0];
+                vy[i] = vs[i][1];
+                vz[i] = vs[i][2];
+            }
+            this->rotate_vecs (vx, vy, vz);
+            sm::vvec<sm::vec<F, 3>> rotated (n);
+            for (std::size_t i = 0; i < n; ++i) { rotated[i] = { vx[i], vy[i], vz[i] }; }
+            return rotated;
+        }
+
+        /*!
+         * Normalized linear interpolation between the quaternions in this array and those in
+         * q2. The result is written into qo (which may be *this). Cheaper than slerp and
+         * adequate for small angular differences. Interpolation follows the shorter arc. Throws
+         * if t is not in [0,1].
+         */
+        void nlerp (const quaternion_array<F>& q2, const F t, quaternion_array<F>& qo) const
+        {
+            if (t < F{0} || t > F{1}) { throw std::runtime_error ("quaternion_array::nlerp: t out of range [0,1]"); }
+            const std::size_t n = this->size();
+            if (q2.size() != n) { throw std::runtime_error ("quaternion_array::nlerp: arrays differ in size"); }
+            qo.resize (n);
+            const F s0 = F{1} - t;
+            for (std::size_t i = 0; i < n; ++i) {
+                const F d = this->w[i] * q2.w[i] + this->x[i] * q2.x[i] + this->y[i] * q2.y[i] + this->z[i] * q2.z[i];
+                const F s1 = d < F{0} ? -t : t;
+                const F _w = s0 * this->w[i] + s1 * q2.w[i];
+                const F _x = s0 * this->x[i] + s1 * q2.x[i];
+                const F _y = s0 * this->y[i] + s1 * q2.y[i];
+                const F _z = s0 * this->z[i] + s1 * q2.z[i];
+                const F oneovermag = F{1} / std::sqrt (_w * _w + _x * _x + _y * _y + _z * _z);
+                qo.w[i] = _w * oneovermag;
+                qo.x[i] = _x * oneovermag;
+                qo.y[i] = _y * oneovermag;
+                qo.z[i] = _z * oneovermag;
+            }
+        }
+
+        /*!
+         * Spherical linear interpolation between the quaternions in this array and those in q2,
+         * written into qo (which may be *this). Gives the same results as quaternion::slerp
+         * applied to each pair. All quaternions are ASSUMED to be unit quaternions (they are not
+         * checked, as they are in quaternion::slerp). Throws if t is not in [0,1].
+         */
+        void slerp (const quaternion_array<F>& q2, const F t, quaternion_array<F>& qo) const
+        {
+            if (t < F{0} || t > F{1}) { throw std::runtime_error ("quaternion_array::slerp: t out of range [0,1]"); }
+            const std::size_t n = this->size();
+            if (q2.size() != n) { throw std::runtime_error ("quaternion_array::slerp: arrays differ in size"); }
+            qo.resize (n);
+            constexpr F one = F{1} - std::numeric_limits<F>::epsilon();
+            for (std::size_t i = 0; i < n; ++i) {
+                const F d = this->w[i] * q2.w[i] + this->x[i] * q2.x[i] + this->y[i] * q2.y[i] + this->z[i] * q2.z[i];
+                const F abs_d = std::abs (d);
+                F scale0 = F{1} - t;
+                F scale1 = t;
+                if (abs_d < one) {
+                    // theta is the angle between the 2 quaternions
+                    const F theta = std::acos (abs_d);
+                    const F oneover_sin_theta = F{1} / std::sqrt (F{1} - abs_d * abs_d);
+                    scale0 = std::sin ((F{1} - t) * theta) * oneover_sin_theta;
+                    scale1 = std::sin (t * theta) * oneover_sin_theta;
+                }
+                if (d < F{0}) { scale1 = -scale1; }
+                const F _w = scale0 * this->w[i] + scale1 * q2.w[i];
+                const F _x = scale0 * this->x[i] + scale1 * q2.x[i];
+                const F _y = scale0 * this->y[i] + scale1 * q2.y[i];
+                const F _z = scale0 * this->z[i] + scale1 * q2.z[i];
+                qo.w[i] = _w;
+                qo.x[i] = _x;
+                qo.y[i] = _y;
+                qo.z[i] = _z;
+            }
+        }
+
+        //! Return the slerp of this array towards q2 by t
+        quaternion_array<F> slerp (const quaternion_array<F>& q2, const F t) const
+        {
+            quaternion_array<F> qo;
+            this->slerp (q2, t, qo);
+            return qo;
+        }
+
+        //! Return the nlerp of this array towards q2 by t
+        quaternion_array<F> nlerp (const quaternion_array<F>& q2, const F t) const
+        {
+            quaternion_array<F> qo;
+            this->nlerp (q2, t, qo);
+            return qo;
+        }
+
+        /*!
+         * Write the 4x4 rotation matrix for each quaternion into mats (which is resized to
+         * match). For unit quaternions, this gives the same result as sm::mat<F, 4>::pure_rotation.
+         * Like quaternion::rotation_matrix, it divides by the squared norm, so the quaternions are
+         * not required to be unit quaternions.
+         */
+        void rotation_matrices (sm::vvec<sm::mat<F, 4>>& mats) const
+        {
+            const std::size_t n = this->size();
+            mats.resize (n);
+            for (std::size_t i = 0; i < n; ++i) {
+                const F _w = this->w[i];
+                const F _x = this->x[i];
+                const F _y = this->y[i];
+                const F _z = this->z[i];
+                const F s = F{2} / (_w * _w + _x * _x + _y * _y + _z * _z);
+                sm::mat<F, 4>& m = mats[i];
+                m[0] = F{1} - s * (_y * _y + _z * _z);
+                m[1] = s * (_x * _y + _w * _z);
+                m[2] = s * (_x * _z - _w * _y);
+                m[3] = F{0};
+                m[4] = s * (_x * _y - _w * _z);
+                m[5] = F{1} - s * (_x * _x + _z * _z);
+                m[6] = s * (_y * _z + _w * _x);
+                m[7] = F{0};
+                m[8] = s * (_x * _z + _w * _y);
+                m[9] = s * (_y * _z - _w * _x);
+                m[10] = F{1} - s * (_x * _x + _y * _y);
+                m[11] = F{0};
+                m[12] = F{0};
+                m[13] = F{0};
+                m[14] = F{0};
+                m[15] = F{1};
+            }
+        }
+
+        //! Return the 4x4 rotation matrices for all the quaternions in the array
+        sm::vvec<sm::mat<F, 4>> rotation_matrices() const
+        {
+            sm::vvec<sm::mat<F, 4>> mats;
+            this->rotation_matrices (mats);
+            return mats;
+        }
+    };
+
+} // namespace sm
@@ -0,0 +1,127 @@
+// Test sm::affine against the equivalent sm::mat<F, 4> operations
+
+#include <iostream>
+#include <limits>
+
+import sm.mathconst;
+import sm.vec;
+import sm.quaternion;
+import sm.mat;
+import sm.affine;
+
+template <typename F>
+bool close (const sm::mat<F, 4>& m1, const sm::mat<F, 4>& m2, const F tol)
+{
+    return (m1.arr - m2.arr).abs().max() < tol;
+}
+
+// A constexpr function that builds a transform chain and inverts it
+constexpr sm::vec<float, 3> constexpr_chain()
+{
+    sm::affine<float> a;
+    a.translate (sm::vec<float, 3>{ 1.0f, 2.0f, 3.0f });
+    a.scale (2.0f);
+    sm::affine<float> b = a * a.inverse();
+    return b * sm::vec<float, 3>{ 4.0f, 5.0f, 6.0f };
+}
+
+int main()
+{
+    int rtn = 0;
+
+    using F = double;
+    using mc = sm::mathconst<F>;
+    constexpr F tol = F{100} * std::numeric_limits<F>::epsilon();
+
+    // A default affine is the identity
+    sm::affine<F> ident;
+    if (!close (ident.mat44(), sm::mat<F, 4>::identity(), tol)) { ++rtn; }
+
+    // Build the same transform chain on a mat and an affine
+    sm::quaternion<F> q1 (sm::vec<F, 3>{ F{1}, F{2}, F{-1} }, mc::pi_over_3);
+    sm::quaternion<F> q2 (sm::vec<F, 3>{ F{0}, F{1}, F{0} }, F{-0.4});
+
+    sm::mat<F, 4> m;
+    m.translate (sm::vec<F, 3>{ F{1}, F{-2}, F{0.5} });
+    m.rotate (q1);
+    m.scale (F{2}, F{0.5}, F{3});
+    m.translate (F{4}, F{0}, F{-1});
+    m.prerotate (q2);
+    m.pretranslate (sm::vec<F, 3>{ F{0.1}, F{0.2}, F{0.3} });
+
+    sm::affine<F> a;
+    a.translate (sm::vec<F, 3>{ F{1}, F{-2}, F{0.5} });
+    a.rotate (q1);
+    a.scale (F{2}, F{0.5}, F{3});
+    a.translate (F{4}, F{0}, F{-1});
+    a.prerotate (q2);
+    a.pretranslate (sm::vec<F, 3>{ F{0.1}, F{0.2}, F{0.3} });
+
+    if (!close (a.mat44(), m, tol)) {
+        std::cout << "Transform chain differs:\n" << a << "\nvs\n" << m << std::endl;
+        ++rtn;
+    }
+
+    // Conversion from mat<F, 4>
+    if (!sm::affine<F>::is_affine (m)) { ++rtn; }
+    sm::affine<F> a_from_m (m);
+    if (!close (a_from_m.mat44(), m, tol)) { ++rtn; }
+    sm::mat<F, 4> persp = sm::mat<F, 4>::perspective (F{50}, F{1}, F{0.1}, F{100});
+    if (sm::affine<F>::is_affine (persp)) { ++rtn; }
+
+    // Composition matches mat multiplication
+    sm::affine<F> b (q2);
+    b.translate (F{-3}, F{2}, F{1});
+    b.scale (F{1.5});
+    sm::mat<F, 4> mb = b.mat44();
+    if (!close ((a * b).mat44(), m * mb, tol)) { ++rtn; }
+    sm::affine<F> ab = a;
+    ab *= b;
+    if (!close (ab.mat44(), m * mb, tol)) { ++rtn; }
+    sm::affine<F> ba = a;
+    ba.premultiply (b);
+    if (!close (ba.mat44(), mb * m, tol)) { ++rtn; }
+
+    // Inverse matches mat inverse
+    if (!close (a.inverse().mat44(), m.inverse(), F{10} * tol)) {
+        std::cout << "Inverse differs:\n" << a.inverse() << "\nvs\n" << m.inverse() << std::endl;
+        ++rtn;
+    }
+    if (!close ((a * a.inverse()).mat44(), sm::mat<F, 4>::identity(), F{10} * tol)) { ++rtn; }
+
+    // Rigid inverse for a rotation + translation
+    sm::affine<F> r (q1);
+    r.pretranslate (sm::vec<F, 3>{ F{5}, F{6}, F{7} });
+    if (!close (r.rigid_inverse().mat44(), r.inverse().mat44(), tol)) { ++rtn; }
+    if (!close ((r.rigid_inverse() * r).mat44(), sm::mat<F, 4>::identity(), tol)) { ++rtn; }
+
+    // Transforming points and directions
+    sm::vec<F, 3> p = { F{1}, F{2}, F{3} };
+    sm::vec<F, 4> p4 = { F{1}, F{2}, F{3}, F{1} };
+    sm::vec<F, 4> mp = m * p4;
+    sm::vec<F, 3> ap = a * p;
+    sm::vec<F, 4> ap4 = a * p4;
+    if ((ap - mp.less_one_dim()).abs().max() > tol) { ++rtn; }
+    if ((ap4 - mp).abs().max() > tol) { ++rtn; }
+    sm::vec<F, 3> d = a.transform_direction (p);
+    if ((d - (a.linear * p)).abs().max() > tol) { ++rtn; }
+
+    // frombasis matches mat::frombasis
+    sm::vec<F, 3> bx = { F{0}, F{1}, F{0} };
+    sm::vec<F, 3> by = { F{-1}, F{0}, F{0} };
+    sm::vec<F, 3> bz = { F{0}, F{0}, F{1} };
+    if (!close (sm::affine<F>::frombasis (bx, by, bz).mat44(), sm::mat<F, 4>::frombasis (bx, by, bz), tol)) { ++rtn; }
+
+    // Equality
+    if (a_from_m != sm::affine<F>(m)) { ++rtn; }
+
+    // Compile time use
+    constexpr sm::vec<float, 3> cv = constexpr_chain();
+    if ((cv - sm::vec<float, 3>{ 4.0f, 5.0f, 6.0f }).abs().max() > 1e-5f) {
+        std::cout << "constexpr chain gave " << cv << std::endl;
+        ++rtn;
+    }
+
+    std::cout << "Test " << (rtn ? "FAILED" : "PASSED") << std::endl;
+    return rtn;
+}
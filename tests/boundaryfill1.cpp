@@ -0,0 +1,166 @@
+// Test boundary application in hexgrid and cartgrid with the flood and scanline interior
+// fills. The scanline result is checked against an independent point-in-polygon test of each
+// element centre, and the two fills are checked against each other on convex boundaries.
+
+#include <iostream>
+#include <vector>
+#include <set>
+#include <utility>
+#include <cstdint>
+#include <type_traits>
+
+import sm.boundaryfill;
+import sm.hexgrid;
+import sm.cartgrid;
+import sm.vec;
+
+using path_t = std::vector<sm::bezcoord<float>>;
+
+// A thick 'C' shape whose centroid lies in its mouth, outside the enclosed region
+path_t c_shape (const float step)
+{
+    const std::vector<sm::vec<float, 2>> corners = {
+        { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, -0.5f }, { -0.5f, -0.5f },
+        { -0.5f, 0.5f }, { 1.0f, 0.5f }, { 1.0f, 1.0f }, { -1.0f, 1.0f }
+    };
+    path_t path;
+    for (std::size_t i = 0; i < corners.size(); ++i) {
+        sm::vec<float, 2> a = corners[i];
+        sm::vec<float, 2> b = corners[(i + 1) % corners.size()];
+        const int n = static_cast<int>((b - a).length() / step);
+        for (int k = 0; k < n; ++k) { path.emplace_back (a + (b - a) * (static_cast<float>(k) / n)); }
+    }
+    return path;
+}
+
+// In scanline mode, the kept elements must be exactly the boundary elements plus those (of the
+// full grid) whose centres lie inside the path.
+template <typename G>
+int check_scanline (G& full, G& g, const path_t& path, const char* label)
+{
+    int rtn = 0;
+    // Brute force even-odd test against every edge of the path
+    auto inside = [&path](const float x, const float y) {
+        bool in = false;
+        for (std::size_t i = 0, j = path.size() - 1; i < path.size(); j = i++) {
+            const sm::bezcoord<float>& p = path[i];
+            const sm::bezcoord<float>& q = path[j];
+            if ((p.y() > y) != (q.y() > y) && x > p.x() + (y - p.y()) / (q.y() - p.y()) * (q.x() - p.x())) { in = !in; }
+        }
+        return in;
+    };
+
+    std::set<std::pair<float, float>> kept;
+    std::uint32_t n_boundary = 0;
+    std::uint32_t n_other_outside = 0;
+    auto tally = [&](const auto& el, const bool is_boundary) {
+        kept.insert ({ el.x, el.y });
+        if (is_boundary) {
+            ++n_boundary;
+        } else if (!inside (el.x, el.y)) {
+            ++n_other_outside;
+        }
+    };
+    if constexpr (std::is_same_v<G, sm::hexgrid>) {
+        for (const auto& h : g.hexen) { tally (h, h.test_flags (sm::HEX_IS_BOUNDARY)); }
+    } else {
+        for (const auto& r : g.rects) { tally (r, r.test_flags (sm::RECT_IS_BOUNDARY)); }
+    }
+    if (n_boundary == 0 || n_other_outside > 0) {
+        std::cout << label << ": " << n_boundary << " boundary elements, "
+                  << n_other_outside << " kept non-boundary elements outside the path\n";
+        ++rtn;
+    }
+    std::uint32_t n_missing = 0;
+    auto check_full = [&](const auto& el) {
+        if (inside (el.x, el.y) && kept.count ({ el.x, el.y }) == 0) { ++n_missing; }
+    };
+    if constexpr (std::is_same_v<G, sm::hexgrid>) {
+        for (const auto& h : full.hexen) { check_full (h); }
+    } else {
+        for (const auto& r : full.rects) { check_full (r); }
+    }
+    if (n_missing > 0) {
+        std::cout << label << ": " << n_missing << " elements inside the path were discarded\n";
+        ++rtn;
+    }
+    if (g.d_x.size() != g.num()) { ++rtn; }
+    return rtn;
+}
+
+int main()
+{
+    int rtn = 0;
+
+    // Scanline crossings of the unit square
+    path_t sq = { sm::bezcoord<float>(sm::vec<float, 2>{ 0.0f, 0.0f }), sm::bezcoord<float>(sm::vec<float, 2>{ 1.0f, 0.0f }),
+                  sm::bezcoord<float>(sm::vec<float, 2>{ 1.0f, 1.0f }), sm::bezcoord<float>(sm::vec<float, 2>{ 0.0f, 1.0f }) };
+    std::vector<std::vector<float>> xs;
+    sm::algo::scanline_crossings (sq, { -0.5f, 0.0f, 0.5f, 1.0f }, xs);
+    if (xs.size() != 4u || !xs[0].empty() || xs[1].size() != 2u || xs[2] != std::vector<float>{ 0.0f, 1.0f } || !xs[3].empty()) {
+        std::cout << "scanline_crossings of the unit square are wrong\n";
+        ++rtn;
+    }
+
+    // hexgrid: flood and scanline agree on an ellipse
+    {
+        sm::hexgrid hf (0.02f, 3.0f, 0.0f);
+        sm::hexgrid hs (0.02f, 3.0f, 0.0f);
+        sm::hexgrid full (0.02f, 3.0f, 0.0f);
+        hs.boundary_fill = sm::boundaryfill::scanline;
+        path_t e = hf.ellipse_compute (1.0f, 0.6f);
+        path_t e1 = e;
+        path_t e2 = e;
+        hf.set_boundary (e1, false);
+        hs.set_boundary (e2, false);
+        if (hf.num() != hs.num() || hf.num() < 1000u) {
+            std::cout << "hexgrid ellipse: flood kept " << hf.num() << ", scanline kept " << hs.num() << std::endl;
+            ++rtn;
+        }
+        if (hf.get_boundary().size() < 100u) { ++rtn; }
+        rtn += check_scanline (full, hs, e, "hexgrid ellipse");
+    }
+
+    // hexgrid: a boundary whose centroid is outside it needs the scanline fill
+    {
+        sm::hexgrid hs (0.02f, 3.0f, 0.0f);
+        sm::hexgrid full (0.02f, 3.0f, 0.0f);
+        hs.boundary_fill = sm::boundaryfill::scanline;
+        path_t c = c_shape (0.01f);
+        path_t c1 = c;
+        hs.set_boundary (c1, false);
+        rtn += check_scanline (full, hs, c, "hexgrid C");
+    }
+
+    // cartgrid: flood and scanline agree on a circle
+    {
+        sm::cartgrid cf (0.02f, 3.0f, 0.0f, sm::griddomainshape::boundary);
+        sm::cartgrid cs (0.02f, 3.0f, 0.0f, sm::griddomainshape::boundary);
+        sm::cartgrid full (0.02f, 3.0f, 0.0f, sm::griddomainshape::boundary);
+        cs.boundary_fill = sm::boundaryfill::scanline;
+        path_t e = cf.ellipse_compute (1.0f, 1.0f);
+        path_t e1 = e;
+        path_t e2 = e;
+        cf.set_boundary (e1, false);
+        cs.set_boundary (e2, false);
+        if (cf.num() != cs.num() || cf.num() < 1000u) {
+            std::cout << "cartgrid circle: flood kept " << cf.num() << ", scanline kept " << cs.num() << std::endl;
+            ++rtn;
+        }
+        rtn += check_scanline (full, cs, e, "cartgrid circle");
+    }
+
+    // cartgrid: the C shape
+    {
+        sm::cartgrid cs (0.02f, 3.0f, 0.0f, sm::griddomainshape::boundary);
+        sm::cartgrid full (0.02f, 3.0f, 0.0f, sm::griddomainshape::boundary);
+        cs.boundary_fill = sm::boundaryfill::scanline;
+        path_t c = c_shape (0.01f);
+        path_t c1 = c;
+        cs.set_boundary (c1, false);
+        rtn += check_scanline (full, cs, c, "cartgrid C");
+    }
+
+    std::cout << "Test " << (rtn ? "FAILED" : "PASSED") << std::endl;
+    return rtn;
+}
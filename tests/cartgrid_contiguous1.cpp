@@ -0,0 +1,107 @@
+// Test that a cartgrid with contiguous storage has the same elements, neighbour relations and
+// filter results as the default, list storage cartgrid.
+
+#include <iostream>
+#include <vector>
+#include <stdexcept>
+
+import sm.cartgrid;
+import sm.vvec;
+
+// Compare the d_ vectors of two cartgrids
+int compare_d (const sm::cartgrid& a, const sm::cartgrid& b)
+{
+    int rtn = 0;
+    if (a.num() != b.num()) { std::cout << "num differs: " << a.num() << " vs " << b.num() << std::endl; return 1; }
+    if (a.d_x != b.d_x || a.d_y != b.d_y || a.d_xi != b.d_xi || a.d_yi != b.d_yi) { ++rtn; }
+    if (a.d_ne != b.d_ne || a.d_nne != b.d_nne || a.d_nn != b.d_nn || a.d_nnw != b.d_nnw) { ++rtn; }
+    if (a.d_nw != b.d_nw || a.d_nsw != b.d_nsw || a.d_ns != b.d_ns || a.d_nse != b.d_nse) { ++rtn; }
+    if (a.d_flags != b.d_flags) { ++rtn; }
+    if (a.d_dist_to_boundary != b.d_dist_to_boundary) { ++rtn; }
+    if (rtn) { std::cout << "d_ vectors differ\n"; }
+    return rtn;
+}
+
+int compare_filters (const sm::cartgrid& a, const sm::cartgrid& b, const sm::cartgrid& kernel)
+{
+    int rtn = 0;
+    std::vector<float> data (a.num());
+    for (std::uint32_t i = 0; i < a.num(); ++i) { data[i] = static_cast<float>((i * 7919u) % 101u) / 10.0f; }
+    std::vector<float> kdata (kernel.num(), 1.0f);
+    kdata[0] = 3.0f;
+
+    std::vector<float> ra (a.num());
+    std::vector<float> rb (b.num());
+    a.oncentre_offsurround (data, ra);
+    b.oncentre_offsurround (data, rb);
+    if (ra != rb) { std::cout << "oncentre_offsurround differs\n"; ++rtn; }
+    a.boxfilter (data, ra, 3);
+    b.boxfilter (data, rb, 3);
+    if (ra != rb) { std::cout << "boxfilter differs\n"; ++rtn; }
+    a.convolve (kernel, kdata, data, ra);
+    b.convolve (kernel, kdata, data, rb);
+    if (ra != rb) { std::cout << "convolve differs\n"; ++rtn; }
+    return rtn;
+}
+
+int main()
+{
+    int rtn = 0;
+
+    // Symmetric constructor
+    sm::cartgrid l1 (0.5f, 4.0f);
+    sm::cartgrid c1 (0.5f, 4.0f, 0.0f, sm::griddomainshape::rectangle, sm::cartgridstorage::contiguous);
+    if (!c1.rects.empty()) { ++rtn; }
+    if (c1.num() != 81) { ++rtn; }
+    rtn += compare_d (l1, c1);
+    l1.set_boundary_on_outer_edge();
+    c1.set_boundary_on_outer_edge();
+    rtn += compare_d (l1, c1);
+    if (l1.widthnum() != c1.widthnum() || l1.depth() != c1.depth() || l1.get_extents() != c1.get_extents()) { ++rtn; }
+    if (c1.last_vector_index() != l1.last_vector_index()) { ++rtn; }
+
+    // Kernel grid for convolutions
+    sm::cartgrid kernel (0.5f, 1.0f, 0.0f, sm::griddomainshape::rectangle, sm::cartgridstorage::contiguous);
+    rtn += compare_filters (l1, c1, kernel);
+
+    // Non-symmetric constructor, with and without horizontal wrapping
+    for (auto wrap : { sm::griddomainwrap::none, sm::griddomainwrap::horizontal }) {
+        sm::cartgrid l2 (0.5f, 0.5f, 0.0f, 0.0f, 6.0f, 3.5f, 0.0f, sm::griddomainshape::rectangle, wrap);
+        sm::cartgrid c2 (0.5f, 0.5f, 0.0f, 0.0f, 6.0f, 3.5f, 0.0f, sm::griddomainshape::rectangle, wrap,
+                         sm::cartgridstorage::contiguous);
+        rtn += compare_d (l2, c2);
+        l2.set_boundary_on_outer_edge();
+        c2.set_boundary_on_outer_edge();
+        rtn += compare_d (l2, c2);
+        if (l2.width() != c2.width()) { ++rtn; }
+        rtn += compare_filters (l2, c2, kernel);
+        if (wrap == sm::griddomainwrap::horizontal) {
+            // The fast box filter agrees with the neighbour-following one
+            sm::vvec<float> data (c2.num());
+            data.randomize();
+            sm::vvec<float> fast (c2.num());
+            std::vector<float> slow (c2.num());
+            c2.boxfilter_f<float, 3> (data, fast);
+            c2.boxfilter (data, slow, 3);
+            for (std::uint32_t i = 0; i < c2.num(); ++i) {
+                if (std::abs (fast[i] - slow[i]) > 1e-5f) { ++rtn; break; }
+            }
+        }
+    }
+
+    // Methods that need rects throw with contiguous storage
+    try {
+        c1.set_circular_boundary (1.0f);
+        std::cout << "set_circular_boundary did not throw\n";
+        ++rtn;
+    } catch (const std::runtime_error&) {}
+
+    // Boundary domains need list storage
+    try {
+        sm::cartgrid cb (0.5f, 4.0f, 0.0f, sm::griddomainshape::boundary, sm::cartgridstorage::contiguous);
+        ++rtn;
+    } catch (const std::runtime_error&) {}
+
+    std::cout << "Test " << (rtn ? "FAILED" : "PASSED") << std::endl;
+    return rtn;
+}
@@ -0,0 +1,109 @@
+// Test the cartgrid 3x3 neighbourhood filters (oncentre_offsurround, laplacian, sobel and
+// median3x3) against straightforward per-element computations on the d_ neighbour arrays,
+// for rectangular (strided) and boundary-shaped domains.
+
+#include <iostream>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+import sm.cartgrid;
+import sm.vvec;
+
+int check_grid (const sm::cartgrid& cg, const char* label)
+{
+    int rtn = 0;
+    const std::uint32_t n = cg.num();
+    sm::vvec<double> data (n);
+    data.randomize();
+
+    auto nbr = [&cg](const std::uint32_t i, const int k) -> std::int32_t {
+        const std::vector<std::int32_t>* nb[8] = { &cg.d_ne, &cg.d_nne, &cg.d_nn, &cg.d_nnw,
+                                                   &cg.d_nw, &cg.d_nsw, &cg.d_ns, &cg.d_nse };
+        return (*nb[k])[i];
+    };
+    auto val = [&](const std::uint32_t i, const int k) { return nbr (i, k) >= 0 ? data[nbr (i, k)] : data[i]; };
+
+    std::vector<double> r1 (n);
+    std::vector<double> r2 (n);
+
+    // On-centre, off-surround
+    cg.oncentre_offsurround (data, r1);
+    for (std::uint32_t i = 0; i < n; ++i) {
+        double s = 0.0;
+        int c = 0;
+        for (int k = 0; k < 8; ++k) { if (nbr (i, k) >= 0) { s += data[nbr (i, k)]; ++c; } }
+        const double ref = data[i] - s / c;
+        if (std::abs (r1[i] - ref) > 1e-12) { std::cout << label << ": oncentre_offsurround differs at " << i << std::endl; ++rtn; break; }
+    }
+
+    // Laplacian (zero flux at edges)
+    cg.laplacian (data, r1);
+    const double d = cg.get_d();
+    const double v = cg.get_v();
+    for (std::uint32_t i = 0; i < n; ++i) {
+        double lx = 0.0;
+        double ly = 0.0;
+        if (nbr (i, 0) >= 0) { lx += data[nbr (i, 0)] - data[i]; }
+        if (nbr (i, 4) >= 0) { lx += data[nbr (i, 4)] - data[i]; }
+        if (nbr (i, 2) >= 0) { ly += data[nbr (i, 2)] - data[i]; }
+        if (nbr (i, 6) >= 0) { ly += data[nbr (i, 6)] - data[i]; }
+        const double ref = lx / (d * d) + ly / (v * v);
+        if (std::abs (r1[i] - ref) > 1e-9 * (1.0 + std::abs (ref))) { std::cout << label << ": laplacian differs at " << i << std::endl; ++rtn; break; }
+    }
+
+    // Sobel
+    cg.sobel (data, r1, r2);
+    for (std::uint32_t i = 0; i < n; ++i) {
+        const double gx = ((val (i, 1) + 2.0 * val (i, 0) + val (i, 7)) - (val (i, 3) + 2.0 * val (i, 4) + val (i, 5))) / (8.0 * d);
+        const double gy = ((val (i, 3) + 2.0 * val (i, 2) + val (i, 1)) - (val (i, 5) + 2.0 * val (i, 6) + val (i, 7))) / (8.0 * v);
+        if (std::abs (r1[i] - gx) > 1e-9 || std::abs (r2[i] - gy) > 1e-9) { std::cout << label << ": sobel differs at " << i << std::endl; ++rtn; break; }
+    }
+
+    // Median
+    cg.median3x3 (data, r1);
+    for (std::uint32_t i = 0; i < n; ++i) {
+        std::vector<double> p = { data[i] };
+        for (int k = 0; k < 8; ++k) { if (nbr (i, k) >= 0) { p.push_back (data[nbr (i, k)]); } }
+        std::sort (p.begin(), p.end());
+        if (r1[i] != p[p.size() / 2]) { std::cout << label << ": median3x3 differs at " << i << std::endl; ++rtn; break; }
+    }
+
+    return rtn;
+}
+
+int main()
+{
+    int rtn = 0;
+
+    for (auto storage : { sm::cartgridstorage::list, sm::cartgridstorage::contiguous }) {
+        for (auto wrap : { sm::griddomainwrap::none, sm::griddomainwrap::horizontal }) {
+            sm::cartgrid cg (0.5f, 0.25f, 0.0f, 0.0f, 9.5f, 6.0f, 0.0f, sm::griddomainshape::rectangle, wrap, storage);
+            rtn += check_grid (cg, "rectangle");
+        }
+    }
+
+    // A boundary-shaped domain, which uses the d_ neighbour indices throughout
+    sm::cartgrid cb (0.5f, 4.0f, 0.0f, sm::griddomainshape::boundary);
+    cb.set_circular_boundary (3.0f);
+    rtn += check_grid (cb, "circle");
+
+    // A linear field has uniform Sobel gradient and zero Laplacian in the interior
+    sm::cartgrid cl (0.5f, 0.5f, 0.0f, 0.0f, 5.0f, 5.0f, 0.0f, sm::griddomainshape::rectangle);
+    std::vector<double> lin (cl.num());
+    for (std::uint32_t i = 0; i < cl.num(); ++i) { lin[i] = 3.0 * cl.d_x[i] - 2.0 * cl.d_y[i]; }
+    std::vector<double> gx (cl.num());
+    std::vector<double> gy (cl.num());
+    std::vector<double> lap (cl.num());
+    cl.sobel (lin, gx, gy);
+    cl.laplacian (lin, lap);
+    for (std::uint32_t i = 0; i < cl.num(); ++i) {
+        if ((cl.d_flags[i] & sm::RECT_HAS_NEIGHB_ALL) != sm::RECT_HAS_NEIGHB_ALL) { continue; }
+        if (std::abs (gx[i] - 3.0) > 1e-9 || std::abs (gy[i] + 2.0) > 1e-9 || std::abs (lap[i]) > 1e-9) { ++rtn; break; }
+    }
+
+    std::cout << "Test " << (rtn ? "FAILED" : "PASSED") << std::endl;
+    return rtn;
+}
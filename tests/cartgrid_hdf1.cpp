@@ -0,0 +1,75 @@
+// Save cartgrids to HDF5 with sm::cartgrid_save, load them with sm::cartgrid_load and check
+// that the loaded grids match the originals.
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+
+import sm.cartgrid.hdf;
+
+int compare (const sm::cartgrid& a, const sm::cartgrid& b, const char* label)
+{
+    int rtn = 0;
+    if (a.num() != b.num()) { std::cout << label << ": num differs\n"; return 1; }
+    if (a.get_d() != b.get_d() || a.get_v() != b.get_v() || a.get_span() != b.get_span()) { ++rtn; }
+    if (a.is_grid_reduced() != b.is_grid_reduced() || a.storage != b.storage) { ++rtn; }
+    if (a.domain_shape != b.domain_shape || a.domain_wrap != b.domain_wrap) { ++rtn; }
+    if (a.boundary_centroid != b.boundary_centroid) { ++rtn; }
+    if (a.d_x != b.d_x || a.d_y != b.d_y || a.d_xi != b.d_xi || a.d_yi != b.d_yi) { ++rtn; }
+    if (a.d_ne != b.d_ne || a.d_nne != b.d_nne || a.d_nn != b.d_nn || a.d_nnw != b.d_nnw) { ++rtn; }
+    if (a.d_nw != b.d_nw || a.d_nsw != b.d_nsw || a.d_ns != b.d_ns || a.d_nse != b.d_nse) { ++rtn; }
+    if (a.d_flags != b.d_flags || a.d_dist_to_boundary != b.d_dist_to_boundary) { ++rtn; }
+    if (a.rects.size() != b.rects.size()) { ++rtn; }
+
+    // The rebuilt rects have the right neighbours and boundary flags
+    std::uint32_t nb_a = 0;
+    std::uint32_t nb_b = 0;
+    for (const sm::rect& r : a.rects) { nb_a += r.boundary_rect() ? 1 : 0; }
+    for (const sm::rect& r : b.rects) {
+        nb_b += r.boundary_rect() ? 1 : 0;
+        if (b.d_xi[r.di] != r.xi || b.d_yi[r.di] != r.yi) { ++rtn; break; }
+        if (r.has_ne() && r.ne->di != static_cast<std::uint32_t>(b.d_ne[r.di])) { ++rtn; break; }
+        if (r.has_nn() && r.nn->di != static_cast<std::uint32_t>(b.d_nn[r.di])) { ++rtn; break; }
+        if (r.has_nsw() && r.nsw->di != static_cast<std::uint32_t>(b.d_nsw[r.di])) { ++rtn; break; }
+    }
+    if (nb_a != nb_b) { ++rtn; }
+
+    // And the same filter results
+    std::vector<float> data (a.num());
+    for (std::uint32_t i = 0; i < a.num(); ++i) { data[i] = static_cast<float>((i * 7919u) % 101u); }
+    std::vector<float> ra (a.num());
+    std::vector<float> rb (b.num());
+    a.oncentre_offsurround (data, ra);
+    b.oncentre_offsurround (data, rb);
+    if (ra != rb) { ++rtn; }
+
+    if (rtn) { std::cout << label << ": loaded cartgrid differs from saved cartgrid\n"; }
+    return rtn;
+}
+
+int main()
+{
+    int rtn = 0;
+
+    // A grid with a circular boundary
+    sm::cartgrid c1 (0.05f, 2.0f, 0.0f, sm::griddomainshape::boundary);
+    c1.set_circular_boundary (0.8f);
+    sm::cartgrid_save (c1, "cartgrid_hdf1_c1.h5");
+    sm::cartgrid l1;
+    sm::cartgrid_load (l1, "cartgrid_hdf1_c1.h5");
+    rtn += compare (c1, l1, "circle");
+
+    // A horizontally wrapped rectangle, in list and contiguous storage
+    for (auto storage : { sm::cartgridstorage::list, sm::cartgridstorage::contiguous }) {
+        sm::cartgrid c2 (0.01f, 0.01f, 0.0f, 0.0f, 2.0f, 1.0f, 0.0f,
+                         sm::griddomainshape::rectangle, sm::griddomainwrap::horizontal, storage);
+        c2.set_boundary_on_outer_edge();
+        sm::cartgrid_save (c2, "cartgrid_hdf1_c2.h5");
+        sm::cartgrid l2;
+        sm::cartgrid_load (l2, "cartgrid_hdf1_c2.h5");
+        rtn += compare (c2, l2, "rectangle");
+    }
+
+    std::cout << "Test " << (rtn ? "FAILED" : "PASSED") << std::endl;
+    return rtn;
+}
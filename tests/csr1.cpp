@@ -0,0 +1,136 @@
+// Test sm::csr against a dense matrix (building from rows with repeated columns, element
+// access, the matrix-vector product and identity_plus), and sm::conjugate_gradient on a
+// one dimensional Poisson problem with a known solution.
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+
+import sm.csr;
+
+int main()
+{
+    int rtn = 0;
+
+    // A small matrix with rows given out of order, one repeated column and one empty row
+    const std::uint32_t n = 5;
+    const double dense[5][5] = {
+        { 4.0, -1.0, 0.0, 0.0, 0.5 },
+        { -1.0, 4.0, -1.0, 0.0, 0.0 },
+        { 0.0, 0.0, 0.0, 0.0, 0.0 },
+        { 0.0, 0.0, -1.0, 4.0, -1.0 },
+        { 0.5, 0.0, 0.0, -1.0, 4.0 }
+    };
+    sm::csr<double> a = sm::csr<double>::from_rows<6> (n, [&dense](std::uint32_t i, std::uint32_t* c, double* v)
+    {
+        std::uint32_t m = 0;
+        for (std::uint32_t j = n; j-- > 0u;) {
+            if (dense[i][j] == 0.0) { continue; }
+            // Split the diagonal into two entries, which must be summed
+            if (j == i) {
+                c[m] = j;
+                v[m++] = 1.0;
+                c[m] = j;
+                v[m++] = dense[i][j] - 1.0;
+            } else {
+                c[m] = j;
+                v[m++] = dense[i][j];
+            }
+        }
+        return m;
+    });
+    if (a.nnz() != 12u || a.row_start.size() != n + 1u) {
+        std::cout << "Matrix has " << a.nnz() << " entries; expected 12\n";
+        rtn -= 1;
+    }
+    for (std::uint32_t i = 0; i < n; ++i) {
+        for (std::uint32_t j = 0; j < n; ++j) {
+            if (a.at (i, j) != dense[i][j]) {
+                std::cout << "Element (" << i << "," << j << ") is " << a.at (i, j) << "\n";
+                rtn -= 1;
+            }
+        }
+        for (std::uint32_t k = a.row_start[i] + 1u; k < a.row_start[i + 1]; ++k) {
+            if (a.col[k] <= a.col[k - 1]) {
+                std::cout << "Columns of row " << i << " are not in order\n";
+                rtn -= 1;
+            }
+        }
+    }
+    // Rows 1 and 3 have entries in column 2, but row 2 is empty
+    if (a.is_symmetric()) {
+        std::cout << "Matrix should not be symmetric\n";
+        rtn -= 1;
+    }
+
+    // Matrix-vector product
+    const std::vector<double> x = { 1.0, -2.0, 3.0, 0.25, 7.0 };
+    const std::vector<double> y = a * x;
+    for (std::uint32_t i = 0; i < n; ++i) {
+        double ref = 0.0;
+        for (std::uint32_t j = 0; j < n; ++j) { ref += dense[i][j] * x[j]; }
+        if (std::abs (y[i] - ref) > 1e-12) {
+            std::cout << "A x differs in row " << i << "\n";
+            rtn -= 1;
+        }
+    }
+
+    // I + beta A, including the row without a diagonal entry
+    const sm::csr<double> b = a.identity_plus (-0.5);
+    for (std::uint32_t i = 0; i < n; ++i) {
+        for (std::uint32_t j = 0; j < n; ++j) {
+            const double ref = (i == j ? 1.0 : 0.0) - 0.5 * dense[i][j];
+            if (b.at (i, j) != ref) {
+                std::cout << "I - A/2 differs at (" << i << "," << j << ")\n";
+                rtn -= 1;
+            }
+        }
+    }
+    if (sm::csr<double>::identity (n).identity_plus (1.0).diagonal() != std::vector<double>(n, 2.0)) {
+        std::cout << "2I has the wrong diagonal\n";
+        rtn -= 1;
+    }
+
+    // -u'' = 1 on (0,1) with u(0) = u(1) = 0 has u = x (1 - x) / 2, which the three point
+    // difference reproduces exactly at the nodes
+    const std::uint32_t m = 200;
+    const double h = 1.0 / (m + 1);
+    sm::csr<double> p = sm::csr<double>::from_rows<3> (m, [](std::uint32_t i, std::uint32_t* c, double* v)
+    {
+        std::uint32_t k = 0;
+        if (i > 0u) { c[k] = i - 1u; v[k++] = -1.0; }
+        c[k] = i;
+        v[k++] = 2.0;
+        if (i + 1u < m) { c[k] = i + 1u; v[k++] = -1.0; }
+        return k;
+    });
+    p *= 1.0 / (h * h);
+    if (!p.is_symmetric()) {
+        std::cout << "Poisson matrix should be symmetric\n";
+        rtn -= 1;
+    }
+    const std::vector<double> rhs (m, 1.0);
+    std::vector<double> u;
+    const sm::cg_result<double> res = sm::conjugate_gradient (p, rhs, u, 1e-12, 1000);
+    double maxerr = 0.0;
+    for (std::uint32_t i = 0; i < m; ++i) {
+        const double xi = (i + 1) * h;
+        maxerr = std::max (maxerr, std::abs (u[i] - xi * (1.0 - xi) / 2.0));
+    }
+    if (!res.converged || res.iterations > m || maxerr > 1e-9) {
+        std::cout << "CG: converged " << res.converged << " in " << res.iterations << " iterations, residual "
+                  << res.residual << ", max error " << maxerr << "\n";
+        rtn -= 1;
+    }
+
+    // Starting from the solution, no iterations are needed
+    const sm::cg_result<double> res2 = sm::conjugate_gradient (p, rhs, u, 1e-6, 1000);
+    if (!res2.converged || res2.iterations != 0u) {
+        std::cout << "CG from the solution took " << res2.iterations << " iterations\n";
+        rtn -= 1;
+    }
+
+    std::cout << "Test " << (rtn == 0 ? "PASSED" : "FAILED") << std::endl;
+    return rtn;
+}
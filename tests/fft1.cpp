@@ -0,0 +1,64 @@
+// Test the radix-2 FFT against a direct DFT, and that the inverse undoes the forward transform
+#include <iostream>
+#include <complex>
+#include <vector>
+#include <cmath>
+#include <stdexcept>
+
+import sm.fft;
+import sm.mathconst;
+
+int main()
+{
+    int rtn = 0;
+
+    if (sm::algo::next_pow2 (0) != 1 || sm::algo::next_pow2 (5) != 8 || sm::algo::next_pow2 (64) != 64) { ++rtn; }
+
+    // 1D, compared with the DFT
+    constexpr std::size_t n = 32;
+    std::vector<std::complex<double>> a (n);
+    for (std::size_t j = 0; j < n; ++j) { a[j] = { std::sin (0.3 * j) + 0.1 * j, std::cos (1.7 * j) }; }
+    std::vector<std::complex<double>> fa = a;
+    sm::algo::fft<double> (fa);
+    for (std::size_t k = 0; k < n; ++k) {
+        std::complex<double> s = 0.0;
+        for (std::size_t j = 0; j < n; ++j) {
+            s += a[j] * std::polar (1.0, -sm::mathconst<double>::two_pi * static_cast<double>(j * k) / n);
+        }
+        if (std::abs (s - fa[k]) > 1e-10) {
+            std::cout << "DFT element " << k << " differs: " << s << " vs " << fa[k] << std::endl;
+            ++rtn;
+        }
+    }
+    sm::algo::fft<double> (fa, true);
+    for (std::size_t j = 0; j < n; ++j) {
+        if (std::abs (fa[j] - a[j]) > 1e-12) { ++rtn; break; }
+    }
+
+    // 2D round trip and the DC term
+    constexpr std::size_t w = 16;
+    constexpr std::size_t h = 8;
+    std::vector<std::complex<float>> b (w * h);
+    std::complex<float> total = 0.0f;
+    for (std::size_t i = 0; i < b.size(); ++i) {
+        b[i] = { static_cast<float>(i % 7), 0.0f };
+        total += b[i];
+    }
+    std::vector<std::complex<float>> fb = b;
+    sm::algo::fft_2d<float> (fb, w, h);
+    if (std::abs (fb[0] - total) > 1e-3f) { ++rtn; }
+    sm::algo::fft_2d<float> (fb, w, h, true);
+    for (std::size_t i = 0; i < b.size(); ++i) {
+        if (std::abs (fb[i] - b[i]) > 1e-4f) { ++rtn; break; }
+    }
+
+    // Non power of two sizes are rejected
+    try {
+        std::vector<std::complex<double>> c (12);
+        sm::algo::fft<double> (c);
+        ++rtn;
+    } catch (const std::runtime_error&) {}
+
+    std::cout << "Test " << (rtn ? "FAILED" : "PASSED") << std::endl;
+    return rtn;
+}
@@ -0,0 +1,70 @@
+// Test that a grid that computes its coordinates on the fly (store_coords = false) gives the same
+// coordinates as the default grid, which stores them in v_c.
+
+#include <iostream>
+#include <array>
+
+import sm.vec;
+import sm.vvec;
+import sm.grid;
+
+int main()
+{
+    int rtn = 0;
+
+    constexpr std::array<sm::gridorder, 4> orders = {
+        sm::gridorder::bottomleft_to_topright, sm::gridorder::topleft_to_bottomright,
+        sm::gridorder::bottomleft_to_topright_colmaj, sm::gridorder::topleft_to_bottomright_colmaj
+    };
+
+    const sm::vec<float, 2> dx = { 0.5f, 0.25f };
+    const sm::vec<float, 2> offset = { -1.0f, 2.0f };
+
+    for (auto order : orders) {
+        sm::grid<int, float> g (9, 6, dx, offset, sm::griddomainwrap::horizontal, order);
+        sm::grid<int, float, false> gi (9, 6, dx, offset, sm::griddomainwrap::horizontal, order);
+
+        // The implicit grid stores no coordinates
+        if (!gi.v_c.empty()) { ++rtn; }
+
+        for (int i = 0; i < g.n(); ++i) {
+            if (g[i] != gi[i]) { ++rtn; }
+            if (g.coord_lookup (i) != gi.coord_lookup (i)) { ++rtn; }
+            if (g.coord_ne (i) != gi.coord_ne (i)) { ++rtn; }
+            if (g.coord_nsw (i) != gi.coord_nsw (i)) { ++rtn; }
+            if (gi.index_lookup (gi[i]) != i) { ++rtn; }
+        }
+        // Out of range lookups give the same 'no coordinate' value
+        if (g[g.n()] != gi[gi.n()]) { ++rtn; }
+
+        if (g.get_abscissae() != gi.get_abscissae()) { ++rtn; }
+        if (g.get_ordinates() != gi.get_ordinates()) { ++rtn; }
+        if (g.extents() != gi.extents()) { ++rtn; }
+
+        // Changing the grid parameters updates the computed coordinates
+        g.set_dx ({ 2.0f, 3.0f });
+        gi.set_dx ({ 2.0f, 3.0f });
+        if (g[17] != gi[17]) { ++rtn; }
+
+        if (rtn) {
+            std::cout << "Failed for order " << static_cast<int>(order) << std::endl;
+            break;
+        }
+    }
+
+    // Resampling an image gives the same result with either grid
+    sm::grid<int, float> g (20, 10, { 0.1f, 0.1f });
+    sm::grid<int, float, false> gi (20, 10, { 0.1f, 0.1f });
+    sm::vvec<float> image (64);
+    for (std::size_t i = 0; i < image.size(); ++i) { image[i] = static_cast<float>(i % 7); }
+    sm::vvec<float> r1 = g.resample_image (image, 8, { 1.0f, 1.0f }, { 0.0f, 0.0f });
+    sm::vvec<float> r2 = gi.resample_image (image, 8, { 1.0f, 1.0f }, { 0.0f, 0.0f });
+    if (r1 != r2) { ++rtn; }
+
+    // A very large implicit grid is cheap to create
+    sm::grid<std::uint64_t, double, false> big (100000, 100000);
+    if (big[big.n() - 1] != sm::vec<double, 2>{ 99999.0, 99999.0 }) { ++rtn; }
+
+    std::cout << "Test " << (rtn ? "FAILED" : "PASSED") << std::endl;
+    return rtn;
+}
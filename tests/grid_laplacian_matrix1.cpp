@@ -0,0 +1,130 @@
+// Test the adjacency and Laplacian matrices exported by hexgrid and cartgrid against their
+// d_ neighbour arrays and laplacian methods, and take implicit diffusion steps with them.
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <algorithm>
+
+import sm.hexgrid;
+import sm.cartgrid;
+
+// Compare L u with laplacian(u), which every grid provides
+template <typename G>
+int check_laplacian (const G& g, const std::uint32_t n, const char* label)
+{
+    int rtn = 0;
+    std::vector<double> u (n);
+    for (std::uint32_t i = 0; i < n; ++i) { u[i] = std::sin (3.0 * g.d_x[i]) * std::cos (2.0 * g.d_y[i]); }
+    std::vector<double> lu (n);
+    g.laplacian (u, lu);
+
+    const sm::csr<double> l = g.template laplacian_matrix<double>();
+    const std::vector<double> lmu = l * u;
+    double maxdiff = 0.0;
+    double maxval = 0.0;
+    for (std::uint32_t i = 0; i < n; ++i) {
+        maxdiff = std::max (maxdiff, std::abs (lmu[i] - lu[i]));
+        maxval = std::max (maxval, std::abs (lu[i]));
+    }
+    if (maxdiff > 1e-9 * maxval) {
+        std::cout << label << ": L u differs from laplacian(u) by " << maxdiff << "\n";
+        rtn -= 1;
+    }
+    if (!l.is_symmetric (1e-9 * maxval)) {
+        std::cout << label << ": the Laplacian matrix is not symmetric\n";
+        rtn -= 1;
+    }
+    // With zero flux, each row sums to zero; with zero boundary values the edge rows do not
+    const sm::csr<double> ld = g.template laplacian_matrix<double> (sm::boundary_condition::dirichlet);
+    const std::vector<double> ones (n, 1.0);
+    const std::vector<double> rows = l * ones;
+    const std::vector<double> rows_d = ld * ones;
+    const double edge = *std::min_element (rows_d.begin(), rows_d.end());
+    if (*std::max_element (rows.begin(), rows.end()) > 1e-9 * maxval || -*std::min_element (rows.begin(), rows.end()) > 1e-9 * maxval
+        || !(edge < 0.0) || ld.nnz() != l.nnz()) {
+        std::cout << label << ": row sums are wrong\n";
+        rtn -= 1;
+    }
+
+    // An implicit step with D dt 20 times the explicit stability limit conserves the total
+    // and satisfies the step's equations
+    const double D = 0.1;
+    const double dt = 20.0 * g.get_d() * g.get_d() / (3.0 * D);
+    const sm::csr<double> m = l.identity_plus (-D * dt);
+    std::vector<double> u1 = u;
+    const sm::cg_result<double> res = sm::conjugate_gradient (m, u, u1, 1e-10, 2000);
+    const double s0 = std::accumulate (u.begin(), u.end(), 0.0);
+    const double s1 = std::accumulate (u1.begin(), u1.end(), 0.0);
+    const std::vector<double> mu1 = m * u1;
+    double resid = 0.0;
+    for (std::uint32_t i = 0; i < n; ++i) { resid = std::max (resid, std::abs (mu1[i] - u[i])); }
+    if (!res.converged || std::abs (s1 - s0) > 1e-6 * n || resid > 1e-8) {
+        std::cout << label << ": implicit step converged " << res.converged << " after " << res.iterations
+                  << " iterations; total " << s0 << " -> " << s1 << ", residual " << resid << "\n";
+        rtn -= 1;
+    }
+    // Diffusion smooths: the extremes move inwards
+    const auto [mn0, mx0] = std::minmax_element (u.begin(), u.end());
+    const auto [mn1, mx1] = std::minmax_element (u1.begin(), u1.end());
+    if (*mx1 > *mx0 || *mn1 < *mn0) {
+        std::cout << label << ": implicit step made new extremes\n";
+        rtn -= 1;
+    }
+    return rtn;
+}
+
+// Compare an adjacency matrix with the d_ neighbour arrays
+int check_adjacency (const sm::csr<float>& a, const std::vector<const std::vector<std::int32_t>*>& nbrs, const char* label)
+{
+    int rtn = 0;
+    std::size_t links = 0;
+    for (std::uint32_t i = 0; i < a.rows; ++i) {
+        for (const auto* nb : nbrs) {
+            if ((*nb)[i] >= 0) {
+                ++links;
+                if (a.at (i, (*nb)[i]) != 1.0f) { rtn -= 1; }
+            }
+        }
+    }
+    if (rtn != 0 || a.nnz() != links || !a.is_symmetric()) {
+        std::cout << label << ": adjacency matrix has " << a.nnz() << " entries for " << links << " links\n";
+        rtn = -1;
+    }
+    return rtn;
+}
+
+int main()
+{
+    int rtn = 0;
+
+    sm::hexgrid hg (0.02f, 1.0f, 0.0f);
+    hg.set_circular_boundary (0.3f);
+    rtn += check_laplacian (hg, hg.num(), "hexgrid");
+    rtn += check_adjacency (hg.adjacency_matrix(), { &hg.d_ne, &hg.d_nne, &hg.d_nnw, &hg.d_nw, &hg.d_nsw, &hg.d_nse }, "hexgrid");
+
+    // The matrices follow the order of the d_ vectors
+    sm::hexgrid hh (0.02f, 1.0f, 0.0f);
+    hh.d_order = sm::hexorder::hilbert;
+    hh.set_elliptical_boundary (0.4f, 0.25f);
+    rtn += check_laplacian (hh, hh.num(), "hexgrid in Hilbert order");
+    rtn += check_adjacency (hh.adjacency_matrix(), { &hh.d_ne, &hh.d_nne, &hh.d_nnw, &hh.d_nw, &hh.d_nsw, &hh.d_nse },
+                            "hexgrid in Hilbert order");
+
+    for (auto wrap : { sm::griddomainwrap::none, sm::griddomainwrap::horizontal }) {
+        sm::cartgrid cg (0.05f, 0.04f, 0.0f, 0.0f, 1.0f, 0.8f, 0.0f, sm::griddomainshape::rectangle, wrap);
+        const char* label = wrap == sm::griddomainwrap::none ? "cartgrid" : "wrapped cartgrid";
+        rtn += check_laplacian (cg, cg.num(), label);
+        rtn += check_adjacency (cg.adjacency_matrix(), { &cg.d_ne, &cg.d_nn, &cg.d_nw, &cg.d_ns }, label);
+        rtn += check_adjacency (cg.adjacency_matrix (true), { &cg.d_ne, &cg.d_nne, &cg.d_nn, &cg.d_nnw,
+                                                              &cg.d_nw, &cg.d_nsw, &cg.d_ns, &cg.d_nse }, label);
+    }
+    sm::cartgrid cb (0.05f, 2.0f, 0.0f, sm::griddomainshape::boundary);
+    cb.set_circular_boundary (0.5f);
+    rtn += check_laplacian (cb, cb.num(), "cartgrid with a boundary");
+
+    std::cout << "Test " << (rtn == 0 ? "PASSED" : "FAILED") << std::endl;
+    return rtn;
+}
@@ -0,0 +1,137 @@
+// Test sm::grid_pyramid: the levels it creates, the restriction and prolongation operators and
+// their use in a multigrid V-cycle Poisson solver.
+
+#include <iostream>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+import sm.mathconst;
+import sm.vec;
+import sm.vvec;
+import sm.grid;
+import sm.grid_pyramid;
+
+using F = double;
+using pyr_t = sm::grid_pyramid<int, F>;
+
+// Residual r = f - A u, where A u = -laplacian(u) on level l
+void residual (const pyr_t& p, const std::size_t l, const sm::vvec<F>& u, const sm::vvec<F>& f, sm::vvec<F>& r)
+{
+    const F h = p[l].get_dx()[0];
+    const sm::vec<F, 5> neg_lap = sm::vec<F, 5>{ -1, -1, 4, -1, -1 } / (h * h);
+    r.resize (u.size());
+    p[l].apply_stencil<5> (neg_lap, u, r);
+    r = f - r;
+}
+
+// Weighted Jacobi smoothing
+void smooth (const pyr_t& p, const std::size_t l, sm::vvec<F>& u, const sm::vvec<F>& f, const int sweeps)
+{
+    const F h = p[l].get_dx()[0];
+    sm::vvec<F> r;
+    for (int s = 0; s < sweeps; ++s) {
+        residual (p, l, u, f, r);
+        u += r * (F{0.8} * h * h / F{4});
+    }
+}
+
+// One multigrid V-cycle for A u = f on level l
+void vcycle (const pyr_t& p, const std::size_t l, sm::vvec<F>& u, const sm::vvec<F>& f)
+{
+    if (l + 1 == p.size()) {
+        smooth (p, l, u, f, 50);
+        return;
+    }
+    smooth (p, l, u, f, 3);
+    sm::vvec<F> r;
+    residual (p, l, u, f, r);
+    sm::vvec<F> rc;
+    p.restriction (l, r, rc);
+    sm::vvec<F> ec (rc.size(), F{0});
+    vcycle (p, l + 1, ec, rc);
+    sm::vvec<F> e;
+    p.prolongation (l, ec, e);
+    u += e;
+    smooth (p, l, u, f, 3);
+}
+
+int main()
+{
+    int rtn = 0;
+
+    constexpr std::array<sm::gridorder, 4> orders = {
+        sm::gridorder::bottomleft_to_topright, sm::gridorder::topleft_to_bottomright,
+        sm::gridorder::bottomleft_to_topright_colmaj, sm::gridorder::topleft_to_bottomright_colmaj
+    };
+
+    for (auto order : orders) {
+        // Level sizes, spacing and coincident coordinates
+        sm::grid<int, F> g (33, 17, sm::vec<F, 2>{ 0.1, 0.2 }, sm::vec<F, 2>{ -1.0, 0.5 }, sm::griddomainwrap::none, order);
+        pyr_t p (g);
+        if (p.size() != 5) { std::cout << "Expected 5 levels, got " << p.size() << std::endl; ++rtn; }
+        if (p[1].get_dims() != sm::vec<int, 2>{ 17, 9 } || p[4].get_dims() != sm::vec<int, 2>{ 3, 2 }) { ++rtn; }
+        if (p[2].get_dx() != sm::vec<F, 2>{ 0.4, 0.8 }) { ++rtn; }
+        for (int i = 0; i < p[1].n(); ++i) {
+            const int c = p[1].col (i);
+            const int r = p[1].row (i);
+            const int fi = p[0].rowmaj() ? 2 * r * p[0].get_w() + 2 * c : 2 * c * p[0].get_h() + 2 * r;
+            if ((p[1][i] - p[0][fi]).abs().max() > 1e-12) { ++rtn; }
+        }
+
+        // Restriction of a linear field is exact away from the edges; a constant field is
+        // preserved everywhere. Prolongation of a linear field is exact everywhere here (both
+        // fine dimensions are odd, so every fine element lies between coarse elements).
+        sm::vvec<F> lin (p[0].n());
+        for (int i = 0; i < p[0].n(); ++i) { lin[i] = F{3} * p[0][i][0] - F{2} * p[0][i][1] + F{1}; }
+        sm::vvec<F> lin_c;
+        p.restriction (0, lin, lin_c);
+        for (int i = 0; i < p[1].n(); ++i) {
+            const int c = p[1].col (i);
+            const int r = p[1].row (i);
+            if (c == 0 || r == 0 || c == p[1].get_w() - 1 || r == p[1].get_h() - 1) { continue; }
+            if (std::abs (lin_c[i] - (F{3} * p[1][i][0] - F{2} * p[1][i][1] + F{1})) > 1e-12) { ++rtn; }
+        }
+        sm::vvec<F> cnst (p[0].n(), F{2.5});
+        sm::vvec<F> cnst_c;
+        p.restriction (0, cnst, cnst_c);
+        if ((cnst_c - F{2.5}).abs().max() > 1e-12) { ++rtn; }
+
+        for (int i = 0; i < p[1].n(); ++i) { lin_c[i] = F{3} * p[1][i][0] - F{2} * p[1][i][1] + F{1}; }
+        sm::vvec<F> lin_f;
+        p.prolongation (0, lin_c, lin_f);
+        if ((lin_f - lin).abs().max() > 1e-12) { std::cout << "prolongation of linear field inexact\n"; ++rtn; }
+    }
+
+    // Multigrid V-cycles solve a periodic Poisson problem much faster than smoothing alone
+    using mc = sm::mathconst<F>;
+    constexpr int n = 64;
+    for (auto order : orders) {
+        sm::grid<int, F> g (n, n, sm::vec<F, 2>{ F{1} / n, F{1} / n }, sm::vec<F, 2>{ 0.0, 0.0 }, sm::griddomainwrap::both, order);
+        pyr_t p (g);
+        if (p.size() != 6) { std::cout << "Expected 6 levels, got " << p.size() << std::endl; ++rtn; }
+
+        sm::vvec<F> f (g.n());
+        for (int i = 0; i < g.n(); ++i) { f[i] = std::sin (mc::two_pi * g[i][0]) * std::cos (F{4} * mc::pi * g[i][1]); }
+        sm::vvec<F> u (g.n(), F{0});
+        sm::vvec<F> r;
+        residual (p, 0, u, f, r);
+        const F r0 = r.abs().max();
+        int cycles = 0;
+        for (; cycles < 20; ++cycles) {
+            vcycle (p, 0, u, f);
+            u -= u.mean();
+            residual (p, 0, u, f, r);
+            if (r.abs().max() < F{1e-8} * r0) { break; }
+        }
+        if (cycles >= 20) { std::cout << "V-cycles did not converge; residual " << r.abs().max() / r0 << std::endl; ++rtn; }
+    }
+
+    // Wrapped dimensions with an odd number of elements can't be coarsened
+    sm::grid<int, F> godd (15, 16, sm::vec<F, 2>{ 1.0, 1.0 }, sm::vec<F, 2>{ 0.0, 0.0 }, sm::griddomainwrap::horizontal);
+    pyr_t podd (godd);
+    if (podd.size() != 1) { ++rtn; }
+
+    std::cout << "Test " << (rtn ? "FAILED" : "PASSED") << std::endl;
+    return rtn;
+}
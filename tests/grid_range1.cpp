@@ -0,0 +1,185 @@
+// Test the grid range queries (indices_in_radius, for_each_in_rectangle, etc) against a brute
+// force search over every element of the grid, for all grid orders and wrappings.
+
+#include <iostream>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <functional>
+#include <cmath>
+#include <stdexcept>
+
+import sm.vec;
+import sm.vvec;
+import sm.grid;
+
+// Indices of all elements for which inside() is true for some periodic image of the element
+std::vector<int> brute_force (const sm::grid<int, float>& g, std::function<bool(const sm::vec<float, 2>&)> inside)
+{
+    const bool wrap_x = g.get_wrap() == sm::griddomainwrap::horizontal || g.get_wrap() == sm::griddomainwrap::both;
+    const bool wrap_y = g.get_wrap() == sm::griddomainwrap::vertical || g.get_wrap() == sm::griddomainwrap::both;
+    const sm::vec<float, 2> period = g.get_dx() * g.get_dims().as<float>();
+    std::vector<int> found;
+    for (int i = 0; i < g.n(); ++i) {
+        bool in = false;
+        for (int kx = (wrap_x ? -1 : 0); kx <= (wrap_x ? 1 : 0); ++kx) {
+            for (int ky = (wrap_y ? -1 : 0); ky <= (wrap_y ? 1 : 0); ++ky) {
+                sm::vec<float, 2> p = g[i] + sm::vec<float, 2>{ kx * period[0], ky * period[1] };
+                if (inside (p)) { in = true; }
+            }
+        }
+        if (in) { found.push_back (i); }
+    }
+    return found;
+}
+
+int compare (std::vector<int> got, const std::vector<int>& expected, const char* what)
+{
+    std::sort (got.begin(), got.end());
+    if (got != expected) {
+        std::cout << what << ": found " << got.size() << " indices; expected " << expected.size() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main()
+{
+    int rtn = 0;
+
+    constexpr std::array<sm::gridorder, 4> orders = {
+        sm::gridorder::bottomleft_to_topright, sm::gridorder::topleft_to_bottomright,
+        sm::gridorder::bottomleft_to_topright_colmaj, sm::gridorder::topleft_to_bottomright_colmaj
+    };
+    constexpr std::array<sm::griddomainwrap, 4> wraps = {
+        sm::griddomainwrap::none, sm::griddomainwrap::horizontal,
+        sm::griddomainwrap::vertical, sm::griddomainwrap::both
+    };
+
+    const sm::vec<float, 2> dx = { 0.5f, 0.25f };
+    const sm::vec<float, 2> offset = { -1.0f, 2.0f };
+
+    for (auto order : orders) {
+        for (auto wrap : wraps) {
+            sm::grid<int, float> g (20, 24, dx, offset, wrap, order);
+            // Centres near a corner (so that regions cross the edges) and in the middle
+            const float ysgn = g[g.n() - 1][1] > offset[1] ? 1.0f : -1.0f;
+            const std::array<sm::vec<float, 2>, 3> centres = {
+                offset + sm::vec<float, 2>{ 0.3f, ysgn * 0.1f },
+                offset + sm::vec<float, 2>{ 4.6f, ysgn * 3.05f },
+                offset + sm::vec<float, 2>{ 9.4f, ysgn * 5.9f }
+            };
+
+            for (auto loc : centres) {
+                const float radius = 1.6f;
+                std::vector<int> expected = brute_force (g, [loc, radius](const sm::vec<float, 2>& p) {
+                    return (p - loc).sos() < radius * radius;
+                });
+                // The vvec form starts from the element nearest loc, so loc must be on the grid
+                bool on_grid = true;
+                try { g.index_lookup (loc); } catch (const std::runtime_error&) { on_grid = false; }
+                if (on_grid) {
+                    sm::vvec<int> inds;
+                    g.indices_in_radius (loc, radius, inds);
+                    rtn += compare (std::vector<int>(inds.begin(), inds.end()), expected, "indices_in_radius (vvec)");
+                    // The vvec form gives the nearest element first, then the rest ring by ring
+                    if (inds[0] != g.index_lookup (loc)) { std::cout << "indices_in_radius: centre is not first\n"; ++rtn; }
+                    if (wrap == sm::griddomainwrap::none) {
+                        int last_ring = 0;
+                        for (int i : inds) {
+                            const sm::vec<float, 2> steps = ((g[i] - g[inds[0]]) / dx).abs();
+                            const int ring = static_cast<int>(std::round (steps[0] + steps[1]));
+                            if (ring < last_ring) { std::cout << "indices_in_radius: ring " << ring << " after " << last_ring << "\n"; ++rtn; break; }
+                            last_ring = ring;
+                        }
+                    }
+                    // The exact order: the centre, then the rest in visiting order, stable sorted by ring
+                    const sm::vec<int, 2> dims = g.get_dims();
+                    auto ring_of = [&g, &inds, dx, dims, wrap](const int i)
+                    {
+                        const sm::vec<float, 2> steps = ((g[i] - g[inds[0]]) / dx).abs();
+                        int dc = static_cast<int>(std::round (steps[0]));
+                        int dr = static_cast<int>(std::round (steps[1]));
+                        if (wrap == sm::griddomainwrap::horizontal || wrap == sm::griddomainwrap::both) { dc = std::min (dc, dims[0] - dc); }
+                        if (wrap == sm::griddomainwrap::vertical || wrap == sm::griddomainwrap::both) { dr = std::min (dr, dims[1] - dr); }
+                        return dc + dr;
+                    };
+                    std::vector<int> reference (1, inds[0]);
+                    g.for_each_in_radius (loc, radius, [&reference](const int i) { if (i != reference[0]) { reference.push_back (i); } });
+                    std::stable_sort (reference.begin() + 1, reference.end(),
+                                      [&ring_of](const int a, const int b) { return ring_of (a) < ring_of (b); });
+                    if (std::vector<int>(inds.begin(), inds.end()) != reference) {
+                        std::cout << "indices_in_radius: order differs from the stable sorted reference\n";
+                        ++rtn;
+                    }
+                } else {
+                    sm::vvec<int> inds;
+                    try {
+                        g.indices_in_radius (loc, radius, inds);
+                        std::cout << "indices_in_radius should throw for an off-grid location\n";
+                        ++rtn;
+                    } catch (const std::runtime_error&) {}
+                }
+                std::vector<int> inds2;
+                g.indices_in_radius (loc, radius, std::back_inserter (inds2));
+                rtn += compare (inds2, expected, "indices_in_radius (output iterator)");
+
+                // Annulus
+                expected = brute_force (g, [loc](const sm::vec<float, 2>& p) {
+                    const float d2 = (p - loc).sos();
+                    return d2 >= 0.8f * 0.8f && d2 < 1.9f * 1.9f;
+                });
+                std::vector<int> ann;
+                g.indices_in_annulus (loc, 0.8f, 1.9f, std::back_inserter (ann));
+                rtn += compare (ann, expected, "indices_in_annulus");
+
+                // Ellipse
+                const sm::vec<float, 2> axes = { 2.2f, 0.9f };
+                expected = brute_force (g, [loc, axes](const sm::vec<float, 2>& p) {
+                    return ((p - loc) / axes).sos() < 1.0f;
+                });
+                std::vector<int> ell;
+                g.indices_in_ellipse (loc, axes, std::back_inserter (ell));
+                rtn += compare (ell, expected, "indices_in_ellipse");
+
+                // Rectangle, including edges
+                const sm::vec<float, 2> lo = loc - sm::vec<float, 2>{ 1.0f, 0.5f };
+                const sm::vec<float, 2> hi = loc + sm::vec<float, 2>{ 1.5f, 0.75f };
+                expected = brute_force (g, [lo, hi](const sm::vec<float, 2>& p) {
+                    return p[0] >= lo[0] && p[0] <= hi[0] && p[1] >= lo[1] && p[1] <= hi[1];
+                });
+                std::vector<int> rect;
+                g.indices_in_rectangle (lo, hi, std::back_inserter (rect));
+                rtn += compare (rect, expected, "indices_in_rectangle");
+            }
+
+            // A circle larger than the whole grid visits every element exactly once
+            std::vector<int> all;
+            g.for_each_in_radius (centres[1], 100.0f, [&all](const int i) { all.push_back (i); });
+            std::vector<int> every (g.n());
+            for (int i = 0; i < g.n(); ++i) { every[i] = i; }
+            rtn += compare (all, every, "large radius");
+        }
+    }
+
+    // The element nearest the location is given first even when it lies outside the radius
+    {
+        sm::grid<int, float> gc (10, 10, sm::vec<float, 2>{ 0.1f, 0.1f }, sm::vec<float, 2>{ 0.0f, 0.0f });
+        sm::vvec<int> inds;
+        gc.indices_in_radius (gc[55] + sm::vec<float, 2>{ 0.04f, 0.0f }, 0.02f, inds);
+        if (inds.size() != 1u || inds[0] != 55) { std::cout << "indices_in_radius gave " << inds.size() << " indices for a small radius\n"; ++rtn; }
+        std::vector<int> inds2;
+        gc.indices_in_radius (gc[55] + sm::vec<float, 2>{ 0.04f, 0.0f }, 0.02f, std::back_inserter (inds2));
+        if (!inds2.empty()) { std::cout << "indices_in_radius (output iterator) should find nothing\n"; ++rtn; }
+    }
+
+    // Rectangle edges that fall exactly on element coordinates are included
+    sm::grid<int, float> g (10, 10, sm::vec<float, 2>{ 0.1f, 0.1f }, sm::vec<float, 2>{ 0.0f, 0.0f });
+    int count = 0;
+    g.for_each_in_rectangle (g[11], g[33], [&count](const int) { ++count; });
+    if (count != 9) { std::cout << "rectangle on element coordinates gave " << count << std::endl; ++rtn; }
+
+    std::cout << "Test " << (rtn ? "FAILED" : "PASSED") << std::endl;
+    return rtn;
+}
@@ -0,0 +1,122 @@
+// Test grid::apply_stencil against a reference computed with the grid's neighbour functions, for
+// every combination of gridorder, griddomainwrap and gridedge.
+
+#include <iostream>
+#include <limits>
+#include <array>
+#include <cmath>
+
+import sm.vec;
+import sm.vvec;
+import sm.grid;
+
+using I = int;
+constexpr I imax = std::numeric_limits<I>::max();
+
+// Find the neighbour of i at offset (dx, dy) using the grid's index_n* functions. Returns imax if
+// there is no such neighbour and edge is gridedge::zero.
+I ref_neighbour (const sm::grid<I, float>& g, const I i, const int dx, const int dy, const sm::gridedge edge)
+{
+    I j = i;
+    if (dx != 0) {
+        I t = dx > 0 ? g.index_ne (j) : g.index_nw (j);
+        if (t == imax) {
+            if (edge == sm::gridedge::zero) { return imax; }
+            t = j;
+        }
+        j = t;
+    }
+    if (dy != 0) {
+        I t = dy > 0 ? g.index_nn (j) : g.index_ns (j);
+        if (t == imax) {
+            if (edge == sm::gridedge::zero) { return imax; }
+            t = j;
+        }
+        j = t;
+    }
+    return j;
+}
+
+template <std::uint32_t Npts>
+int test_stencil (const sm::grid<I, float>& g, const sm::vec<float, Npts>& weights, const sm::gridedge edge)
+{
+    // The 3x3 weights, in reading order (north row first)
+    std::array<float, 9> w9 = {};
+    if constexpr (Npts == 9) {
+        for (std::uint32_t k = 0; k < 9; ++k) { w9[k] = weights[k]; }
+    } else {
+        w9 = { 0.0f, weights[0], 0.0f, weights[1], weights[2], weights[3], 0.0f, weights[4], 0.0f };
+    }
+
+    sm::vvec<float> data (g.n());
+    for (I i = 0; i < g.n(); ++i) { data[i] = std::sin (0.37f * i) + 0.01f * i; }
+
+    sm::vvec<float> result (g.n());
+    g.apply_stencil<Npts> (weights, data, result, edge);
+
+    int errs = 0;
+    for (I i = 0; i < g.n(); ++i) {
+        float expected = 0.0f;
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                I j = ref_neighbour (g, i, c - 1, 1 - r, edge);
+                if (j != imax) { expected += w9[r * 3 + c] * data[j]; }
+            }
+        }
+        if (std::abs (expected - result[i]) > 1e-5f) { ++errs; }
+    }
+    return errs;
+}
+
+int main()
+{
+    int rtn = 0;
+
+    constexpr std::array<sm::gridorder, 4> orders = {
+        sm::gridorder::bottomleft_to_topright, sm::gridorder::topleft_to_bottomright,
+        sm::gridorder::bottomleft_to_topright_colmaj, sm::gridorder::topleft_to_bottomright_colmaj
+    };
+    constexpr std::array<sm::griddomainwrap, 4> wraps = {
+        sm::griddomainwrap::none, sm::griddomainwrap::horizontal, sm::griddomainwrap::vertical, sm::griddomainwrap::both
+    };
+    constexpr std::array<sm::gridedge, 2> edges = { sm::gridedge::zero, sm::gridedge::clamp };
+
+    // An asymmetric 9 point stencil shows up any mix up in direction
+    sm::vec<float, 9> w9 = { 0.1f, 0.2f, 0.3f, 0.4f, -2.0f, 0.6f, 0.7f, 0.8f, 0.9f };
+    sm::vec<float, 5> w5 = { 1.5f, 0.5f, -4.0f, 2.0f, -1.0f };
+
+    for (auto order : orders) {
+        for (auto wrap : wraps) {
+            for (auto edge : edges) {
+                for (sm::vec<I, 2> dims : { sm::vec<I, 2>{ 7, 5 }, sm::vec<I, 2>{ 1, 4 }, sm::vec<I, 2>{ 6, 1 } }) {
+                    sm::grid<I, float> g (dims[0], dims[1], { 1.0f, 1.0f }, { 0.0f, 0.0f }, wrap, order);
+                    int e9 = test_stencil<9> (g, w9, edge);
+                    int e5 = test_stencil<5> (g, w5, edge);
+                    if (e9 || e5) {
+                        std::cout << "Stencil errors (" << e9 << "/" << e5 << ") for order " << static_cast<int>(order)
+                                  << ", wrap " << static_cast<int>(wrap) << ", edge " << static_cast<int>(edge)
+                                  << ", dims " << dims << std::endl;
+                        ++rtn;
+                    }
+                }
+            }
+        }
+    }
+
+    // A 5 point Laplacian of a constant field with clamped edges is zero everywhere
+    sm::grid<I, float> g (20, 10);
+    sm::vvec<float> ones (g.n(), 1.0f);
+    sm::vvec<float> lap (g.n());
+    g.apply_stencil<5> (sm::vec<float, 5>{ 1, 1, -4, 1, 1 }, ones, lap, sm::gridedge::clamp);
+    if (lap.abs().max() != 0.0f) { ++rtn; }
+
+    // Mismatched sizes throw
+    try {
+        sm::vvec<float> small (3);
+        g.apply_stencil<5> (sm::vec<float, 5>{ 1, 1, -4, 1, 1 }, ones, small);
+        ++rtn;
+    } catch (const std::runtime_error&) {}
+
+    std::cout << "Test " << (rtn ? "FAILED" : "PASSED") << std::endl;
+    return rtn;
+}
@@ -0,0 +1,75 @@
+// Test the distance to the boundary (in each hex and in d_dist_to_boundary) and the hexes'
+// polar coordinates, and check the grid extents found by get_x_min and get_x_max.
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+import sm.hexgrid;
+import sm.mat;
+import sm.vec;
+
+int main()
+{
+    int rtn = 0;
+
+    const float radius = 0.5f;
+    sm::hexgrid hg (0.02f, 2.0f, 0.0f);
+    hg.set_circular_boundary (radius);
+
+    // Until computed, distances are -1
+    if (hg.d_dist_to_boundary.size() != hg.num()
+        || *std::max_element (hg.d_dist_to_boundary.begin(), hg.d_dist_to_boundary.end()) != -1.0f) {
+        std::cout << "d_dist_to_boundary should start at -1 for every hex\n";
+        rtn -= 1;
+    }
+
+    hg.compute_distance_to_boundary();
+    for (const auto& hh : hg.hexen) {
+        const float dist = hg.d_dist_to_boundary[hh.di];
+        if (dist != hh.dist_to_boundary) {
+            std::cout << "Hex " << hh.vi << " has distance " << hh.dist_to_boundary << " but d_ distance " << dist << "\n";
+            rtn -= 1;
+        }
+        if (hh.test_flags (sm::HEX_IS_BOUNDARY)) {
+            if (dist != 0.0f) { rtn -= 1; }
+        } else if (std::abs (dist - (radius - hh.r)) > 1.5f * hg.get_d()) {
+            // The nearest boundary hex is about radius - r away
+            std::cout << "Hex " << hh.vi << " at r = " << hh.r << " has distance " << dist << "\n";
+            rtn -= 1;
+        }
+        if (hh.r != std::sqrt (hh.x * hh.x + hh.y * hh.y) || hh.phi != std::atan2 (hh.y, hh.x)) {
+            std::cout << "Polar coordinates of hex " << hh.vi << " are wrong\n";
+            rtn -= 1;
+        }
+    }
+
+    // A transform moves the hexes but keeps the distances
+    const std::vector<float> dist0 = hg.d_dist_to_boundary;
+    sm::mat<float, 4> tf;
+    tf.translate (sm::vec<float>{ 0.1f, -0.2f, 0.0f });
+    hg.transform (tf);
+    if (hg.d_dist_to_boundary != dist0) {
+        std::cout << "Distances to the boundary were lost in a transform\n";
+        rtn -= 1;
+    }
+
+    // Extents match a search of the hexes
+    for (const float phi : { 0.0f, 0.3f, 2.0f }) {
+        float xmin = std::numeric_limits<float>::max();
+        float xmax = std::numeric_limits<float>::lowest();
+        for (const auto& hh : hg.hexen) {
+            xmin = std::min (xmin, hh.x * std::cos (phi) + hh.y * std::sin (phi));
+            xmax = std::max (xmax, hh.x * std::cos (phi) + hh.y * std::sin (phi));
+        }
+        if (hg.get_x_min (phi) != xmin || hg.get_x_max (phi) != xmax) {
+            std::cout << "Extent at phi = " << phi << " is [" << hg.get_x_min (phi) << ", " << hg.get_x_max (phi)
+                      << "]; expected [" << xmin << ", " << xmax << "]\n";
+            rtn -= 1;
+        }
+    }
+
+    std::cout << "Test " << (rtn == 0 ? "PASSED" : "FAILED") << std::endl;
+    return rtn;
+}
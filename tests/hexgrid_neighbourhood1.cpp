@@ -0,0 +1,127 @@
+// Test the axial ring, hexagon and disc neighbourhood queries of hexgrid against brute
+// force searches over every hex, near the centre and at the edge of a clipped grid, with
+// the d_ vectors in list and in Hilbert order.
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+import sm.hexgrid;
+
+// The number of steps between two hexes on the lattice
+std::int32_t hex_steps (const sm::hexgrid& hg, std::uint32_t a, std::uint32_t b)
+{
+    const std::int32_t dr = hg.d_ri[b] - hg.d_ri[a];
+    const std::int32_t dg = hg.d_gi[b] - hg.d_gi[a];
+    return (std::abs (dr) + std::abs (dg) + std::abs (dr + dg)) / 2;
+}
+
+int check_grid (const sm::hexgrid& hg, const char* label)
+{
+    int rtn = 0;
+    const std::uint32_t n = hg.d_x.size();
+    const float d = hg.get_d();
+
+    // Centre hex, the hex furthest to the East, and one part way out
+    std::uint32_t centre = 0;
+    std::uint32_t east = 0;
+    for (std::uint32_t i = 0; i < n; ++i) {
+        if (hg.d_ri[i] == 0 && hg.d_gi[i] == 0) { centre = i; }
+        if (hg.d_x[i] > hg.d_x[east]) { east = i; }
+    }
+    const std::uint32_t part = (centre + n / 3u) % n;
+
+    for (const std::uint32_t c : { centre, east, part }) {
+        if (hg.d_index_at (hg.d_ri[c], hg.d_gi[c]) != static_cast<std::int32_t>(c)) {
+            std::cout << label << ": d_index_at does not find hex " << c << "\n";
+            rtn -= 1;
+        }
+        for (const std::uint32_t steps : { 0u, 1u, 2u, 5u }) {
+            std::vector<std::int32_t> ring_expected;
+            std::vector<std::int32_t> hexagon_expected;
+            for (std::uint32_t i = 0; i < n; ++i) {
+                const std::int32_t s = hex_steps (hg, c, i);
+                if (s == static_cast<std::int32_t>(steps)) { ring_expected.push_back (i); }
+                if (s <= static_cast<std::int32_t>(steps)) { hexagon_expected.push_back (i); }
+            }
+            std::vector<std::int32_t> ring = hg.get_ring_indices (c, steps);
+            std::vector<std::int32_t> hexagon = hg.get_hexagon_indices (c, steps);
+            std::sort (ring.begin(), ring.end());
+            std::sort (hexagon.begin(), hexagon.end());
+            if (ring != ring_expected) {
+                std::cout << label << ": ring " << steps << " about hex " << c << " has " << ring.size()
+                          << " hexes; expected " << ring_expected.size() << "\n";
+                rtn -= 1;
+            }
+            if (hexagon != hexagon_expected) {
+                std::cout << label << ": hexagon " << steps << " about hex " << c << " has " << hexagon.size()
+                          << " hexes; expected " << hexagon_expected.size() << "\n";
+                rtn -= 1;
+            }
+        }
+        // Include radii that fall exactly on rings of hex centres
+        for (const float radius : { 0.0f, d, 1.5f * d, 2.0f * d, 3.7f * d }) {
+            std::vector<std::int32_t> expected;
+            for (std::uint32_t i = 0; i < n; ++i) {
+                const double dx = (hg.d_x[i] - hg.d_x[c]) / d;
+                const double dy = (hg.d_y[i] - hg.d_y[c]) / d;
+                if (std::sqrt (dx * dx + dy * dy) <= radius / d + 1e-4) { expected.push_back (i); }
+            }
+            std::vector<std::int32_t> disc = hg.get_disc_indices (c, radius);
+            std::sort (disc.begin(), disc.end());
+            if (disc != expected) {
+                std::cout << label << ": disc of radius " << radius << " about hex " << c << " has " << disc.size()
+                          << " hexes; expected " << expected.size() << "\n";
+                rtn -= 1;
+            }
+        }
+    }
+
+    // A local average with the callback form matches the vector form
+    std::vector<double> u (n);
+    for (std::uint32_t i = 0; i < n; ++i) { u[i] = std::sin (7.0 * hg.d_x[i]) + hg.d_y[i]; }
+    for (const std::uint32_t c : { centre, east }) {
+        double sum_cb = 0.0;
+        std::uint32_t count_cb = 0;
+        hg.for_each_in_disc (c, 2.5f * d, [&](std::int32_t j) { sum_cb += u[j]; ++count_cb; });
+        double sum_vec = 0.0;
+        const std::vector<std::int32_t> disc = hg.get_disc_indices (c, 2.5f * d);
+        for (const std::int32_t j : disc) { sum_vec += u[j]; }
+        if (count_cb != disc.size() || sum_cb != sum_vec) {
+            std::cout << label << ": callback and vector forms of the disc query differ\n";
+            rtn -= 1;
+        }
+    }
+
+    return rtn;
+}
+
+int main()
+{
+    int rtn = 0;
+
+    sm::hexgrid hg (0.05f, 3.0f, 0.0f);
+    hg.set_elliptical_boundary (1.0f, 0.6f);
+    rtn += check_grid (hg, "list order");
+
+    // An interior ring is complete
+    std::uint32_t centre = 0;
+    for (std::uint32_t i = 0; i < hg.d_x.size(); ++i) { if (hg.d_ri[i] == 0 && hg.d_gi[i] == 0) { centre = i; } }
+    if (hg.get_ring_indices (centre, 4).size() != 24u || hg.get_hexagon_indices (centre, 4).size() != 61u) {
+        std::cout << "Interior ring or hexagon is incomplete\n";
+        rtn -= 1;
+    }
+    if (hg.d_index_at (1000, 1000) != -1) {
+        std::cout << "d_index_at found a hex off the grid\n";
+        rtn -= 1;
+    }
+
+    hg.reorder_d_vectors (sm::hexorder::hilbert);
+    rtn += check_grid (hg, "hilbert order");
+
+    std::cout << "Test " << (rtn == 0 ? "PASSED" : "FAILED") << std::endl;
+    return rtn;
+}
@@ -0,0 +1,154 @@
+// Test the hexgrid differential operators (laplacian, gradient, divergence and
+// diffusion_step) against straightforward per-hex computations on the d_ neighbour arrays,
+// and against analytic results for polynomial fields, on hexagonal and boundary-shaped
+// domains.
+
+#include <iostream>
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+import sm.hexgrid;
+import sm.vvec;
+import sm.mathconst;
+
+int check_grid (const sm::hexgrid& hg, const char* label)
+{
+    int rtn = 0;
+    const std::uint32_t n = hg.num();
+    sm::vvec<double> data (n);
+    data.randomize();
+    const double d = hg.get_d();
+
+    auto nbr = [&hg](const std::uint32_t i, const int k) -> std::int32_t {
+        const std::vector<std::int32_t>* nb[6] = { &hg.d_ne, &hg.d_nne, &hg.d_nnw, &hg.d_nw, &hg.d_nsw, &hg.d_nse };
+        return (*nb[k])[i];
+    };
+    auto val = [&nbr](const std::vector<double>& u, const std::uint32_t i, const int k) {
+        return nbr (i, k) >= 0 ? u[nbr (i, k)] : u[i];
+    };
+    auto interior = [&nbr](const std::uint32_t i) {
+        for (int k = 0; k < 6; ++k) { if (nbr (i, k) < 0) { return false; } }
+        return true;
+    };
+    const double ex[6] = { 1.0, 0.5, -0.5, -1.0, -0.5, 0.5 };
+    const double r32 = sm::mathconst<double>::root_3_over_2;
+    const double ey[6] = { 0.0, r32, r32, 0.0, -r32, -r32 };
+    auto close = [](const double a, const double b) { return std::abs (a - b) <= 1e-9 * (1.0 + std::abs (b)); };
+
+    std::vector<double> r1 (n);
+    std::vector<double> r2 (n);
+    std::vector<double> r3 (n);
+
+    // Laplacian (zero flux at edges)
+    hg.laplacian (data, r1);
+    for (std::uint32_t i = 0; i < n; ++i) {
+        double s = 0.0;
+        for (int k = 0; k < 6; ++k) { s += val (data, i, k) - data[i]; }
+        if (!close (r1[i], 2.0 * s / (3.0 * d * d))) { std::cout << label << ": laplacian differs at " << i << std::endl; ++rtn; break; }
+    }
+
+    // Gradient
+    hg.gradient (data, r1, r2);
+    for (std::uint32_t i = 0; i < n; ++i) {
+        double gx = 0.0;
+        double gy = 0.0;
+        for (int k = 0; k < 6; ++k) {
+            gx += (val (data, i, k) - data[i]) * ex[k];
+            gy += (val (data, i, k) - data[i]) * ey[k];
+        }
+        if (!close (r1[i], gx / (3.0 * d)) || !close (r2[i], gy / (3.0 * d))) {
+            std::cout << label << ": gradient differs at " << i << std::endl; ++rtn; break;
+        }
+    }
+
+    // Divergence of (data, r1)
+    hg.divergence (data, r1, r3);
+    for (std::uint32_t i = 0; i < n; ++i) {
+        double dv = 0.0;
+        for (int k = 0; k < 6; ++k) { dv += (val (data, i, k) - data[i]) * ex[k] + (val (r1, i, k) - r1[i]) * ey[k]; }
+        if (!close (r3[i], dv / (3.0 * d))) { std::cout << label << ": divergence differs at " << i << std::endl; ++rtn; break; }
+    }
+
+    // Analytic fields: lap(x^2 + y^2) = 4, grad(2x - 3y) = (2, -3), div(x, y) = 2, in the interior
+    std::vector<double> q (n);
+    std::vector<double> lin (n);
+    std::vector<double> xs (n);
+    std::vector<double> ys (n);
+    for (std::uint32_t i = 0; i < n; ++i) {
+        xs[i] = hg.d_x[i];
+        ys[i] = hg.d_y[i];
+        q[i] = xs[i] * xs[i] + ys[i] * ys[i];
+        lin[i] = 2.0 * xs[i] - 3.0 * ys[i];
+    }
+    hg.laplacian (q, r1);
+    hg.gradient (lin, r2, r3);
+    std::uint32_t n_bad = 0;
+    for (std::uint32_t i = 0; i < n; ++i) {
+        if (!interior (i)) { continue; }
+        if (std::abs (r1[i] - 4.0) > 1e-3 || std::abs (r2[i] - 2.0) > 1e-4 || std::abs (r3[i] + 3.0) > 1e-4) { ++n_bad; }
+    }
+    hg.divergence (xs, ys, r1);
+    for (std::uint32_t i = 0; i < n; ++i) { if (interior (i) && std::abs (r1[i] - 2.0) > 1e-4) { ++n_bad; } }
+    if (n_bad) { std::cout << label << ": " << n_bad << " interior hexes have wrong analytic derivatives\n"; ++rtn; }
+
+    // Diffusion conserves the total with zero flux boundaries, and the reaction term is added
+    const double D = 0.1;
+    const double dt = 0.2 * d * d / D;
+    hg.laplacian (data, r1);
+    hg.diffusion_step (data, r2, D, dt);
+    std::vector<double> f (n, 0.5);
+    hg.diffusion_step (data, f, r3, D, dt);
+    double sum0 = 0.0;
+    double sum1 = 0.0;
+    for (std::uint32_t i = 0; i < n; ++i) {
+        sum0 += data[i];
+        sum1 += r2[i];
+        if (!close (r2[i], data[i] + D * dt * r1[i]) || !close (r3[i], r2[i] + 0.5 * dt)) {
+            std::cout << label << ": diffusion_step differs at " << i << std::endl; ++rtn; break;
+        }
+    }
+    if (std::abs (sum1 - sum0) > 1e-9 * n) { std::cout << label << ": diffusion did not conserve the total\n"; ++rtn; }
+
+    // Aliased input and output is rejected
+    try {
+        hg.laplacian (data, data);
+        ++rtn;
+    } catch (const std::runtime_error&) {}
+
+    return rtn;
+}
+
+int main()
+{
+    int rtn = 0;
+
+    sm::hexgrid hg (0.02f, 2.0f, 0.0f);
+    // Before the d_ vectors are populated, the operators throw
+    try {
+        std::vector<double> a (hg.num(), 0.0);
+        std::vector<double> b (hg.num(), 0.0);
+        hg.laplacian (a, b);
+        ++rtn;
+    } catch (const std::runtime_error&) {}
+    hg.populate_d_vectors();
+    rtn += check_grid (hg, "hexagonal");
+
+    sm::hexgrid he (0.02f, 3.0f, 0.0f);
+    he.set_elliptical_boundary (1.0f, 0.6f);
+    rtn += check_grid (he, "ellipse");
+
+    // Cut the link between two interior hexes, in place. After update_stencil, both are
+    // edge hexes for the operators.
+    std::int32_t i = 0;
+    while (he.d_ne[i] < 0 || he.d_nne[i] < 0 || he.d_nnw[i] < 0 || he.d_nw[i] < 0 || he.d_nsw[i] < 0 || he.d_nse[i] < 0) { ++i; }
+    const std::int32_t j = he.d_ne[i];
+    he.d_ne[i] = -1;
+    he.d_nw[j] = -1;
+    he.update_stencil();
+    rtn += check_grid (he, "ellipse with a cut link");
+
+    std::cout << "Test " << (rtn ? "FAILED" : "PASSED") << std::endl;
+    return rtn;
+}
@@ -0,0 +1,108 @@
+// Test reordering the hexgrid d_ vectors along Hilbert and Morton curves: the d_ vectors must
+// stay consistent with the hexes, operators must give the same results once data is
+// permuted, and neighbours should end up closer together in memory.
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+import sm.hexgrid;
+import sm.bezcoord;
+
+// Check the d_ vectors against the hexes
+int check_consistent (const sm::hexgrid& hg, const char* label)
+{
+    std::uint32_t n_bad = 0;
+    for (const auto& hh : hg.hexen) {
+        const std::uint32_t i = hh.di;
+        if (hg.d_x[i] != hh.x || hg.d_y[i] != hh.y || hg.d_ri[i] != hh.ri || hg.d_gi[i] != hh.gi
+            || hg.d_vi[i] != hh.vi || hg.d_flags[i] != hh.get_flags()) { ++n_bad; }
+        if ((hh.has_ne() ? static_cast<std::int32_t>(hh.ne->di) : -1) != hg.d_ne[i]) { ++n_bad; }
+        if ((hh.has_nne() ? static_cast<std::int32_t>(hh.nne->di) : -1) != hg.d_nne[i]) { ++n_bad; }
+        if ((hh.has_nnw() ? static_cast<std::int32_t>(hh.nnw->di) : -1) != hg.d_nnw[i]) { ++n_bad; }
+        if ((hh.has_nw() ? static_cast<std::int32_t>(hh.nw->di) : -1) != hg.d_nw[i]) { ++n_bad; }
+        if ((hh.has_nsw() ? static_cast<std::int32_t>(hh.nsw->di) : -1) != hg.d_nsw[i]) { ++n_bad; }
+        if ((hh.has_nse() ? static_cast<std::int32_t>(hh.nse->di) : -1) != hg.d_nse[i]) { ++n_bad; }
+    }
+    if (n_bad) { std::cout << label << ": " << n_bad << " inconsistencies between d_ vectors and hexen\n"; }
+    return n_bad ? 1 : 0;
+}
+
+// The fraction of NNE/NSW neighbour pairs that lie within 32 elements of each other in the d_ vectors
+double near_fraction (const sm::hexgrid& hg)
+{
+    std::uint32_t near = 0;
+    std::uint32_t total = 0;
+    for (std::size_t i = 0; i < hg.d_x.size(); ++i) {
+        for (const std::int32_t j : { hg.d_nne[i], hg.d_nsw[i] }) {
+            if (j < 0) { continue; }
+            ++total;
+            if (std::abs (j - static_cast<std::int32_t>(i)) <= 32) { ++near; }
+        }
+    }
+    return static_cast<double>(near) / total;
+}
+
+int main()
+{
+    int rtn = 0;
+
+    sm::hexgrid hg (0.01f, 3.0f, 0.0f);
+    hg.set_elliptical_boundary (1.0f, 0.7f);
+    const std::uint32_t n = hg.num();
+
+    // Data indexed by vi, and its Laplacian computed in the original (list) order
+    std::vector<double> data (n);
+    for (const auto& hh : hg.hexen) { data[hh.vi] = std::sin (3.0 * hh.x) * std::cos (5.0 * hh.y); }
+    std::vector<double> lap0 (n);
+    hg.laplacian (data, lap0);
+    const double near_list = near_fraction (hg);
+
+    for (const sm::hexorder order : { sm::hexorder::hilbert, sm::hexorder::morton, sm::hexorder::list }) {
+        const char* label = order == sm::hexorder::hilbert ? "hilbert" : (order == sm::hexorder::morton ? "morton" : "list");
+        hg.reorder_d_vectors (order);
+        rtn += check_consistent (hg, label);
+
+        std::vector<double> data_d;
+        std::vector<double> lap_d (n);
+        std::vector<double> lap (n);
+        hg.to_d_order (data, data_d);
+        hg.laplacian (data_d, lap_d);
+        hg.from_d_order (lap_d, lap);
+        if (lap != lap0) { std::cout << label << ": laplacian changed when reordered\n"; ++rtn; }
+
+        if (order == sm::hexorder::list) {
+            for (std::uint32_t i = 0; i < n; ++i) { if (hg.d_vi[i] != i) { ++rtn; break; } }
+        } else {
+            const double near = near_fraction (hg);
+            if (near < near_list + 0.2) {
+                std::cout << label << ": " << near << " of neighbours are near in memory (list order: " << near_list << ")\n";
+                ++rtn;
+            }
+        }
+    }
+
+    // d_order set before the boundary is applied is kept by populate_d_vectors. get_region still
+    // returns the hexes (by vi) that it returns in list order.
+    sm::hexgrid h2 (0.01f, 3.0f, 0.0f);
+    h2.d_order = sm::hexorder::hilbert;
+    h2.set_elliptical_boundary (1.0f, 0.7f);
+    rtn += check_consistent (h2, "hilbert via d_order");
+    bool identity = true;
+    for (std::uint32_t i = 0; i < h2.d_vi.size(); ++i) { identity = identity && h2.d_vi[i] == i; }
+    if (identity) { std::cout << "d_order was not applied\n"; ++rtn; }
+    std::vector<sm::bezcoord<float>> region = h2.ellipse_compute (0.3f, 0.2f);
+    std::vector<sm::bezcoord<float>> region0 = region;
+    sm::vec<float, 2> c;
+    const std::size_t n_hilbert = h2.get_region (region, c, false).size();
+    const std::size_t n_list = hg.get_region (region0, c, false).size();
+    if (n_hilbert != n_list || n_list < 100u) {
+        std::cout << "get_region found " << n_hilbert << " hexes in hilbert order, " << n_list << " in list order\n";
+        ++rtn;
+    }
+
+    std::cout << "Test " << (rtn ? "FAILED" : "PASSED") << std::endl;
+    return rtn;
+}
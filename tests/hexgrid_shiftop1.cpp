@@ -0,0 +1,95 @@
+// Test the precomputed shift operators that hexgrid::shiftdata uses: the cached and
+// explicit operators must give the same result, a shift must conserve the data and move
+// it by the requested vector, and the cache must follow changes to the grid.
+
+#include <iostream>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+import sm.hexgrid;
+import sm.vvec;
+import sm.vec;
+
+int main()
+{
+    int rtn = 0;
+
+    sm::hexgrid hg (0.02f, 2.0f, 0.0f);
+    const float d = hg.get_d();
+
+    // A Gaussian bump in the middle of the grid
+    sm::vvec<double> bump (hg.num(), 0.0);
+    for (const auto& hh : hg.hexen) { bump[hh.vi] = std::exp (-(hh.x * hh.x + hh.y * hh.y) / 0.01); }
+    auto centroid = [&hg](const sm::vvec<double>& data)
+    {
+        sm::vec<double, 2> c = { 0.0, 0.0 };
+        for (const auto& hh : hg.hexen) {
+            c[0] += data[hh.vi] * hh.x;
+            c[1] += data[hh.vi] * hh.y;
+        }
+        return c / data.sum();
+    };
+
+    // A sub-hex shift and a shift of a few hexes plus a remainder
+    for (const sm::vec<float, 2> dx : { sm::vec<float, 2>{ 0.3f * d, -0.2f * d }, sm::vec<float, 2>{ 3.4f * d, 2.1f * d } }) {
+        sm::vvec<double> shifted = bump;
+        if (!hg.shiftdata (shifted, dx)) {
+            std::cout << "shiftdata failed for dx = " << dx << "\n";
+            rtn -= 1;
+            continue;
+        }
+        // The explicit operator must give exactly the same result
+        sm::hexgrid::shift_operator op = hg.make_shift_operator (dx);
+        sm::vvec<double> shifted2 = bump;
+        hg.shiftdata (shifted2, op);
+        if (shifted2 != shifted) {
+            std::cout << "Explicit shift operator differs from shiftdata for dx = " << dx << "\n";
+            rtn -= 1;
+        }
+        if (std::abs (shifted.sum() - bump.sum()) > 1e-5 * bump.sum()) {
+            std::cout << "Shift by " << dx << " changed the total from " << bump.sum() << " to " << shifted.sum() << "\n";
+            rtn -= 1;
+        }
+        sm::vec<double, 2> moved = centroid (shifted) - centroid (bump);
+        if (std::abs (moved[0] - dx[0]) > 0.05 * d || std::abs (moved[1] - dx[1]) > 0.05 * d) {
+            std::cout << "Shift by " << dx << " moved the centroid by " << moved << "\n";
+            rtn -= 1;
+        }
+    }
+
+    // Repeated requests for a shift come from the cache
+    const sm::vec<float, 2> dx0 = { 0.25f * d, 0.1f * d };
+    const sm::hexgrid::shift_operator* op0 = &hg.get_shift_operator (dx0);
+    hg.get_shift_operator (sm::vec<float, 2>{ -0.1f * d, 0.0f });
+    if (&hg.get_shift_operator (dx0) != op0) {
+        std::cout << "Shift operator was not reused from the cache\n";
+        rtn -= 1;
+    }
+
+    // Data of the wrong size is rejected
+    try {
+        sm::vvec<double> wrong (hg.num() + 1u, 0.0);
+        hg.shiftdata (wrong, *op0);
+        std::cout << "Expected an exception for data of the wrong size\n";
+        rtn -= 1;
+    } catch (const std::runtime_error&) {
+        // expected
+    }
+
+    // Changing the grid discards the cached operators
+    hg.set_elliptical_boundary (0.8f, 0.5f);
+    const sm::hexgrid::shift_operator& op1 = hg.get_shift_operator (dx0);
+    if (op1.row_start.size() != hg.num() + 1u) {
+        std::cout << "Cached shift operator was not rebuilt after the boundary changed\n";
+        rtn -= 1;
+    }
+    sm::vvec<double> clipped (hg.num(), 1.0);
+    if (!hg.shiftdata (clipped, dx0)) {
+        std::cout << "shiftdata failed on the clipped grid\n";
+        rtn -= 1;
+    }
+
+    std::cout << "Test " << (rtn == 0 ? "PASSED" : "FAILED") << std::endl;
+    return rtn;
+}
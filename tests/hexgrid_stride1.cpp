@@ -0,0 +1,161 @@
+// Test hexorder::rows: a parallelogram domain is regular (whole rows of d_rowlen hexes), its
+// interior runs have constant neighbour offsets, and the operators give the same results as in
+// list order, with and without parallelogram wrapping. A rectangle's rows are strided too.
+
+#include <iostream>
+#include <vector>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <atomic>
+#include <numeric>
+#include <algorithm>
+#include <type_traits>
+
+import sm.hexgrid;
+
+// The laplacian, gradient, divergence and a diffusion step of some data, indexed by vi
+std::array<std::vector<double>, 5> operators (const sm::hexgrid& hg)
+{
+    const std::uint32_t n = hg.num();
+    std::vector<double> u (n);
+    std::vector<double> v (n);
+    for (const auto& hh : hg.hexen) {
+        u[hh.vi] = std::sin (13.0 * hh.x) * std::cos (7.0 * hh.y) + hh.x;
+        v[hh.vi] = std::cos (5.0 * hh.x * hh.y);
+    }
+    std::vector<double> ud, vd;
+    hg.to_d_order (u, ud);
+    hg.to_d_order (v, vd);
+    std::array<std::vector<double>, 5> rd;
+    for (auto& r : rd) { r.resize (n); }
+    hg.laplacian (ud, rd[0]);
+    hg.gradient (ud, rd[1], rd[2]);
+    hg.divergence (ud, vd, rd[3]);
+    hg.diffusion_step (ud, rd[4], 0.1, 0.01);
+    std::array<std::vector<double>, 5> r;
+    for (std::size_t k = 0; k < 5; ++k) { hg.from_d_order (rd[k], r[k]); }
+    return r;
+}
+
+int compare (const std::array<std::vector<double>, 5>& a, const std::array<std::vector<double>, 5>& b, const char* label)
+{
+    int rtn = 0;
+    for (std::size_t k = 0; k < 5; ++k) {
+        double maxdiff = 0.0;
+        double maxval = 0.0;
+        for (std::size_t i = 0; i < a[k].size(); ++i) {
+            maxdiff = std::max (maxdiff, std::abs (a[k][i] - b[k][i]));
+            maxval = std::max (maxval, std::abs (a[k][i]));
+        }
+        if (maxdiff > 1e-12 * maxval) {
+            std::cout << label << ": operator " << k << " differs by " << maxdiff << "\n";
+            rtn -= 1;
+        }
+    }
+    return rtn;
+}
+
+// The number of hexes that apply_hex_stencil passes to interior_run with strided_neighbours
+std::uint32_t count_strided (const sm::hexgrid& hg)
+{
+    std::atomic<std::uint32_t> strided = 0;
+    hg.apply_hex_stencil (
+        [&strided](const std::int32_t i0, const std::int32_t i1, const auto nb)
+        {
+            if constexpr (std::is_same_v<std::decay_t<decltype(nb)>, sm::hexgrid::strided_neighbours>) { strided += i1 - i0; }
+        },
+        [](const std::int32_t) {});
+    return strided;
+}
+
+int main()
+{
+    int rtn = 0;
+
+    sm::hexgrid hl (0.02f, 1.0f, 0.0f);
+    hl.set_parallelogram_boundary (6, 4);
+    sm::hexgrid hr (0.02f, 1.0f, 0.0f);
+    hr.d_order = sm::hexorder::rows;
+    hr.set_parallelogram_boundary (6, 4);
+
+    if (hl.is_regular() || hl.d_rowlen != 0u) {
+        std::cout << "A parallelogram in list order should not be regular\n";
+        rtn -= 1;
+    }
+    if (!hr.is_regular() || hr.d_rowlen != 13u || hr.d_numrows != 9u || hr.d_size != hr.num()) {
+        std::cout << "Parallelogram in rows order: rowlen " << hr.d_rowlen << ", numrows " << hr.d_numrows << "\n";
+        rtn -= 1;
+    }
+    const std::int32_t rmin = *std::min_element (hr.d_ri.begin(), hr.d_ri.end());
+    const std::int32_t gmin = *std::min_element (hr.d_gi.begin(), hr.d_gi.end());
+    for (std::int32_t i = 0; i < static_cast<std::int32_t>(hr.num()); ++i) {
+        if (hr.d_ri[i] != rmin + i % 13 || hr.d_gi[i] != gmin + i / 13) {
+            std::cout << "Hex " << i << " is not at row " << i / 13 << ", column " << i % 13 << "\n";
+            rtn -= 1;
+            break;
+        }
+    }
+    // The 11 x 7 interior hexes, one run per row
+    if (count_strided (hr) != 77u || count_strided (hl) != 0u) {
+        std::cout << "Wrong number of strided hexes: " << count_strided (hr) << "\n";
+        rtn -= 1;
+    }
+    rtn += compare (operators (hl), operators (hr), "parallelogram");
+
+    // With wrapping, every hex has six neighbours; the row ends make short runs of their own
+    hl.set_parallelogram_wrap (true, true);
+    hr.set_parallelogram_wrap (true, true);
+    for (const sm::hexgrid* hg : { &hl, &hr }) {
+        for (std::uint32_t i = 0; i < hg->num(); ++i) {
+            if (hg->d_ne[i] < 0 || hg->d_nne[i] < 0 || hg->d_nnw[i] < 0 || hg->d_nw[i] < 0 || hg->d_nsw[i] < 0 || hg->d_nse[i] < 0) {
+                std::cout << "Hex " << i << " is missing a neighbour after wrapping\n";
+                rtn -= 1;
+                break;
+            }
+        }
+    }
+    if (hr.d_ne[12] != 0 || hr.d_nw[0] != 12 || hr.d_nsw[0] != 8 * 13 || count_strided (hr) != hr.num()) {
+        std::cout << "Wrapped rows: E of 12 is " << hr.d_ne[12] << ", " << count_strided (hr) << " strided\n";
+        rtn -= 1;
+    }
+    const std::array<std::vector<double>, 5> wl = operators (hl);
+    rtn += compare (wl, operators (hr), "wrapped parallelogram");
+    // On the torus the Laplacian sums to zero
+    const double total = std::accumulate (wl[0].begin(), wl[0].end(), 0.0);
+    double maxval = 0.0;
+    for (const double l : wl[0]) { maxval = std::max (maxval, std::abs (l)); }
+    if (std::abs (total) > 1e-9 * maxval * hl.num()) {
+        std::cout << "Wrapped Laplacian sums to " << total << "\n";
+        rtn -= 1;
+    }
+
+    // A rectangle's rows shift in ri, so the offsets differ from row to row, but are still
+    // constant along each row
+    sm::hexgrid rl (0.02f, 1.0f, 0.0f);
+    rl.set_rectangular_boundary (0.5f, 0.3f);
+    sm::hexgrid rr (0.02f, 1.0f, 0.0f);
+    rr.d_order = sm::hexorder::rows;
+    rr.set_rectangular_boundary (0.5f, 0.3f);
+    std::vector<std::uint32_t> rowlens (1, 1u);
+    for (std::uint32_t i = 1; i < rr.num(); ++i) {
+        if (rr.d_gi[i] == rr.d_gi[i - 1]) { ++rowlens.back(); } else { rowlens.push_back (1u); }
+    }
+    const bool equal_rows = std::all_of (rowlens.begin(), rowlens.end(), [&rowlens](std::uint32_t l) { return l == rowlens[0]; });
+    if (rr.is_regular() != equal_rows || (equal_rows && rr.d_rowlen != rowlens[0])) {
+        std::cout << "Rectangle: is_regular is " << rr.is_regular() << " for " << rowlens.size() << " rows\n";
+        rtn -= 1;
+    }
+    std::uint32_t interior = 0;
+    for (std::uint32_t i = 0; i < rr.num(); ++i) {
+        if (rr.d_ne[i] >= 0 && rr.d_nne[i] >= 0 && rr.d_nnw[i] >= 0 && rr.d_nw[i] >= 0 && rr.d_nsw[i] >= 0 && rr.d_nse[i] >= 0) { ++interior; }
+    }
+    if (interior == 0u || count_strided (rr) != interior) {
+        std::cout << "Rectangle: " << count_strided (rr) << " strided hexes of " << interior << " interior\n";
+        rtn -= 1;
+    }
+    rtn += compare (operators (rl), operators (rr), "rectangle");
+
+    std::cout << "Test " << (rtn == 0 ? "PASSED" : "FAILED") << std::endl;
+    return rtn;
+}
@@ -0,0 +1,159 @@
+// Test the tiled decomposition of a hexgrid: the tiles must cover the domain, their local
+// neighbour indices and halo exchange lists must be consistent, and diffusion stepped tile
+// by tile with halo exchange must match diffusion stepped on the whole grid, with one
+// executor or with two executors (standing in for two processes) sharing a transport.
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <cmath>
+#include <cstdint>
+
+import sm.hexgrid;
+import sm.hexgrid.tiles;
+
+// Check the decomposition against the hexgrid
+int check_decomposition (const sm::hexgrid& hg, const sm::hexgrid_tiles& dec)
+{
+    int rtn = 0;
+    const std::size_t n = hg.d_x.size();
+    std::vector<int> n_owners (n, 0);
+    const std::vector<std::int32_t>* gnb[6] = { &hg.d_ne, &hg.d_nne, &hg.d_nnw, &hg.d_nw, &hg.d_nsw, &hg.d_nse };
+    std::size_t n_halo = 0;
+    for (const sm::hextile& tile : dec.tiles) {
+        // Local index to d_ index
+        std::vector<std::uint32_t> global (tile.owned);
+        global.insert (global.end(), tile.halo.begin(), tile.halo.end());
+        n_halo += tile.halo.size();
+        for (std::size_t l = 0; l < tile.num_owned(); ++l) {
+            ++n_owners[tile.owned[l]];
+            for (int j = 0; j < 6; ++j) {
+                const std::int32_t gn = (*gnb[j])[tile.owned[l]];
+                const std::int32_t ln = tile.nb[j][l];
+                if ((gn < 0) != (ln < 0) || (gn >= 0 && global[ln] != static_cast<std::uint32_t>(gn))) { ++rtn; }
+            }
+        }
+        // The interior runs and edge hexes partition the owned hexes
+        std::size_t n_split = tile.edge.size();
+        for (const auto& run : tile.interior_runs) {
+            n_split += run[1] - run[0];
+            for (std::int32_t l = run[0]; l < run[1]; ++l) {
+                for (int j = 0; j < 6; ++j) { if (tile.nb[j][l] < 0) { ++rtn; } }
+            }
+        }
+        for (const std::int32_t l : tile.edge) {
+            bool all = true;
+            for (int j = 0; j < 6; ++j) { all = all && tile.nb[j][l] >= 0; }
+            if (all) { ++rtn; }
+        }
+        if (n_split != tile.num_owned()) { ++rtn; }
+        // Each recv must match the peer's send, hex for hex
+        for (const sm::hextile::exchange& rx : tile.recvs) {
+            bool matched = false;
+            for (const sm::hextile::exchange& tx : dec.tiles[rx.peer].sends) {
+                if (tx.peer != tile.id) { continue; }
+                matched = tx.local.size() == rx.local.size();
+                for (std::size_t i = 0; matched && i < tx.local.size(); ++i) {
+                    matched = dec.tiles[rx.peer].owned[tx.local[i]] == global[rx.local[i]];
+                }
+            }
+            if (!matched) { ++rtn; }
+        }
+    }
+    for (std::size_t i = 0; i < n; ++i) { if (n_owners[i] != 1) { ++rtn; break; } }
+    // Compact tiles have small halos
+    if (n_halo > n / 5) { std::cout << "halo of " << n_halo << " for " << n << " hexes is not compact\n"; ++rtn; }
+    if (rtn) { std::cout << "decomposition is inconsistent\n"; }
+    return rtn;
+}
+
+int main()
+{
+    int rtn = 0;
+
+    sm::hexgrid hg (0.01f, 3.0f, 0.0f);
+    hg.set_elliptical_boundary (1.0f, 0.7f);
+    const std::size_t n = hg.d_x.size();
+
+    const std::uint32_t n_tiles = 12;
+    sm::hexgrid_tiles dec (hg, n_tiles);
+    rtn += check_decomposition (hg, dec);
+
+    // Initial state and the reference result of diffusing on the whole grid
+    std::vector<double> u0 (n);
+    for (std::size_t i = 0; i < n; ++i) { u0[i] = std::exp (-10.0 * (hg.d_x[i] * hg.d_x[i] + 4.0 * hg.d_y[i] * hg.d_y[i])); }
+    const double D = 0.1;
+    const double dt = 0.25 * hg.get_d() * hg.get_d() / D;
+    const std::uint32_t n_steps = 40;
+    std::vector<double> ref = u0;
+    std::vector<double> tmp (n);
+    for (std::uint32_t s = 0; s < n_steps; ++s) {
+        hg.diffusion_step (ref, tmp, D, dt);
+        ref.swap (tmp);
+    }
+
+    // The same diffusion step for one tile, on local indices
+    const double k = D * dt * 2.0 / (3.0 * hg.get_d() * hg.get_d());
+    auto step = [k](const sm::hextile& tile, const std::vector<double>& u, std::vector<double>& un)
+    {
+        for (std::size_t i = 0; i < tile.num_owned(); ++i) {
+            double sum = 0.0;
+            double count = 0.0;
+            for (int j = 0; j < 6; ++j) {
+                const std::int32_t nb = tile.nb[j][i];
+                if (nb >= 0) {
+                    sum += u[nb];
+                    count += 1.0;
+                }
+            }
+            un[i] = u[i] + (sum - count * u[i]) * k;
+        }
+    };
+    auto compare = [&ref, n](const std::vector<double>& result, const char* label)
+    {
+        double maxdiff = 0.0;
+        for (std::size_t i = 0; i < n; ++i) { maxdiff = std::max (maxdiff, std::abs (result[i] - ref[i])); }
+        if (maxdiff > 1e-12) {
+            std::cout << label << ": tiled diffusion differs from whole grid diffusion by " << maxdiff << std::endl;
+            return 1;
+        }
+        return 0;
+    };
+
+    // One executor, four threads
+    {
+        std::vector<std::vector<double>> state;
+        dec.scatter (u0, state);
+        sm::local_transport<double> tr;
+        sm::tile_executor<double> ex (dec, tr, 4);
+        ex.run (state, n_steps, step);
+        std::vector<double> result;
+        dec.gather (state, result);
+        rtn += compare (result, "one executor");
+    }
+
+    // Two executors, each stepping half of the tiles, exchanging through one transport
+    {
+        std::vector<std::vector<double>> state;
+        dec.scatter (u0, state);
+        sm::local_transport<double> tr;
+        std::vector<std::uint32_t> a;
+        std::vector<std::uint32_t> b;
+        for (std::uint32_t t = 0; t < n_tiles; ++t) { (t < n_tiles / 2 ? a : b).push_back (t); }
+        sm::tile_executor<double> exa (dec, tr, 2, a);
+        sm::tile_executor<double> exb (dec, tr, 3, b);
+        std::thread other ([&]() { exb.run (state, n_steps, step); });
+        exa.run (state, n_steps, step);
+        other.join();
+        std::vector<double> result;
+        dec.gather (state, result);
+        rtn += compare (result, "two executors");
+    }
+
+    // A single tile has no halo
+    sm::hexgrid_tiles one (hg, 1);
+    if (!one.tiles[0].halo.empty() || one.tiles[0].num_owned() != n) { ++rtn; }
+
+    std::cout << "Test " << (rtn ? "FAILED" : "PASSED") << std::endl;
+    return rtn;
+}
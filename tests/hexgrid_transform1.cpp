@@ -0,0 +1,126 @@
+// Test hexgrid::transform, which moves d_x and d_y in place. The result must match
+// transforming each hex and rebuilding the d_ vectors, the other d_ vectors must be
+// unchanged, and in lazy mode the hexes must be brought up to date when they are needed.
+
+#include <iostream>
+#include <cstdint>
+#include <vector>
+
+import sm.hexgrid;
+import sm.mat;
+import sm.vec;
+
+// Transform every hex and rebuild the d_ vectors, as transform used to
+void transform_by_rebuild (sm::hexgrid& hg, const sm::mat<float, 4>& tf)
+{
+    for (auto& hh : hg.hexen) { hh.transform (tf); }
+    hg.populate_d_vectors();
+}
+
+int compare (const sm::hexgrid& a, const sm::hexgrid& b, const char* label)
+{
+    int rtn = 0;
+    if (a.d_x != b.d_x || a.d_y != b.d_y) {
+        std::cout << label << ": d_x or d_y differ\n";
+        rtn -= 1;
+    }
+    if (a.d_ri != b.d_ri || a.d_gi != b.d_gi || a.d_vi != b.d_vi || a.d_flags != b.d_flags
+        || a.d_ne != b.d_ne || a.d_nne != b.d_nne || a.d_nnw != b.d_nnw
+        || a.d_nw != b.d_nw || a.d_nsw != b.d_nsw || a.d_nse != b.d_nse
+        || a.d_dist_to_boundary != b.d_dist_to_boundary) {
+        std::cout << label << ": the other d_ vectors differ\n";
+        rtn -= 1;
+    }
+    auto ha = a.hexen.begin();
+    auto hb = b.hexen.begin();
+    for (; ha != a.hexen.end() && hb != b.hexen.end(); ++ha, ++hb) {
+        if (a.hex_position (*ha) != b.hex_position (*hb) || ha->di != hb->di) {
+            std::cout << label << ": hex " << ha->vi << " differs\n";
+            rtn -= 1;
+            break;
+        }
+    }
+    return rtn;
+}
+
+int main()
+{
+    int rtn = 0;
+
+    sm::mat<float, 4> tf;
+    tf.translate (sm::vec<float>{ 0.013f, -0.021f, 0.0f });
+    tf.rotate (sm::vec<float>{ 0.0f, 0.0f, 1.0f }, 0.4f);
+
+    for (const sm::hexorder order : { sm::hexorder::list, sm::hexorder::hilbert }) {
+        sm::hexgrid hg (0.02f, 2.0f, 0.0f);
+        hg.d_order = order;
+        hg.set_circular_boundary (0.5f);
+        hg.compute_distance_to_boundary();
+        sm::hexgrid ref (0.02f, 2.0f, 0.0f);
+        ref.d_order = order;
+        ref.set_circular_boundary (0.5f);
+        ref.compute_distance_to_boundary();
+
+        // Two transforms in a row, as transforms are applied to the current positions
+        const std::vector<std::int32_t> nne0 = hg.d_nne;
+        hg.transform (tf);
+        hg.transform (tf);
+        transform_by_rebuild (ref, tf);
+        transform_by_rebuild (ref, tf);
+        rtn += compare (hg, ref, "eager");
+        if (!hg.hexen_synced()) {
+            std::cout << "hexen were not updated by an eager transform\n";
+            rtn -= 1;
+        }
+        for (const auto& hh : hg.hexen) {
+            if (hh.x != hg.d_x[hh.di] || hh.y != hg.d_y[hh.di]) {
+                std::cout << "Hex " << hh.vi << " is not at its d_x, d_y\n";
+                rtn -= 1;
+                break;
+            }
+        }
+        if (hg.d_nne != nne0) {
+            std::cout << "A transform changed d_nne\n";
+            rtn -= 1;
+        }
+
+        // In lazy mode, only d_x and d_y move until the hexes are needed
+        hg.lazy_transform = true;
+        const sm::vec<float, 2> h0 = { hg.hexen.front().x, hg.hexen.front().y };
+        hg.transform (tf);
+        transform_by_rebuild (ref, tf);
+        if (hg.hexen_synced() || hg.hexen.front().x != h0[0] || hg.hexen.front().y != h0[1]) {
+            std::cout << "A lazy transform moved the hexes\n";
+            rtn -= 1;
+        }
+        rtn += compare (hg, ref, "lazy");
+        if (hg.width() != ref.width() || hg.depth() != ref.depth()) {
+            std::cout << "Extents differ after a lazy transform\n";
+            rtn -= 1;
+        }
+
+        // find_hex_nearest brings the hexes up to date
+        const auto hn = hg.find_hex_nearest (sm::vec<float, 2>{ 0.1f, 0.1f });
+        const auto rn = ref.find_hex_nearest (sm::vec<float, 2>{ 0.1f, 0.1f });
+        if (!hg.hexen_synced() || hn->vi != rn->vi) {
+            std::cout << "find_hex_nearest did not sync the hexes\n";
+            rtn -= 1;
+        }
+        rtn += compare (hg, ref, "synced");
+
+        // A new boundary after a lazy transform uses the transformed positions
+        hg.transform (tf);
+        transform_by_rebuild (ref, tf);
+        hg.set_elliptical_boundary (0.4f, 0.3f);
+        ref.set_elliptical_boundary (0.4f, 0.3f);
+        if (hg.num() != ref.num()) {
+            std::cout << "Boundaries applied after a lazy transform differ\n";
+            rtn -= 1;
+        } else {
+            rtn += compare (hg, ref, "new boundary");
+        }
+    }
+
+    std::cout << "Test " << (rtn == 0 ? "PASSED" : "FAILED") << std::endl;
+    return rtn;
+}
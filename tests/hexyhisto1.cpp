@@ -0,0 +1,117 @@
+// Test sm::hexyhisto against a histogram made by searching the whole grid for each
+// point's nearest hex, on a grid at its lattice positions and on a transformed grid. Also
+// test weighted counts and adding points in several batches.
+
+#include <iostream>
+#include <cstdint>
+#include <cmath>
+
+import sm.hexyhisto;
+import sm.hexgrid;
+import sm.mat;
+import sm.vvec;
+import sm.vec;
+import sm.random;
+
+// The histogram as defined by hexyhisto: each point counts in its nearest hex, if that is
+// no further than get_v() away
+template <typename T>
+sm::vvec<T> reference_counts (sm::hexgrid& hg, const sm::vvec<sm::vec<T>>& data, const sm::vvec<T>* weights, T& total)
+{
+    sm::vvec<T> counts (hg.num(), T{0});
+    total = T{0};
+    for (std::size_t k = 0; k < data.size(); ++k) {
+        if (data[k][2] < T{0}) { continue; }
+        auto hi = hg.find_hex_nearest (data[k].less_one_dim().as_float());
+        sm::vec<T, 2> hipos = { static_cast<T>(hi->x), static_cast<T>(hi->y) };
+        if ((hipos - data[k].less_one_dim()).length() <= hg.get_v()) {
+            const T w = weights == nullptr ? T{1} : (*weights)[k];
+            counts[hi->vi] += w;
+            total += w;
+        }
+    }
+    return counts;
+}
+
+// Random points over and around the grid, some flagged to be ignored, plus points at hex
+// centres and at the midpoints between neighbouring hexes (where two hexes are equally near)
+template <typename T>
+sm::vvec<sm::vec<T>> make_points (const sm::hexgrid& hg, const std::uint32_t n_random)
+{
+    sm::rand_uniform<T> rng (T{-0.7}, T{0.7}, 42);
+    sm::rand_uniform<T> flag (T{-0.1}, T{1}, 43);
+    sm::vvec<sm::vec<T>> data;
+    for (std::uint32_t k = 0; k < n_random; ++k) { data.push_back ({ rng.get(), rng.get(), flag.get() }); }
+    for (std::size_t i = 0; i < hg.d_x.size(); i += 7) {
+        data.push_back ({ hg.d_x[i], hg.d_y[i], T{0} });
+        if (hg.d_ne[i] >= 0) {
+            data.push_back ({ (hg.d_x[i] + hg.d_x[hg.d_ne[i]]) / T{2}, (hg.d_y[i] + hg.d_y[hg.d_ne[i]]) / T{2}, T{0} });
+        }
+    }
+    return data;
+}
+
+template <typename T>
+int check (sm::hexgrid& hg, const char* label)
+{
+    int rtn = 0;
+    const sm::vvec<sm::vec<T>> data = make_points<T> (hg, 20000);
+
+    // Unweighted counts and proportions are exactly those of the reference
+    T ref_total = T{0};
+    const sm::vvec<T> ref = reference_counts (hg, data, static_cast<const sm::vvec<T>*>(nullptr), ref_total);
+    sm::vvec<T> ref_prop = ref;
+    ref_prop /= ref_total;
+    sm::hexyhisto<T> hh (data, &hg);
+    if (hh.counts != ref || hh.datacount != ref_total || hh.proportions != ref_prop) {
+        std::cout << label << ": counts differ from the reference (datacount " << hh.datacount << " vs " << ref_total << ")\n";
+        rtn -= 1;
+    }
+
+    // Adding the points in two batches gives the same result
+    sm::vvec<sm::vec<T>> first (data.begin(), data.begin() + data.size() / 3);
+    sm::vvec<sm::vec<T>> second (data.begin() + data.size() / 3, data.end());
+    sm::hexyhisto<T> hh2 (&hg);
+    hh2.add (first);
+    hh2.add (second);
+    if (hh2.counts != ref || hh2.datacount != ref_total) {
+        std::cout << label << ": counts made in two batches differ from the reference\n";
+        rtn -= 1;
+    }
+
+    // Weighted counts
+    sm::vvec<T> weights (data.size());
+    for (std::size_t k = 0; k < data.size(); ++k) { weights[k] = T{0.5} + static_cast<T>(k % 5); }
+    T wref_total = T{0};
+    const sm::vvec<T> wref = reference_counts (hg, data, &weights, wref_total);
+    sm::hexyhisto<T> hhw (&hg);
+    hhw.add (data, weights);
+    if ((hhw.counts - wref).abs().max() > T{1e-4} * wref.max() || std::abs (hhw.datacount - wref_total) > T{1e-5} * wref_total) {
+        std::cout << label << ": weighted counts differ from the reference\n";
+        rtn -= 1;
+    }
+
+    return rtn;
+}
+
+int main()
+{
+    int rtn = 0;
+
+    sm::hexgrid hg (0.03f, 2.0f, 0.0f);
+    hg.set_circular_boundary (0.5f);
+    rtn += check<float> (hg, "float");
+    rtn += check<double> (hg, "double");
+
+    // In a transformed grid the hexes are no longer at their lattice positions
+    sm::hexgrid hgt (0.03f, 2.0f, 0.0f);
+    hgt.set_circular_boundary (0.5f);
+    sm::mat<float, 4> tf;
+    tf.translate (sm::vec<float>{ 0.011f, -0.007f, 0.0f });
+    tf.rotate (sm::vec<float>{ 0.0f, 0.0f, 1.0f }, 0.3f);
+    hgt.transform (tf);
+    rtn += check<float> (hgt, "transformed");
+
+    std::cout << "Test " << (rtn == 0 ? "PASSED" : "FAILED") << std::endl;
+    return rtn;
+}
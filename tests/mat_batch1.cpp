@@ -0,0 +1,108 @@
+// Test sm::mat_batch against the equivalent per-matrix sm::mat operations
+
+#include <iostream>
+#include <complex>
+#include <array>
+
+import sm.vec;
+import sm.vvec;
+import sm.mat;
+import sm.mat_batch;
+import sm.random;
+
+template <typename F, std::uint32_t N>
+int test_batch (const std::size_t nmats)
+{
+    int rtn = 0;
+    constexpr F tol = F{1e-9};
+
+    sm::rand_uniform<F> rng (F{-2}, F{2}, 1234);
+    sm::mat_batch<F, N> mb (nmats);
+
+    // Freshly created batch holds identity matrices
+    for (std::size_t i = 0; i < nmats; ++i) {
+        if (mb.get (i) != sm::mat<F, N>::identity()) { ++rtn; }
+    }
+
+    std::vector<sm::mat<F, N>> mats (nmats);
+    for (std::size_t i = 0; i < nmats; ++i) {
+        for (std::uint32_t k = 0; k < N * N; ++k) { mats[i][k] = rng.get(); }
+        // Make some matrices symmetric (real eigenvalues) and one singular
+        if (i % 3 == 0) { mats[i] = mats[i] + mats[i].transpose(); }
+        if (i == 5) { mats[i].set_zero(); }
+        mb.set (i, mats[i]);
+    }
+    // Element (r, c) arrays hold the same element of every matrix
+    if (mb.element (1, 0)[7] != mats[7](1, 0)) { ++rtn; }
+
+    // Determinants
+    sm::vvec<F> dets = mb.determinant();
+    for (std::size_t i = 0; i < nmats; ++i) {
+        if (std::abs (dets[i] - mats[i].determinant()) > tol) {
+            std::cout << "determinant " << i << " differs: " << dets[i] << " vs " << mats[i].determinant() << std::endl;
+            ++rtn;
+        }
+    }
+
+    // Inverses
+    sm::mat_batch<F, N> inv = mb.inverse();
+    for (std::size_t i = 0; i < nmats; ++i) {
+        if ((inv.get (i).arr - mats[i].inverse().arr).abs().max() > tol) {
+            std::cout << "inverse " << i << " differs" << std::endl;
+            ++rtn;
+        }
+    }
+
+    // Solve A x = b
+    sm::vvec<sm::vec<F, N>> b (nmats);
+    for (auto& bi : b) { for (auto& bij : bi) { bij = rng.get(); } }
+    sm::vvec<sm::vec<F, N>> x = mb.solve (b);
+    for (std::size_t i = 0; i < nmats; ++i) {
+        if (i == 5) {
+            if (x[i].abs().max() != F{0}) { ++rtn; }
+            continue;
+        }
+        if (((mats[i] * x[i]) - b[i]).abs().max() > F{1e-6}) {
+            std::cout << "solve " << i << " differs: A x = " << (mats[i] * x[i]) << " vs b = " << b[i] << std::endl;
+            ++rtn;
+        }
+    }
+
+    // Eigenvalues, compared with mat::eigenvalues
+    sm::vvec<sm::vec<std::complex<F>, N>> ev = mb.eigenvalues();
+    for (std::size_t i = 0; i < nmats; ++i) {
+        sm::vec<std::complex<F>, N> ev_ref = mats[i].eigenvalues();
+        for (std::uint32_t j = 0; j < N; ++j) {
+            if (std::abs (ev[i][j] - ev_ref[j]) > F{1e-6}) {
+                std::cout << "eigenvalues " << i << " differ: " << ev[i] << " vs " << ev_ref << std::endl;
+                ++rtn;
+                break;
+            }
+        }
+    }
+
+    return rtn;
+}
+
+int main()
+{
+    int rtn = 0;
+
+    rtn += test_batch<double, 2> (100);
+    rtn += test_batch<double, 3> (100);
+
+    // Inputs with known eigenvalues: a rotation has a complex conjugate pair
+    sm::mat_batch<double, 2> rb (1);
+    rb.set (0, sm::mat<double, 2>{ 0.0, 1.0, -1.0, 0.0 });
+    std::array<sm::vvec<double>, 2> re;
+    std::array<sm::vvec<double>, 2> im;
+    rb.eigenvalues (re, im);
+    if (re[0][0] != 0.0 || re[1][0] != 0.0 || im[0][0] != -1.0 || im[1][0] != 1.0) { ++rtn; }
+
+    // Float batches
+    sm::mat_batch<float, 3> fb (4);
+    if (fb.determinant().sum() != 4.0f) { ++rtn; }
+
+    std::cout << "Test " << (rtn ? "FAILED" : "PASSED") << std::endl;
+    return rtn;
+}
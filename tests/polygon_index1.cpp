@@ -0,0 +1,153 @@
+// Test sm::polygon_index against a brute force winding number, and its use in
+// hexgrid::get_region and cartgrid::get_region
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <type_traits>
+
+import sm.polygon_index;
+import sm.hexgrid;
+import sm.cartgrid;
+import sm.bezcoord;
+import sm.vec;
+import sm.random;
+import sm.mathconst;
+
+using path_t = std::vector<sm::vec<float, 2>>;
+
+// Sunday's winding number, visiting every edge
+int brute_wind (const path_t& path, const float x, const float y)
+{
+    int wn = 0;
+    for (std::size_t i = 0; i < path.size(); ++i) {
+        const sm::vec<float, 2>& p = path[i];
+        const sm::vec<float, 2>& q = path[(i + 1) % path.size()];
+        const float is_left = (q[0] - p[0]) * (y - p[1]) - (x - p[0]) * (q[1] - p[1]);
+        if (p[1] <= y) {
+            if (q[1] > y && is_left > 0.0f) { ++wn; }
+        } else {
+            if (q[1] <= y && is_left < 0.0f) { --wn; }
+        }
+    }
+    return wn;
+}
+
+// Check n random points, singly and as a batch
+int check_random (const path_t& path, const char* label, const std::uint32_t n_slabs = 0)
+{
+    int rtn = 0;
+    sm::polygon_index<float> pi (path, n_slabs);
+    sm::rand_uniform<float> rng (-1.5f, 1.5f, 17);
+    std::vector<float> xs = rng.get (20000);
+    std::vector<float> ys = rng.get (20000);
+    // Some query points exactly on the rows of the path vertices
+    for (std::size_t i = 0; i < path.size(); ++i) { ys[i] = path[i][1]; }
+
+    std::vector<int> w;
+    pi.wind (xs, ys, w);
+    std::vector<std::uint8_t> inside;
+    pi.contains (xs, ys, inside);
+    std::uint32_t n_bad = 0;
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        const int bw = brute_wind (path, xs[i], ys[i]);
+        if (pi.wind (xs[i], ys[i]) != bw || w[i] != bw || (inside[i] != 0) != (bw != 0)) { ++n_bad; }
+    }
+    if (n_bad) {
+        std::cout << label << ": " << n_bad << " points have the wrong winding number\n";
+        ++rtn;
+    }
+    return rtn;
+}
+
+// The region must be exactly the elements under the path plus those whose centres are inside it
+template <typename G>
+int check_region (G& g, const path_t& path, const char* label)
+{
+    std::vector<sm::bezcoord<float>> bpoints;
+    for (const auto& p : path) { bpoints.emplace_back (p); }
+    sm::vec<float, 2> centroid;
+    auto region = g.get_region (bpoints, centroid, false);
+
+    std::uint32_t n_expected = 0;
+    std::uint32_t n_wrong = 0;
+    auto check = [&](const auto& el, const bool on_path, const bool in_region) {
+        const bool expected = on_path || brute_wind (path, el.x, el.y) != 0;
+        if (expected) { ++n_expected; }
+        if (expected != in_region) { ++n_wrong; }
+    };
+    if constexpr (std::is_same_v<G, sm::hexgrid>) {
+        for (const auto& h : g.hexen) {
+            check (h, h.test_flags (sm::HEX_IS_REGION_BOUNDARY), h.test_flags (sm::HEX_INSIDE_REGION));
+        }
+    } else {
+        for (const auto& r : g.rects) {
+            check (r, r.test_flags (sm::RECT_IS_REGION_BOUNDARY), r.test_flags (sm::RECT_INSIDE_REGION));
+        }
+    }
+    if (n_wrong || region.size() != n_expected || region.size() < 100u) {
+        std::cout << label << ": region has " << region.size() << " elements (expected "
+                  << n_expected << "), " << n_wrong << " wrongly classified\n";
+        return 1;
+    }
+    return 0;
+}
+
+int main()
+{
+    int rtn = 0;
+
+    // A unit square
+    path_t sq = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+    sm::polygon_index<float> psq (sq);
+    if (psq.wind (0.5f, 0.5f) != 1 || psq.contains (1.5f, 0.5f) || psq.contains (0.5f, -0.1f)) { ++rtn; }
+
+    // The same square, clockwise
+    path_t sqcw (sq.rbegin(), sq.rend());
+    if (sm::polygon_index<float>(sqcw).wind (0.5f, 0.5f) != -1) { ++rtn; }
+
+    // A pentagram, traced as a single self-intersecting path. Its centre has winding number 2.
+    path_t star;
+    for (int i = 0; i < 5; ++i) {
+        const float a = sm::mathconst<float>::pi_over_2 + i * 4.0f * sm::mathconst<float>::pi / 5.0f;
+        star.push_back ({ std::cos (a), std::sin (a) });
+    }
+    sm::polygon_index<float> pstar (star);
+    if (pstar.wind (0.0f, 0.0f) != 2 || pstar.wind (0.0f, 0.8f) != 1) {
+        std::cout << "pentagram winding numbers are wrong\n";
+        ++rtn;
+    }
+    rtn += check_random (star, "pentagram");
+
+    // A finely sampled 'C', with many vertices lying on the same rows
+    path_t cpath;
+    const path_t corners = {
+        { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, -0.5f }, { -0.5f, -0.5f },
+        { -0.5f, 0.5f }, { 1.0f, 0.5f }, { 1.0f, 1.0f }, { -1.0f, 1.0f }
+    };
+    for (std::size_t i = 0; i < corners.size(); ++i) {
+        const sm::vec<float, 2> a = corners[i];
+        const sm::vec<float, 2> b = corners[(i + 1) % corners.size()];
+        const int n = static_cast<int>((b - a).length() / 0.01f);
+        for (int k = 0; k < n; ++k) { cpath.push_back (a + (b - a) * (static_cast<float>(k) / n)); }
+    }
+    rtn += check_random (cpath, "C shape");
+    rtn += check_random (cpath, "C shape, 3 slabs", 3);
+
+    // Degenerate paths contain nothing
+    if (sm::polygon_index<float>(path_t{ { 0.0f, 0.0f }, { 1.0f, 0.0f } }).contains (0.5f, 0.0f)) { ++rtn; }
+
+    // get_region on a region whose centroid lies outside it
+    {
+        sm::hexgrid hg (0.02f, 3.0f, 0.0f);
+        rtn += check_region (hg, cpath, "hexgrid C region");
+    }
+    {
+        sm::cartgrid cg (0.02f, 3.0f, 0.0f);
+        rtn += check_region (cg, cpath, "cartgrid C region");
+    }
+
+    std::cout << "Test " << (rtn ? "FAILED" : "PASSED") << std::endl;
+    return rtn;
+}
@@ -0,0 +1,131 @@
+// Test the batch (structure of arrays) polynomial solvers in sm::polysolve against the single
+// polynomial solvers
+
+#include <iostream>
+#include <complex>
+#include <vector>
+#include <array>
+#include <span>
+#include <cmath>
+
+import sm.polysolve;
+import sm.random;
+
+// Compare batch roots (re[j][i], im[j][i]) with those from the single polynomial solver
+template <typename T, std::size_t K>
+int compare (const std::array<std::vector<T>, K>& re, const std::array<std::vector<T>, K>& im,
+             const std::vector<std::vector<std::complex<T>>>& expected, const T tol)
+{
+    int errs = 0;
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        for (std::size_t j = 0; j < K; ++j) {
+            if (std::abs (std::complex<T>{ re[j][i], im[j][i] } - expected[i][j]) > tol) {
+                std::cout << "Polynomial " << i << " root " << j << ": (" << re[j][i] << "," << im[j][i]
+                          << ") vs expected " << expected[i][j] << std::endl;
+                ++errs;
+            }
+        }
+    }
+    return errs;
+}
+
+int main()
+{
+    int rtn = 0;
+
+    using T = double;
+    constexpr std::size_t n = 1000;
+    constexpr T tol = 1e-8;
+    sm::rand_uniform<T> rng (T{-5}, T{5}, 4321);
+
+    std::array<std::vector<T>, 5> a;
+    for (auto& ai : a) { ai = rng.get (n); }
+    // Make some leading coefficients larger
+    for (std::size_t i = 0; i < n; i += 7) { a[0][i] = a[0][i] * T{10}; }
+
+    // Quadratics
+    {
+        std::array<std::vector<T>, 2> re = { std::vector<T>(n), std::vector<T>(n) };
+        std::array<std::vector<T>, 2> im = re;
+        sm::polysolve::quadratic<T> (a[0], a[1], a[2], { re[0], re[1] }, { im[0], im[1] });
+        std::vector<std::vector<std::complex<T>>> expected (n);
+        for (std::size_t i = 0; i < n; ++i) { expected[i] = sm::polysolve::quadratic<T> (a[0][i], a[1][i], a[2][i]); }
+        rtn += compare<T, 2> (re, im, expected, tol);
+
+        // Real roots only
+        std::array<std::vector<T>, 2> rr = re;
+        sm::polysolve::quadratic_real<T> (a[0], a[1], a[2], { rr[0], rr[1] });
+        for (std::size_t i = 0; i < n; ++i) {
+            std::vector<T> rexp = sm::polysolve::real<T> (std::vector<T>{ a[2][i], a[1][i], a[0][i] });
+            for (std::size_t j = 0; j < 2; ++j) {
+                if (j < rexp.size() && std::abs (rr[j][i] - rexp[j]) > tol) { ++rtn; }
+                if (j >= rexp.size() && !std::isnan (rr[j][i])) { ++rtn; }
+            }
+        }
+    }
+
+    // Cubics, sorted and unsorted
+    {
+        std::array<std::vector<T>, 3> re = { std::vector<T>(n), std::vector<T>(n), std::vector<T>(n) };
+        std::array<std::vector<T>, 3> im = re;
+        sm::polysolve::cubic<T> (a[0], a[1], a[2], a[3], { re[0], re[1], re[2] }, { im[0], im[1], im[2] });
+        std::vector<std::vector<std::complex<T>>> expected (n);
+        for (std::size_t i = 0; i < n; ++i) { expected[i] = sm::polysolve::cubic<T> (a[0][i], a[1][i], a[2][i], a[3][i]); }
+        rtn += compare<T, 3> (re, im, expected, tol);
+
+        // Unsorted roots are the same set, in some order
+        std::array<std::vector<T>, 3> ure = re;
+        std::array<std::vector<T>, 3> uim = im;
+        sm::polysolve::cubic<T> (a[0], a[1], a[2], a[3], { ure[0], ure[1], ure[2] }, { uim[0], uim[1], uim[2] }, false);
+        for (std::size_t i = 0; i < n; ++i) {
+            std::vector<std::complex<T>> u = { { ure[0][i], uim[0][i] }, { ure[1][i], uim[1][i] }, { ure[2][i], uim[2][i] } };
+            sm::polysolve::sort_roots (u);
+            for (std::size_t j = 0; j < 3; ++j) { if (std::abs (u[j] - expected[i][j]) > tol) { ++rtn; } }
+        }
+
+        // Known real roots: (x - 1)(x - 2)(x - 3) and (x - 1)(x^2 + 1)
+        std::vector<T> c3 = { 1, 1 };
+        std::vector<T> c2 = { -6, -1 };
+        std::vector<T> c1 = { 11, 1 };
+        std::vector<T> c0 = { -6, -1 };
+        std::array<std::vector<T>, 3> rr = { std::vector<T>(2), std::vector<T>(2), std::vector<T>(2) };
+        sm::polysolve::cubic_real<T> (c3, c2, c1, c0, { rr[0], rr[1], rr[2] });
+        if (std::abs (rr[0][0] - 1) > tol || std::abs (rr[1][0] - 2) > tol || std::abs (rr[2][0] - 3) > tol) { ++rtn; }
+        if (std::abs (rr[0][1] - 1) > tol || !std::isnan (rr[1][1]) || !std::isnan (rr[2][1])) { ++rtn; }
+    }
+
+    // Quartics
+    {
+        std::array<std::vector<T>, 4> re = { std::vector<T>(n), std::vector<T>(n), std::vector<T>(n), std::vector<T>(n) };
+        std::array<std::vector<T>, 4> im = re;
+        sm::polysolve::quartic<T> (a[0], a[1], a[2], a[3], a[4], { re[0], re[1], re[2], re[3] }, { im[0], im[1], im[2], im[3] });
+        std::vector<std::vector<std::complex<T>>> expected (n);
+        for (std::size_t i = 0; i < n; ++i) {
+            expected[i] = sm::polysolve::quartic<T> (a[0][i], a[1][i], a[2][i], a[3][i], a[4][i]);
+        }
+        rtn += compare<T, 4> (re, im, expected, tol);
+
+        std::array<std::vector<T>, 4> rr = re;
+        sm::polysolve::quartic_real<T> (a[0], a[1], a[2], a[3], a[4], { rr[0], rr[1], rr[2], rr[3] });
+        for (std::size_t i = 0; i < n; ++i) {
+            // The real roots precede any NaNs and are ascending
+            bool seen_nan = false;
+            for (std::size_t j = 0; j < 4; ++j) {
+                if (std::isnan (rr[j][i])) { seen_nan = true; }
+                else if (seen_nan || (j > 0 && rr[j][i] < rr[j - 1][i])) { ++rtn; }
+            }
+        }
+    }
+
+    // Mismatched sizes throw
+    try {
+        std::vector<T> small (3);
+        std::vector<T> r0 (n);
+        std::vector<T> r1 (n);
+        sm::polysolve::quadratic_real<T> (a[0], a[1], small, { r0, r1 });
+        ++rtn;
+    } catch (const std::invalid_argument&) {}
+
+    std::cout << "Test " << (rtn ? "FAILED" : "PASSED") << std::endl;
+    return rtn;
+}
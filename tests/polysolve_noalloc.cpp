@@ -0,0 +1,114 @@
+// Check that the fixed degree polysolve functions and mat::eigenvalues do not allocate, and that
+// they can be evaluated at compile time.
+
+#include <iostream>
+#include <complex>
+#include <array>
+#include <vector>
+#include <cstdlib>
+#include <new>
+
+import sm.vec;
+import sm.mat;
+import sm.polysolve;
+
+// Count every global allocation made by the program
+static std::size_t n_allocs = 0;
+
+void* operator new (std::size_t sz)
+{
+    ++n_allocs;
+    if (void* p = std::malloc (sz ? sz : 1)) { return p; }
+    throw std::bad_alloc{};
+}
+void operator delete (void* p) noexcept { std::free (p); }
+void operator delete (void* p, std::size_t) noexcept { std::free (p); }
+
+// x^2 - 5x + 6 = 0 has roots 2 and 3
+constexpr std::array<std::complex<double>, 2> constexpr_quadratic()
+{
+    return sm::polysolve::solve_fixed<double, 2> (std::array<double, 3>{ 6.0, -5.0, 1.0 });
+}
+
+// The eigenvalues of a symmetric 3x3 matrix
+constexpr sm::vec<std::complex<double>, 3> constexpr_eigenvalues()
+{
+    sm::mat<double, 3> m = { 2.0, 1.0, 0.0,  1.0, 2.0, 0.0,  0.0, 0.0, 5.0 };
+    return m.eigenvalues();
+}
+
+int main()
+{
+    int rtn = 0;
+
+    sm::mat<double, 2> m2 = { 4.0, 1.0, 2.0, 3.0 };
+    sm::mat<double, 3> m3 = { 2.0, -1.0, 0.0,  -1.0, 2.0, -1.0,  0.0, -1.0, 2.0 };
+    sm::mat<double, 4> m4 = { 2.0, 0.0, 0.0, 0.0,  0.0, 3.0, 0.0, 0.0,  0.0, 0.0, 5.0, 0.0,  0.0, 0.0, 0.0, 7.0 };
+    sm::mat<float, 4> mr = sm::mat<float, 4>::identity();
+    mr.rotate (sm::vec<float, 3>{ 1.0f, 1.0f, 0.0f }, 0.6f);
+
+    std::array<double, 4> cubic_coeffs = { -6.0, 11.0, -6.0, 1.0 };        // (x-1)(x-2)(x-3)
+    std::array<double, 5> quartic_coeffs = { 4.0, 0.0, -5.0, 0.0, 1.0 };   // (x^2-1)(x^2-4)
+    std::array<double, 6> quintic_coeffs = { -120.0, 274.0, -225.0, 85.0, -15.0, 1.0 }; // (x-1)...(x-5)
+    std::array<double, 5> degenerate_coeffs = { 2.0, 1.0, 0.0, 0.0, 0.0 }; // x + 2, as a 'quartic'
+
+    const std::size_t allocs_before = n_allocs;
+
+    sm::vec<std::complex<double>, 2> ev2 = m2.eigenvalues();
+    sm::vec<std::complex<double>, 3> ev3 = m3.eigenvalues();
+    sm::vec<std::complex<double>, 4> ev4 = m4.eigenvalues();
+    sm::vec<std::complex<float>, 4> evr = mr.eigenvalues();
+    std::array<std::complex<double>, 3> cr = sm::polysolve::solve_fixed<double, 3> (cubic_coeffs);
+    std::array<std::complex<double>, 4> qr = sm::polysolve::solve_fixed<double, 4> (quartic_coeffs);
+    std::array<std::complex<double>, 5> hr = sm::polysolve::solve_fixed<double, 5> (quintic_coeffs);
+    std::array<std::complex<double>, 4> dr = {};
+    std::uint32_t n_dr = sm::polysolve::solve<double, 4> (degenerate_coeffs, dr);
+
+    const std::size_t allocs = n_allocs - allocs_before;
+
+    if (allocs != 0) {
+        std::cout << "Fixed size solvers made " << allocs << " allocations\n";
+        ++rtn;
+    }
+
+    // Check the results
+    constexpr double tol = 1e-9;
+    if (std::abs (ev2[0] - 2.0) > tol || std::abs (ev2[1] - 5.0) > tol) { ++rtn; }
+    const double r2 = std::sqrt (2.0);
+    if (std::abs (ev3[0] - (2.0 - r2)) > tol || std::abs (ev3[1] - 2.0) > tol || std::abs (ev3[2] - (2.0 + r2)) > tol) { ++rtn; }
+    if (std::abs (ev4[0] - 2.0) > tol || std::abs (ev4[3] - 7.0) > tol) { ++rtn; }
+    // A rotation has eigenvalues exp(-i theta), exp(i theta), 1, 1 (cos(theta) < 1 sorts first)
+    if (std::abs (evr[0] - std::complex<float>(std::cos (0.6f), -std::sin (0.6f))) > 1e-4f) {
+        std::cout << "Rotation eigenvalues: " << evr << std::endl;
+        ++rtn;
+    }
+    for (std::uint32_t i = 0; i < 3; ++i) { if (std::abs (cr[i] - double(i + 1)) > tol) { ++rtn; } }
+    if (std::abs (qr[0] + 2.0) > tol || std::abs (qr[3] - 2.0) > tol) { ++rtn; }
+    for (std::uint32_t i = 0; i < 5; ++i) { if (std::abs (hr[i] - double(i + 1)) > 1e-6) { ++rtn; } }
+    if (n_dr != 1 || std::abs (dr[0] + 2.0) > tol || !std::isnan (dr[1].real())) { ++rtn; }
+
+    // The fixed size path gives the same roots as the std::vector path
+    std::vector<std::complex<double>> qv = sm::polysolve::solve<double> (std::vector<double>(quartic_coeffs.begin(), quartic_coeffs.end()));
+    for (std::uint32_t i = 0; i < 4; ++i) { if (qv[i] != qr[i]) { ++rtn; } }
+
+    // solve<T, N> (coeffs) returns a std::vector with one root per degree, as it always has
+    std::vector<std::complex<double>> qa = sm::polysolve::solve<double, 4> (quartic_coeffs);
+    std::vector<std::complex<double>> da = sm::polysolve::solve<double, 4> (degenerate_coeffs);
+    if (qa.size() != 4u || da.size() != 1u || std::abs (da[0] + 2.0) > tol) {
+        std::cout << "solve<double, 4> returned " << qa.size() << " and " << da.size() << " roots\n";
+        ++rtn;
+    }
+    for (std::uint32_t i = 0; i < 4; ++i) { if (qa[i] != qr[i]) { ++rtn; } }
+
+    // Compile time evaluation
+    constexpr std::array<std::complex<double>, 2> cq = constexpr_quadratic();
+    if (std::abs (cq[0] - 2.0) > tol || std::abs (cq[1] - 3.0) > tol) { ++rtn; }
+    constexpr sm::vec<std::complex<double>, 3> cev = constexpr_eigenvalues();
+    if (std::abs (cev[0] - 1.0) > 1e-6 || std::abs (cev[1] - 3.0) > 1e-6 || std::abs (cev[2] - 5.0) > 1e-6) {
+        std::cout << "constexpr eigenvalues: " << cev << std::endl;
+        ++rtn;
+    }
+
+    std::cout << "Test " << (rtn ? "FAILED" : "PASSED") << std::endl;
+    return rtn;
+}
@@ -0,0 +1,140 @@
+// Test the bulk operations of sm::quaternion_array against the single quaternion equivalents
+
+#include <iostream>
+#include <limits>
+#include <cmath>
+#include <exception>
+
+import sm.mathconst;
+import sm.vec;
+import sm.vvec;
+import sm.quaternion;
+import sm.quaternion_array;
+import sm.mat;
+
+// Compare two quaternions element-wise to within a tolerance
+template <typename F>
+bool close (const sm::quaternion<F>& q1, const sm::quaternion<F>& q2, const F tol)
+{
+    return (std::abs (q1.w - q2.w) < tol && std::abs (q1.x - q2.x) < tol
+            && std::abs (q1.y - q2.y) < tol && std::abs (q1.z - q2.z) < tol);
+}
+
+int main()
+{
+    int rtn = 0;
+
+    using F = double;
+    using mc = sm::mathconst<F>;
+    constexpr F tol = F{100} * std::numeric_limits<F>::epsilon();
+
+    // Make two sets of rotations
+    constexpr std::size_t n = 37;
+    sm::quaternion_array<F> qa (n);
+    sm::quaternion_array<F> qb (n);
+    if (qa.size() != n) { ++rtn; }
+    if (qa.get (5) != sm::quaternion<F>{}) { ++rtn; }
+
+    for (std::size_t i = 0; i < n; ++i) {
+        sm::vec<F, 3> ax1 = { F{1}, static_cast<F>(i) * F{0.1}, F{0.5} };
+        sm::vec<F, 3> ax2 = { static_cast<F>(i) * F{-0.2}, F{1}, F{0.3} };
+        qa.set (i, sm::quaternion<F> (ax1, static_cast<F>(i) * mc::pi / F{n}));
+        qb.set (i, sm::quaternion<F> (ax2, mc::pi_over_2 - static_cast<F>(i) * F{0.05}));
+    }
+
+    // Element-wise multiplication
+    sm::quaternion_array<F> qab = qa * qb;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!close (qab.get (i), qa.get (i) * qb.get (i), tol)) {
+            std::cout << "multiply mismatch at " << i << ": " << qab.get (i) << " vs " << (qa.get (i) * qb.get (i)) << std::endl;
+            ++rtn;
+        }
+    }
+
+    // Pre/post multiply by a single quaternion
+    sm::quaternion<F> qs (sm::vec<F, 3>{ F{0}, F{0}, F{1} }, mc::pi_over_3);
+    sm::quaternion_array<F> qpost = qa;
+    qpost.postmultiply (qs);
+    sm::quaternion_array<F> qpre = qa;
+    qpre.premultiply (qs);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!close (qpost.get (i), qa.get (i) * qs, tol)) { ++rtn; }
+        if (!close (qpre.get (i), qs * qa.get (i), tol)) { ++rtn; }
+    }
+
+    // Renormalize
+    sm::quaternion_array<F> qr (3);
+    qr.set (0, sm::quaternion<F>{ F{2}, F{0}, F{0}, F{0} });
+    qr.set (1, sm::quaternion<F>{ F{1}, F{1}, F{1}, F{1} });
+    qr.set (2, sm::quaternion<F>{ F{0}, F{3}, F{0}, F{4} });
+    qr.renormalize();
+    sm::vvec<F> nrm = qr.norm();
+    for (auto nn : nrm) { if (std::abs (nn - F{1}) > tol) { ++rtn; } }
+    if (!close (qr.get (2), sm::quaternion<F>{ F{0}, F{0.6}, F{0}, F{0.8} }, tol)) { ++rtn; }
+
+    // Rotate vectors, in both SoA and vvec-of-vec forms
+    sm::vvec<sm::vec<F, 3>> vs (n);
+    for (std::size_t i = 0; i < n; ++i) { vs[i] = { F{1}, static_cast<F>(i), F{-2} }; }
+    sm::vvec<sm::vec<F, 3>> vrot = qab.rotate_vecs (vs);
+    for (std::size_t i = 0; i < n; ++i) {
+        sm::vec<F, 3> expected = qab.get (i).rotate_vec (vs[i]);
+        if ((vrot[i] - expected).abs().max() > F{10} * tol * vs[i].length()) {
+            std::cout << "rotate_vecs mismatch at " << i << ": " << vrot[i] << " vs " << expected << std::endl;
+            ++rtn;
+        }
+    }
+
+    // Slerp and nlerp
+    for (F t : { F{0}, F{0.25}, F{0.5}, F{1} }) {
+        sm::quaternion_array<F> qsl = qa.slerp (qb, t);
+        sm::quaternion_array<F> qnl = qa.nlerp (qb, t);
+        for (std::size_t i = 0; i < n; ++i) {
+            sm::quaternion<F> expected = qa.get (i).slerp (qb.get (i), t);
+            if (!close (qsl.get (i), expected, tol)) {
+                std::cout << "slerp mismatch at " << i << ", t=" << t << ": " << qsl.get (i) << " vs " << expected << std::endl;
+                ++rtn;
+            }
+            if (!qnl.get (i).checkunit()) { ++rtn; }
+        }
+        // At the ends, nlerp matches slerp (up to sign)
+        if (t == F{0} || t == F{1}) {
+            for (std::size_t i = 0; i < n; ++i) {
+                if (!close (qnl.get (i), qsl.get (i), tol) && !close (-qnl.get (i), qsl.get (i), tol)) { ++rtn; }
+            }
+        }
+    }
+
+    bool caught = false;
+    try {
+        sm::quaternion_array<F> qbad = qa.slerp (qb, F{2});
+    } catch (const std::exception&) {
+        caught = true;
+    }
+    if (!caught) { ++rtn; }
+
+    // Conversion to mat<F, 4>
+    sm::vvec<sm::mat<F, 4>> mats = qab.rotation_matrices();
+    for (std::size_t i = 0; i < n; ++i) {
+        sm::mat<F, 4> expected = sm::mat<F, 4>::pure_rotation (qab.get (i));
+        if ((mats[i].arr - expected.arr).abs().max() > tol) {
+            std::cout << "rotation_matrices mismatch at " << i << std::endl;
+            ++rtn;
+        }
+    }
+
+    // Single precision
+    sm::quaternion_array<float> qf (2);
+    qf.set (1, sm::quaternion<float> (sm::vec<float, 3>{ 1.0f, 0.0f, 0.0f }, sm::mathconst<float>::pi_over_2));
+    sm::vvec<float> vx = { 0.0f, 0.0f };
+    sm::vvec<float> vy = { 1.0f, 1.0f };
+    sm::vvec<float> vz = { 0.0f, 0.0f };
+    qf.rotate_vecs (vx, vy, vz);
+    // Identity leaves (0,1,0) alone; rotation about x by pi/2 takes (0,1,0) to (0,0,1)
+    if (std::abs (vy[0] - 1.0f) > 1e-6f || std::abs (vz[1] - 1.0f) > 1e-6f || std::abs (vy[1]) > 1e-6f) {
+        std::cout << "float rotate_vecs failed: " << vx << ", " << vy << ", " << vz << std::endl;
+        ++rtn;
+    }
+
+    std::cout << "Test " << (rtn == 0 ? "PASSED" : "FAILED") << std::endl;
+    return rtn;
+}